@@ -411,6 +411,8 @@ bool OBSApp::InitGlobalConfigDefaults()
 				  "Normal");
 	config_set_default_bool(globalConfig, "General", "EnableAutoUpdates",
 				true);
+	config_set_default_bool(globalConfig, "Basic", "SceneCollectionBinary",
+				false);
 
 #if _WIN32
 	config_set_default_string(globalConfig, "Video", "Renderer",
@@ -1946,6 +1948,9 @@ QAccessibleInterface *accessibleFactory(const QString &classname,
 	return nullptr;
 }
 
+/* always keep the last 30 seconds, so a trace can be saved after a stutter */
+#define TRACE_WINDOW_NS 30000000000ULL
+
 static const char *run_program_init = "run_program_init";
 static int run_program(fstream &logFile, int argc, char *argv[])
 {
@@ -1957,6 +1962,7 @@ static int run_program(fstream &logFile, int argc, char *argv[])
 		static_cast<void *>(&ProfilerFree), ProfilerFree);
 
 	profiler_start();
+	profiler_trace_start(TRACE_WINDOW_NS);
 	profile_register_root(run_program_init, 0);
 
 	ScopeProfiler prof{run_program_init};
@@ -2661,6 +2667,9 @@ int main(int argc, char *argv[])
 		} else if (arg_is(argv[i], "--unfiltered_log", nullptr)) {
 			unfiltered_log = true;
 
+		} else if (arg_is(argv[i], "--track-allocs", nullptr)) {
+			bmem_set_tracking(true);
+
 		} else if (arg_is(argv[i], "--startstreaming", nullptr)) {
 			opt_start_streaming = true;
 
@@ -2718,7 +2727,8 @@ int main(int argc, char *argv[])
 				"--multi, -m: Don't warn when launching multiple instances.\n\n"
 				"--verbose: Make log more verbose.\n"
 				"--always-on-top: Start in 'always on top' mode.\n\n"
-				"--unfiltered_log: Make log unfiltered.\n\n"
+				"--unfiltered_log: Make log unfiltered.\n"
+				"--track-allocs: Log leaked allocations by call site on exit.\n\n"
 				"--disable-updater: Disable built-in updater (Windows/Mac only)\n\n"
 				"--disable-high-dpi-scaling: Disable automatic high-DPI scaling\n\n";
 
@@ -2762,6 +2772,7 @@ int main(int argc, char *argv[])
 	int ret = run_program(logFile, argc, argv);
 
 	blog(LOG_INFO, "Number of memory leaks: %ld", bnum_allocs());
+	bmem_log_arenas(LOG_INFO);
 	base_set_log_handler(nullptr, nullptr);
 	return ret;
 }
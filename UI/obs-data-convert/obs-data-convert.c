@@ -0,0 +1,92 @@
+/*
+ * Converts obs_data files, such as scene collections, between json and the
+ * binary encoding written by obs_data_save_binary.  The format of the input
+ * is detected from its contents, and by default the output is written in the
+ * other one.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <util/platform.h>
+#include <obs-data.h>
+
+enum format {
+	FORMAT_AUTO,
+	FORMAT_JSON,
+	FORMAT_BINARY,
+};
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: obs-data-convert [--json | --binary] <input> <output>\n"
+		"\n"
+		"Converts between json and binary obs_data files.  Without an\n"
+		"option the output is in the format the input is not.\n");
+}
+
+static bool is_binary_file(const char *file)
+{
+	FILE *f = os_fopen(file, "rb");
+	char magic[4];
+	bool binary;
+
+	if (!f)
+		return false;
+
+	binary = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+		 memcmp(magic, "OBSD", sizeof(magic)) == 0;
+
+	fclose(f);
+	return binary;
+}
+
+int main(int argc, char *argv[])
+{
+	enum format format = FORMAT_AUTO;
+	const char *input;
+	const char *output;
+	obs_data_t *data;
+	bool binary_in;
+	bool binary_out;
+	bool success;
+	int arg = 1;
+
+	if (argc > arg && strcmp(argv[arg], "--json") == 0) {
+		format = FORMAT_JSON;
+		arg++;
+	} else if (argc > arg && strcmp(argv[arg], "--binary") == 0) {
+		format = FORMAT_BINARY;
+		arg++;
+	}
+
+	if (argc - arg != 2) {
+		usage();
+		return 1;
+	}
+
+	input = argv[arg];
+	output = argv[arg + 1];
+
+	binary_in = is_binary_file(input);
+	data = binary_in ? obs_data_create_from_binary_file(input)
+			 : obs_data_create_from_json_file(input);
+	if (!data) {
+		fprintf(stderr, "Failed to load '%s'\n", input);
+		return 1;
+	}
+
+	binary_out = format == FORMAT_AUTO ? !binary_in
+					   : format == FORMAT_BINARY;
+	success = binary_out ? obs_data_save_binary(data, output)
+			     : obs_data_save_json(data, output);
+	obs_data_release(data);
+
+	if (!success) {
+		fprintf(stderr, "Failed to write '%s'\n", output);
+		return 1;
+	}
+
+	return 0;
+}
@@ -89,6 +89,16 @@ bool SceneCollectionExists(const char *findName)
 	return found;
 }
 
+/* removes the binary copy the scene collection may have, see
+ * OBSBasic::Save */
+static void RemoveBinarySceneCollection(std::string file)
+{
+	file += ".obsdata";
+	os_unlink(file.c_str());
+	file += ".bak";
+	os_unlink(file.c_str());
+}
+
 static bool GetSceneCollectionName(QWidget *parent, std::string &name,
 				   std::string &file,
 				   const char *oldName = nullptr)
@@ -276,6 +286,7 @@ void OBSBasic::on_actionRenameSceneCollection_triggered()
 	}
 
 	oldFile.insert(0, path);
+	RemoveBinarySceneCollection(oldFile);
 	oldFile += ".json";
 	os_unlink(oldFile.c_str());
 	oldFile += ".bak";
@@ -337,6 +348,7 @@ void OBSBasic::on_actionRemoveSceneCollection_triggered()
 	}
 
 	oldFile.insert(0, path);
+	RemoveBinarySceneCollection(oldFile);
 	oldFile += ".json";
 
 	os_unlink(oldFile.c_str());
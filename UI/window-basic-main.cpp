@@ -65,6 +65,7 @@
 #include "undo-stack-obs.hpp"
 #include <fstream>
 #include <sstream>
+#include <sys/stat.h>
 
 #ifdef _WIN32
 #include "win-update/win-update.hpp"
@@ -664,6 +665,44 @@ obs_data_array_t *OBSBasic::SaveProjectors()
 	return savedProjectors;
 }
 
+/* with "SceneCollectionBinary" set, a binary copy of the scene collection is
+ * kept next to the json file, which stays the one other tools read */
+static inline bool UseBinarySceneCollection()
+{
+	return config_get_bool(App()->GlobalConfig(), "Basic",
+			       "SceneCollectionBinary");
+}
+
+static std::string BinarySceneCollectionPath(const char *file)
+{
+	std::string path = file;
+	size_t ext = path.rfind(".json");
+
+	if (ext != std::string::npos && ext + 5 == path.size())
+		path.erase(ext);
+	return path + ".obsdata";
+}
+
+/* the binary copy is only used when it was written at least as recently as
+ * the json file, in case something else edited the json since */
+static obs_data_t *LoadBinarySceneCollection(const char *file)
+{
+	std::string binPath = BinarySceneCollectionPath(file);
+	struct stat jsonStat, binStat;
+
+	if (os_stat(binPath.c_str(), &binStat) != 0)
+		return nullptr;
+	if (os_stat(file, &jsonStat) == 0 &&
+	    jsonStat.st_mtime > binStat.st_mtime)
+		return nullptr;
+
+	obs_data_t *data = obs_data_create_from_binary_file(binPath.c_str());
+	if (!data)
+		blog(LOG_WARNING, "Failed to load %s, using %s instead",
+		     binPath.c_str(), file);
+	return data;
+}
+
 void OBSBasic::Save(const char *file)
 {
 	OBSScene scene = GetCurrentScene();
@@ -699,6 +738,14 @@ void OBSBasic::Save(const char *file)
 	if (!obs_data_save_json_safe(saveData, file, "tmp", "bak"))
 		blog(LOG_ERROR, "Could not save scene data to %s", file);
 
+	if (UseBinarySceneCollection()) {
+		std::string binPath = BinarySceneCollectionPath(file);
+		if (!obs_data_save_binary_safe(saveData, binPath.c_str(), "tmp",
+					       "bak"))
+			blog(LOG_ERROR, "Could not save scene data to %s",
+			     binPath.c_str());
+	}
+
 	obs_data_release(saveData);
 	obs_data_array_release(sceneOrder);
 	obs_data_array_release(quickTrData);
@@ -930,7 +977,11 @@ void OBSBasic::Load(const char *file)
 {
 	disableSaving++;
 
-	obs_data_t *data = obs_data_create_from_json_file_safe(file, "bak");
+	obs_data_t *data = nullptr;
+	if (UseBinarySceneCollection())
+		data = LoadBinarySceneCollection(file);
+	if (!data)
+		data = obs_data_create_from_json_file_safe(file, "bak");
 	if (!data) {
 		disableSaving--;
 		blog(LOG_INFO, "No scene file found, creating default scene");
@@ -4183,6 +4234,14 @@ int OBSBasic::ResetVideo()
 		config_get_uint(App()->GlobalConfig(), "Video", "AdapterIdx");
 	ovi.gpu_conversion = true;
 	ovi.scale_type = GetScaleType(basicConfig);
+	ovi.staging_depth[OBS_MAIN_VIDEO_RENDERING] = (uint32_t)config_get_uint(
+		basicConfig, "Video", "StagingDepthMain");
+	ovi.staging_depth[OBS_STREAMING_VIDEO_RENDERING] =
+		(uint32_t)config_get_uint(basicConfig, "Video",
+					  "StagingDepthStream");
+	ovi.staging_depth[OBS_RECORDING_VIDEO_RENDERING] =
+		(uint32_t)config_get_uint(basicConfig, "Video",
+					  "StagingDepthRecord");
 
 	if (ovi.base_width < 8 || ovi.base_height < 8) {
 		ovi.base_width = 1920;
@@ -5821,6 +5880,26 @@ void OBSBasic::on_actionViewCurrentLog_triggered()
 	}
 }
 
+void OBSBasic::on_actionSaveTrace_triggered()
+{
+	char logDir[512];
+	if (GetConfigPath(logDir, sizeof(logDir), "obs-studio/logs") <= 0)
+		return;
+
+	QString path = QT_UTF8(logDir) + "/" +
+		       QT_UTF8(GenerateTimeDateFilename("json").c_str());
+	path = SaveFile(this, QTStr("Basic.MainMenu.Help.Logs.SaveTrace"),
+			path, "JSON Files (*.json)");
+	if (path.isEmpty())
+		return;
+
+	if (!profiler_trace_save(QT_TO_UTF8(path)))
+		OBSMessageBox::warning(
+			this, QTStr("Basic.MainMenu.Help.Logs.SaveTrace"),
+			QTStr("Basic.MainMenu.Help.Logs.SaveTrace.Failed")
+				.arg(path));
+}
+
 void OBSBasic::on_actionShowCrashLogs_triggered()
 {
 	char logDir[512];
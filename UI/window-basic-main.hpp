@@ -896,6 +896,7 @@ private slots:
 	void on_actionUploadCurrentLog_triggered();
 	void on_actionUploadLastLog_triggered();
 	void on_actionViewCurrentLog_triggered();
+	void on_actionSaveTrace_triggered();
 	void on_actionCheckForUpdates_triggered();
 
 	void on_actionShowCrashLogs_triggered();
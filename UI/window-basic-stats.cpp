@@ -48,6 +48,17 @@ static QString MakeMissedFramesText(uint32_t total_lagged,
 		     QString::number(num, 'f', 1));
 }
 
+static QString MakeLatencyText(const struct obs_latency_stats &stats)
+{
+	auto ms = [](uint64_t ns) {
+		return QString::number((double)ns / 1000000.0, 'f', 1);
+	};
+
+	return QString("%1 / %2 / %3 / %4 ms")
+		.arg(ms(stats.p50_ns), ms(stats.p95_ns), ms(stats.p99_ns),
+		     ms(stats.p999_ns));
+}
+
 OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	: QWidget(parent),
 	  cpu_info(os_cpu_usage_info_start()),
@@ -92,6 +103,8 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 
 	fps = new QLabel(this);
 	renderTime = new QLabel(this);
+	renderLatency = new QLabel(this);
+	audioLatency = new QLabel(this);
 	skippedFrames = new QLabel(this);
 	missedFrames = new QLabel(this);
 
@@ -99,10 +112,18 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	textWidth = missedFrames->fontMetrics().boundingRect(str).width();
 	missedFrames->setMinimumWidth(textWidth);
 
+	struct obs_latency_stats maxLatency = {0, 999000000, 999000000,
+					       999000000, 999000000};
+	str = MakeLatencyText(maxLatency);
+	textWidth = renderLatency->fontMetrics().boundingRect(str).width();
+	renderLatency->setMinimumWidth(textWidth);
+
 	row = 0;
 
 	newStatBare("FPS", fps, 2);
 	newStat("AverageTimeToRender", renderTime, 2);
+	newStat("RenderLatency", renderLatency, 2);
+	newStat("AudioLatency", audioLatency, 2);
 	newStat("MissedFrames", missedFrames, 2);
 	newStat("SkippedFrames", skippedFrames, 2);
 
@@ -131,6 +152,7 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	addOutputCol("Basic.Stats.DroppedFrames");
 	addOutputCol("Basic.Stats.MegabytesSent");
 	addOutputCol("Basic.Stats.Bitrate");
+	addOutputCol("Basic.Stats.EncodeLatency");
 
 	/* --------------------------------------------- */
 
@@ -246,6 +268,7 @@ void OBSBasicStats::AddOutputLabels(QString name)
 	ol.droppedFrames = new QLabel(this);
 	ol.megabytesSent = new QLabel(this);
 	ol.bitrate = new QLabel(this);
+	ol.encodeLatency = new QLabel(this);
 
 	int newPointSize = ol.status->font().pointSize();
 	newPointSize *= 13;
@@ -261,6 +284,7 @@ void OBSBasicStats::AddOutputLabels(QString name)
 	outputLayout->addWidget(ol.droppedFrames, row, col++);
 	outputLayout->addWidget(ol.megabytesSent, row, col++);
 	outputLayout->addWidget(ol.bitrate, row, col++);
+	outputLayout->addWidget(ol.encodeLatency, row, col++);
 	outputLabels.push_back(ol);
 }
 
@@ -276,6 +300,7 @@ void OBSBasicStats::InitializeValues()
 	first_skipped = video_output_get_skipped_frames(video);
 	first_rendered = obs_get_total_frames();
 	first_lagged = obs_get_lagged_frames();
+	obs_reset_pipeline_stats();
 }
 
 void OBSBasicStats::Update()
@@ -373,6 +398,24 @@ void OBSBasicStats::Update()
 
 	/* ------------------ */
 
+	struct obs_pipeline_stats pipeline;
+	obs_get_pipeline_stats(&pipeline);
+
+	renderLatency->setText(MakeLatencyText(pipeline.render));
+
+	num = (long double)pipeline.render.p99_ns / 1000000.0l;
+
+	if (num > fpsFrameTime)
+		setThemeID(renderLatency, "error");
+	else if (num > fpsFrameTime * 0.75l)
+		setThemeID(renderLatency, "warning");
+	else
+		setThemeID(renderLatency, "");
+
+	audioLatency->setText(MakeLatencyText(pipeline.audio));
+
+	/* ------------------ */
+
 	video_t *video = obs_get_video();
 	uint32_t total_encoded = video_output_get_total_frames(video);
 	uint32_t total_skipped = video_output_get_skipped_frames(video);
@@ -486,6 +529,7 @@ void OBSBasicStats::Reset()
 	first_skipped = 0xFFFFFFFF;
 	first_rendered = 0xFFFFFFFF;
 	first_lagged = 0xFFFFFFFF;
+	obs_reset_pipeline_stats();
 
 	OBSOutput strOutput = obs_frontend_get_streaming_output();
 	OBSOutput recOutput = obs_frontend_get_recording_output();
@@ -547,6 +591,17 @@ void OBSBasicStats::OutputLabels::Update(obs_output_t *output, bool rec)
 		QString("%1 MB").arg(QString::number(num, 'f', 1)));
 	bitrate->setText(QString("%1 kb/s").arg(QString::number(kbps, 'f', 0)));
 
+	obs_encoder_t *encoder =
+		output && active ? obs_output_get_video_encoder(output)
+				 : nullptr;
+	if (encoder) {
+		struct obs_latency_stats encodeStats;
+		obs_encoder_get_latency_stats(encoder, &encodeStats);
+		encodeLatency->setText(MakeLatencyText(encodeStats));
+	} else {
+		encodeLatency->setText(QString());
+	}
+
 	if (!rec) {
 		int total = output ? obs_output_get_total_frames(output) : 0;
 		int dropped = output ? obs_output_get_frames_dropped(output)
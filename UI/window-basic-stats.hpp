@@ -22,6 +22,8 @@ class OBSBasicStats : public QWidget {
 	QLabel *memUsage = nullptr;
 
 	QLabel *renderTime = nullptr;
+	QLabel *renderLatency = nullptr;
+	QLabel *audioLatency = nullptr;
 	QLabel *skippedFrames = nullptr;
 	QLabel *missedFrames = nullptr;
 
@@ -40,6 +42,7 @@ class OBSBasicStats : public QWidget {
 		QPointer<QLabel> droppedFrames;
 		QPointer<QLabel> megabytesSent;
 		QPointer<QLabel> bitrate;
+		QPointer<QLabel> encodeLatency;
 
 		uint64_t lastBytesSent = 0;
 		uint64_t lastBytesSentTime = 0;
@@ -17,6 +17,7 @@
 #include <obs-data.h>
 #include <obs-properties.h>
 #include <obs-interaction.h>
+#include <callback/atom.h>
 #include <callback/calldata.h>
 #include <callback/decl.h>
 #include <callback/proc.h>
@@ -94,6 +95,7 @@ static inline void wrap_blog(int log_level, const char *message)
 %include "obs-interaction.h"
 %include "obs-hotkey.h"
 %include "obs.h"
+%include "callback/atom.h"
 %include "callback/calldata.h"
 %include "callback/proc.h"
 %include "callback/signal.h"
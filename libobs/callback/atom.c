@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../util/base.h"
+#include "../util/threading.h"
+
+#include "atom.h"
+
+/*
+ *   Atoms are kept in a fixed number of hash chains.  Entries are only ever
+ * pushed onto the front of a chain and never freed, so names can be looked up
+ * without a lock; only adding a name takes the mutex.  Atoms are numbered in
+ * the order they're added, and found by number through blocks of entry
+ * pointers that never move once allocated.
+ *
+ *   The table outlives libobs itself (atoms may be kept in statics), so it is
+ * allocated with malloc rather than bmalloc and stays out of the leak count.
+ */
+
+#define ATOM_BUCKETS 1024
+#define ATOM_BLOCK_SIZE 256
+#define ATOM_MAX_BLOCKS 4096
+
+struct atom_entry {
+	struct atom_entry *volatile next;
+	uint32_t hash;
+	callback_atom_t atom;
+	char *name;
+};
+
+static struct atom_entry *volatile buckets[ATOM_BUCKETS];
+static struct atom_entry **volatile blocks[ATOM_MAX_BLOCKS];
+static volatile long num_atoms = 0;
+static pthread_mutex_t atom_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint32_t atom_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static inline struct atom_entry *
+next_entry(struct atom_entry *const volatile *link)
+{
+	return os_atomic_load_ptr((void *const volatile *)link);
+}
+
+static callback_atom_t atom_lookup(const char *name, uint32_t hash)
+{
+	struct atom_entry *entry =
+		next_entry(&buckets[hash & (ATOM_BUCKETS - 1)]);
+
+	while (entry) {
+		if (entry->hash == hash && strcmp(entry->name, name) == 0)
+			return entry->atom;
+		entry = next_entry(&entry->next);
+	}
+
+	return 0;
+}
+
+static callback_atom_t atom_add(const char *name, uint32_t hash)
+{
+	long id = num_atoms + 1;
+	size_t block = (size_t)id / ATOM_BLOCK_SIZE;
+	size_t len = strlen(name);
+	struct atom_entry *entry;
+	struct atom_entry *volatile *bucket;
+
+	if (block >= ATOM_MAX_BLOCKS) {
+		blog(LOG_ERROR, "callback_atom_get: too many atoms, could not "
+				"add '%s'",
+		     name);
+		return 0;
+	}
+
+	if (!blocks[block]) {
+		void *entries = calloc(ATOM_BLOCK_SIZE, sizeof(entry));
+		if (!entries)
+			bcrash("Out of memory while adding atom '%s'", name);
+		os_atomic_set_ptr((void *volatile *)&blocks[block], entries);
+	}
+
+	entry = malloc(sizeof(struct atom_entry) + len + 1);
+	if (!entry)
+		bcrash("Out of memory while adding atom '%s'", name);
+
+	bucket = &buckets[hash & (ATOM_BUCKETS - 1)];
+	entry->next = *bucket;
+	entry->hash = hash;
+	entry->atom = (callback_atom_t)id;
+	entry->name = (char *)(entry + 1);
+	memcpy(entry->name, name, len + 1);
+
+	blocks[block][id % ATOM_BLOCK_SIZE] = entry;
+	os_atomic_set_long(&num_atoms, id);
+	os_atomic_set_ptr((void *volatile *)bucket, entry);
+
+	return entry->atom;
+}
+
+callback_atom_t callback_atom_get(const char *name)
+{
+	callback_atom_t atom;
+	uint32_t hash;
+
+	if (!name || !*name)
+		return 0;
+
+	hash = atom_hash(name);
+	atom = atom_lookup(name, hash);
+	if (atom)
+		return atom;
+
+	pthread_mutex_lock(&atom_mutex);
+	atom = atom_lookup(name, hash);
+	if (!atom)
+		atom = atom_add(name, hash);
+	pthread_mutex_unlock(&atom_mutex);
+
+	return atom;
+}
+
+callback_atom_t callback_atom_find(const char *name)
+{
+	if (!name || !*name)
+		return 0;
+
+	return atom_lookup(name, atom_hash(name));
+}
+
+const char *callback_atom_name(callback_atom_t atom)
+{
+	struct atom_entry **block;
+
+	if (!atom || (long)atom > os_atomic_load_long(&num_atoms))
+		return NULL;
+
+	block = os_atomic_load_ptr(
+		(void *const volatile *)&blocks[atom / ATOM_BLOCK_SIZE]);
+	return block[atom % ATOM_BLOCK_SIZE]->name;
+}
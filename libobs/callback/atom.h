@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Atom table
+ *
+ *   Interns the names of signals, procedures and call parameters, so a name
+ * can be resolved to an ID once and then compared as an integer.  Atoms are
+ * shared by every handler and live for the rest of the process, so an ID can
+ * be kept in a static variable.  0 is never a valid atom.
+ */
+
+typedef uint32_t callback_atom_t;
+
+/** Returns the atom for a name, adding it to the table if needed */
+EXPORT callback_atom_t callback_atom_get(const char *name);
+
+/** Returns the atom for a name, or 0 if the name has never been added */
+EXPORT callback_atom_t callback_atom_find(const char *name);
+
+/** Returns the name of an atom, or NULL if it is not valid */
+EXPORT const char *callback_atom_name(callback_atom_t atom);
+
+#ifdef __cplusplus
+}
+#endif
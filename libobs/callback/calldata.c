@@ -26,27 +26,20 @@
  * fetching.
  *
  *   Stack format is:
- *     [size_t    param1_name_size]
- *     [char[]    param1_name]
+ *     [size_t    param1_atom]
  *     [size_t    param1_data_size]
  *     [uint8_t[] param1_data]
- *     [size_t    param2_name_size]
- *     [char[]    param2_name]
+ *     [size_t    param2_atom]
  *     [size_t    param2_data_size]
  *     [uint8_t[] param2_data]
  *     [...]
  *     [size_t    0]
  *
- *   Strings and string sizes always include the null terminator to allow for
- * direct referencing.
+ *   Parameter names are stored as atoms, so finding a parameter compares
+ * integers rather than strings.  Strings and string sizes always include the
+ * null terminator to allow for direct referencing.
  */
 
-static inline void cd_serialize(uint8_t **pos, void *ptr, size_t size)
-{
-	memcpy(ptr, *pos, size);
-	*pos += size;
-}
-
 static inline size_t cd_serialize_size(uint8_t **pos)
 {
 	size_t size = 0;
@@ -65,43 +58,39 @@ static inline const char *cd_serialize_string(uint8_t **pos)
 	return (size != 0) ? str : NULL;
 }
 
-static bool cd_getparam(const calldata_t *data, const char *name, uint8_t **pos)
+static bool cd_getparam(const calldata_t *data, callback_atom_t name,
+			uint8_t **pos)
 {
-	size_t name_size;
+	size_t atom;
 
 	if (!data->size)
 		return false;
 
 	*pos = data->stack;
 
-	name_size = cd_serialize_size(pos);
-	while (name_size != 0) {
-		const char *param_name = (const char *)*pos;
+	atom = cd_serialize_size(pos);
+	while (atom != 0) {
 		size_t param_size;
 
-		*pos += name_size;
-		if (strcmp(param_name, name) == 0)
+		if (atom == name)
 			return true;
 
 		param_size = cd_serialize_size(pos);
 		*pos += param_size;
 
-		name_size = cd_serialize_size(pos);
+		atom = cd_serialize_size(pos);
 	}
 
 	*pos -= sizeof(size_t);
 	return false;
 }
 
-static inline void cd_copy_string(uint8_t **pos, const char *str, size_t len)
+static inline void cd_copy_atom(uint8_t **pos, callback_atom_t name)
 {
-	if (!len)
-		len = strlen(str) + 1;
+	size_t atom = name;
 
-	memcpy(*pos, &len, sizeof(size_t));
+	memcpy(*pos, &atom, sizeof(size_t));
 	*pos += sizeof(size_t);
-	memcpy(*pos, str, len);
-	*pos += len;
 }
 
 static inline void cd_copy_data(uint8_t **pos, const void *in, size_t size)
@@ -115,14 +104,13 @@ static inline void cd_copy_data(uint8_t **pos, const void *in, size_t size)
 	}
 }
 
-static inline void cd_set_first_param(calldata_t *data, const char *name,
+static inline void cd_set_first_param(calldata_t *data, callback_atom_t name,
 				      const void *in, size_t size)
 {
 	uint8_t *pos;
 	size_t capacity;
-	size_t name_len = strlen(name) + 1;
 
-	capacity = sizeof(size_t) * 3 + name_len + size;
+	capacity = sizeof(size_t) * 3 + size;
 	data->size = capacity;
 
 	if (capacity < 128)
@@ -132,7 +120,7 @@ static inline void cd_set_first_param(calldata_t *data, const char *name,
 	data->stack = bmalloc(capacity);
 
 	pos = data->stack;
-	cd_copy_string(&pos, name, name_len);
+	cd_copy_atom(&pos, name);
 	cd_copy_data(&pos, in, size);
 	memset(pos, 0, sizeof(size_t));
 }
@@ -156,7 +144,14 @@ static inline bool cd_ensure_capacity(calldata_t *data, uint8_t **pos,
 	if (new_capacity < new_size)
 		new_capacity = new_size;
 
-	data->stack = brealloc(data->stack, new_capacity);
+	if (data->borrowed) {
+		uint8_t *stack = bmalloc(new_capacity);
+		memcpy(stack, data->stack, data->size);
+		data->stack = stack;
+		data->borrowed = false;
+	} else {
+		data->stack = brealloc(data->stack, new_capacity);
+	}
 	data->capacity = new_capacity;
 
 	*pos = data->stack + offset;
@@ -165,13 +160,13 @@ static inline bool cd_ensure_capacity(calldata_t *data, uint8_t **pos,
 
 /* ------------------------------------------------------------------------- */
 
-bool calldata_get_data(const calldata_t *data, const char *name, void *out,
-		       size_t size)
+bool calldata_get_data_id(const calldata_t *data, callback_atom_t name,
+			  void *out, size_t size)
 {
 	uint8_t *pos;
 	size_t data_size;
 
-	if (!data || !name || !*name)
+	if (!data || !name)
 		return false;
 
 	if (!cd_getparam(data, name, &pos))
@@ -185,12 +180,12 @@ bool calldata_get_data(const calldata_t *data, const char *name, void *out,
 	return true;
 }
 
-void calldata_set_data(calldata_t *data, const char *name, const void *in,
-		       size_t size)
+void calldata_set_data_id(calldata_t *data, callback_atom_t name,
+			  const void *in, size_t size)
 {
 	uint8_t *pos = NULL;
 
-	if (!data || !name || !*name)
+	if (!data || !name)
 		return;
 
 	if (!data->fixed && !data->stack) {
@@ -222,23 +217,22 @@ void calldata_set_data(calldata_t *data, const char *name, const void *in,
 		cd_copy_data(&pos, in, size);
 
 	} else {
-		size_t name_len = strlen(name) + 1;
-		size_t offset = name_len + size + sizeof(size_t) * 2;
+		size_t offset = size + sizeof(size_t) * 2;
 		if (!cd_ensure_capacity(data, &pos, data->size + offset))
 			return;
 		data->size += offset;
 
-		cd_copy_string(&pos, name, 0);
+		cd_copy_atom(&pos, name);
 		cd_copy_data(&pos, in, size);
 		memset(pos, 0, sizeof(size_t));
 	}
 }
 
-bool calldata_get_string(const calldata_t *data, const char *name,
-			 const char **str)
+bool calldata_get_string_id(const calldata_t *data, callback_atom_t name,
+			    const char **str)
 {
 	uint8_t *pos;
-	if (!data || !name || !*name)
+	if (!data || !name)
 		return false;
 
 	if (!cd_getparam(data, name, &pos))
@@ -247,3 +241,24 @@ bool calldata_get_string(const calldata_t *data, const char *name,
 	*str = cd_serialize_string(&pos);
 	return true;
 }
+
+/* names that were never added can't be in any calldata, so getting doesn't
+ * need to add them to the table */
+
+bool calldata_get_data(const calldata_t *data, const char *name, void *out,
+		       size_t size)
+{
+	return calldata_get_data_id(data, callback_atom_find(name), out, size);
+}
+
+void calldata_set_data(calldata_t *data, const char *name, const void *in,
+		       size_t size)
+{
+	calldata_set_data_id(data, callback_atom_get(name), in, size);
+}
+
+bool calldata_get_string(const calldata_t *data, const char *name,
+			 const char **str)
+{
+	return calldata_get_string_id(data, callback_atom_find(name), str);
+}
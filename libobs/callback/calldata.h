@@ -19,6 +19,7 @@
 #include <string.h>
 #include "../util/c99defs.h"
 #include "../util/bmem.h"
+#include "atom.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,6 +30,9 @@ extern "C" {
  *
  *   This is used to store parameters (and return value) sent to/from signals,
  * procedures, and callbacks.
+ *
+ *   Parameters are stored by atom (see atom.h).  The _id functions take an
+ * atom directly, which saves looking the name up each time.
  */
 
 enum call_param_type {
@@ -48,6 +52,7 @@ struct calldata {
 	size_t size;     /* size of the stack, in bytes */
 	size_t capacity; /* capacity of the stack, in bytes */
 	bool fixed;      /* fixed size (using call stack) */
+	bool borrowed;   /* using call stack until it fills, then the heap */
 };
 
 typedef struct calldata calldata_t;
@@ -65,13 +70,27 @@ static inline void calldata_init_fixed(struct calldata *data, uint8_t *stack,
 	data->stack = stack;
 	data->capacity = size;
 	data->fixed = true;
+	data->borrowed = false;
+	data->size = 0;
+	calldata_clear(data);
+}
+
+/* like calldata_init_fixed, but moves to the heap rather than failing if the
+ * parameters outgrow the buffer, so calldata_free must still be called */
+static inline void calldata_init_inline(struct calldata *data, uint8_t *stack,
+					size_t size)
+{
+	data->stack = stack;
+	data->capacity = size;
+	data->fixed = false;
+	data->borrowed = true;
 	data->size = 0;
 	calldata_clear(data);
 }
 
 static inline void calldata_free(struct calldata *data)
 {
-	if (!data->fixed)
+	if (!data->fixed && !data->borrowed)
 		bfree(data->stack);
 }
 
@@ -79,6 +98,10 @@ EXPORT bool calldata_get_data(const calldata_t *data, const char *name,
 			      void *out, size_t size);
 EXPORT void calldata_set_data(calldata_t *data, const char *name,
 			      const void *in, size_t new_size);
+EXPORT bool calldata_get_data_id(const calldata_t *data, callback_atom_t name,
+				 void *out, size_t size);
+EXPORT void calldata_set_data_id(calldata_t *data, callback_atom_t name,
+				 const void *in, size_t new_size);
 
 static inline void calldata_clear(struct calldata *data)
 {
@@ -130,6 +153,33 @@ static inline bool calldata_get_ptr(const calldata_t *data, const char *name,
 EXPORT bool calldata_get_string(const calldata_t *data, const char *name,
 				const char **str);
 
+static inline bool calldata_get_int_id(const calldata_t *data,
+				       callback_atom_t name, long long *val)
+{
+	return calldata_get_data_id(data, name, val, sizeof(*val));
+}
+
+static inline bool calldata_get_float_id(const calldata_t *data,
+					 callback_atom_t name, double *val)
+{
+	return calldata_get_data_id(data, name, val, sizeof(*val));
+}
+
+static inline bool calldata_get_bool_id(const calldata_t *data,
+					callback_atom_t name, bool *val)
+{
+	return calldata_get_data_id(data, name, val, sizeof(*val));
+}
+
+static inline bool calldata_get_ptr_id(const calldata_t *data,
+				       callback_atom_t name, void *p_ptr)
+{
+	return calldata_get_data_id(data, name, p_ptr, sizeof(p_ptr));
+}
+
+EXPORT bool calldata_get_string_id(const calldata_t *data,
+				   callback_atom_t name, const char **str);
+
 /* ------------------------------------------------------------------------- */
 /* call if you know your data is valid */
 
@@ -204,6 +254,39 @@ static inline void calldata_set_string(calldata_t *data, const char *name,
 		calldata_set_data(data, name, NULL, 0);
 }
 
+static inline void calldata_set_int_id(calldata_t *data, callback_atom_t name,
+				       long long val)
+{
+	calldata_set_data_id(data, name, &val, sizeof(val));
+}
+
+static inline void calldata_set_float_id(calldata_t *data,
+					 callback_atom_t name, double val)
+{
+	calldata_set_data_id(data, name, &val, sizeof(val));
+}
+
+static inline void calldata_set_bool_id(calldata_t *data, callback_atom_t name,
+					bool val)
+{
+	calldata_set_data_id(data, name, &val, sizeof(val));
+}
+
+static inline void calldata_set_ptr_id(calldata_t *data, callback_atom_t name,
+				       void *ptr)
+{
+	calldata_set_data_id(data, name, &ptr, sizeof(ptr));
+}
+
+static inline void calldata_set_string_id(calldata_t *data,
+					  callback_atom_t name, const char *str)
+{
+	if (str)
+		calldata_set_data_id(data, name, str, strlen(str) + 1);
+	else
+		calldata_set_data_id(data, name, NULL, 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
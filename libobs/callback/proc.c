@@ -21,6 +21,7 @@
 
 struct proc_info {
 	struct decl_info func;
+	callback_atom_t atom;
 	void *data;
 	proc_handler_proc_t callback;
 };
@@ -67,22 +68,23 @@ void proc_handler_add(proc_handler_t *handler, const char *decl_string,
 		return;
 	}
 
+	pi.atom = callback_atom_get(pi.func.name);
 	pi.callback = proc;
 	pi.data = data;
 
 	da_push_back(handler->procs, &pi);
 }
 
-bool proc_handler_call(proc_handler_t *handler, const char *name,
-		       calldata_t *params)
+bool proc_handler_call_id(proc_handler_t *handler, callback_atom_t name,
+			  calldata_t *params)
 {
-	if (!handler)
+	if (!handler || !name)
 		return false;
 
 	for (size_t i = 0; i < handler->procs.num; i++) {
 		struct proc_info *info = handler->procs.array + i;
 
-		if (strcmp(info->func.name, name) == 0) {
+		if (info->atom == name) {
 			info->callback(info->data, params);
 			return true;
 		}
@@ -90,3 +92,9 @@ bool proc_handler_call(proc_handler_t *handler, const char *name,
 
 	return false;
 }
+
+bool proc_handler_call(proc_handler_t *handler, const char *name,
+		       calldata_t *params)
+{
+	return proc_handler_call_id(handler, callback_atom_find(name), params);
+}
@@ -49,6 +49,10 @@ EXPORT void proc_handler_add(proc_handler_t *handler, const char *decl_string,
 EXPORT bool proc_handler_call(proc_handler_t *handler, const char *name,
 			      calldata_t *params);
 
+/** Same as proc_handler_call, with the name already resolved to an atom */
+EXPORT bool proc_handler_call_id(proc_handler_t *handler, callback_atom_t name,
+				 calldata_t *params);
+
 #ifdef __cplusplus
 }
 #endif
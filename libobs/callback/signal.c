@@ -16,44 +16,371 @@
 
 #include "../util/darray.h"
 #include "../util/threading.h"
+#include "../util/platform.h"
 
 #include "decl.h"
 #include "signal.h"
 
+/* ------------------------------------------------------------------------- */
+/* Callback lists are copy-on-write so that signalling doesn't take a lock.
+ * Connecting or disconnecting builds a new snapshot of the list under the
+ * list mutex and swaps it in, while signalling only pins whichever snapshot
+ * is current while calling through it.
+ *
+ * Snapshots are never freed while the list exists.  They're reused once
+ * nothing pins them, which keeps it safe for a thread that read the current
+ * snapshot just before it was swapped out to raise its reader count.  A
+ * callback is freed once the last snapshot holding it has been reused.
+ *
+ * Different threads can be inside the same signal at once, so a thread that
+ * disconnects from inside a callback doesn't wait for the others there: two
+ * threads each disconnecting the callback the other one is in would wait on
+ * each other forever.  The wait is put off until the thread has returned
+ * from its outermost signal instead. */
+
 struct signal_callback {
 	signal_callback_t callback;
+	global_signal_callback_t global_callback;
 	void *data;
-	bool remove;
 	bool keep_ref;
+
+	volatile bool remove;
+	volatile long calls;
+
+	/* snapshots and waiters holding the callback */
+	volatile long refs;
 };
 
-struct signal_info {
-	struct decl_info func;
-	DARRAY(struct signal_callback) callbacks;
+struct callback_snapshot {
+	volatile long readers;
+	DARRAY(struct signal_callback *) callbacks;
+};
+
+struct callback_list {
+	struct callback_snapshot *volatile current;
+	DARRAY(struct callback_snapshot *) snapshots;
 	pthread_mutex_t mutex;
-	bool signalling;
+};
 
-	struct signal_info *next;
+/* the callbacks the current thread is in the middle of calling */
+struct signal_frame {
+	signal_handler_t *handler;
+	struct signal_callback *cb;
+	struct signal_frame *prev;
 };
 
-static inline struct signal_info *signal_info_create(struct decl_info *info)
+static THREAD_LOCAL struct signal_frame *current_frame = NULL;
+
+/* callbacks disconnected from inside a signal, still to be waited for */
+static THREAD_LOCAL DARRAY(struct signal_callback *) deferred_waits;
+
+static bool callback_list_init(struct callback_list *list)
 {
 	pthread_mutexattr_t attr;
-	struct signal_info *si;
+	bool success;
+
+	memset(list, 0, sizeof(*list));
 
 	if (pthread_mutexattr_init(&attr) != 0)
-		return NULL;
-	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
-		return NULL;
+		return false;
+	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0) {
+		pthread_mutexattr_destroy(&attr);
+		return false;
+	}
+
+	success = pthread_mutex_init(&list->mutex, &attr) == 0;
+	pthread_mutexattr_destroy(&attr);
+	return success;
+}
+
+static inline void callback_release(struct signal_callback *cb)
+{
+	if (os_atomic_dec_long(&cb->refs) == 0)
+		bfree(cb);
+}
+
+static void snapshot_clear(struct callback_snapshot *snapshot)
+{
+	for (size_t i = 0; i < snapshot->callbacks.num; i++)
+		callback_release(snapshot->callbacks.array[i]);
+	snapshot->callbacks.num = 0;
+}
+
+static void callback_list_free(struct callback_list *list)
+{
+	for (size_t i = 0; i < list->snapshots.num; i++) {
+		struct callback_snapshot *snapshot = list->snapshots.array[i];
+
+		snapshot_clear(snapshot);
+		da_free(snapshot->callbacks);
+		bfree(snapshot);
+	}
+
+	da_free(list->snapshots);
+	pthread_mutex_destroy(&list->mutex);
+}
+
+static inline struct callback_snapshot *
+callback_list_current(struct callback_list *list)
+{
+	return os_atomic_load_ptr((void *const volatile *)&list->current);
+}
+
+/* the reader count goes up before checking that the snapshot is still the
+ * current one, so a writer either sees the reader or the reader sees the
+ * swap */
+static struct callback_snapshot *callback_list_pin(struct callback_list *list)
+{
+	for (;;) {
+		struct callback_snapshot *snapshot =
+			callback_list_current(list);
+		if (!snapshot)
+			return NULL;
+
+		os_atomic_inc_long(&snapshot->readers);
+		if (snapshot == callback_list_current(list))
+			return snapshot;
+		os_atomic_dec_long(&snapshot->readers);
+	}
+}
+
+static struct callback_snapshot *
+callback_list_unused_snapshot(struct callback_list *list)
+{
+	struct callback_snapshot *current = list->current;
+	struct callback_snapshot *snapshot;
+
+	for (size_t i = 0; i < list->snapshots.num; i++) {
+		snapshot = list->snapshots.array[i];
+
+		if (snapshot != current &&
+		    os_atomic_load_long(&snapshot->readers) == 0) {
+			snapshot_clear(snapshot);
+			return snapshot;
+		}
+	}
+
+	snapshot = bzalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_SIGNALS),
+				 sizeof(*snapshot));
+	da_push_back(list->snapshots, &snapshot);
+	return snapshot;
+}
+
+/* swaps in a copy of the current callbacks with add appended, or without
+ * the ones marked for removal when purging.  Returns how many of the removed
+ * callbacks held a reference to the signal handler */
+static long callback_list_publish(struct callback_list *list,
+				  struct signal_callback *add, bool purge)
+{
+	struct callback_snapshot *next = callback_list_unused_snapshot(list);
+	struct callback_snapshot *current = list->current;
+	long removed_refs = 0;
+
+	if (current) {
+		da_reserve(next->callbacks, current->callbacks.num + 1);
+
+		for (size_t i = 0; i < current->callbacks.num; i++) {
+			struct signal_callback *cb =
+				current->callbacks.array[i];
+
+			if (purge && os_atomic_load_bool(&cb->remove)) {
+				if (cb->keep_ref)
+					removed_refs++;
+				continue;
+			}
+
+			os_atomic_inc_long(&cb->refs);
+			da_push_back(next->callbacks, &cb);
+		}
+	}
+
+	if (add) {
+		os_atomic_inc_long(&add->refs);
+		da_push_back(next->callbacks, &add);
+	}
+
+	os_atomic_set_ptr((void *volatile *)&list->current, next);
+	return removed_refs;
+}
+
+static struct signal_callback *
+callback_list_find(struct callback_list *list, signal_callback_t callback,
+		   global_signal_callback_t global_callback, void *data)
+{
+	struct callback_snapshot *current = list->current;
+
+	for (size_t i = 0; current && i < current->callbacks.num; i++) {
+		struct signal_callback *cb = current->callbacks.array[i];
+
+		if (cb->callback == callback &&
+		    cb->global_callback == global_callback &&
+		    cb->data == data && !os_atomic_load_bool(&cb->remove))
+			return cb;
+	}
+
+	return NULL;
+}
+
+static void callback_list_add(struct callback_list *list,
+			      signal_callback_t callback,
+			      global_signal_callback_t global_callback,
+			      void *data, bool keep_ref)
+{
+	struct signal_callback *cb;
+
+	pthread_mutex_lock(&list->mutex);
+
+	if (keep_ref ||
+	    !callback_list_find(list, callback, global_callback, data)) {
+		cb = bzalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_SIGNALS),
+				   sizeof(*cb));
+		cb->callback = callback;
+		cb->global_callback = global_callback;
+		cb->data = data;
+		cb->keep_ref = keep_ref;
+
+		callback_list_publish(list, cb, false);
+	}
+
+	pthread_mutex_unlock(&list->mutex);
+}
+
+static bool in_signal_handler(signal_handler_t *handler)
+{
+	for (struct signal_frame *frame = current_frame; frame;
+	     frame = frame->prev) {
+		if (frame->handler == handler)
+			return true;
+	}
+
+	return false;
+}
+
+/* waits for every thread to leave the callback, then drops the reference
+ * the waiter was holding.  The list may be gone by now, which is why the
+ * reference count doesn't rely on the list mutex */
+static void callback_wait(struct signal_callback *cb)
+{
+	while (os_atomic_load_long(&cb->calls) > 0)
+		os_sleep_ms(1);
+
+	callback_release(cb);
+}
+
+static void run_deferred_waits(void)
+{
+	for (size_t i = 0; i < deferred_waits.num; i++)
+		callback_wait(deferred_waits.array[i]);
+
+	da_free(deferred_waits);
+}
+
+/* once this returns, the callback won't be called again.  Outside of any
+ * signal, it also waits for other threads to leave the callback so its data
+ * can be freed; inside one, that wait is deferred */
+static long callback_list_remove(struct callback_list *list,
+				 signal_callback_t callback,
+				 global_signal_callback_t global_callback,
+				 void *data)
+{
+	struct signal_callback *cb;
+	long removed_refs = 0;
+
+	pthread_mutex_lock(&list->mutex);
+
+	cb = callback_list_find(list, callback, global_callback, data);
+	if (cb) {
+		/* set before checking calls, while signalling raises calls
+		 * before checking this */
+		os_atomic_set_bool(&cb->remove, true);
+		removed_refs = callback_list_publish(list, NULL, true);
+		os_atomic_inc_long(&cb->refs);
+	}
+
+	pthread_mutex_unlock(&list->mutex);
+
+	if (cb) {
+		if (current_frame)
+			da_push_back(deferred_waits, &cb);
+		else
+			callback_wait(cb);
+	}
+
+	return removed_refs;
+}
+
+static long callback_list_call(signal_handler_t *handler,
+			       struct callback_list *list, const char *signal,
+			       calldata_t *params)
+{
+	struct callback_snapshot *snapshot = callback_list_pin(list);
+	struct signal_frame frame = {handler, NULL, current_frame};
+	bool removed = false;
+	long removed_refs = 0;
 
-	si = bmalloc(sizeof(struct signal_info));
+	if (!snapshot)
+		return 0;
+
+	current_frame = &frame;
+
+	for (size_t i = 0; i < snapshot->callbacks.num; i++) {
+		struct signal_callback *cb = snapshot->callbacks.array[i];
+
+		os_atomic_inc_long(&cb->calls);
+
+		if (!os_atomic_load_bool(&cb->remove)) {
+			frame.cb = cb;
+
+			if (cb->global_callback)
+				cb->global_callback(cb->data, signal, params);
+			else
+				cb->callback(cb->data, params);
+
+			/* signal_handler_remove_current() */
+			if (os_atomic_load_bool(&cb->remove))
+				removed = true;
+		}
+
+		os_atomic_dec_long(&cb->calls);
+	}
+
+	current_frame = frame.prev;
+	os_atomic_dec_long(&snapshot->readers);
+
+	if (!current_frame && deferred_waits.num)
+		run_deferred_waits();
+
+	if (removed) {
+		pthread_mutex_lock(&list->mutex);
+		removed_refs = callback_list_publish(list, NULL, true);
+		pthread_mutex_unlock(&list->mutex);
+	}
+
+	return removed_refs;
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct signal_info {
+	struct decl_info func;
+	callback_atom_t atom;
+	struct callback_list callbacks;
+
+	struct signal_info *volatile next;
+};
+
+static inline struct signal_info *signal_info_create(struct decl_info *info)
+{
+	struct signal_info *si;
+
+	si = bmalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_SIGNALS),
+			   sizeof(struct signal_info));
 
 	si->func = *info;
+	si->atom = callback_atom_get(info->name);
 	si->next = NULL;
-	si->signalling = false;
-	da_init(si->callbacks);
 
-	if (pthread_mutex_init(&si->mutex, &attr) != 0) {
+	if (!callback_list_init(&si->callbacks)) {
 		blog(LOG_ERROR, "Could not create signal");
 
 		decl_info_free(&si->func);
@@ -67,56 +394,42 @@ static inline struct signal_info *signal_info_create(struct decl_info *info)
 static inline void signal_info_destroy(struct signal_info *si)
 {
 	if (si) {
-		pthread_mutex_destroy(&si->mutex);
+		callback_list_free(&si->callbacks);
 		decl_info_free(&si->func);
-		da_free(si->callbacks);
 		bfree(si);
 	}
 }
 
-static inline size_t signal_get_callback_idx(struct signal_info *si,
-					     signal_callback_t callback,
-					     void *data)
-{
-	for (size_t i = 0; i < si->callbacks.num; i++) {
-		struct signal_callback *sc = si->callbacks.array + i;
-
-		if (sc->callback == callback && sc->data == data)
-			return i;
-	}
-
-	return DARRAY_INVALID;
-}
-
-struct global_callback_info {
-	global_signal_callback_t callback;
-	void *data;
-	long signaling;
-	bool remove;
-};
-
 struct signal_handler {
-	struct signal_info *first;
+	/* only ever appended to, so it can be read without the mutex */
+	struct signal_info *volatile first;
 	pthread_mutex_t mutex;
 	volatile long refs;
 
-	DARRAY(struct global_callback_info) global_callbacks;
-	pthread_mutex_t global_callbacks_mutex;
+	struct callback_list global_callbacks;
 };
 
+static inline struct signal_info *next_signal(struct signal_info *const volatile *link)
+{
+	return os_atomic_load_ptr((void *const volatile *)link);
+}
+
 static struct signal_info *getsignal(signal_handler_t *handler,
-				     const char *name,
+				     callback_atom_t atom,
 				     struct signal_info **p_last)
 {
 	struct signal_info *signal, *last = NULL;
 
-	signal = handler->first;
+	if (!handler)
+		return NULL;
+
+	signal = next_signal(&handler->first);
 	while (signal != NULL) {
-		if (strcmp(signal->func.name, name) == 0)
+		if (atom && signal->atom == atom)
 			break;
 
 		last = signal;
-		signal = signal->next;
+		signal = next_signal(&signal->next);
 	}
 
 	if (p_last)
@@ -128,22 +441,18 @@ static struct signal_info *getsignal(signal_handler_t *handler,
 
 signal_handler_t *signal_handler_create(void)
 {
-	struct signal_handler *handler = bzalloc(sizeof(struct signal_handler));
+	struct signal_handler *handler =
+		bzalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_SIGNALS),
+			      sizeof(struct signal_handler));
 	handler->first = NULL;
 	handler->refs = 1;
 
-	pthread_mutexattr_t attr;
-	if (pthread_mutexattr_init(&attr) != 0)
-		return NULL;
-	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
-		return NULL;
-
 	if (pthread_mutex_init(&handler->mutex, NULL) != 0) {
 		blog(LOG_ERROR, "Couldn't create signal handler mutex!");
 		bfree(handler);
 		return NULL;
 	}
-	if (pthread_mutex_init(&handler->global_callbacks_mutex, &attr) != 0) {
+	if (!callback_list_init(&handler->global_callbacks)) {
 		blog(LOG_ERROR, "Couldn't create signal handler global "
 				"callbacks mutex!");
 		pthread_mutex_destroy(&handler->mutex);
@@ -163,8 +472,7 @@ static void signal_handler_actually_destroy(signal_handler_t *handler)
 		sig = next;
 	}
 
-	da_free(handler->global_callbacks);
-	pthread_mutex_destroy(&handler->global_callbacks_mutex);
+	callback_list_free(&handler->global_callbacks);
 	pthread_mutex_destroy(&handler->mutex);
 	bfree(handler);
 }
@@ -179,7 +487,7 @@ void signal_handler_destroy(signal_handler_t *handler)
 bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 {
 	struct decl_info func = {0};
-	struct signal_info *sig, *last;
+	struct signal_info *sig, *last = NULL;
 	bool success = true;
 
 	if (!parse_decl_string(&func, signal_decl)) {
@@ -189,17 +497,16 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 
 	pthread_mutex_lock(&handler->mutex);
 
-	sig = getsignal(handler, func.name, &last);
+	sig = getsignal(handler, callback_atom_get(func.name), &last);
 	if (sig) {
 		blog(LOG_WARNING, "Signal declaration '%s' exists", func.name);
 		decl_info_free(&func);
 		success = false;
 	} else {
 		sig = signal_info_create(&func);
-		if (!last)
-			handler->first = sig;
-		else
-			last->next = sig;
+		os_atomic_set_ptr(last ? (void *volatile *)&last->next
+				       : (void *volatile *)&handler->first,
+				  sig);
 	}
 
 	pthread_mutex_unlock(&handler->mutex);
@@ -212,17 +519,12 @@ static void signal_handler_connect_internal(signal_handler_t *handler,
 					    signal_callback_t callback,
 					    void *data, bool keep_ref)
 {
-	struct signal_info *sig, *last;
-	struct signal_callback cb_data = {callback, data, false, keep_ref};
-	size_t idx;
+	struct signal_info *sig;
 
 	if (!handler)
 		return;
 
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, signal, &last);
-	pthread_mutex_unlock(&handler->mutex);
-
+	sig = getsignal(handler, callback_atom_find(signal), NULL);
 	if (!sig) {
 		blog(LOG_WARNING,
 		     "signal_handler_connect: "
@@ -233,16 +535,10 @@ static void signal_handler_connect_internal(signal_handler_t *handler,
 
 	/* -------------- */
 
-	pthread_mutex_lock(&sig->mutex);
-
 	if (keep_ref)
 		os_atomic_inc_long(&handler->refs);
 
-	idx = signal_get_callback_idx(sig, callback, data);
-	if (keep_ref || idx == DARRAY_INVALID)
-		da_push_back(sig->callbacks, &cb_data);
-
-	pthread_mutex_unlock(&sig->mutex);
+	callback_list_add(&sig->callbacks, callback, NULL, data, keep_ref);
 }
 
 void signal_handler_connect(signal_handler_t *handler, const char *signal,
@@ -257,170 +553,81 @@ void signal_handler_connect_ref(signal_handler_t *handler, const char *signal,
 	signal_handler_connect_internal(handler, signal, callback, data, true);
 }
 
-static inline struct signal_info *getsignal_locked(signal_handler_t *handler,
-						   const char *name)
+/* references dropped while the handler is signalling are only subtracted,
+ * the handler can't go away underneath the signal */
+static void signal_handler_release_refs(signal_handler_t *handler, long refs,
+					bool signalling)
 {
-	struct signal_info *sig;
-
-	if (!handler)
-		return NULL;
-
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, name, NULL);
-	pthread_mutex_unlock(&handler->mutex);
+	if (!refs)
+		return;
 
-	return sig;
+	if (os_atomic_add_long(&handler->refs, -refs) == 0 && !signalling)
+		signal_handler_actually_destroy(handler);
 }
 
 void signal_handler_disconnect(signal_handler_t *handler, const char *signal,
 			       signal_callback_t callback, void *data)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
-	bool keep_ref = false;
-	size_t idx;
+	struct signal_info *sig =
+		getsignal(handler, callback_atom_find(signal), NULL);
+	long removed_refs;
 
 	if (!sig)
 		return;
 
-	pthread_mutex_lock(&sig->mutex);
-
-	idx = signal_get_callback_idx(sig, callback, data);
-	if (idx != DARRAY_INVALID) {
-		if (sig->signalling) {
-			sig->callbacks.array[idx].remove = true;
-		} else {
-			keep_ref = sig->callbacks.array[idx].keep_ref;
-			da_erase(sig->callbacks, idx);
-		}
-	}
-
-	pthread_mutex_unlock(&sig->mutex);
-
-	if (keep_ref && os_atomic_dec_long(&handler->refs) == 0) {
-		signal_handler_actually_destroy(handler);
-	}
+	removed_refs = callback_list_remove(&sig->callbacks, callback,
+					    NULL, data);
+	signal_handler_release_refs(handler, removed_refs,
+				    in_signal_handler(handler));
 }
 
-static THREAD_LOCAL struct signal_callback *current_signal_cb = NULL;
-static THREAD_LOCAL struct global_callback_info *current_global_cb = NULL;
-
 void signal_handler_remove_current(void)
 {
-	if (current_signal_cb)
-		current_signal_cb->remove = true;
-	else if (current_global_cb)
-		current_global_cb->remove = true;
+	if (current_frame && current_frame->cb)
+		os_atomic_set_bool(&current_frame->cb->remove, true);
 }
 
-void signal_handler_signal(signal_handler_t *handler, const char *signal,
-			   calldata_t *params)
+void signal_handler_signal_id(signal_handler_t *handler,
+			      callback_atom_t signal, calldata_t *params)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
-	long remove_refs = 0;
+	struct signal_info *sig = getsignal(handler, signal, NULL);
+	long removed_refs;
 
 	if (!sig)
 		return;
 
-	pthread_mutex_lock(&sig->mutex);
-	sig->signalling = true;
-
-	for (size_t i = 0; i < sig->callbacks.num; i++) {
-		struct signal_callback *cb = sig->callbacks.array + i;
-		if (!cb->remove) {
-			current_signal_cb = cb;
-			cb->callback(cb->data, params);
-			current_signal_cb = NULL;
-		}
-	}
-
-	for (size_t i = sig->callbacks.num; i > 0; i--) {
-		struct signal_callback *cb = sig->callbacks.array + i - 1;
-		if (cb->remove) {
-			if (cb->keep_ref)
-				remove_refs++;
-
-			da_erase(sig->callbacks, i - 1);
-		}
-	}
-
-	sig->signalling = false;
-	pthread_mutex_unlock(&sig->mutex);
-
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
+	removed_refs = callback_list_call(handler, &sig->callbacks,
+					  sig->func.name, params);
+	callback_list_call(handler, &handler->global_callbacks, sig->func.name,
+			   params);
 
-	if (handler->global_callbacks.num) {
-		for (size_t i = 0; i < handler->global_callbacks.num; i++) {
-			struct global_callback_info *cb =
-				handler->global_callbacks.array + i;
-
-			if (!cb->remove) {
-				cb->signaling++;
-				current_global_cb = cb;
-				cb->callback(cb->data, signal, params);
-				current_global_cb = NULL;
-				cb->signaling--;
-			}
-		}
-
-		for (size_t i = handler->global_callbacks.num; i > 0; i--) {
-			struct global_callback_info *cb =
-				handler->global_callbacks.array + (i - 1);
-
-			if (cb->remove && !cb->signaling)
-				da_erase(handler->global_callbacks, i - 1);
-		}
-	}
-
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	signal_handler_release_refs(handler, removed_refs, true);
+}
 
-	if (remove_refs) {
-		os_atomic_set_long(&handler->refs,
-				   os_atomic_load_long(&handler->refs) -
-					   remove_refs);
-	}
+void signal_handler_signal(signal_handler_t *handler, const char *signal,
+			   calldata_t *params)
+{
+	signal_handler_signal_id(handler, callback_atom_find(signal), params);
 }
 
 void signal_handler_connect_global(signal_handler_t *handler,
 				   global_signal_callback_t callback,
 				   void *data)
 {
-	struct global_callback_info cb_data = {callback, data, 0, false};
-	size_t idx;
-
 	if (!handler || !callback)
 		return;
 
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
-
-	idx = da_find(handler->global_callbacks, &cb_data, 0);
-	if (idx == DARRAY_INVALID)
-		da_push_back(handler->global_callbacks, &cb_data);
-
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	callback_list_add(&handler->global_callbacks, NULL, callback, data,
+			  false);
 }
 
 void signal_handler_disconnect_global(signal_handler_t *handler,
 				      global_signal_callback_t callback,
 				      void *data)
 {
-	struct global_callback_info cb_data = {callback, data, false};
-	size_t idx;
-
 	if (!handler || !callback)
 		return;
 
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
-
-	idx = da_find(handler->global_callbacks, &cb_data, 0);
-	if (idx != DARRAY_INVALID) {
-		struct global_callback_info *cb =
-			handler->global_callbacks.array + idx;
-
-		if (cb->signaling)
-			cb->remove = true;
-		else
-			da_erase(handler->global_callbacks, idx);
-	}
-
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	callback_list_remove(&handler->global_callbacks, NULL,
+			     callback, data);
 }
@@ -62,6 +62,19 @@ EXPORT void signal_handler_connect(signal_handler_t *handler,
 EXPORT void signal_handler_connect_ref(signal_handler_t *handler,
 				       const char *signal,
 				       signal_callback_t callback, void *data);
+/**
+ * Once this returns, the callback won't be called again.  Different threads
+ * can be inside the same signal at once:
+ *
+ * - Called outside of any signal callback, this also waits for other threads
+ *   to return from the callback, so its data can be freed afterwards.
+ * - Called from inside a signal callback, it doesn't wait there, since two
+ *   threads each disconnecting the callback the other is in would deadlock.
+ *   The wait is done once the current thread returns from its outermost
+ *   signal, so the data can only be freed after that, not in the callback.
+ *
+ * The same goes for signal_handler_disconnect_global.
+ */
 EXPORT void signal_handler_disconnect(signal_handler_t *handler,
 				      const char *signal,
 				      signal_callback_t callback, void *data);
@@ -78,6 +91,14 @@ EXPORT void signal_handler_remove_current(void);
 EXPORT void signal_handler_signal(signal_handler_t *handler, const char *signal,
 				  calldata_t *params);
 
+/**
+ * Same as signal_handler_signal, with the signal name already resolved with
+ * callback_atom_get, for signals that are sent often.
+ */
+EXPORT void signal_handler_signal_id(signal_handler_t *handler,
+				     callback_atom_t signal,
+				     calldata_t *params);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,10 +23,12 @@
 #include "../util/circlebuf.h"
 #include "../util/platform.h"
 #include "../util/profiler.h"
+#include "../util/histogram.h"
 #include "../util/util_uint64.h"
 
 #include "audio-io.h"
 #include "audio-resampler.h"
+#include "audio-mix.h"
 #include "obs-internal.h"
 
 extern profiler_name_store_t *obs_get_profiler_name_store(void);
@@ -71,6 +73,8 @@ struct audio_output {
 	void *input_param;
 	pthread_mutex_t input_mutex;
 	struct audio_mix mixes[NUM_RENDERING_MODES][MAX_AUDIO_MIXES];
+
+	struct histogram tick_histogram;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -101,7 +105,8 @@ static bool resample_audio_output(struct audio_input *input,
 }
 
 static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
-				   uint64_t timestamp, uint32_t frames)
+				   uint64_t timestamp, uint32_t frames,
+				   bool recording_shared)
 {
 	struct audio_mix *main_mix = &audio->mixes[OBS_MAIN_AUDIO_RENDERING][mix_idx];
 	struct audio_data main_data;
@@ -110,8 +115,12 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 		&audio->mixes[OBS_STREAMING_AUDIO_RENDERING][mix_idx];
 	struct audio_data streaming_data;
 
+	/* the recording mix is identical to the streaming mix and was not
+	 * rendered separately */
 	struct audio_mix *recording_mix =
-		&audio->mixes[OBS_RECORDING_AUDIO_RENDERING][mix_idx];
+		recording_shared
+			? streaming_mix
+			: &audio->mixes[OBS_RECORDING_AUDIO_RENDERING][mix_idx];
 	struct audio_data recording_data;
 
 	pthread_mutex_lock(&audio->input_mutex);
@@ -125,7 +134,9 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 		struct audio_input *streaming_input =
 			streaming_mix->inputs.array + (i - 1);
 		struct audio_input *recording_input =
-			recording_mix->inputs.array + (i - 1);
+			audio->mixes[OBS_RECORDING_AUDIO_RENDERING][mix_idx]
+				.inputs.array +
+			(i - 1);
 
 		for (size_t i = 0; i < audio->planes; i++) {
 			main_data.data[i] = (uint8_t *)main_mix->buffer[i];
@@ -165,7 +176,8 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 	pthread_mutex_unlock(&audio->input_mutex);
 }
 
-static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
+static inline void clamp_audio_output(struct audio_output *audio, size_t bytes,
+				      bool recording_shared)
 {
 	size_t float_size = bytes / sizeof(float);
 	enum obs_audio_rendering_mode start =
@@ -173,8 +185,9 @@ static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
 					     : OBS_MAIN_AUDIO_RENDERING;
 
 	enum obs_audio_rendering_mode end =
-		get_cached_multiple_rendering() ? OBS_RECORDING_AUDIO_RENDERING
-					     : OBS_MAIN_AUDIO_RENDERING;
+		get_cached_multiple_rendering() && !recording_shared
+			? OBS_RECORDING_AUDIO_RENDERING
+			: start;
 
 	for (enum obs_audio_rendering_mode mode = start; mode <= end; mode++) {
 		for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
@@ -184,17 +197,9 @@ static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
 			if (!mix->inputs.num)
 				continue;
 
-			for (size_t plane = 0; plane < audio->planes; plane++) {
-				float *mix_data = mix->buffer[plane];
-				float *mix_end = &mix_data[float_size];
-
-				while (mix_data < mix_end) {
-					float val = *mix_data;
-					val = (val > 1.0f) ? 1.0f : val;
-					val = (val < -1.0f) ? -1.0f : val;
-					*(mix_data++) = val;
-				}
-			}
+			for (size_t plane = 0; plane < audio->planes; plane++)
+				audio_clamp_floats(mix->buffer[plane],
+						   float_size);
 		}
 	}
 
@@ -207,6 +212,7 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	struct audio_output_data data[NUM_RENDERING_MODES][MAX_AUDIO_MIXES];
 	uint32_t active_mixes = 0;
 	uint64_t new_ts = 0;
+	bool recording_shared = false;
 	bool success;
 
 	enum obs_audio_rendering_mode start =
@@ -236,11 +242,14 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	}
 	pthread_mutex_unlock(&audio->input_mutex);
 
-	/* clear mix buffers */
+	/* clear mix buffers.  the recording mixes are fully written by the
+	 * input callback whenever they differ from the streaming mixes, so
+	 * they never need to be cleared */
 	for (enum obs_audio_rendering_mode mode = start; mode <= end; mode++) {
 		for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 			struct audio_mix *mix = &audio->mixes[mode][mix_idx];
-			memset(mix->buffer, 0, sizeof(mix->buffer));
+			if (mode != OBS_RECORDING_AUDIO_RENDERING)
+				memset(mix->buffer, 0, sizeof(mix->buffer));
 
 			for (size_t i = 0; i < audio->planes; i++)
 				data[mode][mix_idx].data[i] =
@@ -257,12 +266,20 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	if (!success)
 		return;
 
+	/* the callback points the recording mixes at the streaming buffers
+	 * when no source renders differently for the two outputs */
+	if (get_cached_multiple_rendering())
+		recording_shared =
+			data[OBS_RECORDING_AUDIO_RENDERING][0].data[0] ==
+			data[OBS_STREAMING_AUDIO_RENDERING][0].data[0];
+
 	/* clamps audio data to -1.0..1.0 */
-	clamp_audio_output(audio, bytes);
+	clamp_audio_output(audio, bytes, recording_shared);
 
 	/* output */
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
-		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES,
+				recording_shared);
 }
 
 static void *audio_thread(void *param)
@@ -283,12 +300,14 @@ static void *audio_thread(void *param)
 				   "audio_thread(%s)", audio->info.name);
 
 	while (os_event_try(audio->stop_event) == EAGAIN) {
+		uint64_t tick_start;
 		uint64_t cur_time;
 
 		os_sleep_ms(audio_wait_time);
 
 		profile_start(audio_thread_name);
 
+		tick_start = os_gettime_ns();
 		cache_multiple_rendering();
 		cur_time = os_gettime_ns();
 		while (audio_time <= cur_time) {
@@ -300,6 +319,8 @@ static void *audio_thread(void *param)
 			prev_time = audio_time;
 		}
 
+		histogram_record(&audio->tick_histogram,
+				 os_gettime_ns() - tick_start);
 		profile_end(audio_thread_name);
 
 		profile_reenable_thread();
@@ -471,6 +492,9 @@ int audio_output_open(audio_t **audio, struct audio_output_info *info)
 	out->block_size = (planar ? 1 : out->channels) *
 			  get_audio_bytes_per_channel(info->format);
 
+	/* select the mixing kernels before the audio thread starts */
+	audio_mix_get_active_kernels();
+
 	if (pthread_mutexattr_init(&attr) != 0)
 		goto fail;
 	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
@@ -568,3 +592,8 @@ uint32_t audio_output_get_sample_rate(const audio_t *audio)
 {
 	return audio ? audio->info.samples_per_sec : 0;
 }
+
+struct histogram *audio_output_get_tick_histogram(audio_t *audio)
+{
+	return audio ? &audio->tick_histogram : NULL;
+}
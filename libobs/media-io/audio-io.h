@@ -40,6 +40,7 @@ extern "C" {
 
 struct audio_output;
 typedef struct audio_output audio_t;
+struct histogram;
 
 enum audio_format {
 	AUDIO_FORMAT_UNKNOWN,
@@ -85,6 +86,12 @@ struct audio_output_data {
 	float *data[MAX_AUDIO_CHANNELS];
 };
 
+/*
+ * When rendering multiple outputs, the callback may point recording_data at
+ * the streaming_data buffers instead of filling its own, to signal that both
+ * outputs are identical for this tick.  Otherwise it must fully write every
+ * recording_data buffer, as they are not cleared beforehand.
+ */
 typedef bool (*audio_input_callback_t)(void *param, uint64_t start_ts,
 				       uint64_t end_ts, uint64_t *new_ts,
 				       uint32_t active_mixers,
@@ -232,6 +239,13 @@ EXPORT uint32_t audio_output_get_sample_rate(const audio_t *audio);
 EXPORT const struct audio_output_info *
 audio_output_get_info(const audio_t *audio);
 
+/**
+ * Histogram of how long each wakeup of the output thread takes, in ns, from
+ * the input callback through delivery to every connected output.  Owned by
+ * the audio output; the caller may read or reset it.
+ */
+EXPORT struct histogram *audio_output_get_tick_histogram(audio_t *audio);
+
 #ifdef __cplusplus
 }
 #endif
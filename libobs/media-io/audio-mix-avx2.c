@@ -0,0 +1,69 @@
+/******************************************************************************
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "audio-mix.h"
+
+#include "../util/avx2-intrin.h"
+
+#ifdef HAVE_AVX2_INTRIN
+#include <immintrin.h>
+
+/* the leftover samples are handled the same way as the scalar kernels, so
+ * the results stay bit-identical */
+
+AVX2_TARGET static void mix_avx2(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256 d0 = _mm256_loadu_ps(dst + i);
+		__m256 d1 = _mm256_loadu_ps(dst + i + 8);
+		__m256 s0 = _mm256_loadu_ps(src + i);
+		__m256 s1 = _mm256_loadu_ps(src + i + 8);
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(d0, s0));
+		_mm256_storeu_ps(dst + i + 8, _mm256_add_ps(d1, s1));
+	}
+
+	for (; i < count; i++)
+		dst[i] += src[i];
+}
+
+AVX2_TARGET static void clamp_avx2(float *data, size_t count)
+{
+	const __m256 pos_one = _mm256_set1_ps(1.0f);
+	const __m256 neg_one = _mm256_set1_ps(-1.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 val = _mm256_loadu_ps(data + i);
+		val = _mm256_min_ps(pos_one, val);
+		val = _mm256_max_ps(neg_one, val);
+		_mm256_storeu_ps(data + i, val);
+	}
+
+	for (; i < count; i++) {
+		float val = data[i];
+		val = (val > 1.0f) ? 1.0f : val;
+		val = (val < -1.0f) ? -1.0f : val;
+		data[i] = val;
+	}
+}
+
+const struct audio_mix_kernels audio_mix_kernels_avx2 = {
+	.name = "AVX2",
+	.mix = mix_avx2,
+	.clamp = clamp_avx2,
+};
+#endif
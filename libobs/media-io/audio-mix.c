@@ -0,0 +1,166 @@
+/******************************************************************************
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "audio-mix.h"
+
+#include "../util/base.h"
+#include "../util/platform.h"
+#include "../util/threading.h"
+#include "../util/avx2-intrin.h"
+#include "../util/sse-intrin.h"
+
+/* ------------------------------------------------------------------------- */
+/* scalar */
+
+static void mix_scalar(float *dst, const float *src, size_t count)
+{
+	const float *end = src + count;
+
+	while (src < end)
+		*(dst++) += *(src++);
+}
+
+static void clamp_scalar(float *data, size_t count)
+{
+	float *end = data + count;
+
+	while (data < end) {
+		float val = *data;
+		val = (val > 1.0f) ? 1.0f : val;
+		val = (val < -1.0f) ? -1.0f : val;
+		*(data++) = val;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* SSE2 (NEON through simde on ARM) */
+
+static void mix_sse2(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 d0 = _mm_loadu_ps(dst + i);
+		__m128 d1 = _mm_loadu_ps(dst + i + 4);
+		__m128 s0 = _mm_loadu_ps(src + i);
+		__m128 s1 = _mm_loadu_ps(src + i + 4);
+		_mm_storeu_ps(dst + i, _mm_add_ps(d0, s0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(d1, s1));
+	}
+
+	mix_scalar(dst + i, src + i, count - i);
+}
+
+/* min/max operand order matters: with (limit, val) a NaN in val is passed
+ * through unchanged, which matches the scalar comparisons exactly */
+static void clamp_sse2(float *data, size_t count)
+{
+	const __m128 pos_one = _mm_set1_ps(1.0f);
+	const __m128 neg_one = _mm_set1_ps(-1.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 val = _mm_loadu_ps(data + i);
+		val = _mm_min_ps(pos_one, val);
+		val = _mm_max_ps(neg_one, val);
+		_mm_storeu_ps(data + i, val);
+	}
+
+	clamp_scalar(data + i, count - i);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const struct audio_mix_kernels kernels_scalar = {
+	.name = "scalar",
+	.mix = mix_scalar,
+	.clamp = clamp_scalar,
+};
+
+static const struct audio_mix_kernels kernels_sse2 = {
+	.name = "SSE2",
+	.mix = mix_sse2,
+	.clamp = clamp_sse2,
+};
+
+static const struct audio_mix_kernels kernels_neon = {
+	.name = "NEON",
+	.mix = mix_sse2,
+	.clamp = clamp_sse2,
+};
+
+#ifdef HAVE_AVX2_INTRIN
+/* audio-mix-avx2.c */
+extern const struct audio_mix_kernels audio_mix_kernels_avx2;
+#endif
+
+const struct audio_mix_kernels *audio_mix_get_kernels(enum audio_mix_impl impl)
+{
+	switch (impl) {
+	case AUDIO_MIX_IMPL_SCALAR:
+		return &kernels_scalar;
+	case AUDIO_MIX_IMPL_SSE2:
+		return os_cpu_has_feature(OS_CPU_FEATURE_SSE2) ? &kernels_sse2
+							       : NULL;
+	case AUDIO_MIX_IMPL_NEON:
+		return os_cpu_has_feature(OS_CPU_FEATURE_NEON) ? &kernels_neon
+							       : NULL;
+	case AUDIO_MIX_IMPL_AVX2:
+#ifdef HAVE_AVX2_INTRIN
+		return os_cpu_has_feature(OS_CPU_FEATURE_AVX2)
+			       ? &audio_mix_kernels_avx2
+			       : NULL;
+#else
+		return NULL;
+#endif
+	}
+
+	return NULL;
+}
+
+static const struct audio_mix_kernels *select_kernels(void)
+{
+	static const enum audio_mix_impl order[] = {
+		AUDIO_MIX_IMPL_AVX2,
+		AUDIO_MIX_IMPL_SSE2,
+		AUDIO_MIX_IMPL_NEON,
+	};
+
+	for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+		const struct audio_mix_kernels *kernels =
+			audio_mix_get_kernels(order[i]);
+		if (kernels)
+			return kernels;
+	}
+
+	return &kernels_scalar;
+}
+
+static pthread_once_t active_kernels_once = PTHREAD_ONCE_INIT;
+static const struct audio_mix_kernels *active_kernels = NULL;
+
+static void init_active_kernels(void)
+{
+	active_kernels = select_kernels();
+	blog(LOG_INFO, "Audio mixing kernels: %s", active_kernels->name);
+}
+
+/* called for every mixed buffer, so after the first call this is only the
+ * pthread_once check */
+const struct audio_mix_kernels *audio_mix_get_active_kernels(void)
+{
+	pthread_once(&active_kernels_once, init_active_kernels);
+	return active_kernels;
+}
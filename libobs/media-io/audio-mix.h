@@ -0,0 +1,68 @@
+/******************************************************************************
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Float mixing kernels used by the audio pipeline.  The fastest
+ * implementation supported by the CPU is selected the first time the kernels
+ * are requested; all implementations produce bit-identical results.
+ */
+
+enum audio_mix_impl {
+	AUDIO_MIX_IMPL_SCALAR,
+	AUDIO_MIX_IMPL_SSE2,
+	AUDIO_MIX_IMPL_NEON,
+	AUDIO_MIX_IMPL_AVX2,
+};
+
+struct audio_mix_kernels {
+	const char *name;
+
+	/* dst[i] += src[i] */
+	void (*mix)(float *dst, const float *src, size_t count);
+
+	/* data[i] = clamp(data[i], -1.0, 1.0) */
+	void (*clamp)(float *data, size_t count);
+};
+
+/** Returns one implementation's mix and clamp functions, for comparing
+ * them against each other, or NULL if this CPU can't run it */
+EXPORT const struct audio_mix_kernels *
+audio_mix_get_kernels(enum audio_mix_impl impl);
+
+/** Returns the functions audio_mix_floats and audio_clamp_floats use */
+EXPORT const struct audio_mix_kernels *audio_mix_get_active_kernels(void);
+
+static inline void audio_mix_floats(float *dst, const float *src,
+				    size_t count)
+{
+	audio_mix_get_active_kernels()->mix(dst, src, count);
+}
+
+static inline void audio_clamp_floats(float *data, size_t count)
+{
+	audio_mix_get_active_kernels()->clamp(data, count);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,398 @@
+/******************************************************************************
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "format-conversion.h"
+
+#include "../util/avx2-intrin.h"
+
+#ifdef HAVE_AVX2_INTRIN
+#include <immintrin.h>
+#include "format-conversion-sse2.h"
+
+/* returns [Y0..Y7 U0..U7] in the low and [V0..V7 zero] in the high half */
+AVX2_TARGET static inline __m256i split_uyvx_avx2(const uint8_t *img)
+{
+	const __m256i shuffle = _mm256_setr_epi8(
+		1, 5, 9, 13, 0, 4, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1, 1, 5,
+		9, 13, 0, 4, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1);
+	const __m256i permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	__m256i val = _mm256_loadu_si256((const __m256i *)img);
+	val = _mm256_shuffle_epi8(val, shuffle);
+	return _mm256_permutevar8x32_epi32(val, permute);
+}
+
+/* averages the chroma of two split lines into [U0..U3 V0..V3] */
+AVX2_TARGET static inline __m128i average_chroma_avx2(__m256i line1,
+						      __m256i line2)
+{
+	__m128i u1 = _mm_cvtepu8_epi16(
+		_mm_srli_si128(_mm256_castsi256_si128(line1), 8));
+	__m128i u2 = _mm_cvtepu8_epi16(
+		_mm_srli_si128(_mm256_castsi256_si128(line2), 8));
+	__m128i v1 = _mm_cvtepu8_epi16(_mm256_extracti128_si256(line1, 1));
+	__m128i v2 = _mm_cvtepu8_epi16(_mm256_extracti128_si256(line2, 1));
+
+	__m128i sum = _mm_hadd_epi16(_mm_add_epi16(u1, u2),
+				     _mm_add_epi16(v1, v2));
+	sum = _mm_srli_epi16(sum, 2);
+	return _mm_packus_epi16(sum, sum);
+}
+
+AVX2_TARGET static void
+compress_uyvx_to_i420_avx2(const uint8_t *input, uint32_t in_linesize,
+			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			   const uint32_t out_linesize[])
+{
+	uint8_t *lum_plane = output[0];
+	uint8_t *u_plane = output[1];
+	uint8_t *v_plane = output[2];
+	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i uv_mask = _mm_set1_epi16(0x00FF);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos = y * in_linesize;
+		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
+		uint32_t lum_y_pos = y * out_linesize[0];
+		uint32_t x = 0;
+
+		for (; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+			uint32_t chroma_pos = chroma_y_pos + (x >> 1);
+
+			__m256i line1 = split_uyvx_avx2(img);
+			__m256i line2 = split_uyvx_avx2(img + in_linesize);
+			__m128i uv = average_chroma_avx2(line1, line2);
+
+			_mm_storel_epi64((__m128i *)(lum_plane + lum_pos0),
+					 _mm256_castsi256_si128(line1));
+			_mm_storel_epi64((__m128i *)(lum_plane + lum_pos1),
+					 _mm256_castsi256_si128(line2));
+			*(uint32_t *)(u_plane + chroma_pos) =
+				(uint32_t)_mm_cvtsi128_si32(uv);
+			*(uint32_t *)(v_plane + chroma_pos) =
+				(uint32_t)_mm_cvtsi128_si32(
+					_mm_srli_si128(uv, 4));
+		}
+
+		for (; x < width; x += 4) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+
+			__m128i line1 = _mm_load_si128((const __m128i *)img);
+			__m128i line2 = _mm_load_si128(
+				(const __m128i *)(img + in_linesize));
+
+			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2,
+				   lum_mask, 1);
+			pack_ch_2plane(u_plane, v_plane,
+				       chroma_y_pos + (x >> 1), line1, line2,
+				       uv_mask);
+		}
+	}
+}
+
+AVX2_TARGET static void
+compress_uyvx_to_nv12_avx2(const uint8_t *input, uint32_t in_linesize,
+			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			   const uint32_t out_linesize[])
+{
+	uint8_t *lum_plane = output[0];
+	uint8_t *chroma_plane = output[1];
+	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i uv_mask = _mm_set1_epi16(0x00FF);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos = y * in_linesize;
+		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
+		uint32_t lum_y_pos = y * out_linesize[0];
+		uint32_t x = 0;
+
+		for (; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+
+			__m256i line1 = split_uyvx_avx2(img);
+			__m256i line2 = split_uyvx_avx2(img + in_linesize);
+			__m128i uv = average_chroma_avx2(line1, line2);
+			uv = _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 4));
+
+			_mm_storel_epi64((__m128i *)(lum_plane + lum_pos0),
+					 _mm256_castsi256_si128(line1));
+			_mm_storel_epi64((__m128i *)(lum_plane + lum_pos1),
+					 _mm256_castsi256_si128(line2));
+			_mm_storel_epi64(
+				(__m128i *)(chroma_plane + chroma_y_pos + x),
+				uv);
+		}
+
+		for (; x < width; x += 4) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+
+			__m128i line1 = _mm_load_si128((const __m128i *)img);
+			__m128i line2 = _mm_load_si128(
+				(const __m128i *)(img + in_linesize));
+
+			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2,
+				   lum_mask, 1);
+			pack_ch_1plane(chroma_plane, chroma_y_pos + x, line1,
+				       line2, uv_mask);
+		}
+	}
+}
+
+AVX2_TARGET static inline void store_444_avx2(uint8_t *output[],
+					      uint32_t pos, __m256i line)
+{
+	__m128i lo = _mm256_castsi256_si128(line);
+
+	_mm_storel_epi64((__m128i *)(output[0] + pos), lo);
+	_mm_storel_epi64((__m128i *)(output[1] + pos), _mm_srli_si128(lo, 8));
+	_mm_storel_epi64((__m128i *)(output[2] + pos),
+			 _mm256_extracti128_si256(line, 1));
+}
+
+AVX2_TARGET static void
+convert_uyvx_to_i444_avx2(const uint8_t *input, uint32_t in_linesize,
+			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			  const uint32_t out_linesize[])
+{
+	uint8_t *lum_plane = output[0];
+	uint8_t *u_plane = output[1];
+	uint8_t *v_plane = output[2];
+	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i u_mask = _mm_set1_epi32(0x000000FF);
+	__m128i v_mask = _mm_set1_epi32(0x00FF0000);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos = y * in_linesize;
+		uint32_t lum_y_pos = y * out_linesize[0];
+		uint32_t x = 0;
+
+		for (; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+
+			store_444_avx2(output, lum_pos0, split_uyvx_avx2(img));
+			store_444_avx2(output, lum_pos1,
+				       split_uyvx_avx2(img + in_linesize));
+		}
+
+		for (; x < width; x += 4) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+
+			__m128i line1 = _mm_load_si128((const __m128i *)img);
+			__m128i line2 = _mm_load_si128(
+				(const __m128i *)(img + in_linesize));
+
+			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2,
+				   lum_mask, 1);
+			pack_val(u_plane, lum_pos0, lum_pos1, line1, line2,
+				 u_mask);
+			pack_shift(v_plane, lum_pos0, lum_pos1, line1, line2,
+				   v_mask, 2);
+		}
+	}
+}
+
+/* expands 8 chroma words into 16 dwords, each word repeated twice */
+AVX2_TARGET static inline void dup_chroma_avx2(__m128i chroma, __m256i *lo,
+					       __m256i *hi)
+{
+	*lo = _mm256_cvtepu16_epi32(_mm_unpacklo_epi16(chroma, chroma));
+	*hi = _mm256_cvtepu16_epi32(_mm_unpackhi_epi16(chroma, chroma));
+}
+
+AVX2_TARGET static inline void unpack_lum_avx2(uint32_t *out,
+					       const uint8_t *lum, int shift,
+					       __m256i chroma_lo,
+					       __m256i chroma_hi)
+{
+	__m256i lum_lo = _mm256_cvtepu8_epi32(
+		_mm_loadl_epi64((const __m128i *)lum));
+	__m256i lum_hi = _mm256_cvtepu8_epi32(
+		_mm_loadl_epi64((const __m128i *)(lum + 8)));
+
+	lum_lo = _mm256_sll_epi32(lum_lo, _mm_cvtsi32_si128(shift));
+	lum_hi = _mm256_sll_epi32(lum_hi, _mm_cvtsi32_si128(shift));
+
+	_mm256_storeu_si256((__m256i *)out, _mm256_or_si256(lum_lo, chroma_lo));
+	_mm256_storeu_si256((__m256i *)(out + 8),
+			    _mm256_or_si256(lum_hi, chroma_hi));
+}
+
+AVX2_TARGET static void decompress_420_avx2(const uint8_t *const input[],
+					    const uint32_t in_linesize[],
+					    uint32_t start_y, uint32_t end_y,
+					    uint8_t *output,
+					    uint32_t out_linesize)
+{
+	uint32_t start_y_d2 = start_y / 2;
+	uint32_t width = in_linesize[0] / 2 * 2;
+	uint32_t height_d2 = end_y / 2;
+	uint32_t y;
+
+	for (y = start_y_d2; y < height_d2; y++) {
+		const uint8_t *chroma0 = input[1] + y * in_linesize[1];
+		const uint8_t *chroma1 = input[2] + y * in_linesize[2];
+		const uint8_t *lum0 = input[0] + y * 2 * in_linesize[0];
+		const uint8_t *lum1 = lum0 + in_linesize[0];
+		uint32_t *output0 = (uint32_t *)(output + y * 2 * out_linesize);
+		uint32_t *output1 =
+			(uint32_t *)((uint8_t *)output0 + out_linesize);
+		uint32_t x = 0;
+
+		for (; x + 16 <= width; x += 16) {
+			__m128i u = _mm_loadl_epi64(
+				(const __m128i *)(chroma0 + x / 2));
+			__m128i v = _mm_loadl_epi64(
+				(const __m128i *)(chroma1 + x / 2));
+			__m256i vu_lo, vu_hi;
+
+			dup_chroma_avx2(_mm_unpacklo_epi8(v, u), &vu_lo,
+					&vu_hi);
+			unpack_lum_avx2(output0 + x, lum0 + x, 16, vu_lo,
+					vu_hi);
+			unpack_lum_avx2(output1 + x, lum1 + x, 16, vu_lo,
+					vu_hi);
+		}
+
+		for (; x < width; x += 2) {
+			uint32_t out = (chroma0[x / 2] << 8) | chroma1[x / 2];
+
+			output0[x] = (lum0[x] << 16) | out;
+			output0[x + 1] = (lum0[x + 1] << 16) | out;
+			output1[x] = (lum1[x] << 16) | out;
+			output1[x + 1] = (lum1[x + 1] << 16) | out;
+		}
+	}
+}
+
+AVX2_TARGET static void decompress_nv12_avx2(const uint8_t *const input[],
+					     const uint32_t in_linesize[],
+					     uint32_t start_y, uint32_t end_y,
+					     uint8_t *output,
+					     uint32_t out_linesize)
+{
+	uint32_t start_y_d2 = start_y / 2;
+	uint32_t width = min_uint32(in_linesize[0], out_linesize) / 2 * 2;
+	uint32_t height_d2 = end_y / 2;
+	uint32_t y;
+
+	for (y = start_y_d2; y < height_d2; y++) {
+		const uint8_t *chroma = input[1] + y * in_linesize[1];
+		const uint8_t *lum0 = input[0] + y * 2 * in_linesize[0];
+		const uint8_t *lum1 = lum0 + in_linesize[0];
+		uint32_t *output0 = (uint32_t *)(output + y * 2 * out_linesize);
+		uint32_t *output1 =
+			(uint32_t *)((uint8_t *)output0 + out_linesize);
+		uint32_t x = 0;
+
+		for (; x + 16 <= width; x += 16) {
+			__m128i uv = _mm_loadu_si128((const __m128i *)(chroma + x));
+			__m256i uv_lo, uv_hi;
+
+			dup_chroma_avx2(uv, &uv_lo, &uv_hi);
+			uv_lo = _mm256_slli_epi32(uv_lo, 8);
+			uv_hi = _mm256_slli_epi32(uv_hi, 8);
+			unpack_lum_avx2(output0 + x, lum0 + x, 0, uv_lo, uv_hi);
+			unpack_lum_avx2(output1 + x, lum1 + x, 0, uv_lo, uv_hi);
+		}
+
+		for (; x < width; x += 2) {
+			uint32_t out = (chroma[x] | (chroma[x + 1] << 8)) << 8;
+
+			output0[x] = lum0[x] | out;
+			output0[x + 1] = lum0[x + 1] | out;
+			output1[x] = lum1[x] | out;
+			output1[x + 1] = lum1[x + 1] | out;
+		}
+	}
+}
+
+AVX2_TARGET static void decompress_422_avx2(const uint8_t *input,
+					    uint32_t in_linesize,
+					    uint32_t start_y, uint32_t end_y,
+					    uint8_t *output,
+					    uint32_t out_linesize,
+					    bool leading_lum)
+{
+	uint32_t width_d2 = min_uint32(in_linesize, out_linesize) / 2;
+	uint32_t keep = leading_lum ? LEADING_LUM_KEEP : LEADING_CHROMA_KEEP;
+	uint32_t dup = leading_lum ? LEADING_LUM_DUP : LEADING_CHROMA_DUP;
+	uint32_t y;
+
+	__m256i keep_mask = _mm256_set1_epi32((int)keep);
+	__m256i dup_mask = _mm256_set1_epi32((int)dup);
+
+	for (y = start_y; y < end_y; y++) {
+		const uint32_t *input32 =
+			(const uint32_t *)(input + y * in_linesize);
+		uint32_t *output32 = (uint32_t *)(output + y * out_linesize);
+		uint32_t x = 0;
+
+		for (; x + 8 <= width_d2; x += 8) {
+			__m256i dw = _mm256_loadu_si256(
+				(const __m256i *)(input32 + x));
+			__m256i dw2 = _mm256_or_si256(
+				_mm256_and_si256(dw, keep_mask),
+				_mm256_and_si256(_mm256_srli_epi32(dw, 16),
+						 dup_mask));
+			__m256i lo = _mm256_unpacklo_epi32(dw, dw2);
+			__m256i hi = _mm256_unpackhi_epi32(dw, dw2);
+
+			_mm256_storeu_si256(
+				(__m256i *)(output32 + x * 2),
+				_mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256(
+				(__m256i *)(output32 + x * 2 + 8),
+				_mm256_permute2x128_si256(lo, hi, 0x31));
+		}
+
+		for (; x < width_d2; x++) {
+			output32[x * 2] = input32[x];
+			output32[x * 2 + 1] = dup_422_lum(input32[x], keep, dup);
+		}
+	}
+}
+
+const struct format_conversion_kernels format_conversion_kernels_avx2 = {
+	.name = "AVX2",
+	.compress_uyvx_to_i420 = compress_uyvx_to_i420_avx2,
+	.compress_uyvx_to_nv12 = compress_uyvx_to_nv12_avx2,
+	.convert_uyvx_to_i444 = convert_uyvx_to_i444_avx2,
+	.decompress_420 = decompress_420_avx2,
+	.decompress_nv12 = decompress_nv12_avx2,
+	.decompress_422 = decompress_422_avx2,
+};
+#endif
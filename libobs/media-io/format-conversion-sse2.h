@@ -0,0 +1,110 @@
+/******************************************************************************
+    Copyright (C) 2013 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+/*
+ * SSE2 packing helpers shared by the SSE2 kernels and the leftover columns
+ * of the AVX2 kernels.  Include sse-intrin.h (or immintrin.h in AVX2 files)
+ * before this.
+ */
+
+/* ...surprisingly, if I don't use a macro to force inlining, it causes the
+ * CPU usage to boost by a tremendous amount in debug builds. */
+
+#define get_m128_32_0(val) (*((uint32_t *)&val))
+#define get_m128_32_1(val) (*(((uint32_t *)&val) + 1))
+
+#define pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, mask, sh)      \
+	do {                                                                   \
+		__m128i pack_val = _mm_packs_epi32(                            \
+			_mm_srli_si128(_mm_and_si128(line1, mask), sh),        \
+			_mm_srli_si128(_mm_and_si128(line2, mask), sh));       \
+		pack_val = _mm_packus_epi16(pack_val, pack_val);               \
+                                                                               \
+		*(uint32_t *)(lum_plane + lum_pos0) = get_m128_32_0(pack_val); \
+		*(uint32_t *)(lum_plane + lum_pos1) = get_m128_32_1(pack_val); \
+	} while (false)
+
+#define pack_val(lum_plane, lum_pos0, lum_pos1, line1, line2, mask)            \
+	do {                                                                   \
+		__m128i pack_val =                                             \
+			_mm_packs_epi32(_mm_and_si128(line1, mask),            \
+					_mm_and_si128(line2, mask));           \
+		pack_val = _mm_packus_epi16(pack_val, pack_val);               \
+                                                                               \
+		*(uint32_t *)(lum_plane + lum_pos0) = get_m128_32_0(pack_val); \
+		*(uint32_t *)(lum_plane + lum_pos1) = get_m128_32_1(pack_val); \
+	} while (false)
+
+#define pack_ch_1plane(uv_plane, chroma_pos, line1, line2, uv_mask)            \
+	do {                                                                   \
+		__m128i add_val =                                              \
+			_mm_add_epi64(_mm_and_si128(line1, uv_mask),           \
+				      _mm_and_si128(line2, uv_mask));          \
+		__m128i avg_val = _mm_add_epi64(                               \
+			add_val,                                               \
+			_mm_shuffle_epi32(add_val, _MM_SHUFFLE(2, 3, 0, 1)));  \
+		avg_val = _mm_srai_epi16(avg_val, 2);                          \
+		avg_val = _mm_shuffle_epi32(avg_val, _MM_SHUFFLE(3, 1, 2, 0)); \
+		avg_val = _mm_packus_epi16(avg_val, avg_val);                  \
+                                                                               \
+		*(uint32_t *)(uv_plane + chroma_pos) = get_m128_32_0(avg_val); \
+	} while (false)
+
+#define pack_ch_2plane(u_plane, v_plane, chroma_pos, line1, line2, uv_mask)    \
+	do {                                                                   \
+		uint32_t packed_vals;                                          \
+                                                                               \
+		__m128i add_val =                                              \
+			_mm_add_epi64(_mm_and_si128(line1, uv_mask),           \
+				      _mm_and_si128(line2, uv_mask));          \
+		__m128i avg_val = _mm_add_epi64(                               \
+			add_val,                                               \
+			_mm_shuffle_epi32(add_val, _MM_SHUFFLE(2, 3, 0, 1)));  \
+		avg_val = _mm_srai_epi16(avg_val, 2);                          \
+		avg_val = _mm_shuffle_epi32(avg_val, _MM_SHUFFLE(3, 1, 2, 0)); \
+		avg_val =                                                      \
+			_mm_shufflelo_epi16(avg_val, _MM_SHUFFLE(3, 1, 2, 0)); \
+		avg_val = _mm_packus_epi16(avg_val, avg_val);                  \
+                                                                               \
+		packed_vals = get_m128_32_0(avg_val);                          \
+                                                                               \
+		*(uint16_t *)(u_plane + chroma_pos) = (uint16_t)(packed_vals); \
+		*(uint16_t *)(v_plane + chroma_pos) =                          \
+			(uint16_t)(packed_vals >> 16);                         \
+	} while (false)
+
+static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
+{
+	return a < b ? a : b;
+}
+
+/* every input dword holds two pixels; the second output pixel is the input
+ * with its first luma byte replaced by the second one */
+#define LEADING_LUM_KEEP 0xFFFFFF00
+#define LEADING_LUM_DUP 0x000000FF
+#define LEADING_CHROMA_KEEP 0xFFFF00FF
+#define LEADING_CHROMA_DUP 0x0000FF00
+
+static FORCE_INLINE uint32_t dup_422_lum(uint32_t dw, uint32_t keep,
+					 uint32_t dup)
+{
+	return (dw & keep) | ((dw >> 16) & dup);
+}
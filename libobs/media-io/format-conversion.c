@@ -17,82 +17,21 @@
 
 #include "format-conversion.h"
 
+#include "../util/base.h"
+#include "../util/platform.h"
+#include "../util/threading.h"
+#include "../util/avx2-intrin.h"
 #include "../util/sse-intrin.h"
+#include "format-conversion-sse2.h"
 
-/* ...surprisingly, if I don't use a macro to force inlining, it causes the
- * CPU usage to boost by a tremendous amount in debug builds. */
-
-#define get_m128_32_0(val) (*((uint32_t *)&val))
-#define get_m128_32_1(val) (*(((uint32_t *)&val) + 1))
-
-#define pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, mask, sh)      \
-	do {                                                                   \
-		__m128i pack_val = _mm_packs_epi32(                            \
-			_mm_srli_si128(_mm_and_si128(line1, mask), sh),        \
-			_mm_srli_si128(_mm_and_si128(line2, mask), sh));       \
-		pack_val = _mm_packus_epi16(pack_val, pack_val);               \
-                                                                               \
-		*(uint32_t *)(lum_plane + lum_pos0) = get_m128_32_0(pack_val); \
-		*(uint32_t *)(lum_plane + lum_pos1) = get_m128_32_1(pack_val); \
-	} while (false)
-
-#define pack_val(lum_plane, lum_pos0, lum_pos1, line1, line2, mask)            \
-	do {                                                                   \
-		__m128i pack_val =                                             \
-			_mm_packs_epi32(_mm_and_si128(line1, mask),            \
-					_mm_and_si128(line2, mask));           \
-		pack_val = _mm_packus_epi16(pack_val, pack_val);               \
-                                                                               \
-		*(uint32_t *)(lum_plane + lum_pos0) = get_m128_32_0(pack_val); \
-		*(uint32_t *)(lum_plane + lum_pos1) = get_m128_32_1(pack_val); \
-	} while (false)
-
-#define pack_ch_1plane(uv_plane, chroma_pos, line1, line2, uv_mask)            \
-	do {                                                                   \
-		__m128i add_val =                                              \
-			_mm_add_epi64(_mm_and_si128(line1, uv_mask),           \
-				      _mm_and_si128(line2, uv_mask));          \
-		__m128i avg_val = _mm_add_epi64(                               \
-			add_val,                                               \
-			_mm_shuffle_epi32(add_val, _MM_SHUFFLE(2, 3, 0, 1)));  \
-		avg_val = _mm_srai_epi16(avg_val, 2);                          \
-		avg_val = _mm_shuffle_epi32(avg_val, _MM_SHUFFLE(3, 1, 2, 0)); \
-		avg_val = _mm_packus_epi16(avg_val, avg_val);                  \
-                                                                               \
-		*(uint32_t *)(uv_plane + chroma_pos) = get_m128_32_0(avg_val); \
-	} while (false)
-
-#define pack_ch_2plane(u_plane, v_plane, chroma_pos, line1, line2, uv_mask)    \
-	do {                                                                   \
-		uint32_t packed_vals;                                          \
-                                                                               \
-		__m128i add_val =                                              \
-			_mm_add_epi64(_mm_and_si128(line1, uv_mask),           \
-				      _mm_and_si128(line2, uv_mask));          \
-		__m128i avg_val = _mm_add_epi64(                               \
-			add_val,                                               \
-			_mm_shuffle_epi32(add_val, _MM_SHUFFLE(2, 3, 0, 1)));  \
-		avg_val = _mm_srai_epi16(avg_val, 2);                          \
-		avg_val = _mm_shuffle_epi32(avg_val, _MM_SHUFFLE(3, 1, 2, 0)); \
-		avg_val =                                                      \
-			_mm_shufflelo_epi16(avg_val, _MM_SHUFFLE(3, 1, 2, 0)); \
-		avg_val = _mm_packus_epi16(avg_val, avg_val);                  \
-                                                                               \
-		packed_vals = get_m128_32_0(avg_val);                          \
-                                                                               \
-		*(uint16_t *)(u_plane + chroma_pos) = (uint16_t)(packed_vals); \
-		*(uint16_t *)(v_plane + chroma_pos) =                          \
-			(uint16_t)(packed_vals >> 16);                         \
-	} while (false)
-
-static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
-{
-	return a < b ? a : b;
-}
+/* ------------------------------------------------------------------------- */
+/* generic: SSE2 packers (NEON through simde on ARM), scalar unpackers */
 
-void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize,
-			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
-			   const uint32_t out_linesize[])
+static void compress_uyvx_to_i420_generic(const uint8_t *input,
+					  uint32_t in_linesize,
+					  uint32_t start_y, uint32_t end_y,
+					  uint8_t *output[],
+					  const uint32_t out_linesize[])
 {
 	uint8_t *lum_plane = output[0];
 	uint8_t *u_plane = output[1];
@@ -127,9 +66,11 @@ void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize,
 	}
 }
 
-void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize,
-			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
-			   const uint32_t out_linesize[])
+static void compress_uyvx_to_nv12_generic(const uint8_t *input,
+					  uint32_t in_linesize,
+					  uint32_t start_y, uint32_t end_y,
+					  uint8_t *output[],
+					  const uint32_t out_linesize[])
 {
 	uint8_t *lum_plane = output[0];
 	uint8_t *chroma_plane = output[1];
@@ -162,9 +103,11 @@ void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize,
 	}
 }
 
-void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize,
-			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
-			  const uint32_t out_linesize[])
+static void convert_uyvx_to_i444_generic(const uint8_t *input,
+					 uint32_t in_linesize,
+					 uint32_t start_y, uint32_t end_y,
+					 uint8_t *output[],
+					 const uint32_t out_linesize[])
 {
 	uint8_t *lum_plane = output[0];
 	uint8_t *u_plane = output[1];
@@ -200,9 +143,10 @@ void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize,
 	}
 }
 
-void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
-		    uint32_t start_y, uint32_t end_y, uint8_t *output,
-		    uint32_t out_linesize)
+static void decompress_420_generic(const uint8_t *const input[],
+				   const uint32_t in_linesize[],
+				   uint32_t start_y, uint32_t end_y,
+				   uint8_t *output, uint32_t out_linesize)
 {
 	uint32_t start_y_d2 = start_y / 2;
 	uint32_t width_d2 = in_linesize[0] / 2;
@@ -234,9 +178,10 @@ void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
 	}
 }
 
-void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
-		     uint32_t start_y, uint32_t end_y, uint8_t *output,
-		     uint32_t out_linesize)
+static void decompress_nv12_generic(const uint8_t *const input[],
+				    const uint32_t in_linesize[],
+				    uint32_t start_y, uint32_t end_y,
+				    uint8_t *output, uint32_t out_linesize)
 {
 	uint32_t start_y_d2 = start_y / 2;
 	uint32_t width_d2 = min_uint32(in_linesize[0], out_linesize) / 2;
@@ -267,9 +212,10 @@ void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
 	}
 }
 
-void decompress_422(const uint8_t *input, uint32_t in_linesize,
-		    uint32_t start_y, uint32_t end_y, uint8_t *output,
-		    uint32_t out_linesize, bool leading_lum)
+static void decompress_422_generic(const uint8_t *input, uint32_t in_linesize,
+				   uint32_t start_y, uint32_t end_y,
+				   uint8_t *output, uint32_t out_linesize,
+				   bool leading_lum)
 {
 	uint32_t width_d2 = min_uint32(in_linesize, out_linesize) / 2;
 	uint32_t y;
@@ -316,3 +262,315 @@ void decompress_422(const uint8_t *input, uint32_t in_linesize,
 		}
 	}
 }
+
+/* ------------------------------------------------------------------------- */
+/* SSE2 unpackers (NEON through simde on ARM) */
+
+static FORCE_INLINE void unpack_420_sse2(uint32_t *out, const uint8_t *lum,
+					 __m128i vu_lo, __m128i vu_hi)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lum_val = _mm_loadu_si128((const __m128i *)lum);
+	__m128i lum_lo = _mm_unpacklo_epi8(lum_val, zero);
+	__m128i lum_hi = _mm_unpackhi_epi8(lum_val, zero);
+
+	_mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi16(vu_lo, lum_lo));
+	_mm_storeu_si128((__m128i *)(out + 4),
+			 _mm_unpackhi_epi16(vu_lo, lum_lo));
+	_mm_storeu_si128((__m128i *)(out + 8),
+			 _mm_unpacklo_epi16(vu_hi, lum_hi));
+	_mm_storeu_si128((__m128i *)(out + 12),
+			 _mm_unpackhi_epi16(vu_hi, lum_hi));
+}
+
+static void decompress_420_sse2(const uint8_t *const input[],
+				const uint32_t in_linesize[], uint32_t start_y,
+				uint32_t end_y, uint8_t *output,
+				uint32_t out_linesize)
+{
+	uint32_t start_y_d2 = start_y / 2;
+	uint32_t width = in_linesize[0] / 2 * 2;
+	uint32_t height_d2 = end_y / 2;
+	uint32_t y;
+
+	for (y = start_y_d2; y < height_d2; y++) {
+		const uint8_t *chroma0 = input[1] + y * in_linesize[1];
+		const uint8_t *chroma1 = input[2] + y * in_linesize[2];
+		const uint8_t *lum0 = input[0] + y * 2 * in_linesize[0];
+		const uint8_t *lum1 = lum0 + in_linesize[0];
+		uint32_t *output0 = (uint32_t *)(output + y * 2 * out_linesize);
+		uint32_t *output1 =
+			(uint32_t *)((uint8_t *)output0 + out_linesize);
+		uint32_t x = 0;
+
+		for (; x + 16 <= width; x += 16) {
+			__m128i u = _mm_loadl_epi64(
+				(const __m128i *)(chroma0 + x / 2));
+			__m128i v = _mm_loadl_epi64(
+				(const __m128i *)(chroma1 + x / 2));
+			__m128i vu = _mm_unpacklo_epi8(v, u);
+			__m128i vu_lo = _mm_unpacklo_epi16(vu, vu);
+			__m128i vu_hi = _mm_unpackhi_epi16(vu, vu);
+
+			unpack_420_sse2(output0 + x, lum0 + x, vu_lo, vu_hi);
+			unpack_420_sse2(output1 + x, lum1 + x, vu_lo, vu_hi);
+		}
+
+		for (; x < width; x += 2) {
+			uint32_t out = (chroma0[x / 2] << 8) | chroma1[x / 2];
+
+			output0[x] = (lum0[x] << 16) | out;
+			output0[x + 1] = (lum0[x + 1] << 16) | out;
+			output1[x] = (lum1[x] << 16) | out;
+			output1[x + 1] = (lum1[x + 1] << 16) | out;
+		}
+	}
+}
+
+static FORCE_INLINE void unpack_nv12_sse2(uint32_t *out, const uint8_t *lum,
+					  __m128i u_lo, __m128i u_hi,
+					  __m128i v_lo, __m128i v_hi)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lum_val = _mm_loadu_si128((const __m128i *)lum);
+	__m128i yu_lo = _mm_or_si128(_mm_unpacklo_epi8(lum_val, zero), u_lo);
+	__m128i yu_hi = _mm_or_si128(_mm_unpackhi_epi8(lum_val, zero), u_hi);
+
+	_mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi16(yu_lo, v_lo));
+	_mm_storeu_si128((__m128i *)(out + 4), _mm_unpackhi_epi16(yu_lo, v_lo));
+	_mm_storeu_si128((__m128i *)(out + 8), _mm_unpacklo_epi16(yu_hi, v_hi));
+	_mm_storeu_si128((__m128i *)(out + 12),
+			 _mm_unpackhi_epi16(yu_hi, v_hi));
+}
+
+static void decompress_nv12_sse2(const uint8_t *const input[],
+				 const uint32_t in_linesize[], uint32_t start_y,
+				 uint32_t end_y, uint8_t *output,
+				 uint32_t out_linesize)
+{
+	uint32_t start_y_d2 = start_y / 2;
+	uint32_t width = min_uint32(in_linesize[0], out_linesize) / 2 * 2;
+	uint32_t height_d2 = end_y / 2;
+	uint32_t y;
+
+	__m128i lo_mask = _mm_set1_epi16(0x00FF);
+
+	for (y = start_y_d2; y < height_d2; y++) {
+		const uint8_t *chroma = input[1] + y * in_linesize[1];
+		const uint8_t *lum0 = input[0] + y * 2 * in_linesize[0];
+		const uint8_t *lum1 = lum0 + in_linesize[0];
+		uint32_t *output0 = (uint32_t *)(output + y * 2 * out_linesize);
+		uint32_t *output1 =
+			(uint32_t *)((uint8_t *)output0 + out_linesize);
+		uint32_t x = 0;
+
+		for (; x + 16 <= width; x += 16) {
+			__m128i uv = _mm_loadu_si128((const __m128i *)(chroma + x));
+			__m128i u = _mm_slli_epi16(uv, 8);
+			__m128i v = _mm_and_si128(_mm_srli_epi16(uv, 8), lo_mask);
+			__m128i u_lo = _mm_unpacklo_epi16(u, u);
+			__m128i u_hi = _mm_unpackhi_epi16(u, u);
+			__m128i v_lo = _mm_unpacklo_epi16(v, v);
+			__m128i v_hi = _mm_unpackhi_epi16(v, v);
+
+			unpack_nv12_sse2(output0 + x, lum0 + x, u_lo, u_hi, v_lo,
+					 v_hi);
+			unpack_nv12_sse2(output1 + x, lum1 + x, u_lo, u_hi, v_lo,
+					 v_hi);
+		}
+
+		for (; x < width; x += 2) {
+			uint32_t out = (chroma[x] | (chroma[x + 1] << 8)) << 8;
+
+			output0[x] = lum0[x] | out;
+			output0[x + 1] = lum0[x + 1] | out;
+			output1[x] = lum1[x] | out;
+			output1[x + 1] = lum1[x + 1] | out;
+		}
+	}
+}
+
+static void decompress_422_sse2(const uint8_t *input, uint32_t in_linesize,
+				uint32_t start_y, uint32_t end_y,
+				uint8_t *output, uint32_t out_linesize,
+				bool leading_lum)
+{
+	uint32_t width_d2 = min_uint32(in_linesize, out_linesize) / 2;
+	uint32_t keep = leading_lum ? LEADING_LUM_KEEP : LEADING_CHROMA_KEEP;
+	uint32_t dup = leading_lum ? LEADING_LUM_DUP : LEADING_CHROMA_DUP;
+	uint32_t y;
+
+	__m128i keep_mask = _mm_set1_epi32((int)keep);
+	__m128i dup_mask = _mm_set1_epi32((int)dup);
+
+	for (y = start_y; y < end_y; y++) {
+		const uint32_t *input32 =
+			(const uint32_t *)(input + y * in_linesize);
+		uint32_t *output32 = (uint32_t *)(output + y * out_linesize);
+		uint32_t x = 0;
+
+		for (; x + 4 <= width_d2; x += 4) {
+			__m128i dw = _mm_loadu_si128(
+				(const __m128i *)(input32 + x));
+			__m128i dw2 = _mm_or_si128(
+				_mm_and_si128(dw, keep_mask),
+				_mm_and_si128(_mm_srli_epi32(dw, 16), dup_mask));
+
+			_mm_storeu_si128((__m128i *)(output32 + x * 2),
+					 _mm_unpacklo_epi32(dw, dw2));
+			_mm_storeu_si128((__m128i *)(output32 + x * 2 + 4),
+					 _mm_unpackhi_epi32(dw, dw2));
+		}
+
+		for (; x < width_d2; x++) {
+			output32[x * 2] = input32[x];
+			output32[x * 2 + 1] = dup_422_lum(input32[x], keep, dup);
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const struct format_conversion_kernels kernels_generic = {
+	.name = "generic",
+	.compress_uyvx_to_i420 = compress_uyvx_to_i420_generic,
+	.compress_uyvx_to_nv12 = compress_uyvx_to_nv12_generic,
+	.convert_uyvx_to_i444 = convert_uyvx_to_i444_generic,
+	.decompress_420 = decompress_420_generic,
+	.decompress_nv12 = decompress_nv12_generic,
+	.decompress_422 = decompress_422_generic,
+};
+
+static const struct format_conversion_kernels kernels_sse2 = {
+	.name = "SSE2",
+	.compress_uyvx_to_i420 = compress_uyvx_to_i420_generic,
+	.compress_uyvx_to_nv12 = compress_uyvx_to_nv12_generic,
+	.convert_uyvx_to_i444 = convert_uyvx_to_i444_generic,
+	.decompress_420 = decompress_420_sse2,
+	.decompress_nv12 = decompress_nv12_sse2,
+	.decompress_422 = decompress_422_sse2,
+};
+
+static const struct format_conversion_kernels kernels_neon = {
+	.name = "NEON",
+	.compress_uyvx_to_i420 = compress_uyvx_to_i420_generic,
+	.compress_uyvx_to_nv12 = compress_uyvx_to_nv12_generic,
+	.convert_uyvx_to_i444 = convert_uyvx_to_i444_generic,
+	.decompress_420 = decompress_420_sse2,
+	.decompress_nv12 = decompress_nv12_sse2,
+	.decompress_422 = decompress_422_sse2,
+};
+
+#ifdef HAVE_AVX2_INTRIN
+/* format-conversion-avx2.c */
+extern const struct format_conversion_kernels format_conversion_kernels_avx2;
+#endif
+
+const struct format_conversion_kernels *
+format_conversion_get_kernels(enum format_conversion_impl impl)
+{
+	switch (impl) {
+	case FORMAT_CONVERSION_IMPL_GENERIC:
+		return &kernels_generic;
+	case FORMAT_CONVERSION_IMPL_SSE2:
+		return os_cpu_has_feature(OS_CPU_FEATURE_SSE2) ? &kernels_sse2
+							       : NULL;
+	case FORMAT_CONVERSION_IMPL_NEON:
+		return os_cpu_has_feature(OS_CPU_FEATURE_NEON) ? &kernels_neon
+							       : NULL;
+	case FORMAT_CONVERSION_IMPL_AVX2:
+#ifdef HAVE_AVX2_INTRIN
+		return os_cpu_has_feature(OS_CPU_FEATURE_AVX2)
+			       ? &format_conversion_kernels_avx2
+			       : NULL;
+#else
+		return NULL;
+#endif
+	}
+
+	return NULL;
+}
+
+static const struct format_conversion_kernels *select_kernels(void)
+{
+	static const enum format_conversion_impl order[] = {
+		FORMAT_CONVERSION_IMPL_AVX2,
+		FORMAT_CONVERSION_IMPL_SSE2,
+		FORMAT_CONVERSION_IMPL_NEON,
+	};
+
+	for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+		const struct format_conversion_kernels *kernels =
+			format_conversion_get_kernels(order[i]);
+		if (kernels)
+			return kernels;
+	}
+
+	return &kernels_generic;
+}
+
+static pthread_once_t active_kernels_once = PTHREAD_ONCE_INIT;
+static const struct format_conversion_kernels *active_kernels = NULL;
+
+static void init_active_kernels(void)
+{
+	active_kernels = select_kernels();
+	blog(LOG_INFO, "Format conversion kernels: %s", active_kernels->name);
+}
+
+/* the first conversion can come from any video or source thread */
+const struct format_conversion_kernels *
+format_conversion_get_active_kernels(void)
+{
+	pthread_once(&active_kernels_once, init_active_kernels);
+	return active_kernels;
+}
+
+void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize,
+			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			   const uint32_t out_linesize[])
+{
+	format_conversion_get_active_kernels()->compress_uyvx_to_i420(
+		input, in_linesize, start_y, end_y, output, out_linesize);
+}
+
+void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize,
+			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			   const uint32_t out_linesize[])
+{
+	format_conversion_get_active_kernels()->compress_uyvx_to_nv12(
+		input, in_linesize, start_y, end_y, output, out_linesize);
+}
+
+void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize,
+			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			  const uint32_t out_linesize[])
+{
+	format_conversion_get_active_kernels()->convert_uyvx_to_i444(
+		input, in_linesize, start_y, end_y, output, out_linesize);
+}
+
+void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
+		    uint32_t start_y, uint32_t end_y, uint8_t *output,
+		    uint32_t out_linesize)
+{
+	format_conversion_get_active_kernels()->decompress_420(
+		input, in_linesize, start_y, end_y, output, out_linesize);
+}
+
+void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
+		     uint32_t start_y, uint32_t end_y, uint8_t *output,
+		     uint32_t out_linesize)
+{
+	format_conversion_get_active_kernels()->decompress_nv12(
+		input, in_linesize, start_y, end_y, output, out_linesize);
+}
+
+void decompress_422(const uint8_t *input, uint32_t in_linesize,
+		    uint32_t start_y, uint32_t end_y, uint8_t *output,
+		    uint32_t out_linesize, bool leading_lum)
+{
+	format_conversion_get_active_kernels()->decompress_422(
+		input, in_linesize, start_y, end_y, output, out_linesize,
+		leading_lum);
+}
@@ -27,6 +27,58 @@ extern "C" {
  * Functions for converting to and from packed 444 YUV
  */
 
+enum format_conversion_impl {
+	FORMAT_CONVERSION_IMPL_GENERIC,
+	FORMAT_CONVERSION_IMPL_SSE2,
+	FORMAT_CONVERSION_IMPL_NEON,
+	FORMAT_CONVERSION_IMPL_AVX2,
+};
+
+/*
+ * Implementations of the conversion functions below.  The fastest one
+ * supported by the CPU is selected on first use; all implementations produce
+ * bit-identical output.
+ */
+struct format_conversion_kernels {
+	const char *name;
+
+	void (*compress_uyvx_to_i420)(const uint8_t *input,
+				      uint32_t in_linesize, uint32_t start_y,
+				      uint32_t end_y, uint8_t *output[],
+				      const uint32_t out_linesize[]);
+	void (*compress_uyvx_to_nv12)(const uint8_t *input,
+				      uint32_t in_linesize, uint32_t start_y,
+				      uint32_t end_y, uint8_t *output[],
+				      const uint32_t out_linesize[]);
+	void (*convert_uyvx_to_i444)(const uint8_t *input,
+				     uint32_t in_linesize, uint32_t start_y,
+				     uint32_t end_y, uint8_t *output[],
+				     const uint32_t out_linesize[]);
+	void (*decompress_420)(const uint8_t *const input[],
+			       const uint32_t in_linesize[], uint32_t start_y,
+			       uint32_t end_y, uint8_t *output,
+			       uint32_t out_linesize);
+	void (*decompress_nv12)(const uint8_t *const input[],
+				const uint32_t in_linesize[], uint32_t start_y,
+				uint32_t end_y, uint8_t *output,
+				uint32_t out_linesize);
+	void (*decompress_422)(const uint8_t *input, uint32_t in_linesize,
+			       uint32_t start_y, uint32_t end_y,
+			       uint8_t *output, uint32_t out_linesize,
+			       bool leading_lum);
+};
+
+/** Returns the set of converters built for impl, or NULL if this CPU lacks
+ * the instructions it needs.  Used by the tests to check that every set
+ * produces the same output */
+EXPORT const struct format_conversion_kernels *
+format_conversion_get_kernels(enum format_conversion_impl impl);
+
+/** Returns the set that compress_uyvx_to_i420() and the other functions
+ * below forward to */
+EXPORT const struct format_conversion_kernels *
+format_conversion_get_active_kernels(void);
+
 EXPORT void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize,
 				  uint32_t start_y, uint32_t end_y,
 				  uint8_t *output[],
@@ -35,52 +35,116 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 #define MAX_CONVERT_BUFFERS 3
 #define MAX_CACHE_SIZE 16
 
+/* frame count and skipped count are packed into a single value so either
+ * thread can update both with one compare-and-swap */
+#define COUNT_BITS 15
+#define COUNT_MASK ((1L << COUNT_BITS) - 1)
+#define MAX_FRAME_COUNT COUNT_MASK
+
+static inline long pack_counts(long count, long skipped)
+{
+	return count | (skipped << COUNT_BITS);
+}
+
+static inline long unpack_count(long counts)
+{
+	return counts & COUNT_MASK;
+}
+
+static inline long unpack_skipped(long counts)
+{
+	return counts >> COUNT_BITS;
+}
+
+/*
+ * The frame cache is a single-producer (graphics thread) single-consumer
+ * (video thread) ring.  Each slot carries a sequence number relative to the
+ * ring position p that maps to it:
+ *
+ *   seq == p                  free, the producer may fill it
+ *   seq == p + 1              published, the consumer may read it
+ *   seq == p + cache_size     consumed, free again for position p + size
+ */
 struct cached_frame_info {
-	struct video_data frame;
-	int skipped;
-	int count;
+	struct video_data frame[NUM_RENDERING_MODES];
+	volatile long counts;
+	volatile long seq;
 };
 
-struct video_input {
+/* Scalers and their output frames are shared by every input that requests
+ * the same conversion, so each distinct target is only scaled once per
+ * frame.  Entries are reference counted by the inputs using them. */
+struct video_scale_cache_entry {
 	struct video_scale_info conversion;
 	video_scaler_t *scaler;
 	struct video_frame frame[MAX_CONVERT_BUFFERS];
 	int cur_frame;
+	long refs;
+
+	/* last scaled result of each rendering mode, valid for the delivery
+	 * whose sequence number is stored in scaled_seq */
+	pthread_mutex_t mutex;
+	uint64_t scaled_seq[NUM_RENDERING_MODES];
+	struct video_data scaled[NUM_RENDERING_MODES];
+};
+
+struct video_input {
+	struct video_scale_info conversion;
+	struct video_scale_cache_entry *scale;
 
 	void (*callback)(void *param, struct video_data *streaming_frame,
 			 struct video_data *recording_frame);
 	void *param;
+
+	struct video_output_input_stats stats;
 };
 
-static inline void video_input_free(struct video_input *input)
-{
-	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
-		video_frame_free(&input->frame[i]);
-	video_scaler_destroy(input->scaler);
-}
+/* Optional worker pool that delivers a frame to several inputs at once.  The
+ * video thread takes part in every round and only returns once every input
+ * has been delivered to, so frames are released exactly as before. */
+#define MAX_FANOUT_WORKERS 4
+
+struct video_fanout {
+	struct video_output *video;
+	pthread_t threads[MAX_FANOUT_WORKERS];
+	os_sem_t *start_sems[MAX_FANOUT_WORKERS];
+	size_t num_threads;
+	os_event_t *done_event;
+	bool stop;
+
+	struct cached_frame_info *cfi;
+	volatile long next_input;
+	volatile long pending;
+};
 
 struct video_output {
 	struct video_output_info info;
 
 	pthread_t thread;
-	pthread_mutex_t data_mutex;
 	bool stop;
 
 	os_sem_t *update_semaphore;
 	uint64_t frame_time;
 	volatile long skipped_frames;
 	volatile long total_frames;
+	volatile long producer_stalls;
+	volatile long consumer_stalls;
 
 	bool initialized;
 
 	pthread_mutex_t input_mutex;
 	DARRAY(struct video_input) inputs;
 	volatile long repeat_input;
+	struct video_fanout *fanout;
+
+	DARRAY(struct video_scale_cache_entry *) scale_cache;
+	uint64_t delivery_seq; /* video thread only */
+	volatile long scale_cache_hits;
+	volatile long scale_cache_misses;
 
-	size_t available_frames;
-	size_t first_added;
-	size_t last_added;
-	struct cached_frame_info caches[NUM_RENDERING_MODES][MAX_CACHE_SIZE];
+	uint64_t write_pos; /* graphics thread only */
+	uint64_t read_pos;  /* video thread only */
+	struct cached_frame_info caches[MAX_CACHE_SIZE];
 
 	volatile bool raw_active;
 	volatile long gpu_refs;
@@ -88,136 +152,399 @@ struct video_output {
 
 /* ------------------------------------------------------------------------- */
 
-static inline bool scale_video_output(struct video_input *input,
-				      struct video_data *data)
+static inline bool scale_info_equal(const struct video_scale_info *a,
+				    const struct video_scale_info *b)
 {
+	return a->format == b->format && a->width == b->width &&
+	       a->height == b->height && a->range == b->range &&
+	       a->colorspace == b->colorspace;
+}
+
+static struct video_scale_cache_entry *
+scale_cache_acquire(struct video_output *video,
+		    const struct video_scale_info *conversion)
+{
+	struct video_scale_cache_entry *entry;
+	struct video_scale_info from = {.format = video->info.format,
+					.width = video->info.width,
+					.height = video->info.height,
+					.range = video->info.range,
+					.colorspace = video->info.colorspace};
+	int ret;
+
+	for (size_t i = 0; i < video->scale_cache.num; i++) {
+		entry = video->scale_cache.array[i];
+		if (scale_info_equal(&entry->conversion, conversion)) {
+			entry->refs++;
+			return entry;
+		}
+	}
+
+	entry = bzalloc(sizeof(*entry));
+	entry->conversion = *conversion;
+	entry->refs = 1;
+
+	ret = video_scaler_create(&entry->scaler, conversion, &from,
+				  VIDEO_SCALE_FAST_BILINEAR);
+	if (ret != VIDEO_SCALER_SUCCESS) {
+		if (ret == VIDEO_SCALER_BAD_CONVERSION)
+			blog(LOG_ERROR, "video_input_init: Bad "
+					"scale conversion type");
+		else
+			blog(LOG_ERROR, "video_input_init: Failed to "
+					"create scaler");
+
+		bfree(entry);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
+		video_frame_init(&entry->frame[i], conversion->format,
+				 conversion->width, conversion->height);
+
+	pthread_mutex_init_value(&entry->mutex);
+	pthread_mutex_init(&entry->mutex, NULL);
+
+	da_push_back(video->scale_cache, &entry);
+	return entry;
+}
+
+static void scale_cache_release(struct video_output *video,
+				struct video_scale_cache_entry *entry)
+{
+	if (!entry || --entry->refs > 0)
+		return;
+
+	da_erase_item(video->scale_cache, &entry);
+
+	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
+		video_frame_free(&entry->frame[i]);
+	video_scaler_destroy(entry->scaler);
+	pthread_mutex_destroy(&entry->mutex);
+	bfree(entry);
+}
+
+static inline void video_input_free(struct video_output *video,
+				    struct video_input *input)
+{
+	scale_cache_release(video, input->scale);
+}
+
+static inline bool scale_video_output(struct video_output *video,
+				      struct video_input *input,
+				      struct video_data *data,
+				      enum obs_video_rendering_mode mode)
+{
+	struct video_scale_cache_entry *entry = input->scale;
 	bool success = true;
 
-	if (input->scaler) {
+	if (!entry)
+		return true;
+
+	pthread_mutex_lock(&entry->mutex);
+
+	if (entry->scaled_seq[mode] == video->delivery_seq) {
+		os_atomic_inc_long(&video->scale_cache_hits);
+
+	} else {
 		struct video_frame *frame;
 
-		if (++input->cur_frame == MAX_CONVERT_BUFFERS)
-			input->cur_frame = 0;
+		if (++entry->cur_frame == MAX_CONVERT_BUFFERS)
+			entry->cur_frame = 0;
 
-		frame = &input->frame[input->cur_frame];
+		frame = &entry->frame[entry->cur_frame];
 
-		success = video_scaler_scale(input->scaler, frame->data,
+		success = video_scaler_scale(entry->scaler, frame->data,
 					     frame->linesize,
 					     (const uint8_t *const *)data->data,
 					     data->linesize);
 
 		if (success) {
 			for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-				data->data[i] = frame->data[i];
-				data->linesize[i] = frame->linesize[i];
+				entry->scaled[mode].data[i] = frame->data[i];
+				entry->scaled[mode].linesize[i] =
+					frame->linesize[i];
 			}
+			entry->scaled_seq[mode] = video->delivery_seq;
 		} else {
 			blog(LOG_WARNING, "video-io: Could not scale frame!");
 		}
+
+		os_atomic_inc_long(&video->scale_cache_misses);
 	}
 
+	if (success) {
+		for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+			data->data[i] = entry->scaled[mode].data[i];
+			data->linesize[i] = entry->scaled[mode].linesize[i];
+		}
+	}
+
+	pthread_mutex_unlock(&entry->mutex);
 	return success;
 }
 
-static inline bool video_output_cur_frame(struct video_output *video)
+static inline struct cached_frame_info *get_slot(struct video_output *video,
+						 uint64_t pos)
 {
-	bool complete;
-	bool skipped;
+	return &video->caches[pos % video->info.cache_size];
+}
 
-	/* -------------------------------- */
+static inline bool slot_ready(struct cached_frame_info *cfi, uint64_t seq)
+{
+	return os_atomic_load_long(&cfi->seq) == (long)seq;
+}
 
-	pthread_mutex_lock(&video->data_mutex);
+static void deliver_to_input(struct video_output *video,
+			     struct video_input *input,
+			     struct cached_frame_info *cfi)
+{
+	uint64_t start = os_gettime_ns();
+	uint64_t latency;
+	bool delivered = false;
 
-	struct cached_frame_info *main_frame_info =
-		&video->caches[OBS_MAIN_VIDEO_RENDERING][video->first_added];
-	struct cached_frame_info *streaming_frame_info =
-		&video->caches[OBS_STREAMING_VIDEO_RENDERING][video->first_added];
-	struct cached_frame_info *recording_frame_info =
-		&video->caches[OBS_RECORDING_VIDEO_RENDERING][video->first_added];
+	if (!obs_get_multiple_rendering()) {
+		struct video_data frame = cfi->frame[OBS_MAIN_VIDEO_RENDERING];
+		if (scale_video_output(video, input, &frame,
+				       OBS_MAIN_VIDEO_RENDERING)) {
+			input->callback(input->param, &frame, &frame);
+			delivered = true;
+		}
+	} else {
+		struct video_data stream_frame =
+			cfi->frame[OBS_STREAMING_VIDEO_RENDERING];
+		struct video_data record_frame =
+			cfi->frame[OBS_RECORDING_VIDEO_RENDERING];
+		if (scale_video_output(video, input, &stream_frame,
+				       OBS_STREAMING_VIDEO_RENDERING) &&
+		    scale_video_output(video, input, &record_frame,
+				       OBS_RECORDING_VIDEO_RENDERING)) {
+			input->callback(input->param, &stream_frame,
+					&record_frame);
+			delivered = true;
+		}
+	}
 
-	pthread_mutex_unlock(&video->data_mutex);
+	latency = os_gettime_ns() - start;
 
-	/* -------------------------------- */
+	if (delivered) {
+		input->stats.delivered_frames++;
+		input->stats.last_latency_ns = latency;
+		input->stats.total_latency_ns += latency;
+		if (latency > input->stats.max_latency_ns)
+			input->stats.max_latency_ns = latency;
+	} else {
+		input->stats.skipped_frames++;
+	}
+}
 
-	pthread_mutex_lock(&video->input_mutex);
+/* ------------------------------------------------------------------------- */
 
-	for (size_t i = 0; i < video->inputs.num; i++) {
-		struct video_input *input = video->inputs.array + i;
-		if (!obs_get_multiple_rendering()) {
-			struct video_data frame = main_frame_info->frame;
-			if (scale_video_output(input, &frame))
-				input->callback(input->param, &frame, &frame);
-		} else {
-			struct video_data stream_frame =
-				streaming_frame_info->frame;
-			struct video_data record_frame =
-				recording_frame_info->frame;
-			if (scale_video_output(input, &stream_frame) &&
-			    scale_video_output(input, &record_frame)) {
-				input->callback(input->param, &stream_frame,
-						&record_frame);
-			}
-		}
+static void fanout_work(struct video_fanout *fanout)
+{
+	struct video_output *video = fanout->video;
+	long idx;
+
+	while ((idx = os_atomic_inc_long(&fanout->next_input) - 1) <
+	       (long)video->inputs.num)
+		deliver_to_input(video, video->inputs.array + idx,
+				 fanout->cfi);
+
+	if (os_atomic_dec_long(&fanout->pending) == 0)
+		os_event_signal(fanout->done_event);
+}
+
+struct fanout_worker_param {
+	struct video_fanout *fanout;
+	size_t idx;
+};
+
+static void *fanout_thread(void *data)
+{
+	struct fanout_worker_param *param = data;
+	struct video_fanout *fanout = param->fanout;
+	size_t idx = param->idx;
+
+	bfree(param);
+
+	os_set_thread_name("video-io: fan-out worker");
+
+	while (os_sem_wait(fanout->start_sems[idx]) == 0) {
+		if (fanout->stop)
+			break;
+
+		fanout_work(fanout);
 	}
 
-	pthread_mutex_unlock(&video->input_mutex);
+	return NULL;
+}
 
-	/* -------------------------------- */
+/* must be called with input_mutex held, which keeps the inputs array from
+ * changing while the workers use it */
+static void fanout_deliver(struct video_fanout *fanout,
+			   struct cached_frame_info *cfi)
+{
+	fanout->cfi = cfi;
+	os_atomic_set_long(&fanout->next_input, 0);
+	os_atomic_set_long(&fanout->pending, (long)fanout->num_threads + 1);
 
-	pthread_mutex_lock(&video->data_mutex);
+	for (size_t i = 0; i < fanout->num_threads; i++)
+		os_sem_post(fanout->start_sems[i]);
 
-	if (!obs_get_multiple_rendering()) {
-		main_frame_info->frame.timestamp += video->frame_time;
-		complete = --main_frame_info->count == 0;
-		skipped = main_frame_info->skipped > 0;
-	} else {
-		streaming_frame_info->frame.timestamp += video->frame_time;
-		complete = --streaming_frame_info->count == 0;
-		skipped = streaming_frame_info->skipped > 0;
+	fanout_work(fanout);
+	os_event_wait(fanout->done_event);
+}
 
-		recording_frame_info->frame.timestamp += video->frame_time;
-		complete = --recording_frame_info->count == 0;
-		skipped = recording_frame_info->skipped > 0;
+static void fanout_destroy(struct video_fanout *fanout)
+{
+	if (!fanout)
+		return;
+
+	fanout->stop = true;
+	for (size_t i = 0; i < fanout->num_threads; i++) {
+		os_sem_post(fanout->start_sems[i]);
+		pthread_join(fanout->threads[i], NULL);
 	}
-	//skip repeat frame
-	if (!complete && !os_atomic_load_long(&video->repeat_input)){
-		if (!obs_get_multiple_rendering()) {
-			main_frame_info->count = 0;
-			os_atomic_add_long(&video->skipped_frames, main_frame_info->skipped);
-			main_frame_info->skipped = 0;
-		} else {
-			streaming_frame_info->count = 0;
-			recording_frame_info->count = 0;
-			os_atomic_add_long(&video->skipped_frames, recording_frame_info->skipped);
-			recording_frame_info->skipped = 0;
-			streaming_frame_info->skipped = 0;
+
+	for (size_t i = 0; i < MAX_FANOUT_WORKERS; i++)
+		os_sem_destroy(fanout->start_sems[i]);
+	os_event_destroy(fanout->done_event);
+	bfree(fanout);
+}
+
+static struct video_fanout *fanout_create(struct video_output *video)
+{
+	struct video_fanout *fanout = bzalloc(sizeof(struct video_fanout));
+	int workers = os_get_logical_cores() - 1;
+
+	if (workers > MAX_FANOUT_WORKERS)
+		workers = MAX_FANOUT_WORKERS;
+	if (workers < 1)
+		workers = 1;
+
+	fanout->video = video;
+
+	if (os_event_init(&fanout->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	for (int i = 0; i < workers; i++) {
+		struct fanout_worker_param *param;
+
+		if (os_sem_init(&fanout->start_sems[i], 0) != 0)
+			goto fail;
+
+		param = bmalloc(sizeof(*param));
+		param->fanout = fanout;
+		param->idx = i;
+
+		if (pthread_create(&fanout->threads[i], NULL, fanout_thread,
+				   param) != 0) {
+			bfree(param);
+			goto fail;
 		}
-		complete = true;
+
+		fanout->num_threads++;
 	}
 
-	if (complete) {
-		if (++video->first_added == video->info.cache_size)
-			video->first_added = 0;
-
-		if (++video->available_frames == video->info.cache_size)
-			video->last_added = video->first_added;
-	} else if (skipped) {
-		if (!obs_get_multiple_rendering()) {
-			--main_frame_info->skipped;
+	return fanout;
+
+fail:
+	blog(LOG_WARNING, "video-io: Failed to create fan-out workers");
+	fanout_destroy(fanout);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline bool video_output_cur_frame(struct video_output *video)
+{
+	enum obs_video_rendering_mode start =
+		obs_get_multiple_rendering() ? OBS_STREAMING_VIDEO_RENDERING
+					     : OBS_MAIN_VIDEO_RENDERING;
+	enum obs_video_rendering_mode end =
+		obs_get_multiple_rendering() ? OBS_RECORDING_VIDEO_RENDERING
+					     : OBS_MAIN_VIDEO_RENDERING;
+	struct cached_frame_info *cfi = get_slot(video, video->read_pos);
+	long counts, new_counts, skipped;
+	bool complete;
+
+	if (!slot_ready(cfi, video->read_pos + 1))
+		return true;
+
+	/* -------------------------------- */
+
+	pthread_mutex_lock(&video->input_mutex);
+
+	/* every delivery (including repeats) gets a new sequence number, which
+	 * is what shared scalers compare against */
+	video->delivery_seq++;
+
+	if (video->fanout && video->inputs.num > 1)
+		fanout_deliver(video->fanout, cfi);
+	else
+		for (size_t i = 0; i < video->inputs.num; i++)
+			deliver_to_input(video, video->inputs.array + i, cfi);
+
+	pthread_mutex_unlock(&video->input_mutex);
+
+	/* -------------------------------- */
+
+	for (enum obs_video_rendering_mode mode = start; mode <= end; mode++)
+		cfi->frame[mode].timestamp += video->frame_time;
+
+	/* the graphics thread may add repeats to this frame concurrently */
+	do {
+		counts = os_atomic_load_long(&cfi->counts);
+		long count = unpack_count(counts) - 1;
+		skipped = unpack_skipped(counts);
+
+		complete = count <= 0;
+
+		//skip repeat frame
+		if (!complete && !os_atomic_load_long(&video->repeat_input)) {
+			new_counts = 0;
+			complete = true;
+		} else if (complete) {
+			new_counts = 0;
+			skipped = 0;
+		} else if (skipped > 0) {
+			new_counts = pack_counts(count, skipped - 1);
+			skipped = 1;
 		} else {
-			--streaming_frame_info->skipped;
-			--recording_frame_info->skipped;
+			new_counts = pack_counts(count, 0);
 		}
-		os_atomic_inc_long(&video->skipped_frames);
-	}
+	} while (!os_atomic_compare_swap_long(&cfi->counts, counts,
+					      new_counts));
 
-	pthread_mutex_unlock(&video->data_mutex);
+	if (skipped)
+		os_atomic_add_long(&video->skipped_frames, skipped);
+
+	if (complete) {
+		os_atomic_set_long(&cfi->seq, (long)(video->read_pos +
+						     video->info.cache_size));
+		video->read_pos++;
+	}
 
 	/* -------------------------------- */
 
 	return complete;
 }
 
+static inline void deliver_frames(struct video_output *video)
+{
+	uint64_t start = os_gettime_ns();
+
+	while (!video->stop && !video_output_cur_frame(video)) {
+		os_atomic_inc_long(&video->total_frames);
+	}
+
+	os_atomic_inc_long(&video->total_frames);
+
+	/* the graphics thread has to repeat frames if this falls behind */
+	if (os_gettime_ns() - start > video->frame_time)
+		os_atomic_inc_long(&video->consumer_stalls);
+}
+
 static void *video_thread(void *param)
 {
 	struct video_output *video = param;
@@ -233,11 +560,7 @@ static void *video_thread(void *param)
 			break;
 
 		profile_start(video_thread_name);
-		while (!video->stop && !video_output_cur_frame(video)) {
-			os_atomic_inc_long(&video->total_frames);
-		}
-
-		os_atomic_inc_long(&video->total_frames);
+		deliver_frames(video);
 		profile_end(video_thread_name);
 
 		profile_reenable_thread();
@@ -259,18 +582,21 @@ static inline void init_cache(struct video_output *video)
 	if (video->info.cache_size > MAX_CACHE_SIZE)
 		video->info.cache_size = MAX_CACHE_SIZE;
 
-       for (enum obs_audio_rendering_mode mode = OBS_MAIN_VIDEO_RENDERING;
-	     mode <= OBS_RECORDING_VIDEO_RENDERING; mode++) {
-		for (size_t i = 0; i < video->info.cache_size; i++) {
+	for (size_t i = 0; i < video->info.cache_size; i++) {
+		struct cached_frame_info *cfi = &video->caches[i];
+
+		for (enum obs_video_rendering_mode mode =
+			     OBS_MAIN_VIDEO_RENDERING;
+		     mode <= OBS_RECORDING_VIDEO_RENDERING; mode++) {
 			struct video_frame *frame;
-			frame = (struct video_frame *)&video->caches[mode][i];
+			frame = (struct video_frame *)&cfi->frame[mode];
 
 			video_frame_init(frame, video->info.format,
 					 video->info.width, video->info.height);
 		}
-	}
 
-	video->available_frames = video->info.cache_size;
+		cfi->seq = (long)i;
+	}
 }
 
 int video_output_open(video_t **video, struct video_output_info *info)
@@ -294,8 +620,6 @@ int video_output_open(video_t **video, struct video_output_info *info)
 		goto fail;
 	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
 		goto fail;
-	if (pthread_mutex_init(&out->data_mutex, &attr) != 0)
-		goto fail;
 	if (pthread_mutex_init(&out->input_mutex, &attr) != 0)
 		goto fail;
 	if (os_sem_init(&out->update_semaphore, 0) != 0)
@@ -321,19 +645,22 @@ void video_output_close(video_t *video)
 
 	video_output_stop(video);
 
+	fanout_destroy(video->fanout);
+
 	for (size_t i = 0; i < video->inputs.num; i++)
-		video_input_free(&video->inputs.array[i]);
+		video_input_free(video, &video->inputs.array[i]);
 	da_free(video->inputs);
-
-	for (enum obs_audio_rendering_mode mode = OBS_MAIN_AUDIO_RENDERING;
-	     mode <= OBS_RECORDING_AUDIO_RENDERING; mode++) {
-		for (size_t i = 0; i < video->info.cache_size; i++)
-			video_frame_free(
-				(struct video_frame *)&video->caches[mode][i]);
+	da_free(video->scale_cache);
+
+	for (size_t i = 0; i < video->info.cache_size; i++) {
+		for (enum obs_video_rendering_mode mode =
+			     OBS_MAIN_VIDEO_RENDERING;
+		     mode <= OBS_RECORDING_VIDEO_RENDERING; mode++)
+			video_frame_free((struct video_frame *)&video->caches[i]
+						 .frame[mode]);
 	}
 
 	os_sem_destroy(video->update_semaphore);
-	pthread_mutex_destroy(&video->data_mutex);
 	pthread_mutex_destroy(&video->input_mutex);
 	bfree(video);
 }
@@ -358,32 +685,9 @@ static inline bool video_input_init(struct video_input *input,
 	if (input->conversion.width != video->info.width ||
 	    input->conversion.height != video->info.height ||
 	    input->conversion.format != video->info.format) {
-		struct video_scale_info from = {.format = video->info.format,
-						.width = video->info.width,
-						.height = video->info.height,
-						.range = video->info.range,
-						.colorspace =
-							video->info.colorspace};
-
-		int ret = video_scaler_create(&input->scaler,
-					      &input->conversion, &from,
-					      VIDEO_SCALE_FAST_BILINEAR);
-		if (ret != VIDEO_SCALER_SUCCESS) {
-			if (ret == VIDEO_SCALER_BAD_CONVERSION)
-				blog(LOG_ERROR, "video_input_init: Bad "
-						"scale conversion type");
-			else
-				blog(LOG_ERROR, "video_input_init: Failed to "
-						"create scaler");
-
+		input->scale = scale_cache_acquire(video, &input->conversion);
+		if (!input->scale)
 			return false;
-		}
-
-		for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
-			video_frame_init(&input->frame[i],
-					 input->conversion.format,
-					 input->conversion.width,
-					 input->conversion.height);
 	}
 
 	return true;
@@ -393,6 +697,10 @@ static inline void reset_frames(video_t *video)
 {
 	os_atomic_set_long(&video->skipped_frames, 0);
 	os_atomic_set_long(&video->total_frames, 0);
+	os_atomic_set_long(&video->producer_stalls, 0);
+	os_atomic_set_long(&video->consumer_stalls, 0);
+	os_atomic_set_long(&video->scale_cache_hits, 0);
+	os_atomic_set_long(&video->scale_cache_misses, 0);
 }
 
 void video_repeat_dec(video_t * video)
@@ -472,9 +780,12 @@ static void log_skipped(video_t *video)
 		     "Video stopped, number of "
 		     "skipped frames due "
 		     "to encoding lag: "
-		     "%ld/%ld (%0.1f%%)",
+		     "%ld/%ld (%0.1f%%), "
+		     "graphics/video thread stalls: %ld/%ld",
 		     video->skipped_frames, video->total_frames,
-		     percentage_skipped);
+		     percentage_skipped,
+		     os_atomic_load_long(&video->producer_stalls),
+		     os_atomic_load_long(&video->consumer_stalls));
 }
 
 void video_output_disconnect(video_t *video,
@@ -490,7 +801,7 @@ void video_output_disconnect(video_t *video,
 
 	size_t idx = video_get_input_idx(video, callback, param);
 	if (idx != DARRAY_INVALID) {
-		video_input_free(video->inputs.array + idx);
+		video_input_free(video, video->inputs.array + idx);
 		da_erase(video->inputs, idx);
 
 		if (video->inputs.num == 0) {
@@ -504,6 +815,61 @@ void video_output_disconnect(video_t *video,
 	pthread_mutex_unlock(&video->input_mutex);
 }
 
+void video_output_set_parallel_delivery(video_t *video, bool enable)
+{
+	if (!video)
+		return;
+
+	pthread_mutex_lock(&video->input_mutex);
+
+	if (enable && !video->fanout) {
+		video->fanout = fanout_create(video);
+	} else if (!enable && video->fanout) {
+		fanout_destroy(video->fanout);
+		video->fanout = NULL;
+	}
+
+	pthread_mutex_unlock(&video->input_mutex);
+}
+
+bool video_output_get_parallel_delivery(video_t *video)
+{
+	bool enabled;
+
+	if (!video)
+		return false;
+
+	pthread_mutex_lock(&video->input_mutex);
+	enabled = video->fanout != NULL;
+	pthread_mutex_unlock(&video->input_mutex);
+
+	return enabled;
+}
+
+bool video_output_get_input_stats(
+	video_t *video,
+	void (*callback)(void *param, struct video_data *streaming_frame,
+			 struct video_data *recording_frame),
+	void *param, struct video_output_input_stats *stats)
+{
+	bool found = false;
+
+	if (!video || !callback || !stats)
+		return false;
+
+	pthread_mutex_lock(&video->input_mutex);
+
+	size_t idx = video_get_input_idx(video, callback, param);
+	if (idx != DARRAY_INVALID) {
+		*stats = video->inputs.array[idx].stats;
+		found = true;
+	}
+
+	pthread_mutex_unlock(&video->input_mutex);
+
+	return found;
+}
+
 bool video_output_active(const video_t *video)
 {
 	if (!video)
@@ -516,10 +882,33 @@ const struct video_output_info *video_output_get_info(const video_t *video)
 	return video ? &video->info : NULL;
 }
 
+/* adds repeats to the most recently published frame, which the video thread
+ * may be consuming at the same time.  fails if it has already finished with
+ * that frame. */
+static bool repeat_last_frame(struct video_output *video, int count)
+{
+	struct cached_frame_info *cfi = get_slot(video, video->write_pos - 1);
+	long counts;
+
+	do {
+		counts = os_atomic_load_long(&cfi->counts);
+		long new_count = unpack_count(counts) + count;
+		long skipped = unpack_skipped(counts) + count;
+
+		if (!unpack_count(counts) || new_count > MAX_FRAME_COUNT ||
+		    skipped > MAX_FRAME_COUNT)
+			return false;
+
+		if (os_atomic_compare_swap_long(&cfi->counts, counts,
+						pack_counts(new_count,
+							    skipped)))
+			return true;
+	} while (true);
+}
+
 bool video_output_lock_frame(video_t *video, struct video_frame **frames,
 			     int count, uint64_t *timestamp)
 {
-	bool locked;
 	enum obs_video_rendering_mode start =
 		obs_get_multiple_rendering() ? OBS_STREAMING_VIDEO_RENDERING
 					     : OBS_MAIN_VIDEO_RENDERING;
@@ -529,37 +918,36 @@ bool video_output_lock_frame(video_t *video, struct video_frame **frames,
 	if (!video)
 		return false;
 
-	pthread_mutex_lock(&video->data_mutex);
+	if (count > MAX_FRAME_COUNT)
+		count = MAX_FRAME_COUNT;
 
-	if (video->available_frames == 0) {
-		for (enum obs_video_rendering_mode mode = start; mode <= end;
-		     mode++) {
-			video->caches[mode][video->last_added].count += count;
-			video->caches[mode][video->last_added].skipped += count;
-		}
-		locked = false;
-	} else {
-		if (video->available_frames != video->info.cache_size) {
-			if (++video->last_added == video->info.cache_size)
-				video->last_added = 0;
-		}
+	/* a second attempt only happens if the video thread finished the last
+	 * frame between the two checks, in which case the ring has room */
+	for (int attempt = 0; attempt < 2; attempt++) {
+		struct cached_frame_info *cfi = get_slot(video, video->write_pos);
 
-		for (enum obs_video_rendering_mode mode = start; mode <= end;
-		     mode++) {
-			struct cached_frame_info *cfi;
-			cfi = &video->caches[mode][video->last_added];
-			cfi->frame.timestamp = timestamp[mode];
-			cfi->count = count;
-			cfi->skipped = 0;
+		if (slot_ready(cfi, video->write_pos)) {
+			for (enum obs_video_rendering_mode mode = start;
+			     mode <= end; mode++) {
+				cfi->frame[mode].timestamp = timestamp[mode];
+				memcpy(frames[mode], &cfi->frame[mode],
+				       sizeof(*frames[mode]));
+			}
 
-			memcpy(frames[mode], &cfi->frame, sizeof(*frames[mode]));
+			os_atomic_set_long(&cfi->counts,
+					   pack_counts(count, 0));
+			return true;
 		}
-		locked = true;
-	}
 
-	pthread_mutex_unlock(&video->data_mutex);
+		if (attempt == 0)
+			os_atomic_inc_long(&video->producer_stalls);
 
-	return locked;
+		if (video->write_pos && repeat_last_frame(video, count))
+			return false;
+	}
+
+	os_atomic_add_long(&video->skipped_frames, count);
+	return false;
 }
 
 void video_output_unlock_frame(video_t *video)
@@ -567,12 +955,12 @@ void video_output_unlock_frame(video_t *video)
 	if (!video)
 		return;
 
-	pthread_mutex_lock(&video->data_mutex);
+	struct cached_frame_info *cfi = get_slot(video, video->write_pos);
 
-	video->available_frames--;
-	os_sem_post(video->update_semaphore);
+	os_atomic_set_long(&cfi->seq, (long)(video->write_pos + 1));
+	video->write_pos++;
 
-	pthread_mutex_unlock(&video->data_mutex);
+	os_sem_post(video->update_semaphore);
 }
 
 uint64_t video_output_get_frame_time(const video_t *video)
@@ -636,6 +1024,31 @@ uint32_t video_output_get_total_frames(const video_t *video)
 	return video ? (uint32_t)os_atomic_load_long(&video->total_frames) : 0;
 }
 
+double video_output_get_scale_cache_hit_rate(const video_t *video)
+{
+	long hits, misses;
+
+	if (!video)
+		return 0.0;
+
+	hits = os_atomic_load_long(&video->scale_cache_hits);
+	misses = os_atomic_load_long(&video->scale_cache_misses);
+
+	return (hits + misses) ? (double)hits / (double)(hits + misses) : 0.0;
+}
+
+uint32_t video_output_get_producer_stalls(const video_t *video)
+{
+	return video ? (uint32_t)os_atomic_load_long(&video->producer_stalls)
+		     : 0;
+}
+
+uint32_t video_output_get_consumer_stalls(const video_t *video)
+{
+	return video ? (uint32_t)os_atomic_load_long(&video->consumer_stalls)
+		     : 0;
+}
+
 /* Note: These four functions below are a very slight bit of a hack.  If the
  * texture encoder thread is active while the raw encoder thread is active, the
  * total frame count will just be doubled while they're both active.  Which is
@@ -247,6 +247,31 @@ EXPORT void video_output_disconnect(video_t *video,
 
 EXPORT bool video_output_active(const video_t *video);
 
+/**
+ * Delivers each frame to the connected inputs concurrently on a small worker
+ * pool instead of one after another on the video thread.  A frame is still
+ * only released once every input has received it.
+ */
+EXPORT void video_output_set_parallel_delivery(video_t *video, bool enable);
+EXPORT bool video_output_get_parallel_delivery(video_t *video);
+
+struct video_output_input_stats {
+	uint64_t delivered_frames;
+	/** frames that could not be scaled for this input */
+	uint64_t skipped_frames;
+	/** time spent scaling the frame and running the input's callback */
+	uint64_t last_latency_ns;
+	uint64_t max_latency_ns;
+	uint64_t total_latency_ns;
+};
+
+/** Gets delivery statistics of the input registered with callback/param */
+EXPORT bool video_output_get_input_stats(
+	video_t *video,
+	void (*callback)(void *param, struct video_data *streaming_frame,
+			 struct video_data *recording_frame),
+	void *param, struct video_output_input_stats *stats);
+
 EXPORT const struct video_output_info *
 video_output_get_info(const video_t *video);
 EXPORT bool video_output_lock_frame(video_t *video, struct video_frame **frame,
@@ -264,6 +289,17 @@ EXPORT double video_output_get_frame_rate(const video_t *video);
 EXPORT uint32_t video_output_get_skipped_frames(const video_t *video);
 EXPORT uint32_t video_output_get_total_frames(const video_t *video);
 
+/** Fraction of scaled frames that were shared with another input requesting
+ * the same conversion instead of being scaled again */
+EXPORT double video_output_get_scale_cache_hit_rate(const video_t *video);
+
+/** Number of times the graphics thread found no free frame in the cache and
+ * had to repeat the previous frame instead */
+EXPORT uint32_t video_output_get_producer_stalls(const video_t *video);
+/** Number of times the video thread took longer than one frame interval to
+ * deliver a frame to its inputs */
+EXPORT uint32_t video_output_get_consumer_stalls(const video_t *video);
+
 extern void video_output_inc_texture_encoders(video_t *video);
 extern void video_output_dec_texture_encoders(video_t *video);
 extern void video_output_inc_texture_frames(video_t *video);
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include "obs-internal.h"
 #include "util/util_uint64.h"
+#include "media-io/audio-mix.h"
 
 struct ts_info {
 	uint64_t start;
@@ -57,21 +58,14 @@ static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
 	return (size_t)util_mul_div64(t, sample_rate, 1000000000ULL);
 }
 
-static inline void mix_audio(struct audio_output_data *main_mixes,
-			     struct audio_output_data *streaming_mixes,
-			     struct audio_output_data *recording_mixes,
-			     obs_source_t *source, size_t channels,
-			     size_t sample_rate, struct ts_info *ts)
+static inline void mix_audio(struct audio_output_data *mixes,
+			     obs_source_t *source,
+			     enum obs_audio_rendering_mode mode,
+			     size_t channels, size_t sample_rate,
+			     struct ts_info *ts)
 {
 	size_t total_floats = AUDIO_OUTPUT_FRAMES;
 	size_t start_point = 0;
-	enum obs_audio_rendering_mode start =
-		get_cached_multiple_rendering() ? OBS_STREAMING_AUDIO_RENDERING
-					     : OBS_MAIN_AUDIO_RENDERING;
-
-	enum obs_audio_rendering_mode end =
-		get_cached_multiple_rendering() ? OBS_RECORDING_AUDIO_RENDERING
-					     : OBS_MAIN_AUDIO_RENDERING;
 
 	if (source->audio_ts < ts->start || ts->end <= source->audio_ts)
 		return;
@@ -85,40 +79,112 @@ static inline void mix_audio(struct audio_output_data *main_mixes,
 		total_floats -= start_point;
 	}
 
-	for (enum obs_audio_rendering_mode mode = start; mode <= end; mode++) {
-		for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-			for (size_t ch = 0; ch < channels; ch++) {
-				register float *mix = NULL;
-				switch (mode) {
-				case OBS_MAIN_AUDIO_RENDERING: {
-					mix = main_mixes[mix_idx].data[ch];
-					break;
-				}
-				case OBS_STREAMING_AUDIO_RENDERING: {
-					mix = streaming_mixes[mix_idx].data[ch];
-					break;
-				}
-				case OBS_RECORDING_AUDIO_RENDERING: {
-					mix = recording_mixes[mix_idx].data[ch];
-					break;
-				}
-				}
-
-				register float *aud =
-					source->audio_output_buf[mode][mix_idx]
-								[ch];
-				register float *end;
-				if(!mix || !aud)
-					return;
-
-				mix += start_point;
-				end = aud + total_floats;
-
-				while (aud < end)
-					*(mix++) += *(aud++);
-			}
+	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *mix = mixes[mix_idx].data[ch];
+			const float *aud =
+				source->audio_output_buf[mode][mix_idx][ch];
+			if (!mix || !aud)
+				return;
+
+			audio_mix_floats(mix + start_point, aud, total_floats);
+		}
+	}
+}
+
+enum mix_filter {
+	MIX_ALL_SOURCES,
+	MIX_SHARED_SOURCES,
+	MIX_DIVERGED_SOURCES,
+};
+
+static inline bool mix_filter_match(const obs_source_t *source,
+				    enum mix_filter filter)
+{
+	switch (filter) {
+	case MIX_SHARED_SOURCES:
+		return !source->audio_outputs_differ;
+	case MIX_DIVERGED_SOURCES:
+		return source->audio_outputs_differ;
+	case MIX_ALL_SOURCES:
+		break;
+	}
+
+	return true;
+}
+
+static void mix_root_nodes(struct obs_core_audio *audio,
+			   struct audio_output_data *mixes,
+			   enum obs_audio_rendering_mode mode,
+			   enum mix_filter filter, size_t channels,
+			   size_t sample_rate, struct ts_info *ts)
+{
+	for (size_t i = 0; i < audio->root_nodes.num; i++) {
+		obs_source_t *source = audio->root_nodes.array[i];
+
+		if (source->audio_pending)
+			continue;
+		if (!mix_filter_match(source, filter))
+			continue;
+
+		pthread_mutex_lock(&source->audio_buf_mutex);
+
+		if (source->audio_output_buf[mode][0][0] && source->audio_ts)
+			mix_audio(mixes, source, mode, channels, sample_rate,
+				  ts);
+
+		pthread_mutex_unlock(&source->audio_buf_mutex);
+	}
+}
+
+static inline bool any_root_node_diverged(struct obs_core_audio *audio)
+{
+	for (size_t i = 0; i < audio->root_nodes.num; i++) {
+		obs_source_t *source = audio->root_nodes.array[i];
+
+		if (!source->audio_pending && source->audio_outputs_differ)
+			return true;
+	}
+
+	return false;
+}
+
+/* Builds the streaming and recording mixes in a single pass over each source
+ * whose streaming and recording output is identical (the common case): such
+ * sources are only mixed into the streaming buffers.  If no source diverges,
+ * the recording mixes are pointed at the streaming buffers, which tells
+ * audio-io to reuse them.  Otherwise the recording mixes start from a copy of
+ * the shared part and only the diverging sources are mixed separately. */
+static void mix_multiple_rendering(struct obs_core_audio *audio,
+				   struct audio_output_data *streaming_mixes,
+				   struct audio_output_data *recording_mixes,
+				   size_t channels, size_t sample_rate,
+				   struct ts_info *ts)
+{
+	mix_root_nodes(audio, streaming_mixes, OBS_STREAMING_AUDIO_RENDERING,
+		       MIX_SHARED_SOURCES, channels, sample_rate, ts);
+
+	if (!any_root_node_diverged(audio)) {
+		for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++)
+			recording_mixes[mix_idx] = streaming_mixes[mix_idx];
+		return;
+	}
+
+	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *dst = recording_mixes[mix_idx].data[ch];
+			float *src = streaming_mixes[mix_idx].data[ch];
+
+			if (dst && src)
+				memcpy(dst, src,
+				       AUDIO_OUTPUT_FRAMES * sizeof(float));
 		}
 	}
+
+	mix_root_nodes(audio, streaming_mixes, OBS_STREAMING_AUDIO_RENDERING,
+		       MIX_DIVERGED_SOURCES, channels, sample_rate, ts);
+	mix_root_nodes(audio, recording_mixes, OBS_RECORDING_AUDIO_RENDERING,
+		       MIX_DIVERGED_SOURCES, channels, sample_rate, ts);
 }
 
 static bool ignore_audio(obs_source_t *source, size_t channels,
@@ -537,9 +603,6 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	struct ts_info ts = {start_ts_in, end_ts_in};
 	size_t audio_size;
 	uint64_t min_ts;
-	enum obs_audio_rendering_mode mode =
-		get_cached_multiple_rendering() ? OBS_STREAMING_AUDIO_RENDERING
-					     : OBS_MAIN_AUDIO_RENDERING;
 
 	da_resize(audio->render_order, 0);
 	da_resize(audio->root_nodes, 0);
@@ -645,23 +708,15 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	/* ------------------------------------------------ */
 	/* mix audio */
 	if (!audio->buffering_wait_ticks) {
-		for (size_t i = 0; i < audio->root_nodes.num; i++) {
-			obs_source_t *source = audio->root_nodes.array[i];
-
-			if (source->audio_pending)
-				continue;
-
-			pthread_mutex_lock(&source->audio_buf_mutex);
-
-			if (source->audio_output_buf[mode]
-						    [0][0] &&
-			    source->audio_ts)
-				mix_audio(main_mixes, streaming_mixes,
-					  recording_mixes, source, channels,
-					  sample_rate, &ts);
-
-			pthread_mutex_unlock(&source->audio_buf_mutex);
-		}
+		if (get_cached_multiple_rendering())
+			mix_multiple_rendering(audio, streaming_mixes,
+					       recording_mixes, channels,
+					       sample_rate, &ts);
+		else
+			mix_root_nodes(audio, main_mixes,
+				       OBS_MAIN_AUDIO_RENDERING,
+				       MIX_ALL_SOURCES, channels, sample_rate,
+				       &ts);
 	}
 
 	/* ------------------------------------------------ */
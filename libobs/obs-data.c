@@ -20,13 +20,16 @@
 #include "util/dstr.h"
 #include "util/darray.h"
 #include "util/platform.h"
+#include "util/array-serializer.h"
 #include "graphics/vec2.h"
 #include "graphics/vec3.h"
 #include "graphics/vec4.h"
 #include "graphics/quat.h"
 #include "obs-data.h"
 
-#include <jansson.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
 
 struct obs_data_item {
 	volatile long ref;
@@ -42,10 +45,18 @@ struct obs_data_item {
 	size_t capacity;
 };
 
+/* items are kept sorted by name; once an object holds enough of them, a
+ * sorted table of the same items is kept alongside the list so that lookups
+ * and insertions can binary search it */
+#define OBS_DATA_INDEX_THRESHOLD 16
+
 struct obs_data {
 	volatile long ref;
 	char *json;
 	struct obs_data_item *first_item;
+	size_t num_items;
+	bool indexed;
+	DARRAY(struct obs_data_item *) index;
 };
 
 struct obs_data_array {
@@ -276,7 +287,8 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 	name_size = get_name_align_size(name);
 	total_size = name_size + sizeof(struct obs_data_item) + size;
 
-	item = bzalloc(total_size);
+	item = bzalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_OBS_DATA),
+			     total_size);
 
 	item->capacity = total_size;
 	item->type = type;
@@ -302,60 +314,158 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 	return item;
 }
 
-static struct obs_data_item **get_item_prev_next(struct obs_data *data,
-						 struct obs_data_item *current)
+/* finds the first indexed item not less than name, returns true if it is a
+ * match */
+static bool index_find(struct obs_data *data, const char *name, size_t *pos)
 {
-	if (!current || !data)
-		return NULL;
+	size_t lo = 0;
+	size_t hi = data->index.num;
 
-	struct obs_data_item **prev_next = &data->first_item;
+	/* loading adds items in order, so check past the end first */
+	if (hi && strcmp(get_item_name(data->index.array[hi - 1]), name) < 0) {
+		*pos = hi;
+		return false;
+	}
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (strcmp(get_item_name(data->index.array[mid]), name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	*pos = lo;
+	return lo < data->index.num &&
+	       strcmp(get_item_name(data->index.array[lo]), name) == 0;
+}
+
+static inline struct obs_data_item **index_prev_next(struct obs_data *data,
+						     size_t pos)
+{
+	return pos ? &data->index.array[pos - 1]->next : &data->first_item;
+}
+
+static void build_index(struct obs_data *data)
+{
 	struct obs_data_item *item = data->first_item;
 
+	da_reserve(data->index, data->num_items);
 	while (item) {
-		if (item == current)
-			return prev_next;
-
-		prev_next = &item->next;
+		da_push_back(data->index, &item);
 		item = item->next;
 	}
 
-	return NULL;
+	data->indexed = true;
 }
 
-static inline void obs_data_item_detach(struct obs_data_item *item)
+static void free_index(struct obs_data *data)
+{
+	da_free(data->index);
+	data->indexed = false;
+}
+
+/* returns the link pointing to the item with the given name, or to where it
+ * would be inserted */
+static struct obs_data_item **find_prev_next(struct obs_data *data,
+					     const char *name)
+{
+	struct obs_data_item **prev_next = &data->first_item;
+
+	if (data->indexed) {
+		size_t pos;
+		index_find(data, name, &pos);
+		return index_prev_next(data, pos);
+	}
+
+	while (*prev_next && strcmp(get_item_name(*prev_next), name) < 0)
+		prev_next = &(*prev_next)->next;
+
+	return prev_next;
+}
+
+static struct obs_data_item **get_item_prev_next(struct obs_data *data,
+						 struct obs_data_item *current)
 {
+	if (!current || !data)
+		return NULL;
+
 	struct obs_data_item **prev_next =
-		get_item_prev_next(item->parent, item);
+		find_prev_next(data, get_item_name(current));
+
+	return *prev_next == current ? prev_next : NULL;
+}
+
+static inline void obs_data_item_detach(struct obs_data_item *item)
+{
+	struct obs_data *data = item->parent;
+	struct obs_data_item **prev_next = get_item_prev_next(data, item);
 
 	if (prev_next) {
+		if (data->indexed) {
+			size_t pos;
+			index_find(data, get_item_name(item), &pos);
+			da_erase(data->index, pos);
+		}
+
 		*prev_next = item->next;
 		item->next = NULL;
+		item->parent = NULL;
+		data->num_items--;
 	}
 }
 
-static inline void obs_data_item_reattach(struct obs_data_item *old_ptr,
-					  struct obs_data_item *new_ptr)
+static void obs_data_item_insert(struct obs_data *data,
+				 struct obs_data_item *item)
 {
-	struct obs_data_item **prev_next =
-		get_item_prev_next(new_ptr->parent, old_ptr);
+	const char *name = get_item_name(item);
+	struct obs_data_item **prev_next;
 
-	if (prev_next)
-		*prev_next = new_ptr;
+	if (!data->indexed && data->num_items + 1 >= OBS_DATA_INDEX_THRESHOLD)
+		build_index(data);
+
+	if (data->indexed) {
+		size_t pos;
+		index_find(data, name, &pos);
+		prev_next = index_prev_next(data, pos);
+		da_insert(data->index, pos, &item);
+	} else {
+		prev_next = find_prev_next(data, name);
+	}
+
+	item->parent = data;
+	item->next = *prev_next;
+	*prev_next = item;
+	data->num_items++;
 }
 
 static struct obs_data_item *
 obs_data_item_ensure_capacity(struct obs_data_item *item)
 {
 	size_t new_size = obs_data_item_total_size(item);
+	struct obs_data *data = item->parent;
+	struct obs_data_item **prev_next;
+	struct obs_data_item **index_slot = NULL;
 	struct obs_data_item *new_item;
 
 	if (item->capacity >= new_size)
 		return item;
 
+	/* find the links to the item before it moves */
+	prev_next = get_item_prev_next(data, item);
+	if (prev_next && data->indexed) {
+		size_t pos;
+		index_find(data, get_item_name(item), &pos);
+		index_slot = &data->index.array[pos];
+	}
+
 	new_item = brealloc(item, new_size);
 	new_item->capacity = new_size;
 
-	obs_data_item_reattach(item, new_item);
+	if (prev_next)
+		*prev_next = new_item;
+	if (index_slot)
+		*index_slot = new_item;
 	return new_item;
 }
 
@@ -469,380 +579,1495 @@ obs_data_item_set_autoselect_data(struct obs_data_item **p_item,
 }
 
 /* ------------------------------------------------------------------------- */
+/* JSON is read directly into obs_data and written directly from it, without
+ * building an intermediate tree.  The rules are the ones jansson applied when
+ * it was used for this (JSON_REJECT_DUPLICATES when reading, the same escaping
+ * and number formatting when writing), so the same text is accepted and the
+ * same text is produced. */
+
+#define JSON_MAX_DEPTH 2048
+
+static struct obs_data_item *get_item(struct obs_data *data, const char *name);
+
+/* returns the length of the UTF-8 sequence at str, or 0 if it is invalid,
+ * overlong, a surrogate half or out of the unicode range */
+static size_t json_utf8_len(const char *str)
+{
+	const uint8_t *s = (const uint8_t *)str;
+	uint32_t val;
+	size_t len;
+
+	if (s[0] < 0x80) {
+		return 1;
+	} else if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+		len = 2;
+		val = s[0] & 0x1F;
+	} else if (s[0] >= 0xE0 && s[0] <= 0xEF) {
+		len = 3;
+		val = s[0] & 0x0F;
+	} else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+		len = 4;
+		val = s[0] & 0x07;
+	} else {
+		return 0;
+	}
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json);
+	for (size_t i = 1; i < len; i++) {
+		if ((s[i] & 0xC0) != 0x80)
+			return 0;
+		val = (val << 6) | (s[i] & 0x3F);
+	}
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
-{
-	const char *item_key;
-	json_t *jitem;
+	if (val > 0x10FFFF || (val >= 0xD800 && val <= 0xDFFF))
+		return 0;
+	if ((len == 3 && val < 0x800) || (len == 4 && val < 0x10000))
+		return 0;
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
-	}
+	return len;
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key,
-					    json_t *jobj)
+static bool json_utf8_valid(const char *str)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	while (*str) {
+		size_t len = json_utf8_len(str);
+		if (!len)
+			return false;
+		str += len;
+	}
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+	return true;
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key,
-				    json_t *jarray)
-{
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
-
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+/* ------------------------------------------------------------------------- */
 
-		if (!json_is_object(jitem))
-			continue;
+struct json_reader {
+	const char *pos;
+	int line;
+	char decimal_point;
+	struct dstr key;
+	struct dstr str;
+	char error[160];
+
+	/* keys and values are usually short enough to never need the heap */
+	char key_buf[128];
+	char str_buf[256];
+};
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
-	}
+struct json_scalar {
+	enum obs_data_type type;
+	enum obs_data_number_type num_type;
+	long long int_val;
+	double double_val;
+	bool bool_val;
+};
 
-	obs_data_set_array(data, key, array);
-	obs_data_array_release(array);
-}
+static bool json_read_object(struct json_reader *r, obs_data_t *data,
+			     int depth);
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array,
+			    int depth);
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json)
+static bool json_error(struct json_reader *r, const char *format, ...)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
-}
-
-/* ------------------------------------------------------------------------- */
+	va_list args;
 
-static inline void set_json_string(json_t *json, const char *name,
-				   obs_data_item_t *item)
-{
-	const char *val = obs_data_item_get_string(item);
-	json_object_set_new(json, name, json_string(val));
+	if (!*r->error) {
+		va_start(args, format);
+		vsnprintf(r->error, sizeof(r->error), format, args);
+		va_end(args);
+	}
+	return false;
 }
 
-static inline void set_json_number(json_t *json, const char *name,
-				   obs_data_item_t *item)
+static inline void json_skip_whitespace(struct json_reader *r)
 {
-	enum obs_data_number_type type = obs_data_item_numtype(item);
+	for (;; r->pos++) {
+		char ch = *r->pos;
 
-	if (type == OBS_DATA_NUM_INT) {
-		long long val = obs_data_item_get_int(item);
-		json_object_set_new(json, name, json_integer(val));
-	} else {
-		double val = obs_data_item_get_double(item);
-		json_object_set_new(json, name, json_real(val));
+		if (ch == '\n')
+			r->line++;
+		else if (ch != ' ' && ch != '\t' && ch != '\r')
+			break;
 	}
 }
 
-static inline void set_json_bool(json_t *json, const char *name,
-				 obs_data_item_t *item)
+static inline void json_str_clear(struct dstr *str)
 {
-	bool val = obs_data_item_get_bool(item);
-	json_object_set_new(json, name, val ? json_true() : json_false());
+	str->len = 0;
+	if (str->array)
+		*str->array = 0;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data);
-static json_t *obs_data_to_full_json(obs_data_t *data);
-
-static inline void set_json_obj(json_t *json, const char *name,
-				obs_data_item_t *item)
+static int32_t json_read_hex4(const char *p)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_json(obj));
-	obs_data_release(obj);
-}
+	int32_t val = 0;
 
-static inline void set_full_json_obj(json_t *json, const char *name,
-	obs_data_item_t *item) {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_full_json(obj));
-	obs_data_release(obj);
+	for (int i = 0; i < 4; i++) {
+		char ch = p[i];
+
+		val <<= 4;
+		if (ch >= '0' && ch <= '9')
+			val |= ch - '0';
+		else if (ch >= 'a' && ch <= 'f')
+			val |= ch - 'a' + 10;
+		else if (ch >= 'A' && ch <= 'F')
+			val |= ch - 'A' + 10;
+		else
+			return -1;
+	}
+
+	return val;
 }
 
-static inline void set_json_array(json_t *json, const char *name,
-				  obs_data_item_t *item)
+static void json_cat_codepoint(struct dstr *str, int32_t val)
 {
-	json_t *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
-	size_t count = obs_data_array_count(array);
+	char buf[4];
+	size_t len;
 
-	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_json(sub_item);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+	if (val < 0x80) {
+		buf[0] = (char)val;
+		len = 1;
+	} else if (val < 0x800) {
+		buf[0] = (char)(0xC0 | (val >> 6));
+		buf[1] = (char)(0x80 | (val & 0x3F));
+		len = 2;
+	} else if (val < 0x10000) {
+		buf[0] = (char)(0xE0 | (val >> 12));
+		buf[1] = (char)(0x80 | ((val >> 6) & 0x3F));
+		buf[2] = (char)(0x80 | (val & 0x3F));
+		len = 3;
+	} else {
+		buf[0] = (char)(0xF0 | (val >> 18));
+		buf[1] = (char)(0x80 | ((val >> 12) & 0x3F));
+		buf[2] = (char)(0x80 | ((val >> 6) & 0x3F));
+		buf[3] = (char)(0x80 | (val & 0x3F));
+		len = 4;
 	}
 
-	json_object_set_new(json, name, jarray);
-	obs_data_array_release(array);
+	dstr_ncat(str, buf, len);
 }
 
-static inline void set_full_json_array(json_t *json, const char *name,
-	obs_data_item_t *item) {
-	json_t           *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
-	size_t           count = obs_data_array_count(array);
+/* reads a \uXXXX escape (or a surrogate pair of them) at p, which points at
+ * the 'u' */
+static bool json_read_unicode_escape(struct json_reader *r, const char **p,
+				     struct dstr *out)
+{
+	int32_t val = json_read_hex4(*p + 1);
 
-	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t     *jitem = obs_data_to_full_json(sub_item);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+	if (val < 0)
+		return json_error(r, "invalid escape");
+	*p += 5;
+
+	if (val >= 0xD800 && val <= 0xDBFF) {
+		int32_t low = -1;
+
+		if ((*p)[0] == '\\' && (*p)[1] == 'u') {
+			low = json_read_hex4(*p + 2);
+			if (low < 0)
+				return json_error(r, "invalid escape");
+		}
+		if (low < 0xDC00 || low > 0xDFFF)
+			return json_error(r, "invalid Unicode '\\u%04X'", val);
+
+		val = ((val - 0xD800) << 10) + (low - 0xDC00) + 0x10000;
+		*p += 6;
+
+	} else if (val >= 0xDC00 && val <= 0xDFFF) {
+		return json_error(r, "invalid Unicode '\\u%04X'", val);
+
+	} else if (val == 0) {
+		return json_error(r, "\\u0000 is not allowed");
 	}
 
-	json_object_set_new(json, name, jarray);
-	obs_data_array_release(array);
+	json_cat_codepoint(out, val);
+	return true;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data)
+/* reads the string at the current position, which points at its opening
+ * quote, unescaped into out */
+static bool json_read_string(struct json_reader *r, struct dstr *out)
 {
-	json_t *json = json_object();
-	obs_data_item_t *item = NULL;
+	const char *p = r->pos + 1;
+	const char *span = p;
 
-	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+	json_str_clear(out);
+
+	for (;;) {
+		uint8_t ch = (uint8_t)*p;
+		size_t len;
+
+		if (ch == '"')
+			break;
+
+		if (ch >= 0x20 && ch < 0x80 && ch != '\\') {
+			p++;
+			continue;
+		}
+
+		if (ch >= 0x80) {
+			len = json_utf8_len(p);
+			if (!len)
+				return json_error(r, "invalid UTF-8 byte 0x%x",
+						  ch);
+			p += len;
+			continue;
+		}
 
-		if (!obs_data_item_has_user_value(item))
+		if (ch == 0)
+			return json_error(r, "premature end of input");
+		if (ch == '\n')
+			return json_error(r, "unexpected newline");
+		if (ch < 0x20)
+			return json_error(r, "control character 0x%x", ch);
+
+		/* escape sequence */
+		dstr_ncat(out, span, p - span);
+		p++;
+
+		switch (*p) {
+		case '"':
+		case '\\':
+		case '/':
+			dstr_cat_ch(out, *p);
+			break;
+		case 'b':
+			dstr_cat_ch(out, '\b');
+			break;
+		case 'f':
+			dstr_cat_ch(out, '\f');
+			break;
+		case 'n':
+			dstr_cat_ch(out, '\n');
+			break;
+		case 'r':
+			dstr_cat_ch(out, '\r');
+			break;
+		case 't':
+			dstr_cat_ch(out, '\t');
+			break;
+		case 'u':
+			if (!json_read_unicode_escape(r, &p, out))
+				return false;
+			span = p;
 			continue;
+		default:
+			return json_error(r, "invalid escape");
+		}
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_json_obj(json, name, item);
-		else if (type == OBS_DATA_ARRAY)
-			set_json_array(json, name, item);
+		span = ++p;
 	}
 
-	return json;
+	dstr_ncat(out, span, p - span);
+	r->pos = p + 1;
+	return true;
+}
+
+static inline bool json_is_digit(char ch)
+{
+	return ch >= '0' && ch <= '9';
 }
 
-static json_t *obs_data_to_full_json(obs_data_t *data)
+static bool json_read_number(struct json_reader *r, struct json_scalar *val)
 {
-	json_t *json = json_object();
-	obs_data_item_t *item = NULL;
+	const char *p = r->pos;
+	bool real = false;
 
-	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name        = get_item_name(item);
+	if (*p == '-')
+		p++;
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_full_json_obj(json, name, item);
-		else if (type == OBS_DATA_ARRAY)
-			set_full_json_array(json, name, item);
+	if (*p == '0') {
+		if (json_is_digit(*++p))
+			return json_error(r, "invalid token");
+	} else if (json_is_digit(*p)) {
+		while (json_is_digit(*++p))
+			;
+	} else {
+		return json_error(r, "invalid token");
 	}
 
-	return json;
-}
+	if (*p == '.') {
+		if (!json_is_digit(*++p))
+			return json_error(r, "invalid token");
+		while (json_is_digit(*++p))
+			;
+		real = true;
+	}
 
-/* ------------------------------------------------------------------------- */
+	if (*p == 'e' || *p == 'E') {
+		p++;
+		if (*p == '+' || *p == '-')
+			p++;
+		if (!json_is_digit(*p))
+			return json_error(r, "invalid token");
+		while (json_is_digit(*++p))
+			;
+		real = true;
+	}
 
-obs_data_t *obs_data_create()
-{
-	struct obs_data *data = bzalloc(sizeof(struct obs_data));
-	data->ref = 1;
+	json_str_clear(&r->str);
+	dstr_ncat(&r->str, r->pos, p - r->pos);
+	r->pos = p;
 
-	return data;
+	val->type = OBS_DATA_NUMBER;
+	errno = 0;
+
+	if (!real) {
+		val->num_type = OBS_DATA_NUM_INT;
+		val->int_val = strtoll(r->str.array, NULL, 10);
+
+		if (errno == ERANGE && val->int_val < 0)
+			return json_error(r, "too big negative integer");
+		if (errno == ERANGE)
+			return json_error(r, "too big integer");
+	} else {
+		char *point;
+
+		if (r->decimal_point != '.' &&
+		    (point = strchr(r->str.array, '.')) != NULL)
+			*point = r->decimal_point;
+
+		val->num_type = OBS_DATA_NUM_DOUBLE;
+		val->double_val = strtod(r->str.array, NULL);
+
+		if (errno == ERANGE && (val->double_val == HUGE_VAL ||
+					val->double_val == -HUGE_VAL))
+			return json_error(r, "real number overflow");
+	}
+
+	return true;
 }
 
-obs_data_t *obs_data_create_from_json(const char *json_string)
+static bool json_read_literal(struct json_reader *r, struct json_scalar *val)
 {
-	obs_data_t *data = obs_data_create();
+	const char *start = r->pos;
+	size_t len;
 
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
+	while ((*r->pos >= 'a' && *r->pos <= 'z') ||
+	       (*r->pos >= 'A' && *r->pos <= 'Z'))
+		r->pos++;
 
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
+	len = r->pos - start;
+
+	if (len == 4 && strncmp(start, "true", 4) == 0) {
+		val->type = OBS_DATA_BOOLEAN;
+		val->bool_val = true;
+	} else if (len == 5 && strncmp(start, "false", 5) == 0) {
+		val->type = OBS_DATA_BOOLEAN;
+		val->bool_val = false;
+	} else if (len == 4 && strncmp(start, "null", 4) == 0) {
+		val->type = OBS_DATA_NULL;
 	} else {
-		blog(LOG_ERROR,
-		     "obs-data.c: [obs_data_create_from_json] "
-		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
-		obs_data_release(data);
-		data = NULL;
+		return json_error(r, "invalid token");
 	}
 
-	return data;
+	return true;
 }
 
-obs_data_t *obs_data_create_from_json_file(const char *json_file)
+/* reads a value that isn't an object or array; strings are left in r->str */
+static bool json_read_scalar(struct json_reader *r, struct json_scalar *val)
 {
-	char *file_data = os_quick_read_utf8_file(json_file);
-	obs_data_t *data = NULL;
+	char ch = *r->pos;
 
-	if (file_data) {
-		data = obs_data_create_from_json(file_data);
-		bfree(file_data);
+	if (ch == '"') {
+		val->type = OBS_DATA_STRING;
+		return json_read_string(r, &r->str);
+	} else if (ch == '-' || json_is_digit(ch)) {
+		return json_read_number(r, val);
+	} else if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')) {
+		return json_read_literal(r, val);
+	} else if (!ch || ch == ',' || ch == ':' || ch == ']' || ch == '}') {
+		return json_error(r, "unexpected token");
 	}
 
-	return data;
+	return json_error(r, "invalid token");
 }
 
-obs_data_t *obs_data_create_from_json_file_safe(const char *json_file,
-						const char *backup_ext)
+static void json_set_scalar(obs_data_t *data, const char *name,
+			    struct json_reader *r, struct json_scalar *val)
 {
-	obs_data_t *file_data = obs_data_create_from_json_file(json_file);
-	if (!file_data && backup_ext && *backup_ext) {
-		struct dstr backup_file = {0};
+	if (val->type == OBS_DATA_STRING)
+		obs_data_set_string(data, name, r->str.array ? r->str.array
+							      : "");
+	else if (val->type == OBS_DATA_BOOLEAN)
+		obs_data_set_bool(data, name, val->bool_val);
+	else if (val->num_type == OBS_DATA_NUM_INT)
+		obs_data_set_int(data, name, val->int_val);
+	else
+		obs_data_set_double(data, name, val->double_val);
+}
 
-		dstr_copy(&backup_file, json_file);
-		if (*backup_ext != '.')
-			dstr_cat(&backup_file, ".");
-		dstr_cat(&backup_file, backup_ext);
+/* null values don't become items, but their names still count towards
+ * duplicate detection, so they're kept in a separate object */
+static bool json_read_member(struct json_reader *r, obs_data_t *data,
+			     obs_data_t **nulls, int depth)
+{
+	size_t count = data->num_items;
+	const char *name;
+	bool success = true;
+	char ch;
 
-		if (os_file_exists(backup_file.array)) {
-			blog(LOG_WARNING,
-			     "obs-data.c: "
-			     "[obs_data_create_from_json_file_safe] "
-			     "attempting backup file");
+	if (!json_read_string(r, &r->key))
+		return false;
 
-			/* delete current file if corrupt to prevent it from
-			 * being backed up again */
-			os_rename(backup_file.array, json_file);
+	name = r->key.array ? r->key.array : "";
+
+	json_skip_whitespace(r);
+	if (*r->pos != ':')
+		return json_error(r, "':' expected");
+	r->pos++;
+	json_skip_whitespace(r);
+
+	if (depth + 1 > JSON_MAX_DEPTH)
+		return json_error(r, "maximum parsing depth reached");
+	if (*nulls && get_item(*nulls, name))
+		return json_error(r, "duplicate object key");
+
+	ch = *r->pos;
+
+	if (ch == '{') {
+		obs_data_t *obj = obs_data_create();
+
+		obs_data_set_obj(data, name, obj);
+		if (data->num_items != count)
+			success = json_read_object(r, obj, depth + 1);
+
+		obs_data_release(obj);
 
-			file_data = obs_data_create_from_json_file(json_file);
+	} else if (ch == '[') {
+		obs_data_array_t *array = obs_data_array_create();
+
+		obs_data_set_array(data, name, array);
+		if (data->num_items != count)
+			success = json_read_array(r, array, depth + 1);
+
+		obs_data_array_release(array);
+
+	} else {
+		struct json_scalar val = {0};
+
+		if (!json_read_scalar(r, &val))
+			return false;
+
+		if (val.type == OBS_DATA_NULL) {
+			if (get_item(data, name))
+				return json_error(r, "duplicate object key");
+
+			if (!*nulls)
+				*nulls = obs_data_create();
+			obs_data_set_bool(*nulls, name, true);
+			return true;
 		}
 
-		dstr_free(&backup_file);
+		json_set_scalar(data, name, r, &val);
 	}
 
-	return file_data;
-}
+	if (data->num_items == count)
+		return json_error(r, "duplicate object key");
 
-void obs_data_addref(obs_data_t *data)
-{
-	if (data)
-		os_atomic_inc_long(&data->ref);
+	return success;
 }
 
-static inline void obs_data_destroy(struct obs_data *data)
+static bool json_read_object(struct json_reader *r, obs_data_t *data,
+			     int depth)
 {
-	struct obs_data_item *item = data->first_item;
+	obs_data_t *nulls = NULL;
+	bool success = false;
 
-	while (item) {
-		struct obs_data_item *next = item->next;
-		obs_data_item_release(&item);
-		item = next;
+	r->pos++;
+	json_skip_whitespace(r);
+
+	if (*r->pos == '}') {
+		r->pos++;
+		return true;
 	}
 
-	/* NOTE: don't use bfree for json text, allocated by json */
-	free(data->json);
-	bfree(data);
-}
+	for (;;) {
+		if (*r->pos != '"') {
+			json_error(r, "string or '}' expected");
+			break;
+		}
 
-void obs_data_release(obs_data_t *data)
-{
-	if (!data)
-		return;
+		if (!json_read_member(r, data, &nulls, depth))
+			break;
 
-	if (os_atomic_dec_long(&data->ref) == 0)
-		obs_data_destroy(data);
+		json_skip_whitespace(r);
+
+		if (*r->pos == '}') {
+			r->pos++;
+			success = true;
+			break;
+		} else if (*r->pos != ',') {
+			json_error(r, "'}' expected");
+			break;
+		}
+
+		r->pos++;
+		json_skip_whitespace(r);
+	}
+
+	obs_data_release(nulls);
+	return success;
 }
 
-const char *obs_data_get_json(obs_data_t *data)
+/* only objects become array items; anything else is validated and dropped */
+static bool json_read_element(struct json_reader *r, obs_data_array_t *array,
+			      int depth)
 {
-	if (!data)
-		return NULL;
+	bool success;
 
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
+	if (depth + 1 > JSON_MAX_DEPTH)
+		return json_error(r, "maximum parsing depth reached");
 
-	json_t *root = obs_data_to_json(data);
-	data->json = json_dumps(root, JSON_PRESERVE_ORDER | JSON_COMPACT);
-	json_decref(root);
+	if (*r->pos == '{') {
+		obs_data_t *obj = obs_data_create();
 
-	return data->json;
-}
+		success = json_read_object(r, obj, depth + 1);
+		if (success)
+			obs_data_array_push_back(array, obj);
 
-const char *obs_data_get_full_json(obs_data_t *data) {
-	if (!data) return NULL;
+		obs_data_release(obj);
 
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
+	} else if (*r->pos == '[') {
+		obs_data_array_t *ignored = obs_data_array_create();
 
-	json_t *root = obs_data_to_full_json(data);
-	data->json = json_dumps(root, JSON_PRESERVE_ORDER | JSON_INDENT(4));
-	json_decref(root);
+		success = json_read_array(r, ignored, depth + 1);
+		obs_data_array_release(ignored);
 
-	return data->json;
-}
+	} else {
+		struct json_scalar val = {0};
+		success = json_read_scalar(r, &val);
+	}
 
-const char *obs_data_get_last_json(obs_data_t *data)
-{
-	return data ? data->json : NULL;
+	return success;
 }
 
-bool obs_data_save_json(obs_data_t *data, const char *file)
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array,
+			    int depth)
 {
-	const char *json = obs_data_get_json(data);
+	r->pos++;
+	json_skip_whitespace(r);
 
-	if (json && *json) {
-		return os_quick_write_utf8_file(file, json, strlen(json),
-						false);
+	if (*r->pos == ']') {
+		r->pos++;
+		return true;
 	}
 
-	return false;
-}
+	for (;;) {
+		if (!json_read_element(r, array, depth))
+			return false;
 
-bool obs_data_save_json_safe(obs_data_t *data, const char *file,
-			     const char *temp_ext, const char *backup_ext)
-{
-	const char *json = obs_data_get_json(data);
+		json_skip_whitespace(r);
 
-	if (json && *json) {
-		return os_quick_write_utf8_file_safe(
-			file, json, strlen(json), false, temp_ext, backup_ext);
-	}
+		if (*r->pos == ']') {
+			r->pos++;
+			return true;
+		} else if (*r->pos != ',') {
+			return json_error(r, "']' expected");
+		}
 
-	return false;
+		r->pos++;
+		json_skip_whitespace(r);
+	}
 }
 
-static void get_defaults_array_cb(obs_data_t *data, void *vp)
+/* a top-level array is accepted but, as before, produces an empty object */
+static bool json_read_root(struct json_reader *r, obs_data_t *data)
 {
-	obs_data_array_t *defs = (obs_data_array_t *)vp;
-	obs_data_t *obs_defaults = obs_data_get_defaults(data);
+	bool success;
 
-	obs_data_array_push_back(defs, obs_defaults);
+	json_skip_whitespace(r);
 
-	obs_data_release(obs_defaults);
+	if (*r->pos == '{') {
+		success = json_read_object(r, data, 1);
+
+	} else if (*r->pos == '[') {
+		obs_data_array_t *ignored = obs_data_array_create();
+
+		success = json_read_array(r, ignored, 1);
+		obs_data_array_release(ignored);
+
+	} else {
+		return json_error(r, "'[' or '{' expected");
+	}
+
+	if (success) {
+		json_skip_whitespace(r);
+		if (*r->pos)
+			return json_error(r, "end of file expected");
+	}
+
+	return success;
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct json_writer {
+	struct dstr out;
+	bool full;
+};
+
+static inline void json_write_indent(struct json_writer *w, int depth)
+{
+	static const char spaces[] = "                                ";
+	size_t count = (size_t)depth * 4;
+
+	if (!w->full)
+		return;
+
+	dstr_cat_ch(&w->out, '\n');
+
+	while (count) {
+		size_t len = count < sizeof(spaces) - 1 ? count
+							 : sizeof(spaces) - 1;
+		dstr_ncat(&w->out, spaces, len);
+		count -= len;
+	}
+}
+
+static void json_write_string(struct json_writer *w, const char *str)
+{
+	const char *span = str;
+
+	dstr_cat_ch(&w->out, '"');
+
+	for (; *str; str++) {
+		uint8_t ch = (uint8_t)*str;
+		char seq[8];
+
+		if (ch >= 0x20 && ch != '"' && ch != '\\')
+			continue;
+
+		dstr_ncat(&w->out, span, str - span);
+		span = str + 1;
+
+		switch (ch) {
+		case '"':
+			dstr_ncat(&w->out, "\\\"", 2);
+			break;
+		case '\\':
+			dstr_ncat(&w->out, "\\\\", 2);
+			break;
+		case '\b':
+			dstr_ncat(&w->out, "\\b", 2);
+			break;
+		case '\f':
+			dstr_ncat(&w->out, "\\f", 2);
+			break;
+		case '\n':
+			dstr_ncat(&w->out, "\\n", 2);
+			break;
+		case '\r':
+			dstr_ncat(&w->out, "\\r", 2);
+			break;
+		case '\t':
+			dstr_ncat(&w->out, "\\t", 2);
+			break;
+		default:
+			snprintf(seq, sizeof(seq), "\\u%04X", ch);
+			dstr_ncat(&w->out, seq, 6);
+		}
+	}
+
+	dstr_ncat(&w->out, span, str - span);
+	dstr_cat_ch(&w->out, '"');
+}
+
+/* items jansson would have refused (invalid UTF-8, non-finite numbers) were
+ * silently left out of the output, and still are */
+static bool json_item_writable(struct json_writer *w, obs_data_item_t *item)
+{
+	if (!w->full && !obs_data_item_has_user_value(item))
+		return false;
+	if (!json_utf8_valid(get_item_name(item)))
+		return false;
+
+	switch (item->type) {
+	case OBS_DATA_STRING:
+		return json_utf8_valid(obs_data_item_get_string(item));
+	case OBS_DATA_NUMBER:
+		return obs_data_item_numtype(item) == OBS_DATA_NUM_INT ||
+		       isfinite(obs_data_item_get_double(item));
+	case OBS_DATA_BOOLEAN:
+	case OBS_DATA_OBJECT:
+	case OBS_DATA_ARRAY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void json_write_object(struct json_writer *w, obs_data_t *data,
+			      int depth);
+
+static void json_write_array(struct json_writer *w, obs_data_array_t *array,
+			     int depth)
+{
+	size_t count = obs_data_array_count(array);
+
+	dstr_cat_ch(&w->out, '[');
+
+	for (size_t idx = 0; idx < count; idx++) {
+		obs_data_t *obj = obs_data_array_item(array, idx);
+
+		if (idx)
+			dstr_cat_ch(&w->out, ',');
+		json_write_indent(w, depth + 1);
+		json_write_object(w, obj, depth + 1);
+
+		obs_data_release(obj);
+	}
+
+	if (count)
+		json_write_indent(w, depth);
+	dstr_cat_ch(&w->out, ']');
+}
+
+static void json_write_value(struct json_writer *w, obs_data_item_t *item,
+			     int depth)
+{
+	char buf[64];
+	int len;
+
+	if (item->type == OBS_DATA_STRING) {
+		json_write_string(w, obs_data_item_get_string(item));
+
+	} else if (item->type == OBS_DATA_NUMBER) {
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+			len = snprintf(buf, sizeof(buf), "%lld",
+				       obs_data_item_get_int(item));
+		else
+			len = os_dtostr(obs_data_item_get_double(item), buf,
+					sizeof(buf));
+
+		if (len > 0)
+			dstr_ncat(&w->out, buf, len);
+
+	} else if (item->type == OBS_DATA_BOOLEAN) {
+		dstr_cat(&w->out,
+			 obs_data_item_get_bool(item) ? "true" : "false");
+
+	} else if (item->type == OBS_DATA_OBJECT) {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+		json_write_object(w, obj, depth);
+		obs_data_release(obj);
+
+	} else if (item->type == OBS_DATA_ARRAY) {
+		obs_data_array_t *array = obs_data_item_get_array(item);
+		json_write_array(w, array, depth);
+		obs_data_array_release(array);
+	}
+}
+
+static void json_write_object(struct json_writer *w, obs_data_t *data,
+			      int depth)
+{
+	struct obs_data_item *item = data ? data->first_item : NULL;
+	bool empty = true;
+
+	dstr_cat_ch(&w->out, '{');
+
+	for (; item; item = item->next) {
+		if (!json_item_writable(w, item))
+			continue;
+
+		if (!empty)
+			dstr_cat_ch(&w->out, ',');
+		json_write_indent(w, depth + 1);
+
+		json_write_string(w, get_item_name(item));
+		dstr_cat(&w->out, w->full ? ": " : ":");
+		json_write_value(w, item, depth + 1);
+		empty = false;
+	}
+
+	if (!empty)
+		json_write_indent(w, depth);
+	dstr_cat_ch(&w->out, '}');
+}
+
+/* ------------------------------------------------------------------------- */
+/* Binary encoding.  Everything is little endian, and counts and lengths are
+ * unsigned LEB128 varints:
+ *
+ *   header: "OBSD", u16 version, u16 flags (reserved, 0)
+ *   object: varint item count, then the items
+ *   item:   u8 type, name, value
+ *   string: varint length, the bytes, then a 0 byte
+ *
+ *   BINARY_STRING: string        BINARY_INT:    zigzag encoded varint
+ *   BINARY_DOUBLE: 8 byte double BINARY_FALSE/BINARY_TRUE: nothing
+ *   BINARY_OBJECT: object        BINARY_ARRAY:  varint count, then objects
+ *
+ * Like the JSON text, only user values are stored.  Names and strings keep
+ * their terminating 0 so they can be used where they are, which also makes a
+ * mapped file readable as-is. */
+
+#define BINARY_MAGIC "OBSD"
+#define BINARY_VERSION 1
+#define BINARY_HEADER_SIZE 8
+#define BINARY_MAX_DEPTH 2048
+
+enum binary_type {
+	BINARY_STRING = 1,
+	BINARY_INT,
+	BINARY_DOUBLE,
+	BINARY_FALSE,
+	BINARY_TRUE,
+	BINARY_OBJECT,
+	BINARY_ARRAY,
+};
+
+static size_t binary_put_varint(uint8_t *buf, uint64_t val)
+{
+	size_t len = 0;
+
+	do {
+		buf[len] = val & 0x7F;
+		val >>= 7;
+		if (val)
+			buf[len] |= 0x80;
+		len++;
+	} while (val);
+
+	return len;
+}
+
+/* each piece goes out in a single write, the per-byte serializer calls are
+ * most of the cost otherwise */
+static void binary_write_varint(struct serializer *s, uint64_t val)
+{
+	uint8_t buf[10];
+	s_write(s, buf, binary_put_varint(buf, val));
+}
+
+static void binary_write_string(struct serializer *s, const char *str)
+{
+	size_t len = strlen(str);
+
+	binary_write_varint(s, len);
+	s_write(s, str, len + 1);
+}
+
+static void binary_write_head(struct serializer *s, enum binary_type type,
+			      const char *name)
+{
+	size_t len = strlen(name);
+	uint8_t buf[11];
+
+	buf[0] = (uint8_t)type;
+	s_write(s, buf, 1 + binary_put_varint(buf + 1, len));
+	s_write(s, name, len + 1);
+}
+
+static void binary_write_u64(struct serializer *s, uint64_t val)
+{
+	uint8_t buf[8];
+
+	for (size_t i = 0; i < 8; i++)
+		buf[i] = (uint8_t)(val >> (i * 8));
+
+	s_write(s, buf, sizeof(buf));
+}
+
+static void binary_write_object(struct serializer *s, obs_data_t *data);
+
+static void binary_write_value(struct serializer *s, obs_data_item_t *item)
+{
+	const char *name = get_item_name(item);
+
+	if (item->type == OBS_DATA_STRING) {
+		binary_write_head(s, BINARY_STRING, name);
+		binary_write_string(s, obs_data_item_get_string(item));
+
+	} else if (item->type == OBS_DATA_NUMBER) {
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT) {
+			long long val = obs_data_item_get_int(item);
+
+			binary_write_head(s, BINARY_INT, name);
+			binary_write_varint(s, ((uint64_t)val << 1) ^
+						       (uint64_t)(val >> 63));
+		} else {
+			double val = obs_data_item_get_double(item);
+			uint64_t bits;
+
+			memcpy(&bits, &val, sizeof(bits));
+			binary_write_head(s, BINARY_DOUBLE, name);
+			binary_write_u64(s, bits);
+		}
+
+	} else if (item->type == OBS_DATA_BOOLEAN) {
+		bool val = obs_data_item_get_bool(item);
+
+		binary_write_head(s, val ? BINARY_TRUE : BINARY_FALSE, name);
+
+	} else if (item->type == OBS_DATA_OBJECT) {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+
+		binary_write_head(s, BINARY_OBJECT, name);
+		binary_write_object(s, obj);
+
+		obs_data_release(obj);
+
+	} else if (item->type == OBS_DATA_ARRAY) {
+		obs_data_array_t *array = obs_data_item_get_array(item);
+		size_t count = obs_data_array_count(array);
+
+		binary_write_head(s, BINARY_ARRAY, name);
+		binary_write_varint(s, count);
+
+		for (size_t idx = 0; idx < count; idx++) {
+			obs_data_t *obj = obs_data_array_item(array, idx);
+			binary_write_object(s, obj);
+			obs_data_release(obj);
+		}
+
+		obs_data_array_release(array);
+	}
+}
+
+static inline bool binary_item_writable(obs_data_item_t *item)
+{
+	return item->type != OBS_DATA_NULL &&
+	       obs_data_item_has_user_value(item);
+}
+
+static void binary_write_object(struct serializer *s, obs_data_t *data)
+{
+	struct obs_data_item *first = data ? data->first_item : NULL;
+	struct obs_data_item *item;
+	size_t count = 0;
+
+	for (item = first; item; item = item->next) {
+		if (binary_item_writable(item))
+			count++;
+	}
+
+	binary_write_varint(s, count);
+
+	for (item = first; item; item = item->next) {
+		if (binary_item_writable(item))
+			binary_write_value(s, item);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct binary_reader {
+	const uint8_t *pos;
+	const uint8_t *end;
+	const char *error;
+};
+
+static bool binary_read_object(struct binary_reader *r, obs_data_t *data,
+			       int depth);
+
+static inline bool binary_error(struct binary_reader *r, const char *error)
+{
+	if (!r->error)
+		r->error = error;
+	return false;
+}
+
+static inline size_t binary_remaining(struct binary_reader *r)
+{
+	return (size_t)(r->end - r->pos);
+}
+
+static bool binary_read_varint(struct binary_reader *r, uint64_t *val)
+{
+	*val = 0;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+
+		if (r->pos == r->end)
+			return binary_error(r, "unexpected end of data");
+
+		byte = *r->pos++;
+		*val |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+
+	return binary_error(r, "invalid varint");
+}
+
+/* returns a count of things that each take at least one byte, so a corrupt
+ * count can't be larger than what's left */
+static bool binary_read_count(struct binary_reader *r, size_t *count)
+{
+	uint64_t val;
+
+	if (!binary_read_varint(r, &val))
+		return false;
+	if (val > binary_remaining(r))
+		return binary_error(r, "invalid count");
+
+	*count = (size_t)val;
+	return true;
+}
+
+static bool binary_read_string(struct binary_reader *r, const char **str)
+{
+	size_t len;
+
+	if (!binary_read_count(r, &len))
+		return false;
+	if (len >= binary_remaining(r) || r->pos[len] != 0 ||
+	    memchr(r->pos, 0, len))
+		return binary_error(r, "invalid string");
+
+	*str = (const char *)r->pos;
+	r->pos += len + 1;
+	return true;
+}
+
+static bool binary_read_u64(struct binary_reader *r, uint64_t *val)
+{
+	if (binary_remaining(r) < 8)
+		return binary_error(r, "unexpected end of data");
+
+	*val = 0;
+	for (int i = 7; i >= 0; i--)
+		*val = (*val << 8) | r->pos[i];
+
+	r->pos += 8;
+	return true;
+}
+
+static bool binary_read_array(struct binary_reader *r, obs_data_array_t *array,
+			      int depth)
+{
+	size_t count;
+
+	if (!binary_read_count(r, &count))
+		return false;
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *obj = obs_data_create();
+		bool success = binary_read_object(r, obj, depth + 1);
+
+		if (success)
+			obs_data_array_push_back(array, obj);
+		obs_data_release(obj);
+
+		if (!success)
+			return false;
+	}
+
+	return true;
+}
+
+static bool binary_read_item(struct binary_reader *r, obs_data_t *data,
+			     int depth)
+{
+	size_t count = data->num_items;
+	bool success = true;
+	const char *name;
+	uint64_t val;
+	uint8_t type;
+
+	if (r->pos == r->end)
+		return binary_error(r, "unexpected end of data");
+
+	type = *r->pos++;
+
+	if (!binary_read_string(r, &name))
+		return false;
+
+	switch (type) {
+	case BINARY_STRING: {
+		const char *str;
+		if (!binary_read_string(r, &str))
+			return false;
+		obs_data_set_string(data, name, str);
+		break;
+	}
+	case BINARY_INT:
+		if (!binary_read_varint(r, &val))
+			return false;
+		obs_data_set_int(data, name,
+				 (long long)(val >> 1) ^ -(long long)(val & 1));
+		break;
+	case BINARY_DOUBLE: {
+		double d;
+		if (!binary_read_u64(r, &val))
+			return false;
+		memcpy(&d, &val, sizeof(d));
+		obs_data_set_double(data, name, d);
+		break;
+	}
+	case BINARY_FALSE:
+	case BINARY_TRUE:
+		obs_data_set_bool(data, name, type == BINARY_TRUE);
+		break;
+	case BINARY_OBJECT: {
+		obs_data_t *obj = obs_data_create();
+
+		obs_data_set_obj(data, name, obj);
+		if (data->num_items != count)
+			success = binary_read_object(r, obj, depth + 1);
+
+		obs_data_release(obj);
+		break;
+	}
+	case BINARY_ARRAY: {
+		obs_data_array_t *array = obs_data_array_create();
+
+		obs_data_set_array(data, name, array);
+		if (data->num_items != count)
+			success = binary_read_array(r, array, depth);
+
+		obs_data_array_release(array);
+		break;
+	}
+	default:
+		return binary_error(r, "unknown item type");
+	}
+
+	if (data->num_items == count)
+		return binary_error(r, "duplicate item name");
+
+	return success;
+}
+
+static bool binary_read_object(struct binary_reader *r, obs_data_t *data,
+			       int depth)
+{
+	size_t count;
+
+	if (depth > BINARY_MAX_DEPTH)
+		return binary_error(r, "maximum depth reached");
+	if (!binary_read_count(r, &count))
+		return false;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!binary_read_item(r, data, depth))
+			return false;
+	}
+
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+obs_data_t *obs_data_create()
+{
+	struct obs_data *data =
+		bzalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_OBS_DATA),
+			      sizeof(struct obs_data));
+	data->ref = 1;
+
+	return data;
+}
+
+obs_data_t *obs_data_create_from_json(const char *json_string)
+{
+	obs_data_t *data = obs_data_create();
+	struct json_reader reader = {0};
+	bool success;
+
+	reader.pos = json_string;
+	reader.line = 1;
+	reader.decimal_point = *localeconv()->decimal_point;
+	dstr_init_inline(&reader.key, reader.key_buf, sizeof(reader.key_buf));
+	dstr_init_inline(&reader.str, reader.str_buf, sizeof(reader.str_buf));
+
+	if (json_string) {
+		success = json_read_root(&reader, data);
+	} else {
+		success = json_error(&reader, "wrong arguments");
+		reader.line = -1;
+	}
+
+	if (!success) {
+		blog(LOG_ERROR,
+		     "obs-data.c: [obs_data_create_from_json] "
+		     "Failed reading json string (%d): %s",
+		     reader.line, reader.error);
+		obs_data_release(data);
+		data = NULL;
+	}
+
+	dstr_free(&reader.key);
+	dstr_free(&reader.str);
+	return data;
+}
+
+obs_data_t *obs_data_create_from_json_file(const char *json_file)
+{
+	char *file_data = os_quick_read_utf8_file(json_file);
+	obs_data_t *data = NULL;
+
+	if (file_data) {
+		data = obs_data_create_from_json(file_data);
+		bfree(file_data);
+	}
+
+	return data;
+}
+
+static obs_data_t *create_from_file_safe(obs_data_t *(*create)(const char *),
+					 const char *file,
+					 const char *backup_ext,
+					 const char *func)
+{
+	obs_data_t *file_data = create(file);
+	if (!file_data && backup_ext && *backup_ext) {
+		struct dstr backup_file = {0};
+
+		dstr_copy(&backup_file, file);
+		if (*backup_ext != '.')
+			dstr_cat(&backup_file, ".");
+		dstr_cat(&backup_file, backup_ext);
+
+		if (os_file_exists(backup_file.array)) {
+			blog(LOG_WARNING,
+			     "obs-data.c: [%s] attempting backup file", func);
+
+			/* delete current file if corrupt to prevent it from
+			 * being backed up again */
+			os_rename(backup_file.array, file);
+
+			file_data = create(file);
+		}
+
+		dstr_free(&backup_file);
+	}
+
+	return file_data;
+}
+
+obs_data_t *obs_data_create_from_json_file_safe(const char *json_file,
+						const char *backup_ext)
+{
+	return create_from_file_safe(obs_data_create_from_json_file,
+				     json_file, backup_ext,
+				     "obs_data_create_from_json_file_safe");
+}
+
+obs_data_t *obs_data_create_from_binary(const void *bin, size_t size)
+{
+	struct binary_reader reader = {0};
+	obs_data_t *data;
+	uint16_t version;
+	uint16_t flags;
+
+	reader.pos = bin;
+	reader.end = reader.pos + size;
+
+	if (!bin || size < BINARY_HEADER_SIZE ||
+	    memcmp(bin, BINARY_MAGIC, 4) != 0) {
+		blog(LOG_ERROR, "obs-data.c: [obs_data_create_from_binary] "
+				"Not obs_data binary data");
+		return NULL;
+	}
+
+	version = reader.pos[4] | (reader.pos[5] << 8);
+	flags = reader.pos[6] | (reader.pos[7] << 8);
+	reader.pos += BINARY_HEADER_SIZE;
+
+	if (version > BINARY_VERSION || flags != 0) {
+		blog(LOG_ERROR,
+		     "obs-data.c: [obs_data_create_from_binary] "
+		     "Unsupported version %d (flags 0x%x)",
+		     (int)version, (unsigned)flags);
+		return NULL;
+	}
+
+	data = obs_data_create();
+
+	if (binary_read_object(&reader, data, 1) && reader.pos != reader.end)
+		binary_error(&reader, "unexpected data after the object");
+
+	if (reader.error) {
+		blog(LOG_ERROR,
+		     "obs-data.c: [obs_data_create_from_binary] "
+		     "Failed reading binary data at offset %lld: %s",
+		     (long long)(reader.pos - (const uint8_t *)bin),
+		     reader.error);
+		obs_data_release(data);
+		data = NULL;
+	}
+
+	return data;
+}
+
+obs_data_t *obs_data_create_from_binary_file(const char *file)
+{
+	obs_data_t *data = NULL;
+	FILE *f = os_fopen(file, "rb");
+	int64_t size;
+	uint8_t *bin;
+
+	if (!f)
+		return NULL;
+
+	size = os_fgetsize(f);
+	if (size >= 0 && (uint64_t)size <= SIZE_MAX) {
+		bin = bmalloc(size ? (size_t)size : 1);
+
+		if (fread(bin, 1, (size_t)size, f) == (size_t)size)
+			data = obs_data_create_from_binary(bin, (size_t)size);
+
+		bfree(bin);
+	}
+
+	fclose(f);
+	return data;
+}
+
+obs_data_t *obs_data_create_from_binary_file_safe(const char *file,
+						  const char *backup_ext)
+{
+	return create_from_file_safe(obs_data_create_from_binary_file, file,
+				     backup_ext,
+				     "obs_data_create_from_binary_file_safe");
+}
+
+void obs_data_addref(obs_data_t *data)
+{
+	if (data)
+		os_atomic_inc_long(&data->ref);
+}
+
+static inline void obs_data_destroy(struct obs_data *data)
+{
+	struct obs_data_item *item = data->first_item;
+
+	/* items are released front to back, which is cheap without the index */
+	free_index(data);
+
+	while (item) {
+		struct obs_data_item *next = item->next;
+		obs_data_item_release(&item);
+		item = next;
+	}
+
+	bfree(data->json);
+	bfree(data);
+}
+
+void obs_data_release(obs_data_t *data)
+{
+	if (!data)
+		return;
+
+	if (os_atomic_dec_long(&data->ref) == 0)
+		obs_data_destroy(data);
+}
+
+static const char *obs_data_write_json(obs_data_t *data, bool full)
+{
+	struct json_writer writer = {0};
+
+	if (!data)
+		return NULL;
+
+	writer.full = full;
+	json_write_object(&writer, data, 0);
+
+	bfree(data->json);
+	data->json = writer.out.array;
+	return data->json;
+}
+
+const char *obs_data_get_json(obs_data_t *data)
+{
+	return obs_data_write_json(data, false);
+}
+
+const char *obs_data_get_full_json(obs_data_t *data)
+{
+	return obs_data_write_json(data, true);
+}
+
+const char *obs_data_get_last_json(obs_data_t *data)
+{
+	return data ? data->json : NULL;
+}
+
+bool obs_data_save_json(obs_data_t *data, const char *file)
+{
+	const char *json = obs_data_get_json(data);
+
+	if (json && *json) {
+		return os_quick_write_utf8_file(file, json, strlen(json),
+						false);
+	}
+
+	return false;
+}
+
+bool obs_data_save_json_safe(obs_data_t *data, const char *file,
+			     const char *temp_ext, const char *backup_ext)
+{
+	const char *json = obs_data_get_json(data);
+
+	if (json && *json) {
+		return os_quick_write_utf8_file_safe(
+			file, json, strlen(json), false, temp_ext, backup_ext);
+	}
+
+	return false;
+}
+
+void *obs_data_get_binary(obs_data_t *data, size_t *size)
+{
+	struct array_output_data output;
+	struct serializer s;
+
+	if (!data) {
+		*size = 0;
+		return NULL;
+	}
+
+	array_output_serializer_init(&s, &output);
+
+	s_write(&s, BINARY_MAGIC, 4);
+	s_wl16(&s, BINARY_VERSION);
+	s_wl16(&s, 0);
+	binary_write_object(&s, data);
+
+	*size = output.bytes.num;
+	return output.bytes.array;
+}
+
+bool obs_data_save_binary(obs_data_t *data, const char *file)
+{
+	size_t size;
+	void *bin = obs_data_get_binary(data, &size);
+	bool success = false;
+
+	if (bin)
+		success = os_quick_write_utf8_file(file, bin, size, false);
+
+	bfree(bin);
+	return success;
+}
+
+bool obs_data_save_binary_safe(obs_data_t *data, const char *file,
+			       const char *temp_ext, const char *backup_ext)
+{
+	size_t size;
+	void *bin = obs_data_get_binary(data, &size);
+	bool success = false;
+
+	if (bin)
+		success = os_quick_write_utf8_file_safe(
+			file, bin, size, false, temp_ext, backup_ext);
+
+	bfree(bin);
+	return success;
+}
+
+static void get_defaults_array_cb(obs_data_t *data, void *vp)
+{
+	obs_data_array_t *defs = (obs_data_array_t *)vp;
+	obs_data_t *obs_defaults = obs_data_get_defaults(data);
+
+	obs_data_array_push_back(defs, obs_defaults);
+
+	obs_data_release(obs_defaults);
 }
 
 obs_data_t *obs_data_get_defaults(obs_data_t *data)
@@ -932,6 +2157,12 @@ static struct obs_data_item *get_item(struct obs_data *data, const char *name)
 	if (!data)
 		return NULL;
 
+	if (data->indexed) {
+		size_t pos;
+		return index_find(data, name, &pos) ? data->index.array[pos]
+						    : NULL;
+	}
+
 	struct obs_data_item *item = data->first_item;
 
 	while (item) {
@@ -954,31 +2185,8 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item,
 	if ((!item || !*item) && data) {
 		new_item = obs_data_item_create(name, ptr, size, type,
 						default_data, autoselect_data);
-
-		obs_data_item_t *prev = obs_data_first(data);
-		obs_data_item_t *next = obs_data_first(data);
-		obs_data_item_next(&next);
-		for (; prev && next;
-		     obs_data_item_next(&prev), obs_data_item_next(&next)) {
-			if (strcmp(get_item_name(next), name) > 0)
-				break;
-		}
-
-		new_item->parent = data;
-		if (prev && strcmp(get_item_name(prev), name) < 0) {
-			prev->next = new_item;
-			new_item->next = next;
-
-		} else {
-			data->first_item = new_item;
-			new_item->next = prev;
-		}
-
-		if (!prev)
-			data->first_item = new_item;
-
-		obs_data_item_release(&prev);
-		obs_data_item_release(&next);
+		if (new_item)
+			obs_data_item_insert(data, new_item);
 
 	} else if (default_data) {
 		obs_data_item_set_default_data(item, ptr, size, type);
@@ -1428,7 +2636,9 @@ obs_data_array_t *obs_data_get_autoselect_array(obs_data_t *data,
 
 obs_data_array_t *obs_data_array_create()
 {
-	struct obs_data_array *array = bzalloc(sizeof(struct obs_data_array));
+	struct obs_data_array *array =
+		bzalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_OBS_DATA),
+			      sizeof(struct obs_data_array));
 	array->ref = 1;
 
 	return array;
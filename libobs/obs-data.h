@@ -66,6 +66,10 @@ EXPORT obs_data_t *obs_data_create_from_json(const char *json_string);
 EXPORT obs_data_t *obs_data_create_from_json_file(const char *json_file);
 EXPORT obs_data_t *obs_data_create_from_json_file_safe(const char *json_file,
 						       const char *backup_ext);
+EXPORT obs_data_t *obs_data_create_from_binary(const void *bin, size_t size);
+EXPORT obs_data_t *obs_data_create_from_binary_file(const char *file);
+EXPORT obs_data_t *obs_data_create_from_binary_file_safe(const char *file,
+							 const char *backup_ext);
 EXPORT void obs_data_addref(obs_data_t *data);
 EXPORT void obs_data_release(obs_data_t *data);
 
@@ -77,6 +81,12 @@ EXPORT bool obs_data_save_json_safe(obs_data_t *data, const char *file,
 				    const char *temp_ext,
 				    const char *backup_ext);
 
+EXPORT void *obs_data_get_binary(obs_data_t *data, size_t *size);
+EXPORT bool obs_data_save_binary(obs_data_t *data, const char *file);
+EXPORT bool obs_data_save_binary_safe(obs_data_t *data, const char *file,
+				      const char *temp_ext,
+				      const char *backup_ext);
+
 EXPORT void obs_data_apply(obs_data_t *target, obs_data_t *apply_data);
 
 EXPORT void obs_data_erase(obs_data_t *data, const char *name);
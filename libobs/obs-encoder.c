@@ -115,7 +115,8 @@ create_encoder(const char *id, enum obs_encoder_type type, const char *name,
 	encoder->control->encoder = encoder;
 
 	obs_context_data_insert(&encoder->context, &obs->data.encoders_mutex,
-				&obs->data.first_encoder);
+				&obs->data.first_encoder,
+				&obs->data.encoders_index);
 
 	blog(LOG_DEBUG, "encoder '%s' (%s) created", name, id);
 	return encoder;
@@ -232,6 +233,8 @@ static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 		if (gpu_encode_available(encoder)) {
 			stop_gpu_encode(encoder);
 		} else {
+			log_raw_video_stats(encoder->media, receive_video,
+					    encoder, encoder->context.name);
 			stop_raw_video(encoder->media, receive_video, encoder);
 			video_repeat_dec(encoder->media);
 		}
@@ -967,6 +970,8 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 static const char *do_encode_name = "do_encode";
 bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 {
+	uint64_t start = os_gettime_ns();
+
 	profile_start(do_encode_name);
 	if (!encoder->profile_encoder_encode_name)
 		encoder->profile_encoder_encode_name =
@@ -989,6 +994,7 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 
 	profile_end(do_encode_name);
 
+	histogram_record(&encoder->encode_histogram, os_gettime_ns() - start);
 	return success;
 }
 
@@ -1541,6 +1547,17 @@ uint32_t obs_encoder_get_caps(const obs_encoder_t *encoder)
 		       : 0;
 }
 
+void obs_encoder_get_latency_stats(const obs_encoder_t *encoder,
+				   struct obs_latency_stats *stats)
+{
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+	if (obs_encoder_valid(encoder, "obs_encoder_get_latency_stats"))
+		get_latency_stats(&encoder->encode_histogram, stats);
+}
+
 bool obs_encoder_paused(const obs_encoder_t *encoder)
 {
 	return obs_encoder_valid(encoder, "obs_encoder_paused")
@@ -0,0 +1,202 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <assert.h>
+#include "obs-interleave.h"
+
+/* sent packets are left in front of a track's head until there are enough
+ * of them to be worth moving the rest down */
+#define MIN_COMPACT 32
+
+static inline struct encoder_packet *head_packet(struct interleave_queue *queue,
+						 size_t heap_idx)
+{
+	return interleave_track_packet(queue, queue->heap[heap_idx], 0);
+}
+
+static inline bool heap_before(struct interleave_queue *queue, size_t a,
+			       size_t b)
+{
+	return interleave_packet_before(head_packet(queue, a),
+					head_packet(queue, b));
+}
+
+static inline void heap_swap(struct interleave_queue *queue, size_t a,
+			     size_t b)
+{
+	uint8_t track = queue->heap[a];
+	queue->heap[a] = queue->heap[b];
+	queue->heap[b] = track;
+}
+
+static void heap_up(struct interleave_queue *queue, size_t idx)
+{
+	while (idx) {
+		size_t parent = (idx - 1) / 2;
+
+		if (!heap_before(queue, idx, parent))
+			break;
+
+		heap_swap(queue, idx, parent);
+		idx = parent;
+	}
+}
+
+static void heap_down(struct interleave_queue *queue, size_t idx)
+{
+	for (;;) {
+		size_t left = idx * 2 + 1;
+		size_t right = left + 1;
+		size_t first = idx;
+
+		if (left < queue->heap_size && heap_before(queue, left, first))
+			first = left;
+		if (right < queue->heap_size && heap_before(queue, right, first))
+			first = right;
+		if (first == idx)
+			break;
+
+		heap_swap(queue, idx, first);
+		idx = first;
+	}
+}
+
+void interleave_queue_push(struct interleave_queue *queue,
+			   const struct encoder_packet *packet)
+{
+	size_t track = interleave_track(packet->type, packet->track_idx);
+	struct interleave_track *t;
+	size_t idx;
+
+	assert(track < INTERLEAVE_TRACKS);
+	t = &queue->tracks[track];
+
+	/* encoders hand packets over in order, so this is almost always the
+	 * end of the track */
+	idx = t->packets.num;
+	while (idx > t->head &&
+	       packet->dts_usec < t->packets.array[idx - 1].dts_usec)
+		idx--;
+
+	da_insert(t->packets, idx, packet);
+	queue->num++;
+
+	if (t->packets.num - t->head == 1) {
+		queue->heap[queue->heap_size] = (uint8_t)track;
+		heap_up(queue, queue->heap_size++);
+
+	} else if (idx == t->head) {
+		for (size_t i = 0; i < queue->heap_size; i++) {
+			if (queue->heap[i] == track) {
+				heap_up(queue, i);
+				break;
+			}
+		}
+	}
+}
+
+struct encoder_packet *interleave_queue_peek(struct interleave_queue *queue)
+{
+	return queue->heap_size ? head_packet(queue, 0) : NULL;
+}
+
+bool interleave_queue_pop(struct interleave_queue *queue,
+			  struct encoder_packet *packet)
+{
+	struct interleave_track *t;
+
+	if (!queue->heap_size)
+		return false;
+
+	t = &queue->tracks[queue->heap[0]];
+	*packet = t->packets.array[t->head++];
+	queue->num--;
+
+	if (t->head == t->packets.num) {
+		t->packets.num = 0;
+		t->head = 0;
+		queue->heap[0] = queue->heap[--queue->heap_size];
+
+	} else if (t->head >= MIN_COMPACT && t->head * 2 >= t->packets.num) {
+		da_erase_range(t->packets, 0, t->head);
+		t->head = 0;
+	}
+
+	heap_down(queue, 0);
+	return true;
+}
+
+void interleave_queue_discard(struct interleave_queue *queue,
+			      const struct encoder_packet *end, bool inclusive)
+{
+	struct encoder_packet last = *end;
+	struct encoder_packet *next;
+
+	while ((next = interleave_queue_peek(queue)) != NULL) {
+		struct encoder_packet packet;
+
+		if (inclusive ? interleave_packet_before(&last, next)
+			      : !interleave_packet_before(next, &last))
+			break;
+
+		interleave_queue_pop(queue, &packet);
+		obs_encoder_packet_release(&packet);
+	}
+}
+
+void interleave_queue_resort(struct interleave_queue *queue)
+{
+	queue->heap_size = 0;
+
+	for (size_t track = 0; track < INTERLEAVE_TRACKS; track++) {
+		struct interleave_track *t = &queue->tracks[track];
+		struct encoder_packet *packets = t->packets.array;
+
+		/* usually still in order, in which case this is one pass */
+		for (size_t i = t->head + 1; i < t->packets.num; i++) {
+			struct encoder_packet packet = packets[i];
+			size_t j = i;
+
+			while (j > t->head &&
+			       packet.dts_usec < packets[j - 1].dts_usec) {
+				packets[j] = packets[j - 1];
+				j--;
+			}
+			packets[j] = packet;
+		}
+
+		if (t->packets.num > t->head) {
+			queue->heap[queue->heap_size] = (uint8_t)track;
+			heap_up(queue, queue->heap_size++);
+		}
+	}
+}
+
+void interleave_queue_free(struct interleave_queue *queue)
+{
+	for (size_t track = 0; track < INTERLEAVE_TRACKS; track++) {
+		struct interleave_track *t = &queue->tracks[track];
+
+		for (size_t i = t->head; i < t->packets.num; i++)
+			obs_encoder_packet_release(t->packets.array + i);
+		da_free(t->packets);
+		t->head = 0;
+	}
+
+	queue->heap_size = 0;
+	queue->num = 0;
+}
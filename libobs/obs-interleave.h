@@ -0,0 +1,127 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "obs.h"
+#include "util/darray.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Interleave queue
+ *
+ *   Holds encoded packets until they can be sent in timestamp order.  Each
+ * track (the video track, then one per audio mix) has its own FIFO, kept in
+ * dts order, and a min-heap of the tracks that have packets gives the next
+ * packet to send.  Adding or taking a packet only touches its own track and
+ * the heap, so nothing else that's queued gets moved.
+ *
+ *   Packets are ordered by dts_usec.  When timestamps are equal, video comes
+ * before audio, and lower audio tracks before higher ones.
+ */
+
+#define INTERLEAVE_TRACKS (MAX_AUDIO_MIXES + 1)
+
+struct interleave_track {
+	DARRAY(struct encoder_packet) packets;
+	size_t head;
+};
+
+struct interleave_queue {
+	struct interleave_track tracks[INTERLEAVE_TRACKS];
+	uint8_t heap[INTERLEAVE_TRACKS];
+	size_t heap_size;
+	size_t num;
+};
+
+static inline size_t interleave_track(enum obs_encoder_type type,
+				      size_t audio_idx)
+{
+	return type == OBS_ENCODER_VIDEO ? 0 : audio_idx + 1;
+}
+
+static inline bool interleave_packet_before(const struct encoder_packet *a,
+					    const struct encoder_packet *b)
+{
+	if (a->dts_usec != b->dts_usec)
+		return a->dts_usec < b->dts_usec;
+	if (a->type != b->type)
+		return a->type == OBS_ENCODER_VIDEO;
+	return a->type == OBS_ENCODER_AUDIO && a->track_idx < b->track_idx;
+}
+
+static inline size_t interleave_track_size(const struct interleave_queue *queue,
+					   size_t track)
+{
+	return queue->tracks[track].packets.num - queue->tracks[track].head;
+}
+
+static inline struct encoder_packet *
+interleave_track_packet(struct interleave_queue *queue, size_t track,
+			size_t idx)
+{
+	struct interleave_track *t = &queue->tracks[track];
+	return t->packets.array + t->head + idx;
+}
+
+static inline struct encoder_packet *
+interleave_queue_first(struct interleave_queue *queue, size_t track)
+{
+	return interleave_track_size(queue, track)
+		       ? interleave_track_packet(queue, track, 0)
+		       : NULL;
+}
+
+static inline struct encoder_packet *
+interleave_queue_last(struct interleave_queue *queue, size_t track)
+{
+	size_t size = interleave_track_size(queue, track);
+	return size ? interleave_track_packet(queue, track, size - 1) : NULL;
+}
+
+/** Adds a packet, taking over its reference */
+EXPORT void interleave_queue_push(struct interleave_queue *queue,
+				  const struct encoder_packet *packet);
+
+/** Returns the next packet in order, or NULL if the queue is empty */
+EXPORT struct encoder_packet *
+interleave_queue_peek(struct interleave_queue *queue);
+
+/** Removes the next packet, handing its reference to the caller */
+EXPORT bool interleave_queue_pop(struct interleave_queue *queue,
+				 struct encoder_packet *packet);
+
+/**
+ * Releases every packet that comes before end, and end itself if inclusive
+ * is set.  end may be one of the queued packets.
+ */
+EXPORT void interleave_queue_discard(struct interleave_queue *queue,
+				     const struct encoder_packet *end,
+				     bool inclusive);
+
+/** Puts the tracks back in order after the queued timestamps have changed */
+EXPORT void interleave_queue_resort(struct interleave_queue *queue);
+
+/** Releases all packets and frees the queue, which can then be reused */
+EXPORT void interleave_queue_free(struct interleave_queue *queue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -24,6 +24,7 @@
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/profiler.h"
+#include "util/histogram.h"
 #include "callback/signal.h"
 #include "callback/proc.h"
 
@@ -35,16 +36,25 @@
 #include "media-io/audio-io.h"
 
 #include "obs.h"
+#include "obs-interleave.h"
 
 //#include <caption/caption.h>
 
-#define NUM_TEXTURES 2
+/* staging surfaces per rendering mode; the depth actually used is chosen
+ * through obs_video_info::staging_depth */
+#define NUM_TEXTURES 4
+#define DEFAULT_STAGING_DEPTH 2
+#define MIN_STAGING_DEPTH 2
 #define NUM_CHANNELS 3
 #define MICROSECOND_DEN 1000000
 #define NUM_ENCODE_TEXTURES 3
 #define NUM_ENCODE_TEXTURE_FRAMES_TO_WAIT 1
 #define NUM_RENDERING_MODES 3
 
+/* frames at least this large (in bytes, all planes and outputs together) are
+ * copied out of the staging surfaces on several threads */
+#define DEFAULT_PARALLEL_COPY_THRESHOLD (1920 * 1080 * 4)
+
 static inline int64_t packet_dts_usec(struct encoder_packet *packet)
 {
 	return packet->dts * MICROSECOND_DEN / packet->timebase_den;
@@ -80,6 +90,19 @@ static inline bool obs_object_valid(const void *obj, const char *f,
 #define obs_encoder_valid obs_ptr_valid
 #define obs_service_valid obs_ptr_valid
 
+static inline void get_latency_stats(const struct histogram *hist,
+				     struct obs_latency_stats *stats)
+{
+	static const double percentiles[] = {50.0, 95.0, 99.0, 99.9};
+	uint64_t values[4];
+
+	stats->count = histogram_percentiles(hist, percentiles, values, 4);
+	stats->p50_ns = values[0];
+	stats->p95_ns = values[1];
+	stats->p99_ns = values[2];
+	stats->p999_ns = values[3];
+}
+
 /* ------------------------------------------------------------------------- */
 /* modules */
 
@@ -252,6 +275,15 @@ struct obs_textures {
 	bool texture_rendered;
 	bool textures_copied[NUM_TEXTURES];
 	bool texture_converted;
+
+	/* readback state, owned by the graphics thread */
+	uint32_t staging_depth;
+	uint32_t cur_texture;
+	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
+	struct circlebuf vframe_info_buffer;
+
+	volatile long maps;
+	volatile long map_stalls;
 };
 
 struct obs_gpu_queues {
@@ -263,7 +295,6 @@ struct obs_core_video {
 	graphics_t *graphics;
 	struct obs_textures textures[NUM_RENDERING_MODES];
 	bool using_nv12_tex;
-	struct circlebuf vframe_info_buffer;
 	struct circlebuf vframe_info_buffer_gpu;
 	gs_effect_t *default_effect;
 	gs_effect_t *default_rect_effect;
@@ -277,8 +308,6 @@ struct obs_core_video {
 	gs_effect_t *bilinear_lowres_effect;
 	gs_effect_t *premultiplied_alpha_effect;
 	gs_samplerstate_t *point_sampler;
-	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
-	int cur_texture;
 	long raw_active;
 	long gpu_encoder_active;
 	pthread_mutex_t gpu_encoder_mutex;
@@ -293,6 +322,7 @@ struct obs_core_video {
 	uint64_t video_time;
 	uint64_t video_frame_interval_ns;
 	uint64_t video_avg_frame_time_ns;
+	struct histogram frame_time_histogram;
 	double video_fps;
 	video_t *video;
 	pthread_t video_thread;
@@ -327,6 +357,11 @@ struct obs_core_video {
 
 	pthread_mutex_t task_mutex;
 	struct circlebuf tasks;
+
+	uint64_t parallel_copy_threshold;
+	bool parallel_delivery;
+	struct video_copy_pool *copy_pool;
+	bool copy_pool_failed;
 };
 
 struct audio_monitor;
@@ -350,6 +385,14 @@ struct obs_core_audio {
 	pthread_mutex_t                 monitoring_mutex;
 };
 
+/* name lookup for one of the context lists below, protected by the same
+ * mutex as the list */
+struct obs_context_index {
+	struct obs_context_data **buckets;
+	size_t num_buckets;
+	size_t count;
+};
+
 /* user sources, output channels, and displays */
 struct obs_core_data {
 	struct obs_source *first_source;
@@ -359,6 +402,11 @@ struct obs_core_data {
 	struct obs_encoder *first_encoder;
 	struct obs_service *first_service;
 
+	struct obs_context_index sources_index;
+	struct obs_context_index outputs_index;
+	struct obs_context_index encoders_index;
+	struct obs_context_index services_index;
+
 	pthread_mutex_t sources_mutex;
 	pthread_mutex_t displays_mutex;
 	pthread_mutex_t outputs_mutex;
@@ -474,6 +522,9 @@ extern bool
 obs_graphics_thread_loop_autorelease(struct obs_graphics_context *context);
 #endif
 
+struct video_copy_pool;
+extern void video_copy_pool_destroy(struct video_copy_pool *pool);
+
 extern gs_effect_t *obs_load_effect(gs_effect_t **effect, const char *file);
 
 extern bool audio_callback(void *param, uint64_t start_ts_in,
@@ -495,6 +546,11 @@ extern void stop_raw_video(video_t *video,
 					    struct video_data *streaming_frame,
 					    struct video_data *recording_frame),
 			   void *param);
+extern void log_raw_video_stats(video_t *video,
+				void (*callback)(void *param,
+						 struct video_data *streaming_frame,
+						 struct video_data *recording_frame),
+				void *param, const char *name);
 
 /* ------------------------------------------------------------------------- */
 /* obs shared context data */
@@ -515,6 +571,11 @@ struct obs_context_data {
 	struct obs_context_data         *next;
 	struct obs_context_data         **prev_next;
 
+	struct obs_context_index        *index;
+	struct obs_context_data         *index_next;
+	struct obs_context_data         **index_prev_next;
+	uint32_t                        name_hash;
+
 	bool                            private;
 
 	DARRAY(char*)                   rename_cache;
@@ -528,7 +589,8 @@ extern bool obs_context_data_init(struct obs_context_data *context,
 extern void obs_context_data_free(struct obs_context_data *context);
 
 extern void obs_context_data_insert(struct obs_context_data *context,
-				    pthread_mutex_t *mutex, void *first);
+				    pthread_mutex_t *mutex, void *first,
+				    struct obs_context_index *index);
 extern void obs_context_data_remove(struct obs_context_data *context);
 
 extern void obs_context_data_setname(struct obs_context_data *context,
@@ -665,6 +727,8 @@ struct obs_source {
 	/* audio */
 	bool audio_failed;
 	bool audio_pending;
+	/* streaming and recording audio_output_buf may differ this tick */
+	bool audio_outputs_differ;
 	bool pending_stop;
 	bool audio_active;
 	bool user_muted;
@@ -715,6 +779,9 @@ struct obs_source {
 	DARRAY(struct async_frame) async_cache;
 	DARRAY(struct obs_source_frame *) async_frames;
 	pthread_mutex_t async_mutex;
+	enum obs_async_overrun_policy async_overrun_policy;
+	os_event_t *async_space_event;
+	struct obs_source_async_stats async_stats;
 	uint32_t async_width;
 	uint32_t async_height;
 	uint32_t async_cache_width;
@@ -962,7 +1029,7 @@ struct obs_output {
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct interleave_queue interleaved_packets;
 	int stop_code;
 
 	int reconnect_retry_sec;
@@ -1035,7 +1102,10 @@ struct obs_output {
 static inline void do_output_signal(struct obs_output *output,
 				    const char *signal)
 {
-	struct calldata params = {0};
+	struct calldata params;
+	uint8_t stack[128];
+
+	calldata_init_inline(&params, stack, sizeof(stack));
 	calldata_set_ptr(&params, "output", output);
 	signal_handler_signal(output->context.signals, signal, &params);
 	calldata_free(&params);
@@ -1135,6 +1205,7 @@ struct obs_encoder {
 	struct pause_data pause;
 
 	const char *profile_encoder_encode_name;
+	struct histogram encode_histogram;
 	char *last_error_message;
 };
 
@@ -19,6 +19,7 @@
 #include "util/threading.h"
 #include "util/util_uint64.h"
 #include "graphics/math-defs.h"
+#include "media-io/audio-mix.h"
 #include "obs-scene.h"
 #include "obs-internal.h"
 
@@ -32,6 +33,10 @@ static void get_ungrouped_transform(obs_sceneitem_t *group, struct vec2 *pos,
 				    struct vec2 *scale, float *rot);
 static inline bool crop_enabled(const struct obs_sceneitem_crop *crop);
 static inline bool item_texture_enabled(const struct obs_scene_item *item);
+/* scene item hotkey names are built on the stack, they only reach the heap
+ * when a source name is unusually long */
+#define SCENE_ITEM_HOTKEY_NAME_SIZE 128
+
 static void init_hotkeys(obs_scene_t *scene, obs_sceneitem_t *item,
 			 const char *name);
 
@@ -711,11 +716,11 @@ update_transforms_and_prune_sources(obs_scene_t *scene,
 
 static void scene_video_render(void *data, gs_effect_t *effect)
 {
-	DARRAY(struct obs_scene_item *) remove_items;
+	DARRAY_INLINE(struct obs_scene_item *, 8) remove_items;
 	struct obs_scene *scene = data;
 	struct obs_scene_item *item;
 
-	da_init(remove_items);
+	da_init_inline(remove_items);
 
 	video_lock(scene);
 
@@ -1213,12 +1218,7 @@ static void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in,
 static inline void mix_audio(float *p_out, float *p_in, size_t pos,
 			     size_t count)
 {
-	register float *out = p_out;
-	register float *in = p_in + pos;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++);
+	audio_mix_floats(p_out, p_in + pos, count);
 }
 
 static inline void render_item_audio(struct obs_scene_item *item,
@@ -1243,6 +1243,10 @@ static bool scene_audio_render(void *data, uint64_t *ts_out,
 
 	audio_lock(scene);
 
+	if (obs_get_multiple_rendering() &&
+	    obs_get_audio_rendering_mode() == OBS_STREAMING_AUDIO_RENDERING)
+		scene->source->audio_outputs_differ = false;
+
 	item = scene->first_item;
 	while (item) {
 		struct obs_source *source;
@@ -1327,6 +1331,11 @@ static bool scene_audio_render(void *data, uint64_t *ts_out,
 		apply_buf = apply_scene_item_volume(item, buf, timestamp,
 						    sample_rate);
 
+		if (obs_get_multiple_rendering() &&
+		    (apply_buf || source->audio_outputs_differ ||
+		     item->stream_visible != item->recording_visible))
+			scene->source->audio_outputs_differ = true;
+
 		if (obs_source_audio_pending(source)) {
 			item = item->next;
 			continue;
@@ -1864,10 +1873,16 @@ static bool hotkey_hide_sceneitem(void *data, obs_hotkey_pair_id id,
 static void init_hotkeys(obs_scene_t *scene, obs_sceneitem_t *item,
 			 const char *name)
 {
-	struct dstr show = {0};
-	struct dstr hide = {0};
-	struct dstr show_desc = {0};
-	struct dstr hide_desc = {0};
+	char show_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	char hide_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	char show_desc_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	char hide_desc_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	struct dstr show, hide, show_desc, hide_desc;
+
+	dstr_init_inline(&show, show_buf, sizeof(show_buf));
+	dstr_init_inline(&hide, hide_buf, sizeof(hide_buf));
+	dstr_init_inline(&show_desc, show_desc_buf, sizeof(show_desc_buf));
+	dstr_init_inline(&hide_desc, hide_desc_buf, sizeof(hide_desc_buf));
 
 	dstr_copy(&show, "libobs.show_scene_item.%1");
 	dstr_replace(&show, "%1", name);
@@ -1893,10 +1908,16 @@ static void init_hotkeys(obs_scene_t *scene, obs_sceneitem_t *item,
 static void sceneitem_rename_hotkey(const obs_sceneitem_t *scene_item,
 				    const char *new_name)
 {
-	struct dstr show = {0};
-	struct dstr hide = {0};
-	struct dstr show_desc = {0};
-	struct dstr hide_desc = {0};
+	char show_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	char hide_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	char show_desc_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	char hide_desc_buf[SCENE_ITEM_HOTKEY_NAME_SIZE];
+	struct dstr show, hide, show_desc, hide_desc;
+
+	dstr_init_inline(&show, show_buf, sizeof(show_buf));
+	dstr_init_inline(&hide, hide_buf, sizeof(hide_buf));
+	dstr_init_inline(&show_desc, show_desc_buf, sizeof(show_desc_buf));
+	dstr_init_inline(&hide_desc, hide_desc_buf, sizeof(hide_desc_buf));
 
 	dstr_copy(&show, "libobs.show_scene_item.%1");
 	dstr_replace(&show, "%1", new_name);
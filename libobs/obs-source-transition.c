@@ -966,6 +966,10 @@ bool obs_transition_audio_render(obs_source_t *transition, uint64_t *ts_out,
 	if (!transition_valid(transition, "obs_transition_audio_render"))
 		return false;
 
+	if (obs_get_multiple_rendering() &&
+	    obs_get_audio_rendering_mode() == OBS_STREAMING_AUDIO_RENDERING)
+		transition->audio_outputs_differ = false;
+
 	lock_transition(transition);
 
 	sources[0] = transition->transition_sources[0];
@@ -992,6 +996,11 @@ bool obs_transition_audio_render(obs_source_t *transition, uint64_t *ts_out,
 
 	unlock_transition(transition);
 
+	if (obs_get_multiple_rendering() &&
+	    (stopped || state.transitioning_audio ||
+	     (state.s[0] && state.s[0]->audio_outputs_differ)))
+		transition->audio_outputs_differ = true;
+
 	if (min_ts) {
 		if (state.transitioning_audio) {
 			if (state.s[0])
@@ -132,7 +132,8 @@ static void allocate_audio_output_buffer(struct obs_source *source)
 		      MAX_AUDIO_MIXES;
 	for (enum obs_audio_rendering_mode mode = OBS_MAIN_AUDIO_RENDERING;
 	     mode <= OBS_RECORDING_AUDIO_RENDERING; mode++) {
-		float *ptr = bzalloc(size);
+		float *ptr = bzalloc_arena(
+			bmem_arena_get_builtin(BMEM_ARENA_AUDIO), size);
 
 		for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
 			size_t mix_pos =
@@ -149,7 +150,8 @@ static void allocate_audio_output_buffer(struct obs_source *source)
 static void allocate_audio_mix_buffer(struct obs_source *source)
 {
 	size_t size = sizeof(float) * AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS;
-	float *ptr = bzalloc(size);
+	float *ptr =
+		bzalloc_arena(bmem_arena_get_builtin(BMEM_ARENA_AUDIO), size);
 
 	for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
 		source->audio_mix_buf[i] = ptr + AUDIO_OUTPUT_FRAMES * i;
@@ -209,6 +211,8 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->caption_cb_mutex, NULL) != 0)
 		return false;
+	if (os_event_init(&source->async_space_event, OS_EVENT_TYPE_AUTO) != 0)
+		return false;
 
 	if (is_audio_source(source) || is_composite_source(source))
 		allocate_audio_output_buffer(source);
@@ -245,7 +249,8 @@ static void obs_source_init_finalize(struct obs_source *source)
 	}
 
 	obs_context_data_insert(&source->context, &obs->data.sources_mutex,
-				&obs->data.first_source);
+				&obs->data.first_source,
+				&obs->data.sources_index);
 }
 
 static bool obs_source_hotkey_mute(void *data, obs_hotkey_pair_id id,
@@ -464,9 +469,9 @@ static char *get_new_filter_name(obs_source_t *dst, const char *name)
 static void duplicate_filters(obs_source_t *dst, obs_source_t *src,
 			      bool private)
 {
-	DARRAY(obs_source_t *) filters;
+	DARRAY_INLINE(obs_source_t *, 16) filters;
 
-	da_init(filters);
+	da_init_inline(filters);
 
 	pthread_mutex_lock(&src->filter_mutex);
 	for (size_t i = 0; i < src->filters.num; i++)
@@ -647,6 +652,16 @@ void obs_source_destroy(struct obs_source *source)
 	blog(LOG_DEBUG, "%ssource '%s' destroyed",
 	     source->context.private ? "private " : "", source->context.name);
 
+	if (source->async_stats.dropped_frames)
+		blog(LOG_INFO,
+		     "source '%s' dropped %llu of %llu async frames "
+		     "(%llu flushes, %llu late)",
+		     source->context.name,
+		     (unsigned long long)source->async_stats.dropped_frames,
+		     (unsigned long long)source->async_stats.output_frames,
+		     (unsigned long long)source->async_stats.flushes,
+		     (unsigned long long)source->async_stats.late_frames);
+
 	obs_source_dosignal(source, "source_destroy", "destroy");
 
 	if (source->context.data) {
@@ -710,6 +725,7 @@ void obs_source_destroy(struct obs_source *source)
 	pthread_mutex_destroy(&source->audio_mutex);
 	pthread_mutex_destroy(&source->caption_cb_mutex);
 	pthread_mutex_destroy(&source->async_mutex);
+	os_event_destroy(source->async_space_event);
 	obs_data_release(source->private_settings);
 	obs_context_data_free(&source->context);
 
@@ -1163,6 +1179,9 @@ static void async_tick(obs_source_t *source)
 	source->last_sys_timestamp = sys_time;
 	pthread_mutex_unlock(&source->async_mutex);
 
+	if (source->async_overrun_policy == OBS_ASYNC_OVERRUN_WAIT)
+		os_event_signal(source->async_space_event);
+
 	if (source->cur_async_frame)
 		source->async_update_texture =
 			set_async_texture_size(source, source->cur_async_frame);
@@ -2822,15 +2841,17 @@ void obs_source_frame_copy(struct obs_source_frame *dst,
 }
 
 static inline bool async_texture_changed(struct obs_source *source,
-					 const struct obs_source_frame *frame)
+					 enum video_format format,
+					 uint32_t width, uint32_t height,
+					 bool full_range)
 {
 	enum convert_type prev, cur;
 	prev = get_convert_type(source->async_cache_format,
 				source->async_cache_full_range);
-	cur = get_convert_type(frame->format, frame->full_range);
+	cur = get_convert_type(format, full_range);
 
-	return source->async_cache_width != frame->width ||
-	       source->async_cache_height != frame->height || prev != cur;
+	return source->async_cache_width != width ||
+	       source->async_cache_height != height || prev != cur;
 }
 
 static inline void free_async_cache(struct obs_source *source)
@@ -2862,30 +2883,105 @@ static void clean_cache(obs_source_t *source)
 }
 
 #define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
-static inline struct obs_source_frame *
-cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+
+static inline void drop_oldest_async_frame(struct obs_source *source)
+{
+	struct obs_source_frame *frame = source->async_frames.array[0];
+
+	da_erase(source->async_frames, 0);
+	remove_async_frame(source, frame);
+	source->async_stats.dropped_frames++;
+}
+
+/* waits up to one output frame interval for the render thread to consume a
+ * queued frame.  must be called with async_mutex held. */
+static bool wait_for_async_frame_room(struct obs_source *source)
+{
+	uint64_t timeout = obs->video.video_frame_interval_ns;
+	uint64_t end;
+
+	if (!timeout)
+		timeout = 1000000000ULL / 30;
+
+	end = os_gettime_ns() + timeout;
+	source->async_stats.waits++;
+
+	while (source->async_frames.num >= MAX_ASYNC_FRAMES) {
+		uint64_t now = os_gettime_ns();
+		if (now >= end) {
+			source->async_stats.wait_timeouts++;
+			return false;
+		}
+
+		pthread_mutex_unlock(&source->async_mutex);
+		os_event_timedwait(source->async_space_event,
+				   (unsigned long)((end - now + 999999) /
+						   1000000));
+		pthread_mutex_lock(&source->async_mutex);
+	}
+
+	return true;
+}
+
+/* applies the source's overrun policy when the async queue is full.  returns
+ * false if the incoming frame should be dropped.  must be called with
+ * async_mutex held. */
+static bool make_async_frame_room(struct obs_source *source)
+{
+	if (source->async_frames.num < MAX_ASYNC_FRAMES)
+		return true;
+
+	switch (source->async_overrun_policy) {
+	case OBS_ASYNC_OVERRUN_WAIT:
+		if (wait_for_async_frame_room(source))
+			return true;
+		/* fall through */
+	case OBS_ASYNC_OVERRUN_DROP_OLDEST:
+		while (source->async_frames.num >= MAX_ASYNC_FRAMES)
+			drop_oldest_async_frame(source);
+		return true;
+
+	case OBS_ASYNC_OVERRUN_DROP_NEWEST:
+		source->async_stats.dropped_frames++;
+		return false;
+
+	case OBS_ASYNC_OVERRUN_FLUSH:
+		break;
+	}
+
+	source->async_stats.dropped_frames += source->async_frames.num + 1;
+	source->async_stats.flushes++;
+	free_async_cache(source);
+	source->last_frame_ts = 0;
+	return false;
+}
+
+/* takes an unused frame out of the async cache (or allocates a new one) and
+ * returns it with an extra reference held for the caller.  returns NULL if
+ * the async frame queue is full. */
+static struct obs_source_frame *get_pooled_frame(struct obs_source *source,
+						 enum video_format format,
+						 uint32_t width,
+						 uint32_t height,
+						 bool full_range)
 {
 	struct obs_source_frame *new_frame = NULL;
 
 	pthread_mutex_lock(&source->async_mutex);
 
-	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
-		free_async_cache(source);
-		source->last_frame_ts = 0;
+	if (!make_async_frame_room(source)) {
 		pthread_mutex_unlock(&source->async_mutex);
 		return NULL;
 	}
 
-	if (async_texture_changed(source, frame)) {
+	if (async_texture_changed(source, format, width, height, full_range)) {
 		free_async_cache(source);
-		source->async_cache_width = frame->width;
-		source->async_cache_height = frame->height;
+		source->async_cache_width = width;
+		source->async_cache_height = height;
 	}
 
-	const enum video_format format = frame->format;
 	source->async_cache_format = format;
-	source->async_cache_full_range = frame->full_range;
+	source->async_cache_full_range = full_range;
 
 	for (size_t i = 0; i < source->async_cache.num; i++) {
 		struct async_frame *af = &source->async_cache.array[i];
@@ -2903,8 +2999,7 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 	if (!new_frame) {
 		struct async_frame new_af;
 
-		new_frame = obs_source_frame_create(format, frame->width,
-						    frame->height);
+		new_frame = obs_source_frame_create(format, width, height);
 		new_af.frame = new_frame;
 		new_af.used = true;
 		new_af.unused_count = 0;
@@ -2917,7 +3012,34 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 
 	pthread_mutex_unlock(&source->async_mutex);
 
-	copy_frame_data(new_frame, frame);
+	return new_frame;
+}
+
+/* drops the caller's reference to a pooled frame and, unless the cache was
+ * flushed in the meantime, queues it for rendering */
+static void queue_pooled_frame(struct obs_source *source,
+			       struct obs_source_frame *frame)
+{
+	pthread_mutex_lock(&source->async_mutex);
+	if (os_atomic_dec_long(&frame->refs) == 0) {
+		obs_source_frame_destroy(frame);
+	} else {
+		da_push_back(source->async_frames, &frame);
+		source->async_stats.output_frames++;
+		source->async_active = true;
+	}
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+static inline struct obs_source_frame *
+cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+{
+	struct obs_source_frame *new_frame = get_pooled_frame(
+		source, frame->format, frame->width, frame->height,
+		frame->full_range);
+
+	if (new_frame)
+		copy_frame_data(new_frame, frame);
 
 	return new_frame;
 }
@@ -2935,18 +3057,67 @@ obs_source_output_video_internal(obs_source_t *source,
 	}
 
 	struct obs_source_frame *output = cache_video(source, frame);
+	if (output)
+		queue_pooled_frame(source, output);
+}
+
+struct obs_source_frame *obs_source_get_output_frame(obs_source_t *source,
+						     enum video_format format,
+						     uint32_t width,
+						     uint32_t height,
+						     enum video_range_type range)
+{
+	if (!obs_source_valid(source, "obs_source_get_output_frame"))
+		return NULL;
+	if (format == VIDEO_FORMAT_NONE || !width || !height)
+		return NULL;
+
+	range = resolve_video_range(format, range);
+
+	struct obs_source_frame *frame = get_pooled_frame(
+		source, format, width, height, range == VIDEO_RANGE_FULL);
+	if (!frame)
+		return NULL;
+
+	/* pooled frames keep whatever the previous user left behind, so only
+	 * hand out the parts of the frame the pool is responsible for */
+	frame->width = width;
+	frame->height = height;
+	frame->full_range = range == VIDEO_RANGE_FULL;
+	frame->timestamp = 0;
+	frame->flip = false;
+	frame->flags = 0;
+	frame->prev_frame = false;
+	video_format_get_parameters(VIDEO_CS_DEFAULT, range,
+				    frame->color_matrix, frame->color_range_min,
+				    frame->color_range_max);
+	return frame;
+}
+
+void obs_source_submit_frame(obs_source_t *source,
+			     struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_submit_frame"))
+		return;
+	if (!obs_ptr_valid(frame, "obs_source_submit_frame"))
+		return;
+
+	queue_pooled_frame(source, frame);
+}
+
+void obs_source_release_output_frame(obs_source_t *source,
+				     struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_release_output_frame"))
+		return;
+	if (!frame)
+		return;
 
-	/* ------------------------------------------- */
 	pthread_mutex_lock(&source->async_mutex);
-	if (output) {
-		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		} else {
-			da_push_back(source->async_frames, &output);
-			source->async_active = true;
-		}
-	}
+	if (os_atomic_dec_long(&frame->refs) == 0)
+		obs_source_frame_destroy(frame);
+	else
+		remove_async_frame(source, frame);
 	pthread_mutex_unlock(&source->async_mutex);
 }
 
@@ -3310,6 +3481,7 @@ static void copy_audio_data(obs_source_t *source, const uint8_t *const data[],
 	size_t blocksize = audio_output_get_block_size(obs->audio.audio);
 	size_t size = (size_t)frames * blocksize;
 	bool resize = source->audio_storage_size < size;
+	struct bmem_arena *arena = bmem_arena_get_builtin(BMEM_ARENA_AUDIO);
 
 	source->audio_data.frames = frames;
 	source->audio_data.timestamp = ts;
@@ -3318,7 +3490,7 @@ static void copy_audio_data(obs_source_t *source, const uint8_t *const data[],
 		/* ensure audio storage capacity */
 		if (resize) {
 			bfree(source->audio_data.data[i]);
-			source->audio_data.data[i] = bmalloc(size);
+			source->audio_data.data[i] = bmalloc_arena(arena, size);
 		}
 
 		if (data[i] != NULL)
@@ -3485,6 +3657,7 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 		while (source->async_frames.num > 1) {
 			da_erase(source->async_frames, 0);
 			remove_async_frame(source, next_frame);
+			source->async_stats.late_frames++;
 			next_frame = source->async_frames.array[0];
 		}
 
@@ -3523,8 +3696,10 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 		if ((source->last_frame_ts - next_frame->timestamp) < 2000000)
 			break;
 
-		if (frame)
+		if (frame) {
 			da_erase(source->async_frames, 0);
+			source->async_stats.late_frames++;
+		}
 
 #if DEBUG_ASYNC_FRAMES
 		blog(LOG_DEBUG,
@@ -3644,10 +3819,11 @@ void obs_source_set_name(obs_source_t *source, const char *name)
 	if (!name || !*name || !source->context.name ||
 	    strcmp(name, source->context.name) != 0) {
 		struct calldata data;
+		uint8_t stack[256];
 		char *prev_name = bstrdup(source->context.name);
 		obs_context_data_setname(&source->context, name);
 
-		calldata_init(&data);
+		calldata_init_inline(&data, stack, sizeof(stack));
 		calldata_set_ptr(&data, "source", source);
 		calldata_set_string(&data, "new_name", source->context.name);
 		calldata_set_string(&data, "prev_name", prev_name);
@@ -4852,6 +5028,10 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers,
 						    &main_audio_data, mixers,
 						    channels, sample_rate);
 	} else {
+		/* scenes and transitions clear this in their streaming pass
+		 * and set it again if anything differs between the outputs */
+		source->audio_outputs_differ = true;
+
 		obs_set_audio_rendering_mode(OBS_STREAMING_AUDIO_RENDERING);
 		success = source->info.audio_render(source->context.data, &ts,
 						    &streaming_audio_data,
@@ -4953,6 +5133,9 @@ static inline void process_audio_source_tick(obs_source_t *source,
 
 	pthread_mutex_unlock(&source->audio_buf_mutex);
 
+	/* every rendering mode receives the same input audio */
+	source->audio_outputs_differ = false;
+
 	for (size_t mix = 1; mix < MAX_AUDIO_MIXES; mix++) {
 		uint32_t mix_and_val = (1 << mix);
 
@@ -5143,6 +5326,39 @@ bool obs_source_async_unbuffered(const obs_source_t *source)
 		       : false;
 }
 
+void obs_source_set_async_overrun_policy(obs_source_t *source,
+					 enum obs_async_overrun_policy policy)
+{
+	if (!obs_source_valid(source, "obs_source_set_async_overrun_policy"))
+		return;
+
+	source->async_overrun_policy = policy;
+	os_event_signal(source->async_space_event);
+}
+
+enum obs_async_overrun_policy
+obs_source_get_async_overrun_policy(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_get_async_overrun_policy")
+		       ? source->async_overrun_policy
+		       : OBS_ASYNC_OVERRUN_FLUSH;
+}
+
+bool obs_source_get_async_stats(obs_source_t *source,
+				struct obs_source_async_stats *stats)
+{
+	if (!obs_source_valid(source, "obs_source_get_async_stats"))
+		return false;
+	if (!obs_ptr_valid(stats, "obs_source_get_async_stats"))
+		return false;
+
+	pthread_mutex_lock(&source->async_mutex);
+	*stats = source->async_stats;
+	stats->queued_frames = (uint32_t)source->async_frames.num;
+	pthread_mutex_unlock(&source->async_mutex);
+	return true;
+}
+
 obs_data_t *obs_source_get_private_settings(obs_source_t *source)
 {
 	if (!obs_ptr_valid(source, "obs_source_get_private_settings"))
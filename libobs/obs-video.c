@@ -112,12 +112,12 @@ static inline void set_render_size(uint32_t width, uint32_t height)
 	gs_set_viewport(0, 0, width, height);
 }
 
-static inline void unmap_last_surface(struct obs_core_video *video)
+static inline void unmap_last_surface(struct obs_textures *textures)
 {
 	for (int c = 0; c < NUM_CHANNELS; ++c) {
-		if (video->mapped_surfaces[c]) {
-			gs_stagesurface_unmap(video->mapped_surfaces[c]);
-			video->mapped_surfaces[c] = NULL;
+		if (textures->mapped_surfaces[c]) {
+			gs_stagesurface_unmap(textures->mapped_surfaces[c]);
+			textures->mapped_surfaces[c] = NULL;
 		}
 	}
 }
@@ -367,12 +367,13 @@ static void render_convert_texture(struct obs_core_video *video,
 
 static const char *stage_output_texture_name = "stage_output_texture";
 static inline void stage_output_texture(struct obs_core_video *video,
-					int cur_texture,
 					enum obs_video_rendering_mode mode)
 {
+	uint32_t cur_texture = video->textures[mode].cur_texture;
+
 	profile_start(stage_output_texture_name);
 
-	unmap_last_surface(video);
+	unmap_last_surface(&video->textures[mode]);
 
 	if (!video->gpu_conversion) {
 		gs_stagesurf_t *copy =
@@ -524,7 +525,7 @@ end:
 #endif
 
 static inline void render_video(struct obs_core_video *video, bool raw_active,
-				const bool gpu_active, int cur_texture,
+				const bool gpu_active,
 				enum obs_video_rendering_mode mode)
 {
 	gs_begin_scene();
@@ -553,7 +554,7 @@ static inline void render_video(struct obs_core_video *video, bool raw_active,
 #endif
 
 		if (raw_active)
-			stage_output_texture(video, cur_texture, mode);
+			stage_output_texture(video, mode);
 	}
 
 	gs_set_render_target(NULL, NULL);
@@ -562,49 +563,262 @@ static inline void render_video(struct obs_core_video *video, bool raw_active,
 	gs_end_scene();
 }
 
+/* a map that takes longer than this is counted as having blocked on the GPU;
+ * the graphics API has no way to ask whether a map would block, so this is
+ * the closest we can get without stalling to find out */
+#define MAP_STALL_THRESHOLD_NS 1000000ULL
+
+static inline bool map_staged_surface(struct obs_textures *textures,
+				      gs_stagesurf_t *surface, uint8_t **data,
+				      uint32_t *linesize)
+{
+	uint64_t start = os_gettime_ns();
+	bool success = gs_stagesurface_map(surface, data, linesize);
+
+	os_atomic_inc_long(&textures->maps);
+	if (os_gettime_ns() - start >= MAP_STALL_THRESHOLD_NS)
+		os_atomic_inc_long(&textures->map_stalls);
+	return success;
+}
+
+/* reads back the oldest staged surface, which was staged staging_depth - 1
+ * frames ago */
 static inline bool download_frame(struct obs_core_video *video,
-				  int prev_texture, struct video_data *frame,
+				  struct video_data *frame,
 				  enum obs_video_rendering_mode mode)
 {
-	if (!video->textures[mode].textures_copied[prev_texture])
+	struct obs_textures *textures = &video->textures[mode];
+	uint32_t read_texture =
+		(textures->cur_texture + 1) % textures->staging_depth;
+
+	if (!textures->textures_copied[read_texture])
 		return false;
 
 	for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
 		gs_stagesurf_t *surface =
-			video->textures[mode]
-				.copy_surfaces[prev_texture][channel];
+			textures->copy_surfaces[read_texture][channel];
 		if (surface) {
-			if (!gs_stagesurface_map(surface, &frame->data[channel],
-						 &frame->linesize[channel]))
+			if (!map_staged_surface(textures, surface,
+						&frame->data[channel],
+						&frame->linesize[channel]))
 				return false;
 
-			video->mapped_surfaces[channel] = surface;
+			textures->mapped_surfaces[channel] = surface;
 		}
 	}
 	return true;
 }
 
-static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
-					      uint32_t linesize_input,
-					      uint32_t linesize_output,
-					      const uint8_t *in, uint8_t *out)
+/* ------------------------------------------------------------------------- */
+/* striped frame copies */
+
+/* Large frames are copied out of the staging surfaces by a small pool of
+ * workers.  Every plane is split into horizontal stripes; the graphics thread
+ * copies the first stripe itself and waits for the others, so the mapped
+ * surfaces are never touched after output_video_data returns. */
+#define MAX_COPY_WORKERS 3
+#define MAX_PLANE_COPIES (NUM_CHANNELS * 2)
+
+struct plane_copy {
+	const uint8_t *in;
+	uint8_t *out;
+	size_t row_size;
+	uint32_t height;
+	uint32_t in_linesize;
+	uint32_t out_linesize;
+};
+
+struct frame_copies {
+	struct plane_copy planes[MAX_PLANE_COPIES];
+	size_t num;
+	uint64_t total_size;
+};
+
+struct video_copy_pool {
+	pthread_t threads[MAX_COPY_WORKERS];
+	os_sem_t *start_sems[MAX_COPY_WORKERS];
+	size_t num_threads;
+	os_event_t *done_event;
+	bool stop;
+
+	const struct frame_copies *copies;
+	volatile long pending;
+};
+
+static void copy_stripe(const struct frame_copies *copies, size_t stripe,
+			size_t num_stripes)
 {
-	if ((width == linesize_input) && (width == linesize_output)) {
-		size_t total = (size_t)width * (size_t)height;
-		memcpy(out, in, total);
-		in += total;
-	} else {
-		for (size_t y = 0; y < height; y++) {
-			memcpy(out, in, width);
-			out += linesize_output;
-			in += linesize_input;
+	for (size_t i = 0; i < copies->num; i++) {
+		const struct plane_copy *plane = &copies->planes[i];
+		size_t start = plane->height * stripe / num_stripes;
+		size_t end = plane->height * (stripe + 1) / num_stripes;
+		const uint8_t *in = plane->in + start * plane->in_linesize;
+		uint8_t *out = plane->out + start * plane->out_linesize;
+
+		if (plane->row_size == plane->in_linesize &&
+		    plane->row_size == plane->out_linesize) {
+			memcpy(out, in, plane->row_size * (end - start));
+			continue;
+		}
+
+		for (size_t y = start; y < end; y++) {
+			memcpy(out, in, plane->row_size);
+			in += plane->in_linesize;
+			out += plane->out_linesize;
 		}
 	}
+}
+
+struct copy_worker_param {
+	struct video_copy_pool *pool;
+	size_t idx;
+};
+
+static void *copy_worker_thread(void *data)
+{
+	struct copy_worker_param *param = data;
+	struct video_copy_pool *pool = param->pool;
+	size_t idx = param->idx;
+
+	bfree(param);
+
+	os_set_thread_name("libobs: frame copy worker");
 
-	return in;
+	while (os_sem_wait(pool->start_sems[idx]) == 0) {
+		if (pool->stop)
+			break;
+
+		copy_stripe(pool->copies, idx + 1, pool->num_threads + 1);
+
+		if (os_atomic_dec_long(&pool->pending) == 0)
+			os_event_signal(pool->done_event);
+	}
+
+	return NULL;
+}
+
+void video_copy_pool_destroy(struct video_copy_pool *pool)
+{
+	if (!pool)
+		return;
+
+	pool->stop = true;
+	for (size_t i = 0; i < pool->num_threads; i++) {
+		os_sem_post(pool->start_sems[i]);
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	for (size_t i = 0; i < MAX_COPY_WORKERS; i++)
+		os_sem_destroy(pool->start_sems[i]);
+	os_event_destroy(pool->done_event);
+	bfree(pool);
+}
+
+static struct video_copy_pool *video_copy_pool_create(void)
+{
+	struct video_copy_pool *pool;
+	int workers = os_get_logical_cores() - 1;
+
+	if (workers > MAX_COPY_WORKERS)
+		workers = MAX_COPY_WORKERS;
+	if (workers < 1)
+		return NULL;
+
+	pool = bzalloc(sizeof(struct video_copy_pool));
+
+	if (os_event_init(&pool->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	for (int i = 0; i < workers; i++) {
+		struct copy_worker_param *param;
+
+		if (os_sem_init(&pool->start_sems[i], 0) != 0)
+			goto fail;
+
+		param = bmalloc(sizeof(*param));
+		param->pool = pool;
+		param->idx = i;
+
+		if (pthread_create(&pool->threads[i], NULL, copy_worker_thread,
+				   param) != 0) {
+			bfree(param);
+			goto fail;
+		}
+
+		pool->num_threads++;
+	}
+
+	blog(LOG_INFO, "Using %d threads for large frame copies", workers + 1);
+	return pool;
+
+fail:
+	blog(LOG_WARNING, "Failed to create frame copy workers");
+	video_copy_pool_destroy(pool);
+	return NULL;
+}
+
+static inline bool use_parallel_copy(struct obs_core_video *video,
+				     const struct frame_copies *copies)
+{
+	uint64_t threshold = video->parallel_copy_threshold;
+
+	if (!threshold || copies->total_size < threshold)
+		return false;
+
+	if (!video->copy_pool && !video->copy_pool_failed) {
+		video->copy_pool = video_copy_pool_create();
+		video->copy_pool_failed = !video->copy_pool;
+	}
+
+	return video->copy_pool != NULL;
+}
+
+static const char *copy_frame_planes_name = "copy_frame_planes";
+
+static void copy_frame_planes(struct obs_core_video *video,
+			      const struct frame_copies *copies)
+{
+	profile_start(copy_frame_planes_name);
+
+	if (use_parallel_copy(video, copies)) {
+		struct video_copy_pool *pool = video->copy_pool;
+
+		pool->copies = copies;
+		os_atomic_set_long(&pool->pending, (long)pool->num_threads);
+
+		for (size_t i = 0; i < pool->num_threads; i++)
+			os_sem_post(pool->start_sems[i]);
+
+		copy_stripe(copies, 0, pool->num_threads + 1);
+		os_event_wait(pool->done_event);
+	} else {
+		copy_stripe(copies, 0, 1);
+	}
+
+	profile_end(copy_frame_planes_name);
+}
+
+static const uint8_t *add_plane_copy(struct frame_copies *copies,
+				     uint32_t width, uint32_t height,
+				     uint32_t linesize_input,
+				     uint32_t linesize_output,
+				     const uint8_t *in, uint8_t *out)
+{
+	struct plane_copy *plane = &copies->planes[copies->num++];
+
+	plane->in = in;
+	plane->out = out;
+	plane->row_size = width;
+	plane->height = height;
+	plane->in_linesize = linesize_input;
+	plane->out_linesize = linesize_output;
+	copies->total_size += (uint64_t)width * height;
+
+	return in + (size_t)linesize_input * height;
 }
 
 static void set_gpu_converted_data(struct obs_core_video *video,
+				   struct frame_copies *copies,
 				   struct video_frame *output,
 				   const struct video_data *input,
 				   const struct video_output_info *info)
@@ -613,40 +827,33 @@ static void set_gpu_converted_data(struct obs_core_video *video,
 		const uint32_t width = info->width;
 		const uint32_t height = info->height;
 
-		const uint8_t *const in_uv = set_gpu_converted_plane(
-			width, height, input->linesize[0], output->linesize[0],
-			input->data[0], output->data[0]);
+		const uint8_t *const in_uv = add_plane_copy(
+			copies, width, height, input->linesize[0],
+			output->linesize[0], input->data[0], output->data[0]);
 
 		const uint32_t height_d2 = height / 2;
-		set_gpu_converted_plane(width, height_d2, input->linesize[0],
-					output->linesize[1], in_uv,
-					output->data[1]);
+		add_plane_copy(copies, width, height_d2, input->linesize[0],
+			       output->linesize[1], in_uv, output->data[1]);
 	} else {
 		switch (info->format) {
 		case VIDEO_FORMAT_I420: {
 			const uint32_t width = info->width;
 			const uint32_t height = info->height;
 
-			set_gpu_converted_plane(width, height,
-						input->linesize[0],
-						output->linesize[0],
-						input->data[0],
-						output->data[0]);
+			add_plane_copy(copies, width, height,
+				       input->linesize[0], output->linesize[0],
+				       input->data[0], output->data[0]);
 
 			const uint32_t width_d2 = width / 2;
 			const uint32_t height_d2 = height / 2;
 
-			set_gpu_converted_plane(width_d2, height_d2,
-						input->linesize[1],
-						output->linesize[1],
-						input->data[1],
-						output->data[1]);
+			add_plane_copy(copies, width_d2, height_d2,
+				       input->linesize[1], output->linesize[1],
+				       input->data[1], output->data[1]);
 
-			set_gpu_converted_plane(width_d2, height_d2,
-						input->linesize[2],
-						output->linesize[2],
-						input->data[2],
-						output->data[2]);
+			add_plane_copy(copies, width_d2, height_d2,
+				       input->linesize[2], output->linesize[2],
+				       input->data[2], output->data[2]);
 
 			break;
 		}
@@ -654,18 +861,14 @@ static void set_gpu_converted_data(struct obs_core_video *video,
 			const uint32_t width = info->width;
 			const uint32_t height = info->height;
 
-			set_gpu_converted_plane(width, height,
-						input->linesize[0],
-						output->linesize[0],
-						input->data[0],
-						output->data[0]);
+			add_plane_copy(copies, width, height,
+				       input->linesize[0], output->linesize[0],
+				       input->data[0], output->data[0]);
 
 			const uint32_t height_d2 = height / 2;
-			set_gpu_converted_plane(width, height_d2,
-						input->linesize[1],
-						output->linesize[1],
-						input->data[1],
-						output->data[1]);
+			add_plane_copy(copies, width, height_d2,
+				       input->linesize[1], output->linesize[1],
+				       input->data[1], output->data[1]);
 
 			break;
 		}
@@ -673,23 +876,17 @@ static void set_gpu_converted_data(struct obs_core_video *video,
 			const uint32_t width = info->width;
 			const uint32_t height = info->height;
 
-			set_gpu_converted_plane(width, height,
-						input->linesize[0],
-						output->linesize[0],
-						input->data[0],
-						output->data[0]);
+			add_plane_copy(copies, width, height,
+				       input->linesize[0], output->linesize[0],
+				       input->data[0], output->data[0]);
 
-			set_gpu_converted_plane(width, height,
-						input->linesize[1],
-						output->linesize[1],
-						input->data[1],
-						output->data[1]);
+			add_plane_copy(copies, width, height,
+				       input->linesize[1], output->linesize[1],
+				       input->data[1], output->data[1]);
 
-			set_gpu_converted_plane(width, height,
-						input->linesize[2],
-						output->linesize[2],
-						input->data[2],
-						output->data[2]);
+			add_plane_copy(copies, width, height,
+				       input->linesize[2], output->linesize[2],
+				       input->data[2], output->data[2]);
 
 			break;
 		}
@@ -714,25 +911,20 @@ static void set_gpu_converted_data(struct obs_core_video *video,
 	}
 }
 
-static inline void copy_rgbx_frame(struct video_frame *output,
+static inline void copy_rgbx_frame(struct frame_copies *copies,
+				   struct video_frame *output,
 				   const struct video_data *input,
 				   const struct video_output_info *info)
 {
-	uint8_t *in_ptr = input->data[0];
-	uint8_t *out_ptr = output->data[0];
-
-	/* if the line sizes match, do a single copy */
-	if (input->linesize[0] == output->linesize[0]) {
-		memcpy(out_ptr, in_ptr,
-		       (size_t)input->linesize[0] * (size_t)info->height);
-	} else {
-		const size_t copy_size = (size_t)info->width * 4;
-		for (size_t y = 0; y < info->height; y++) {
-			memcpy(out_ptr, in_ptr, copy_size);
-			in_ptr += input->linesize[0];
-			out_ptr += output->linesize[0];
-		}
-	}
+	/* if the line sizes match, this becomes a single copy */
+	if (input->linesize[0] == output->linesize[0])
+		add_plane_copy(copies, input->linesize[0], info->height,
+			       input->linesize[0], output->linesize[0],
+			       input->data[0], output->data[0]);
+	else
+		add_plane_copy(copies, info->width * 4, info->height,
+			       input->linesize[0], output->linesize[0],
+			       input->data[0], output->data[0]);
 }
 
 static inline void output_video_data(struct obs_core_video *video,
@@ -746,6 +938,7 @@ static inline void output_video_data(struct obs_core_video *video,
 	struct video_frame main_output_frame;
 	struct video_frame streaming_output_frame;
 	struct video_frame recording_output_frame;
+	struct frame_copies copies = {0};
 
 	output_frames[OBS_MAIN_VIDEO_RENDERING] = &main_output_frame;
 	output_frames[OBS_STREAMING_VIDEO_RENDERING] = &streaming_output_frame;
@@ -766,37 +959,46 @@ static inline void output_video_data(struct obs_core_video *video,
 	if (locked) {
 		if (!obs_get_multiple_rendering()) {
 			if (video->gpu_conversion) {
-				set_gpu_converted_data(video,
+				set_gpu_converted_data(video, &copies,
 						       &main_output_frame,
 						       main_input_frame, info);
 
 			} else {
-				copy_rgbx_frame(&main_output_frame,
+				copy_rgbx_frame(&copies, &main_output_frame,
 						main_input_frame, info);
 			}
 		} else {
 			if (video->gpu_conversion) {
-				set_gpu_converted_data(video,
+				set_gpu_converted_data(video, &copies,
 						       &streaming_output_frame,
 						       streaming_input_frame,
 						       info);
-				set_gpu_converted_data(video,
+				set_gpu_converted_data(video, &copies,
 						       &recording_output_frame,
 						       recording_input_frame,
 						       info);
 
 			} else {
-				copy_rgbx_frame(&streaming_output_frame,
+				copy_rgbx_frame(&copies,
+						&streaming_output_frame,
 						streaming_input_frame, info);
-				copy_rgbx_frame(&recording_output_frame,
+				copy_rgbx_frame(&copies,
+						&recording_output_frame,
 						recording_input_frame, info);
 			}
 		}
 
+		copy_frame_planes(video, &copies);
 		video_output_unlock_frame(video->video);
 	}
 }
 
+static inline enum obs_video_rendering_mode last_rendering_mode(void)
+{
+	return obs_get_multiple_rendering() ? OBS_RECORDING_VIDEO_RENDERING
+					    : OBS_MAIN_VIDEO_RENDERING;
+}
+
 static inline void video_sleep(struct obs_core_video *video, bool raw_active,
 			       const bool gpu_active, uint64_t *p_time,
 			       uint64_t interval_ns)
@@ -820,9 +1022,15 @@ static inline void video_sleep(struct obs_core_video *video, bool raw_active,
 	vframe_info.timestamp = cur_time;
 	vframe_info.count = count;
 
-	if (raw_active)
-		circlebuf_push_back(&video->vframe_info_buffer, &vframe_info,
-				    sizeof(vframe_info));
+	if (raw_active) {
+		enum obs_video_rendering_mode end = last_rendering_mode();
+		for (enum obs_video_rendering_mode mode =
+			     OBS_MAIN_VIDEO_RENDERING;
+		     mode <= end; mode++)
+			circlebuf_push_back(
+				&video->textures[mode].vframe_info_buffer,
+				&vframe_info, sizeof(vframe_info));
+	}
 	if (gpu_active)
 		circlebuf_push_back(&video->vframe_info_buffer_gpu,
 				    &vframe_info, sizeof(vframe_info));
@@ -836,13 +1044,9 @@ static const char *output_frame_output_video_data_name = "output_video_data";
 static inline void output_frame(bool raw_active, const bool gpu_active)
 {
 	struct obs_core_video *video = &obs->video;
-	int cur_texture = video->cur_texture;
-	int prev_texture = cur_texture == 0 ? NUM_TEXTURES - 1
-					    : cur_texture - 1;
-	struct video_data main_frame = {0};
-	struct video_data streaming_frame = {0};
-	struct video_data recording_frame = {0};
-	bool frame_ready = 0;
+	struct video_data frames[NUM_RENDERING_MODES] = {0};
+	struct obs_vframe_info vframe_info[NUM_RENDERING_MODES];
+	bool frame_ready[NUM_RENDERING_MODES] = {0};
 
 	profile_start(output_frame_gs_context_name);
 	gs_enter_context(video->graphics);
@@ -852,30 +1056,13 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 			      output_frame_render_video_name);
 
 	enum obs_video_rendering_mode start = OBS_MAIN_VIDEO_RENDERING;
-	enum obs_video_rendering_mode end =
-		obs_get_multiple_rendering() ? OBS_RECORDING_VIDEO_RENDERING
-					     : OBS_MAIN_VIDEO_RENDERING;
+	enum obs_video_rendering_mode end = last_rendering_mode();
 	for (enum obs_video_rendering_mode mode = start; mode <= end; mode++) {
-		render_video(video, raw_active, gpu_active, cur_texture, mode);
+		render_video(video, raw_active, gpu_active, mode);
 		if (raw_active) {
 			profile_start(output_frame_download_frame_name);
-			switch (mode) {
-			case OBS_MAIN_VIDEO_RENDERING: {
-				frame_ready = download_frame(
-					video, prev_texture, &main_frame, mode);
-				break;
-			}
-			case OBS_STREAMING_VIDEO_RENDERING: {
-				frame_ready = download_frame(
-					video, prev_texture, &streaming_frame, mode);
-				break;
-			}
-			case OBS_RECORDING_VIDEO_RENDERING: {
-				frame_ready = download_frame(
-					video, prev_texture, &recording_frame, mode);
-				break;
-			}
-			}
+			frame_ready[mode] =
+				download_frame(video, &frames[mode], mode);
 			profile_end(output_frame_download_frame_name);
 		}
 	}
@@ -890,25 +1077,41 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 	gs_leave_context();
 	profile_end(output_frame_gs_context_name);
 
-	if (raw_active && frame_ready) {
-		struct obs_vframe_info vframe_info;
-		circlebuf_pop_front(&video->vframe_info_buffer, &vframe_info,
-				    sizeof(vframe_info));
-
-		if (!obs_get_multiple_rendering()) {
-			main_frame.timestamp = vframe_info.timestamp;
+	/* with different depths per mode the modes start producing frames on
+	 * different ticks; a frame is only output once every mode that feeds
+	 * the output has one */
+	bool output_ready = raw_active;
+	start = end == OBS_MAIN_VIDEO_RENDERING ? OBS_MAIN_VIDEO_RENDERING
+						: OBS_STREAMING_VIDEO_RENDERING;
+
+	for (enum obs_video_rendering_mode mode = OBS_MAIN_VIDEO_RENDERING;
+	     mode <= end; mode++) {
+		struct obs_textures *textures = &video->textures[mode];
+
+		if (frame_ready[mode] && textures->vframe_info_buffer.size) {
+			circlebuf_pop_front(&textures->vframe_info_buffer,
+					    &vframe_info[mode],
+					    sizeof(vframe_info[mode]));
+			frames[mode].timestamp = vframe_info[mode].timestamp;
 		} else {
-			streaming_frame.timestamp = vframe_info.timestamp;
-			recording_frame.timestamp = vframe_info.timestamp;
+			frame_ready[mode] = false;
 		}
+
+		if (mode >= start && !frame_ready[mode])
+			output_ready = false;
+
+		if (++textures->cur_texture == textures->staging_depth)
+			textures->cur_texture = 0;
+	}
+
+	if (output_ready) {
 		profile_start(output_frame_output_video_data_name);
-		output_video_data(video, &main_frame, &streaming_frame,
-				  &recording_frame, vframe_info.count);
+		output_video_data(video, &frames[OBS_MAIN_VIDEO_RENDERING],
+				  &frames[OBS_STREAMING_VIDEO_RENDERING],
+				  &frames[OBS_RECORDING_VIDEO_RENDERING],
+				  vframe_info[start].count);
 		profile_end(output_frame_output_video_data_name);
 	}
-
-	if (++video->cur_texture == NUM_TEXTURES)
-		video->cur_texture = 0;
 }
 
 #define NBSP "\xC2\xA0"
@@ -919,18 +1122,19 @@ static void clear_base_frame_data(void)
 	for (size_t i = 0; i < NUM_RENDERING_MODES; i++) {
 		video->textures[i].texture_rendered = false;
 		video->textures[i].texture_converted = false;
+		video->textures[i].cur_texture = 0;
+		circlebuf_free(&video->textures[i].vframe_info_buffer);
 	}
-	circlebuf_free(&video->vframe_info_buffer);
-	video->cur_texture = 0;
 }
 
 static void clear_raw_frame_data(void)
 {
 	struct obs_core_video *video = &obs->video;
-	for (size_t i = 0; i < NUM_RENDERING_MODES; i++)
+	for (size_t i = 0; i < NUM_RENDERING_MODES; i++) {
 		memset(video->textures[i].textures_copied, 0,
 		       sizeof(video->textures[i].textures_copied));
-	circlebuf_free(&video->vframe_info_buffer);
+		circlebuf_free(&video->textures[i].vframe_info_buffer);
+	}
 }
 
 #ifdef _WIN32
@@ -1103,6 +1307,7 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	profile_end(render_displays_name);
 
 	frame_time_ns = os_gettime_ns() - frame_start;
+	histogram_record(&obs->video.frame_time_histogram, frame_time_ns);
 
 	profile_end(context->video_thread_name);
 
@@ -215,7 +215,10 @@ static bool obs_init_textures(struct obs_video_info *ovi)
 	struct obs_core_video *video = &obs->video;
 
 	for (size_t i = 0; i < NUM_RENDERING_MODES; i++) {
-		for (size_t j = 0; j < NUM_TEXTURES; j++) {
+		video->textures[i].staging_depth = ovi->staging_depth[i];
+		video->textures[i].cur_texture = 0;
+
+		for (size_t j = 0; j < ovi->staging_depth[i]; j++) {
 #ifdef _WIN32
 			if (video->using_nv12_tex) {
 				video->textures[i].copy_surfaces[j][0] =
@@ -426,6 +429,9 @@ static int obs_init_video(struct obs_video_info *ovi)
 		return OBS_VIDEO_FAIL;
 	}
 
+	video_output_set_parallel_delivery(video->video,
+					   video->parallel_delivery);
+
 	gs_enter_context(video->graphics);
 
 	if (ovi->gpu_conversion && !obs_init_gpu_conversion(ovi))
@@ -473,6 +479,31 @@ static void stop_video(void)
 	}
 }
 
+static const char *rendering_mode_names[NUM_RENDERING_MODES] = {
+	"main",
+	"streaming",
+	"recording",
+};
+
+static void log_staging_stats(struct obs_core_video *video)
+{
+	for (size_t i = 0; i < NUM_RENDERING_MODES; i++) {
+		struct obs_textures *textures = &video->textures[i];
+		long maps = os_atomic_load_long(&textures->maps);
+		long stalls = os_atomic_load_long(&textures->map_stalls);
+
+		if (!stalls)
+			continue;
+
+		blog(LOG_INFO,
+		     "Video staging (%s): %ld of %ld readbacks blocked "
+		     "(%.1f%%) at a depth of %" PRIu32,
+		     rendering_mode_names[i], stalls, maps,
+		     (double)stalls / (double)maps * 100.0,
+		     textures->staging_depth);
+	}
+}
+
 static void obs_free_video(void)
 {
 	struct obs_core_video *video = &obs->video;
@@ -481,16 +512,26 @@ static void obs_free_video(void)
 		video_output_close(video->video);
 		video->video = NULL;
 
+		video_copy_pool_destroy(video->copy_pool);
+		video->copy_pool = NULL;
+		video->copy_pool_failed = false;
+
 		if (!video->graphics)
 			return;
 
+		log_staging_stats(video);
+
 		gs_enter_context(video->graphics);
 
-		for (size_t c = 0; c < NUM_CHANNELS; c++) {
-			if (video->mapped_surfaces[c]) {
-				gs_stagesurface_unmap(
-					video->mapped_surfaces[c]);
-				video->mapped_surfaces[c] = NULL;
+		for (size_t i = 0; i < NUM_RENDERING_MODES; i++) {
+			struct obs_textures *textures = &video->textures[i];
+
+			for (size_t c = 0; c < NUM_CHANNELS; c++) {
+				if (textures->mapped_surfaces[c]) {
+					gs_stagesurface_unmap(
+						textures->mapped_surfaces[c]);
+					textures->mapped_surfaces[c] = NULL;
+				}
 			}
 		}
 
@@ -549,7 +590,6 @@ static void obs_free_video(void)
 
 		gs_leave_context();
 
-		circlebuf_free(&video->vframe_info_buffer);
 		circlebuf_free(&video->vframe_info_buffer_gpu);
 
 		for (size_t i = 0; i < NUM_RENDERING_MODES; i++) {
@@ -558,6 +598,10 @@ static void obs_free_video(void)
 			memset(video->textures[i].textures_copied, 0,
 			       sizeof(video->textures[i].textures_copied));
 			video->textures[i].texture_converted = false;
+			video->textures[i].cur_texture = 0;
+			video->textures[i].maps = 0;
+			video->textures[i].map_stalls = 0;
+			circlebuf_free(&video->textures[i].vframe_info_buffer);
 		}
 
 
@@ -570,7 +614,6 @@ static void obs_free_video(void)
 		circlebuf_free(&video->tasks);
 
 		video->gpu_encoder_active = 0;
-		video->cur_texture = 0;
 	}
 }
 
@@ -705,6 +748,12 @@ void obs_main_view_free(struct obs_view *view)
 	pthread_mutex_destroy(&view->channels_mutex);
 }
 
+static inline void context_index_free(struct obs_context_index *index)
+{
+	bfree(index->buckets);
+	memset(index, 0, sizeof(*index));
+}
+
 #define FREE_OBS_LINKED_LIST(type)                                         \
 	do {                                                               \
 		int unfreed = 0;                                           \
@@ -733,6 +782,11 @@ static void obs_free_data(void)
 	FREE_OBS_LINKED_LIST(display);
 	FREE_OBS_LINKED_LIST(service);
 
+	context_index_free(&data->sources_index);
+	context_index_free(&data->outputs_index);
+	context_index_free(&data->encoders_index);
+	context_index_free(&data->services_index);
+
 	pthread_mutex_destroy(&data->sources_mutex);
 	pthread_mutex_destroy(&data->audio_sources_mutex);
 	pthread_mutex_destroy(&data->displays_mutex);
@@ -919,6 +973,7 @@ static bool obs_init(const char *locale, const char *module_config_path,
 		OBS_RECORDING_REPLAY_BUFFER_RENDERING;
 	obs->video_rendering_mode = OBS_MAIN_VIDEO_RENDERING;
 	obs->audio_rendering_mode = OBS_MAIN_AUDIO_RENDERING;
+	obs->video.parallel_copy_threshold = DEFAULT_PARALLEL_COPY_THRESHOLD;
 	return true;
 }
 
@@ -1096,6 +1151,9 @@ void obs_shutdown(void)
 	obs = NULL;
 	bfree(cmdline_args.argv);
 
+	if (bmem_tracking_enabled())
+		bmem_log_tracked(LOG_INFO, 50);
+
 #ifdef _WIN32
 	if (com_initialized)
 		uninitialize_com();
@@ -1170,6 +1228,12 @@ int obs_reset_video(struct obs_video_info *ovi)
 	ovi->output_width &= 0xFFFFFFFC;
 	ovi->output_height &= 0xFFFFFFFE;
 
+	for (size_t i = 0; i < NUM_RENDERING_MODES; i++) {
+		uint32_t depth = ovi->staging_depth[i];
+		if (depth < MIN_STAGING_DEPTH || depth > NUM_TEXTURES)
+			ovi->staging_depth[i] = DEFAULT_STAGING_DEPTH;
+	}
+
 	if (!video->graphics) {
 		int errorcode = obs_init_graphics(ovi);
 		if (errorcode != OBS_VIDEO_SUCCESS) {
@@ -1213,11 +1277,15 @@ int obs_reset_video(struct obs_video_info *ovi)
 	     "\tdownscale filter:  %s\n"
 	     "\tfps:               %d/%d\n"
 	     "\tformat:            %s\n"
-	     "\tYUV mode:          %s%s%s",
+	     "\tYUV mode:          %s%s%s\n"
+	     "\tstaging depth:     %" PRIu32 "/%" PRIu32 "/%" PRIu32,
 	     ovi->base_width, ovi->base_height, ovi->output_width,
 	     ovi->output_height, scale_type_name, ovi->fps_num, ovi->fps_den,
 	     get_video_format_name(ovi->output_format),
-	     yuv ? yuv_format : "None", yuv ? "/" : "", yuv ? yuv_range : "");
+	     yuv ? yuv_format : "None", yuv ? "/" : "", yuv ? yuv_range : "",
+	     ovi->staging_depth[OBS_MAIN_VIDEO_RENDERING],
+	     ovi->staging_depth[OBS_STREAMING_VIDEO_RENDERING],
+	     ovi->staging_depth[OBS_RECORDING_VIDEO_RENDERING]);
 
 	return obs_init_video(ovi);
 }
@@ -1261,6 +1329,49 @@ bool obs_get_video_info(struct obs_video_info *ovi)
 	return true;
 }
 
+void obs_set_parallel_copy_threshold(uint64_t size)
+{
+	if (!obs)
+		return;
+
+	obs->video.parallel_copy_threshold = size;
+}
+
+uint64_t obs_get_parallel_copy_threshold(void)
+{
+	return obs ? obs->video.parallel_copy_threshold : 0;
+}
+
+void obs_set_parallel_video_delivery(bool enable)
+{
+	if (!obs)
+		return;
+
+	obs->video.parallel_delivery = enable;
+	if (obs->video.video)
+		video_output_set_parallel_delivery(obs->video.video, enable);
+}
+
+bool obs_get_parallel_video_delivery(void)
+{
+	return obs ? obs->video.parallel_delivery : false;
+}
+
+bool obs_get_video_staging_stats(enum obs_video_rendering_mode mode,
+				 struct obs_video_staging_stats *stats)
+{
+	struct obs_textures *textures;
+
+	if (!obs || !stats || (size_t)mode >= NUM_RENDERING_MODES)
+		return false;
+
+	textures = &obs->video.textures[mode];
+	stats->depth = textures->staging_depth;
+	stats->maps = (uint64_t)os_atomic_load_long(&textures->maps);
+	stats->map_stalls = (uint64_t)os_atomic_load_long(&textures->map_stalls);
+	return true;
+}
+
 bool obs_get_audio_info(struct obs_audio_info *oai)
 {
 	struct obs_core_audio *audio = &obs->audio;
@@ -1464,7 +1575,8 @@ void obs_set_output_source(uint32_t channel, obs_source_t *source)
 
 	struct obs_source *prev_source;
 	struct obs_view *view = &obs->data.main_view;
-	struct calldata params = {0};
+	struct calldata params;
+	uint8_t stack[128];
 
 	pthread_mutex_lock(&view->channels_mutex);
 
@@ -1472,6 +1584,7 @@ void obs_set_output_source(uint32_t channel, obs_source_t *source)
 
 	prev_source = view->channels[channel];
 
+	calldata_init_inline(&params, stack, sizeof(stack));
 	calldata_set_int(&params, "channel", channel);
 	calldata_set_ptr(&params, "prev_source", prev_source);
 	calldata_set_ptr(&params, "source", source);
@@ -1621,22 +1734,124 @@ void obs_enum_services(bool (*enum_proc)(void *, obs_service_t *), void *param)
 		 param);
 }
 
-static inline void *get_context_by_name(void *vfirst, const char *name,
+static inline uint32_t context_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static inline struct obs_context_data **
+context_index_bucket(struct obs_context_index *index, uint32_t hash)
+{
+	return &index->buckets[hash & (index->num_buckets - 1)];
+}
+
+static inline void context_index_link(struct obs_context_index *index,
+				      struct obs_context_data *context)
+{
+	struct obs_context_data **bucket =
+		context_index_bucket(index, context->name_hash);
+
+	context->index_prev_next = bucket;
+	context->index_next = *bucket;
+	if (*bucket)
+		(*bucket)->index_prev_next = &context->index_next;
+	*bucket = context;
+}
+
+static void context_index_grow(struct obs_context_index *index)
+{
+	struct obs_context_data **old_buckets = index->buckets;
+	size_t old_num = index->num_buckets;
+
+	index->num_buckets = old_num ? old_num * 2 : 64;
+	index->buckets =
+		bzalloc(index->num_buckets * sizeof(struct obs_context_data *));
+
+	for (size_t i = 0; i < old_num; i++) {
+		struct obs_context_data *reversed = NULL;
+		struct obs_context_data *context = old_buckets[i];
+
+		/* contexts with the same name have to stay in the order they
+		 * were added, so each chain is reversed before it's moved */
+		while (context) {
+			struct obs_context_data *next = context->index_next;
+			context->index_next = reversed;
+			reversed = context;
+			context = next;
+		}
+
+		while (reversed) {
+			struct obs_context_data *next = reversed->index_next;
+			context_index_link(index, reversed);
+			reversed = next;
+		}
+	}
+
+	bfree(old_buckets);
+}
+
+/* private contexts can't be found by name, so they're never indexed */
+static void context_index_add(struct obs_context_data *context)
+{
+	struct obs_context_index *index = context->index;
+
+	if (!index || context->private || !context->name)
+		return;
+
+	if (index->count >= index->num_buckets)
+		context_index_grow(index);
+
+	context->name_hash = context_name_hash(context->name);
+	context_index_link(index, context);
+	index->count++;
+}
+
+static void context_index_remove(struct obs_context_data *context)
+{
+	if (!context->index_prev_next)
+		return;
+
+	*context->index_prev_next = context->index_next;
+	if (context->index_next)
+		context->index_next->index_prev_next = context->index_prev_next;
+
+	context->index_next = NULL;
+	context->index_prev_next = NULL;
+	context->index->count--;
+}
+
+static inline void *get_context_by_name(struct obs_context_index *index,
+					const char *name,
 					pthread_mutex_t *mutex,
 					void *(*addref)(void *))
 {
-	struct obs_context_data **first = vfirst;
-	struct obs_context_data *context;
+	struct obs_context_data *context = NULL;
+	uint32_t hash;
+
+	if (!name)
+		return NULL;
+
+	hash = context_name_hash(name);
 
 	pthread_mutex_lock(mutex);
 
-	context = *first;
+	if (index->num_buckets)
+		context = *context_index_bucket(index, hash);
+
 	while (context) {
-		if (!context->private && strcmp(context->name, name) == 0) {
+		if (context->name_hash == hash &&
+		    strcmp(context->name, name) == 0) {
 			context = addref(context);
 			break;
 		}
-		context = context->next;
+		context = context->index_next;
 	}
 
 	pthread_mutex_unlock(mutex);
@@ -1670,28 +1885,28 @@ static inline void *obs_id_(void *data)
 
 obs_source_t *obs_get_source_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_source, name,
+	return get_context_by_name(&obs->data.sources_index, name,
 				   &obs->data.sources_mutex,
 				   obs_source_addref_safe_);
 }
 
 obs_output_t *obs_get_output_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_output, name,
+	return get_context_by_name(&obs->data.outputs_index, name,
 				   &obs->data.outputs_mutex,
 				   obs_output_addref_safe_);
 }
 
 obs_encoder_t *obs_get_encoder_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_encoder, name,
+	return get_context_by_name(&obs->data.encoders_index, name,
 				   &obs->data.encoders_mutex,
 				   obs_encoder_addref_safe_);
 }
 
 obs_service_t *obs_get_service_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_service, name,
+	return get_context_by_name(&obs->data.services_index, name,
 				   &obs->data.services_mutex,
 				   obs_service_addref_safe_);
 }
@@ -1881,8 +2096,10 @@ enum obs_replay_buffer_rendering_mode obs_get_replay_buffer_rendering_mode(void)
 
 void obs_set_master_volume(float volume)
 {
-	struct calldata data = {0};
+	struct calldata data;
+	uint8_t stack[128];
 
+	calldata_init_inline(&data, stack, sizeof(stack));
 	calldata_set_float(&data, "volume", volume);
 	signal_handler_signal(obs->signals, "master_volume", &data);
 	volume = (float)calldata_float(&data, "volume");
@@ -2283,7 +2500,8 @@ void obs_context_data_free(struct obs_context_data *context)
 }
 
 void obs_context_data_insert(struct obs_context_data *context,
-			     pthread_mutex_t *mutex, void *pfirst)
+			     pthread_mutex_t *mutex, void *pfirst,
+			     struct obs_context_index *index)
 {
 	struct obs_context_data **first = pfirst;
 
@@ -2292,6 +2510,7 @@ void obs_context_data_insert(struct obs_context_data *context,
 	assert(first);
 
 	context->mutex = mutex;
+	context->index = index;
 
 	pthread_mutex_lock(mutex);
 	context->prev_next = first;
@@ -2299,6 +2518,7 @@ void obs_context_data_insert(struct obs_context_data *context,
 	*first = context;
 	if (context->next)
 		context->next->prev_next = &context->next;
+	context_index_add(context);
 	pthread_mutex_unlock(mutex);
 }
 
@@ -2310,22 +2530,38 @@ void obs_context_data_remove(struct obs_context_data *context)
 			*context->prev_next = context->next;
 		if (context->next)
 			context->next->prev_next = context->prev_next;
+		context_index_remove(context);
 		pthread_mutex_unlock(context->mutex);
 
 		context->mutex = NULL;
+		context->index = NULL;
 	}
 }
 
 void obs_context_data_setname(struct obs_context_data *context,
 			      const char *name)
 {
+	char *new_name = dup_name(name, context->private);
+	pthread_mutex_t *mutex = context->mutex;
+
+	/* the list mutex keeps lookups from seeing the index mid-rename.  it
+	 * may already be held by the caller (e.g. when renaming from inside
+	 * obs_enum_sources), so it always has to be taken first */
+	if (mutex)
+		pthread_mutex_lock(mutex);
 	pthread_mutex_lock(&context->rename_cache_mutex);
 
+	context_index_remove(context);
+
 	if (context->name)
 		da_push_back(context->rename_cache, &context->name);
-	context->name = dup_name(name, context->private);
+	context->name = new_name;
+
+	context_index_add(context);
 
 	pthread_mutex_unlock(&context->rename_cache_mutex);
+	if (mutex)
+		pthread_mutex_unlock(mutex);
 }
 
 profiler_name_store_t *obs_get_profiler_name_store(void)
@@ -2498,6 +2734,42 @@ uint32_t obs_get_lagged_frames(void)
 	return obs->video.lagged_frames;
 }
 
+void obs_get_pipeline_stats(struct obs_pipeline_stats *stats)
+{
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!obs)
+		return;
+
+	get_latency_stats(&obs->video.frame_time_histogram, &stats->render);
+	if (obs->audio.audio)
+		get_latency_stats(
+			audio_output_get_tick_histogram(obs->audio.audio),
+			&stats->audio);
+}
+
+static bool reset_encoder_stats(void *param, obs_encoder_t *encoder)
+{
+	histogram_reset(&encoder->encode_histogram);
+
+	UNUSED_PARAMETER(param);
+	return true;
+}
+
+void obs_reset_pipeline_stats(void)
+{
+	if (!obs)
+		return;
+
+	histogram_reset(&obs->video.frame_time_histogram);
+	if (obs->audio.audio)
+		histogram_reset(
+			audio_output_get_tick_histogram(obs->audio.audio));
+	obs_enum_encoders(reset_encoder_stats, NULL);
+}
+
 void start_raw_video(video_t *v, const struct video_scale_info *conversion,
 		     void (*callback)(void *param,
 				      struct video_data *streaming_frame,
@@ -2520,6 +2792,27 @@ void stop_raw_video(video_t *v,
 	os_atomic_dec_long(&video->raw_active);
 }
 
+void log_raw_video_stats(video_t *v,
+			 void (*callback)(void *param,
+					  struct video_data *streaming_frame,
+					  struct video_data *recording_frame),
+			 void *param, const char *name)
+{
+	struct video_output_input_stats stats;
+
+	if (!video_output_get_input_stats(v, callback, param, &stats) ||
+	    !stats.delivered_frames)
+		return;
+
+	blog(LOG_INFO,
+	     "'%s' raw video delivery: %" PRIu64 " frames, "
+	     "%" PRIu64 " skipped, latency avg %0.3f ms, max %0.3f ms",
+	     name, stats.delivered_frames, stats.skipped_frames,
+	     (double)stats.total_latency_ns /
+		     (double)stats.delivered_frames / 1000000.0,
+	     (double)stats.max_latency_ns / 1000000.0);
+}
+
 void obs_add_raw_video_callback(const struct video_scale_info *conversion,
 				void (*callback)(void *param,
 						 struct video_data *streaming_frame,
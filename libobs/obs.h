@@ -195,6 +195,15 @@ struct obs_video_info {
 	enum video_range_type range;      /**< YUV range (if YUV) */
 
 	enum obs_scale_type scale_type; /**< How to scale if scaling */
+
+	/**
+	 * Number of GPU staging surfaces raw frames are read back through,
+	 * indexed by obs_video_rendering_mode.  Deeper pipelines give the GPU
+	 * more time to finish a frame before it is mapped, at the cost of one
+	 * frame of latency per step.  0 selects the default of 2; the maximum
+	 * is 4.
+	 */
+	uint32_t staging_depth[3];
 };
 
 /**
@@ -419,6 +428,36 @@ EXPORT bool obs_get_video_info(struct obs_video_info *ovi);
 /** Gets the current audio settings, returns false if no audio */
 EXPORT bool obs_get_audio_info(struct obs_audio_info *oai);
 
+/**
+ * Sets the size in bytes above which raw output frames are copied out of the
+ * GPU staging surfaces on several threads.  The size covers every plane of
+ * every output frame produced in one video tick.  0 disables parallel copies.
+ */
+EXPORT void obs_set_parallel_copy_threshold(uint64_t size);
+EXPORT uint64_t obs_get_parallel_copy_threshold(void);
+
+/**
+ * Hands each raw video frame to the connected encoders and raw outputs on a
+ * small worker pool instead of one after another on the video thread.
+ * Kept across video resets.  Off by default.
+ */
+EXPORT void obs_set_parallel_video_delivery(bool enable);
+EXPORT bool obs_get_parallel_video_delivery(void);
+
+struct obs_video_staging_stats {
+	uint32_t depth;      /**< Staging surfaces in use */
+	uint64_t maps;       /**< Staging surfaces mapped for readback */
+	uint64_t map_stalls; /**< Maps that blocked waiting on the GPU */
+};
+
+/**
+ * Gets readback counters for a rendering mode since the last video reset.
+ * Returns false if the mode is invalid.
+ */
+EXPORT bool
+obs_get_video_staging_stats(enum obs_video_rendering_mode mode,
+			    struct obs_video_staging_stats *stats);
+
 /**
  * Opens a plugin module directly from a specific path.
  *
@@ -827,6 +866,36 @@ EXPORT uint64_t obs_get_frame_interval_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/**
+ * Latency percentiles, in nanoseconds.  Each is the upper bound of the
+ * histogram bucket it falls in, which is within about 3% of the true value.
+ */
+struct obs_latency_stats {
+	uint64_t count;
+	uint64_t p50_ns;
+	uint64_t p95_ns;
+	uint64_t p99_ns;
+	uint64_t p999_ns;
+};
+
+struct obs_pipeline_stats {
+	/** Time to render each frame in the graphics thread */
+	struct obs_latency_stats render;
+	/** Time the audio thread spends mixing and sending out each tick's
+	 * audio, zeroed if audio isn't initialized */
+	struct obs_latency_stats audio;
+};
+
+/**
+ * Gets latency percentiles for the graphics and audio threads, counted since
+ * startup or the last call to obs_reset_pipeline_stats.  Per-encoder stats
+ * are available from obs_encoder_get_latency_stats.
+ */
+EXPORT void obs_get_pipeline_stats(struct obs_pipeline_stats *stats);
+
+/** Clears the pipeline stats, including those of every encoder */
+EXPORT void obs_reset_pipeline_stats(void);
+
 EXPORT bool obs_nv12_tex_active(void);
 
 EXPORT void obs_apply_private_data(obs_data_t *settings);
@@ -1328,6 +1397,32 @@ EXPORT void obs_source_output_video(obs_source_t *source,
 EXPORT void obs_source_output_video2(obs_source_t *source,
 				     const struct obs_source_frame2 *frame);
 
+/**
+ * Borrows a frame from the source's async frame pool so that it can be filled
+ * in place, avoiding the copy done by obs_source_output_video.  The frame's
+ * planes are allocated for the given format and size; the caller fills
+ * data/linesize contents, timestamp and any other metadata, then hands the
+ * frame back with obs_source_submit_frame (or obs_source_release_output_frame
+ * to give it back without outputting it).
+ *
+ * Returns NULL if the source is backed up, in which case the frame should be
+ * dropped.
+ */
+EXPORT struct obs_source_frame *
+obs_source_get_output_frame(obs_source_t *source, enum video_format format,
+			    uint32_t width, uint32_t height,
+			    enum video_range_type range);
+
+/** Outputs a frame obtained with obs_source_get_output_frame.  Ownership of
+ * the frame is transferred back to the source. */
+EXPORT void obs_source_submit_frame(obs_source_t *source,
+				    struct obs_source_frame *frame);
+
+/** Returns a frame obtained with obs_source_get_output_frame to the pool
+ * without outputting it. */
+EXPORT void obs_source_release_output_frame(obs_source_t *source,
+					    struct obs_source_frame *frame);
+
 EXPORT void obs_source_set_async_rotation(obs_source_t *source, long rotation);
 
 EXPORT void obs_source_output_cea708(obs_source_t *source,
@@ -1479,6 +1574,48 @@ EXPORT void obs_source_set_async_unbuffered(obs_source_t *source,
 					    bool unbuffered);
 EXPORT bool obs_source_async_unbuffered(const obs_source_t *source);
 
+/** What to do when an async source outputs frames faster than they are
+ * rendered and its frame queue is full */
+enum obs_async_overrun_policy {
+	/** Discard every queued frame and restart timing (default) */
+	OBS_ASYNC_OVERRUN_FLUSH,
+	/** Discard the oldest queued frame to make room */
+	OBS_ASYNC_OVERRUN_DROP_OLDEST,
+	/** Discard the incoming frame */
+	OBS_ASYNC_OVERRUN_DROP_NEWEST,
+	/** Block the outputting thread for up to one frame interval, then
+	 * fall back to dropping the oldest frame */
+	OBS_ASYNC_OVERRUN_WAIT,
+};
+
+struct obs_source_async_stats {
+	/** Frames queued for rendering */
+	uint64_t output_frames;
+	/** Frames discarded because the queue was full */
+	uint64_t dropped_frames;
+	/** Frames that were queued but skipped because a newer frame was
+	 * already due by the time they were rendered */
+	uint64_t late_frames;
+	/** Number of times the whole queue was flushed */
+	uint64_t flushes;
+	/** Number of times OBS_ASYNC_OVERRUN_WAIT had to block, and how many
+	 * of those waits timed out */
+	uint64_t waits;
+	uint64_t wait_timeouts;
+	/** Frames currently waiting to be rendered */
+	uint32_t queued_frames;
+};
+
+EXPORT void
+obs_source_set_async_overrun_policy(obs_source_t *source,
+				    enum obs_async_overrun_policy policy);
+EXPORT enum obs_async_overrun_policy
+obs_source_get_async_overrun_policy(const obs_source_t *source);
+
+/** Gets the frame queue statistics of an async source */
+EXPORT bool obs_source_get_async_stats(obs_source_t *source,
+				       struct obs_source_async_stats *stats);
+
 /** Used to decouple audio from video so that audio doesn't attempt to sync up
  * with video.  I.E. Audio acts independently.  Only works when in unbuffered
  * mode. */
@@ -2332,6 +2469,10 @@ EXPORT void *obs_encoder_create_rerouted(obs_encoder_t *encoder,
 /** Returns whether encoder is paused */
 EXPORT bool obs_encoder_paused(const obs_encoder_t *output);
 
+/** Gets latency percentiles for each frame the encoder encodes */
+EXPORT void obs_encoder_get_latency_stats(const obs_encoder_t *encoder,
+					  struct obs_latency_stats *stats);
+
 /** Set encoder error to outputs */
 EXPORT void obs_outputs_set_last_error(obs_encoder_t *encoder, const char * error_text);
 EXPORT const char *obs_encoder_get_last_error(obs_encoder_t *encoder);
@@ -0,0 +1,39 @@
+/******************************************************************************
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/*
+ * AVX2 code paths are compiled into the baseline (SSE2) build and are only
+ * called after os_cpu_has_feature(OS_CPU_FEATURE_AVX2) returns true.
+ * Functions that use AVX2 intrinsics must be marked with AVX2_TARGET.
+ *
+ * AVX2 code goes in its own file, which includes <immintrin.h> itself and
+ * must not include sse-intrin.h: the simde native aliases defined there
+ * (_mm_round_ps and others) clash with the immintrin.h declarations no
+ * matter which is included first.  Code that only picks between kernels
+ * just checks HAVE_AVX2_INTRIN.
+ */
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+	defined(__i386__)
+#define HAVE_AVX2_INTRIN 1
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
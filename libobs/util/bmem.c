@@ -14,13 +14,28 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#ifndef _WIN32
+#define _GNU_SOURCE
+#endif
+
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include "base.h"
 #include "bmem.h"
 #include "platform.h"
 #include "threading.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#define CALLER_ADDRESS() _ReturnAddress()
+#else
+#include <dlfcn.h>
+#define CALLER_ADDRESS() __builtin_return_address(0)
+#endif
+
 /*
  * NOTE: totally jacked the mem alignment trick from ffmpeg, credit to them:
  *   http://www.ffmpeg.org/
@@ -101,11 +116,868 @@ bool is_allocator_failed(void)
 	return alloc_has_failed;
 }
 
-void *bmalloc(size_t size)
+/* ------------------------------------------------------------------------- */
+/* arenas */
+
+/*
+ * Every block starts with a header of ALIGNMENT bytes that records its size,
+ * the arena it was tagged with and the size class it came from, so that
+ * bfree and brealloc work on any block no matter how it was allocated.
+ */
+
+#define MAX_ARENAS 32
+#define MAX_ARENA_NAME 32
+
+struct bmem_arena {
+	char name[MAX_ARENA_NAME];
+	volatile int64_t live_bytes;
+	volatile int64_t peak_bytes;
+	volatile long live_allocs;
+};
+
+struct bmem_header {
+	size_t size;
+	uint16_t arena;
+	uint16_t pool; /* size class + 1, 0 if not pooled */
+};
+
+#define HEADER_SIZE ALIGNMENT
+
+static struct bmem_arena arenas[MAX_ARENAS] = {
+	[BMEM_ARENA_GENERAL] = {"general"},
+	[BMEM_ARENA_SIGNALS] = {"signals"},
+	[BMEM_ARENA_VIDEO_FRAMES] = {"video-frames"},
+	[BMEM_ARENA_OBS_DATA] = {"obs-data"},
+	[BMEM_ARENA_AUDIO] = {"audio"},
+};
+static volatile long num_arenas = BMEM_NUM_BUILTIN_ARENAS;
+static pthread_mutex_t arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline struct bmem_header *get_header(void *ptr)
+{
+	return (struct bmem_header *)((uint8_t *)ptr - HEADER_SIZE);
+}
+
+static inline void *get_block_data(struct bmem_header *header)
+{
+	return (uint8_t *)header + HEADER_SIZE;
+}
+
+static void arena_add(struct bmem_arena *arena, int64_t bytes)
+{
+	int64_t live = os_atomic_add_int64(&arena->live_bytes, bytes);
+	int64_t peak;
+
+	if (bytes <= 0)
+		return;
+
+	peak = os_atomic_load_int64(&arena->peak_bytes);
+	while (live > peak &&
+	       !os_atomic_compare_exchange_int64(&arena->peak_bytes, &peak,
+						 live))
+		;
+}
+
+struct bmem_arena *bmem_arena_get(const char *name)
+{
+	struct bmem_arena *arena = NULL;
+	long count;
+
+	if (!name || !*name)
+		return &arenas[0];
+
+	pthread_mutex_lock(&arena_mutex);
+
+	count = os_atomic_load_long(&num_arenas);
+	for (long i = 0; i < count; i++) {
+		if (strcmp(arenas[i].name, name) == 0) {
+			arena = &arenas[i];
+			break;
+		}
+	}
+
+	if (!arena && count < MAX_ARENAS) {
+		arena = &arenas[count];
+		strncpy(arena->name, name, MAX_ARENA_NAME - 1);
+		os_atomic_store_long(&num_arenas, count + 1);
+	}
+
+	pthread_mutex_unlock(&arena_mutex);
+
+	if (!arena) {
+		blog(LOG_WARNING,
+		     "bmem_arena_get: out of arenas, '%s' will be "
+		     "counted as '%s'",
+		     name, arenas[0].name);
+		arena = &arenas[0];
+	}
+
+	return arena;
+}
+
+struct bmem_arena *bmem_arena_get_builtin(enum bmem_arena_id id)
+{
+	if ((size_t)id >= BMEM_NUM_BUILTIN_ARENAS)
+		return &arenas[BMEM_ARENA_GENERAL];
+	return &arenas[id];
+}
+
+bool bmem_enum_arenas(size_t idx, struct bmem_arena_stats *stats)
+{
+	struct bmem_arena *arena;
+
+	if (idx >= (size_t)os_atomic_load_long(&num_arenas))
+		return false;
+
+	arena = &arenas[idx];
+	stats->name = arena->name;
+	stats->live_bytes = (uint64_t)os_atomic_load_int64(&arena->live_bytes);
+	stats->peak_bytes = (uint64_t)os_atomic_load_int64(&arena->peak_bytes);
+	stats->live_allocs = os_atomic_load_long(&arena->live_allocs);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* size class pools */
+
+/*
+ * Small blocks come from slabs carved into fixed size classes, which keeps
+ * them out of the general heap where long sessions otherwise fragment it.
+ * Each thread caches freed blocks per class and trades them with a shared
+ * depot in batches, so the depot lock is only taken every POOL_BATCH
+ * allocations or frees.  Slabs are kept for the lifetime of the process.
+ */
+
+#define NUM_POOLS 9
+#define MAX_POOLED_SIZE (1024 - HEADER_SIZE)
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_CACHE_MAX 64
+#define POOL_BATCH 32
+
+/* block sizes include the header and are multiples of ALIGNMENT */
+static const size_t pool_block_sizes[NUM_POOLS] = {64,  96,  128, 192, 256,
+						   384, 512, 768, 1024};
+
+/* size class for a block of (index * ALIGNMENT) bytes */
+static const uint8_t pool_index[MAX_POOLED_SIZE / ALIGNMENT + 2] = {
+	0, 0, 0, 1, 2, 3, 3, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6,
+	7, 7, 7, 7, 7, 7, 7, 7, 8, 8, 8, 8, 8, 8, 8, 8};
+
+struct pool_block {
+	struct pool_block *next;
+};
+
+struct pool_cache {
+	struct pool_block *blocks[NUM_POOLS];
+	size_t count[NUM_POOLS];
+};
+
+struct pool_depot {
+	pthread_mutex_t mutex;
+	struct pool_block *blocks[NUM_POOLS];
+	uint8_t *slab_pos[NUM_POOLS];
+	size_t slab_left[NUM_POOLS];
+	void *slabs;
+	volatile int64_t reserved_bytes;
+};
+
+static struct pool_depot depot = {PTHREAD_MUTEX_INITIALIZER};
+static pthread_once_t pool_init_once = PTHREAD_ONCE_INIT;
+static pthread_key_t pool_cache_key;
+static bool pool_key_valid = false;
+static THREAD_LOCAL struct pool_cache *thread_cache = NULL;
+
+static inline int get_pool(size_t size)
+{
+	if (size > MAX_POOLED_SIZE)
+		return -1;
+	return pool_index[(size + HEADER_SIZE + ALIGNMENT - 1) / ALIGNMENT];
+}
+
+/* must be called with the depot locked */
+static void depot_push(int pool, struct pool_block *first,
+		       struct pool_block *last)
+{
+	last->next = depot.blocks[pool];
+	depot.blocks[pool] = first;
+}
+
+static void pool_cache_flush(struct pool_cache *cache, int pool, size_t count)
+{
+	struct pool_block *first = cache->blocks[pool];
+	struct pool_block *last = first;
+
+	if (!first || !count)
+		return;
+
+	for (size_t i = 1; i < count && last->next; i++)
+		last = last->next;
+
+	cache->blocks[pool] = last->next;
+	cache->count[pool] -= count;
+
+	pthread_mutex_lock(&depot.mutex);
+	depot_push(pool, first, last);
+	pthread_mutex_unlock(&depot.mutex);
+}
+
+static void pool_cache_destroy(void *data)
+{
+	struct pool_cache *cache = data;
+
+	for (int pool = 0; pool < NUM_POOLS; pool++)
+		pool_cache_flush(cache, pool, cache->count[pool]);
+
+	thread_cache = NULL;
+	alloc.free(cache);
+}
+
+static void pool_init(void)
+{
+	pool_key_valid =
+		pthread_key_create(&pool_cache_key, pool_cache_destroy) == 0;
+}
+
+static struct pool_cache *get_pool_cache(void)
+{
+	struct pool_cache *cache = thread_cache;
+	if (cache)
+		return cache;
+
+	pthread_once(&pool_init_once, pool_init);
+	if (!pool_key_valid)
+		return NULL;
+
+	cache = alloc.malloc(sizeof(struct pool_cache));
+	if (!cache)
+		return NULL;
+
+	memset(cache, 0, sizeof(*cache));
+	pthread_setspecific(pool_cache_key, cache);
+	thread_cache = cache;
+	return cache;
+}
+
+/* must be called with the depot locked */
+static bool depot_new_slab(int pool)
+{
+	uint8_t *slab = alloc.malloc(POOL_SLAB_SIZE);
+	if (!slab)
+		return false;
+
+	/* the first block-aligned chunk links the slabs together */
+	*(void **)slab = depot.slabs;
+	depot.slabs = slab;
+
+	depot.slab_pos[pool] = slab + ALIGNMENT;
+	depot.slab_left[pool] = (POOL_SLAB_SIZE - ALIGNMENT) /
+				pool_block_sizes[pool];
+	os_atomic_add_int64(&depot.reserved_bytes, POOL_SLAB_SIZE);
+	return true;
+}
+
+static void pool_cache_refill(struct pool_cache *cache, int pool)
+{
+	size_t count = 0;
+
+	pthread_mutex_lock(&depot.mutex);
+
+	while (count < POOL_BATCH) {
+		struct pool_block *block = depot.blocks[pool];
+
+		if (block) {
+			depot.blocks[pool] = block->next;
+		} else {
+			if (!depot.slab_left[pool] && !depot_new_slab(pool))
+				break;
+
+			block = (struct pool_block *)depot.slab_pos[pool];
+			depot.slab_pos[pool] += pool_block_sizes[pool];
+			depot.slab_left[pool]--;
+		}
+
+		block->next = cache->blocks[pool];
+		cache->blocks[pool] = block;
+		count++;
+	}
+
+	pthread_mutex_unlock(&depot.mutex);
+
+	cache->count[pool] += count;
+}
+
+static struct bmem_header *pool_alloc(int pool)
+{
+	struct pool_cache *cache = get_pool_cache();
+	struct pool_block *block;
+
+	if (!cache)
+		return NULL;
+
+	if (!cache->blocks[pool])
+		pool_cache_refill(cache, pool);
+
+	block = cache->blocks[pool];
+	if (block) {
+		cache->blocks[pool] = block->next;
+		cache->count[pool]--;
+	}
+
+	return (struct bmem_header *)block;
+}
+
+static void pool_free(struct bmem_header *header, int pool)
+{
+	struct pool_cache *cache = get_pool_cache();
+	struct pool_block *block = (struct pool_block *)header;
+
+	if (!cache) {
+		pthread_mutex_lock(&depot.mutex);
+		depot_push(pool, block, block);
+		pthread_mutex_unlock(&depot.mutex);
+		return;
+	}
+
+	block->next = cache->blocks[pool];
+	cache->blocks[pool] = block;
+
+	if (++cache->count[pool] > POOL_CACHE_MAX)
+		pool_cache_flush(cache, pool, POOL_BATCH);
+}
+
+uint64_t bmem_pool_reserved_bytes(void)
+{
+	return (uint64_t)os_atomic_load_int64(&depot.reserved_bytes);
+}
+
+/* ------------------------------------------------------------------------- */
+/* allocation tracking */
+
+/*
+ * When enabled, every live block is recorded with the address it was
+ * allocated from, its size and when it was allocated.  Blocks allocated
+ * before tracking was enabled are not reported.  This costs a lock and a
+ * hash table update per allocation, so it is meant for debugging leaks.
+ *
+ * Call sites are resolved to a module the first time they are seen, so that
+ * blocks leaked by plugins can still be attributed after they are unloaded.
+ */
+
+#define TRACK_BUCKETS (1 << 16)
+#define MAX_SITE_NAME 64
+
+struct call_site {
+	void *caller;
+	char module[MAX_SITE_NAME];
+	char symbol[MAX_SITE_NAME];
+	uintptr_t offset;
+};
+
+struct tracked_alloc {
+	void *ptr;
+	size_t size;
+	uint64_t time;
+	uint32_t site;
+	struct tracked_alloc *next;
+};
+
+struct site_stats {
+	struct call_site site;
+	size_t count;
+	uint64_t bytes;
+	uint64_t oldest;
+};
+
+static volatile bool tracking = false;
+static pthread_mutex_t track_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct tracked_alloc **track_buckets = NULL;
+
+/* call sites in order of first use, and an open addressing index into them
+ * kept at most half full */
+static struct call_site *sites = NULL;
+static uint32_t num_sites = 0;
+static uint32_t *site_index = NULL;
+static uint32_t site_index_size = 0;
+
+static inline size_t track_hash(const void *ptr)
+{
+	return (size_t)((((uintptr_t)ptr / ALIGNMENT) * 2654435761u) &
+			(TRACK_BUCKETS - 1));
+}
+
+static inline uint32_t site_hash(const void *caller, uint32_t size)
+{
+	return (uint32_t)(((uintptr_t)caller * 2654435761u) & (size - 1));
+}
+
+static void resolve_site(struct call_site *site, void *caller)
+{
+	const char *path = NULL;
+	const char *name;
+
+	memset(site, 0, sizeof(*site));
+	site->caller = caller;
+	site->offset = (uintptr_t)caller;
+
+#ifdef _WIN32
+	char buf[MAX_PATH];
+	HMODULE module;
+
+	if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+				       GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			       (LPCSTR)caller, &module) &&
+	    GetModuleFileNameA(module, buf, sizeof(buf))) {
+		path = buf;
+		site->offset -= (uintptr_t)module;
+	}
+#else
+	Dl_info info;
+
+	if (dladdr(caller, &info) && info.dli_fname) {
+		path = info.dli_fname;
+		site->offset -= (uintptr_t)info.dli_fbase;
+		if (info.dli_sname)
+			strncpy(site->symbol, info.dli_sname,
+				MAX_SITE_NAME - 1);
+	}
+#endif
+
+	if (!path)
+		path = "unknown";
+
+	name = strrchr(path, '/');
+#ifdef _WIN32
+	if (!name)
+		name = strrchr(path, '\\');
+#endif
+	name = name ? name + 1 : path;
+
+	strncpy(site->module, name, MAX_SITE_NAME - 1);
+}
+
+/* must be called with the tracking mutex locked */
+static uint32_t *find_site_slot(void *caller)
 {
-	void *ptr = alloc.malloc(size);
-	if (!ptr && !size)
-		ptr = alloc.malloc(1);
+	uint32_t slot = site_hash(caller, site_index_size);
+
+	while (site_index[slot] != UINT32_MAX &&
+	       sites[site_index[slot]].caller != caller)
+		slot = (slot + 1) & (site_index_size - 1);
+
+	return &site_index[slot];
+}
+
+/* must be called with the tracking mutex locked */
+static bool grow_sites(void)
+{
+	uint32_t size = site_index_size ? site_index_size * 2 : 1024;
+	struct call_site *new_sites;
+	uint32_t *new_index;
+
+	new_sites = alloc.realloc(sites, (size / 2) * sizeof(*sites));
+	if (!new_sites)
+		return false;
+	sites = new_sites;
+
+	new_index = alloc.malloc(size * sizeof(*new_index));
+	if (!new_index)
+		return false;
+
+	alloc.free(site_index);
+	site_index = new_index;
+	site_index_size = size;
+	memset(site_index, 0xFF, size * sizeof(*site_index));
+
+	for (uint32_t i = 0; i < num_sites; i++)
+		*find_site_slot(sites[i].caller) = i;
+	return true;
+}
+
+/* must be called with the tracking mutex locked */
+static uint32_t add_site(const struct call_site *site)
+{
+	uint32_t *slot;
+
+	if ((num_sites + 1) * 2 > site_index_size && !grow_sites())
+		return UINT32_MAX;
+
+	slot = find_site_slot(site->caller);
+	if (*slot == UINT32_MAX) {
+		sites[num_sites] = *site;
+		*slot = num_sites++;
+	}
+	return *slot;
+}
+
+/* must be called with the tracking mutex locked */
+static inline uint32_t get_site(void *caller)
+{
+	return site_index_size ? *find_site_slot(caller) : UINT32_MAX;
+}
+
+/* must be called with the tracking mutex locked */
+static struct tracked_alloc *track_remove(void *ptr)
+{
+	struct tracked_alloc **prev = &track_buckets[track_hash(ptr)];
+
+	while (*prev) {
+		struct tracked_alloc *entry = *prev;
+		if (entry->ptr == ptr) {
+			*prev = entry->next;
+			return entry;
+		}
+		prev = &entry->next;
+	}
+
+	return NULL;
+}
+
+/* must be called with the tracking mutex locked */
+static void track_insert(struct tracked_alloc *entry)
+{
+	size_t hash = track_hash(entry->ptr);
+	entry->next = track_buckets[hash];
+	track_buckets[hash] = entry;
+}
+
+static void track_clear(void)
+{
+	if (!track_buckets)
+		return;
+
+	for (size_t i = 0; i < TRACK_BUCKETS; i++) {
+		struct tracked_alloc *entry = track_buckets[i];
+		while (entry) {
+			struct tracked_alloc *next = entry->next;
+			alloc.free(entry);
+			entry = next;
+		}
+	}
+
+	alloc.free(track_buckets);
+	track_buckets = NULL;
+}
+
+void bmem_set_tracking(bool enable)
+{
+	pthread_mutex_lock(&track_mutex);
+
+	if (enable && !track_buckets) {
+		size_t size = sizeof(struct tracked_alloc *) * TRACK_BUCKETS;
+		track_buckets = alloc.malloc(size);
+		if (track_buckets)
+			memset(track_buckets, 0, size);
+		else
+			enable = false;
+
+	} else if (!enable) {
+		track_clear();
+	}
+
+	os_atomic_store_bool(&tracking, enable);
+	pthread_mutex_unlock(&track_mutex);
+}
+
+bool bmem_tracking_enabled(void)
+{
+	return os_atomic_load_bool(&tracking);
+}
+
+static void track_alloc(void *ptr, size_t size, void *caller)
+{
+	struct tracked_alloc *entry = alloc.malloc(sizeof(*entry));
+	struct call_site site;
+	uint32_t idx;
+
+	if (!entry)
+		return;
+
+	entry->ptr = ptr;
+	entry->size = size;
+	entry->time = os_gettime_ns();
+
+	pthread_mutex_lock(&track_mutex);
+	idx = get_site(caller);
+	pthread_mutex_unlock(&track_mutex);
+
+	/* resolving takes the loader lock, so never do it while holding the
+	 * tracking mutex */
+	if (idx == UINT32_MAX)
+		resolve_site(&site, caller);
+
+	pthread_mutex_lock(&track_mutex);
+	if (idx == UINT32_MAX)
+		idx = add_site(&site);
+	if (track_buckets && idx != UINT32_MAX) {
+		entry->site = idx;
+		track_insert(entry);
+		entry = NULL;
+	}
+	pthread_mutex_unlock(&track_mutex);
+
+	alloc.free(entry);
+}
+
+/* resized blocks keep the call site and time they were first allocated at */
+static void track_realloc(void *old_ptr, void *ptr, size_t size, void *caller)
+{
+	struct tracked_alloc *entry = NULL;
+
+	pthread_mutex_lock(&track_mutex);
+	if (track_buckets) {
+		entry = track_remove(old_ptr);
+		if (entry) {
+			entry->ptr = ptr;
+			entry->size = size;
+			track_insert(entry);
+		}
+	}
+	pthread_mutex_unlock(&track_mutex);
+
+	if (!entry)
+		track_alloc(ptr, size, caller);
+}
+
+static void track_free(void *ptr)
+{
+	struct tracked_alloc *entry = NULL;
+
+	pthread_mutex_lock(&track_mutex);
+	if (track_buckets)
+		entry = track_remove(ptr);
+	pthread_mutex_unlock(&track_mutex);
+
+	alloc.free(entry);
+}
+
+static int cmp_site_stats(const void *a, const void *b)
+{
+	const struct site_stats *stats_a = a;
+	const struct site_stats *stats_b = b;
+
+	if (stats_a->bytes == stats_b->bytes)
+		return 0;
+	return stats_a->bytes < stats_b->bytes ? 1 : -1;
+}
+
+/* totals the live tracked blocks of every call site, largest first */
+static struct site_stats *get_site_stats(size_t *count)
+{
+	struct site_stats *stats = NULL;
+	size_t num = 0;
+
+	pthread_mutex_lock(&track_mutex);
+
+	if (num_sites)
+		stats = alloc.malloc(num_sites * sizeof(*stats));
+
+	if (stats) {
+		num = num_sites;
+
+		for (uint32_t i = 0; i < num_sites; i++) {
+			stats[i].site = sites[i];
+			stats[i].count = 0;
+			stats[i].bytes = 0;
+			stats[i].oldest = UINT64_MAX;
+		}
+
+		for (size_t i = 0; track_buckets && i < TRACK_BUCKETS; i++) {
+			struct tracked_alloc *entry = track_buckets[i];
+
+			for (; entry; entry = entry->next) {
+				struct site_stats *site = &stats[entry->site];
+
+				site->count++;
+				site->bytes += entry->size;
+				if (entry->time < site->oldest)
+					site->oldest = entry->time;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&track_mutex);
+
+	if (num)
+		qsort(stats, num, sizeof(*stats), cmp_site_stats);
+
+	/* sites with nothing live left sort to the end */
+	while (num && !stats[num - 1].count)
+		num--;
+
+	*count = num;
+	return stats;
+}
+
+static inline double age_sec(uint64_t now, uint64_t time)
+{
+	return (double)(now - time) / 1000000000.0;
+}
+
+void bmem_log_tracked(int log_level, size_t max_sites)
+{
+	struct site_stats *stats;
+	struct site_stats *modules = NULL;
+	size_t count;
+	size_t num_modules = 0;
+	uint64_t total_bytes = 0;
+	size_t total_count = 0;
+	uint64_t now = os_gettime_ns();
+
+	if (!bmem_tracking_enabled()) {
+		blog(log_level, "Allocation tracking is not enabled");
+		return;
+	}
+
+	stats = get_site_stats(&count);
+
+	for (size_t i = 0; i < count; i++) {
+		total_bytes += stats[i].bytes;
+		total_count += stats[i].count;
+	}
+
+	blog(log_level,
+	     "Tracked allocations: %zu blocks, %" PRIu64 " bytes, "
+	     "%zu call sites",
+	     total_count, total_bytes, count);
+
+	for (size_t i = 0; i < count && i < max_sites; i++) {
+		struct site_stats *site = &stats[i];
+		bool has_symbol = !!site->site.symbol[0];
+
+		blog(log_level,
+		     "\t%s+0x%" PRIxPTR "%s%s%s: %zu blocks, %" PRIu64
+		     " bytes, oldest %.1fs",
+		     site->site.module, site->site.offset,
+		     has_symbol ? " (" : "", site->site.symbol,
+		     has_symbol ? ")" : "", site->count, site->bytes,
+		     age_sec(now, site->oldest));
+	}
+
+	/* module totals reuse the stats structure, keyed by module name */
+	if (count)
+		modules = alloc.malloc(count * sizeof(*modules));
+
+	for (size_t i = 0; modules && i < count; i++) {
+		struct site_stats *module = NULL;
+
+		for (size_t j = 0; j < num_modules; j++) {
+			if (strcmp(modules[j].site.module,
+				   stats[i].site.module) == 0) {
+				module = &modules[j];
+				break;
+			}
+		}
+
+		if (!module) {
+			modules[num_modules++] = stats[i];
+			continue;
+		}
+
+		module->count += stats[i].count;
+		module->bytes += stats[i].bytes;
+		if (stats[i].oldest < module->oldest)
+			module->oldest = stats[i].oldest;
+	}
+
+	if (num_modules) {
+		qsort(modules, num_modules, sizeof(*modules), cmp_site_stats);
+
+		blog(log_level, "Tracked allocations by module:");
+		for (size_t i = 0; i < num_modules; i++)
+			blog(log_level,
+			     "\t%s: %zu blocks, %" PRIu64 " bytes, "
+			     "oldest %.1fs",
+			     modules[i].site.module, modules[i].count,
+			     modules[i].bytes,
+			     age_sec(now, modules[i].oldest));
+	}
+
+	alloc.free(modules);
+	alloc.free(stats);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void *mem_alloc(struct bmem_arena *arena, size_t size)
+{
+	struct bmem_header *header = NULL;
+	int pool = get_pool(size);
+
+	if (pool >= 0)
+		header = pool_alloc(pool);
+
+	if (!header) {
+		if (size > SIZE_MAX - HEADER_SIZE)
+			return NULL;
+
+		pool = -1;
+		header = alloc.malloc(size + HEADER_SIZE);
+		if (!header)
+			return NULL;
+	}
+
+	header->size = size;
+	header->arena = (uint16_t)(arena - arenas);
+	header->pool = (uint16_t)(pool + 1);
+
+	os_atomic_inc_long(&arena->live_allocs);
+	arena_add(arena, (int64_t)size);
+	return get_block_data(header);
+}
+
+static void mem_free(void *ptr)
+{
+	struct bmem_header *header = get_header(ptr);
+	struct bmem_arena *arena = &arenas[header->arena];
+
+	os_atomic_dec_long(&arena->live_allocs);
+	arena_add(arena, -(int64_t)header->size);
+
+	if (header->pool)
+		pool_free(header, header->pool - 1);
+	else
+		alloc.free(header);
+}
+
+static void *mem_realloc(void *ptr, size_t size)
+{
+	struct bmem_header *header = get_header(ptr);
+	struct bmem_arena *arena = &arenas[header->arena];
+	size_t old_size = header->size;
+
+	if (header->pool) {
+		void *new_ptr;
+
+		if (size + HEADER_SIZE <= pool_block_sizes[header->pool - 1]) {
+			arena_add(arena, (int64_t)size - (int64_t)old_size);
+			header->size = size;
+			return ptr;
+		}
+
+		new_ptr = mem_alloc(arena, size);
+		if (new_ptr) {
+			memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+			mem_free(ptr);
+		}
+		return new_ptr;
+	}
+
+	if (size > SIZE_MAX - HEADER_SIZE)
+		return NULL;
+
+	header = alloc.realloc(header, size + HEADER_SIZE);
+	if (!header)
+		return NULL;
+
+	header->size = size;
+	arena_add(arena, (int64_t)size - (int64_t)old_size);
+	return get_block_data(header);
+}
+
+static void *arena_malloc(struct bmem_arena *arena, size_t size,
+			  void *caller)
+{
+	void *ptr = mem_alloc(arena, size);
 	if (!ptr) {
 #ifdef ALIGNED_MALLOC
 		blog(LOG_ERROR, "Failed while trying to allocate %lu bytes, errno %u", (unsigned long)size, errno);
@@ -118,18 +990,32 @@ void *bmalloc(size_t size)
 		       (unsigned long)size);
 	}
 
+	if (os_atomic_load_bool(&tracking))
+		track_alloc(ptr, size, caller);
+
 	os_atomic_inc_long(&num_allocs);
 	return ptr;
 }
 
+void *bmalloc(size_t size)
+{
+	return arena_malloc(&arenas[0], size, CALLER_ADDRESS());
+}
+
+void *bmalloc_arena(struct bmem_arena *arena, size_t size)
+{
+	return arena_malloc(arena ? arena : &arenas[0], size,
+			    CALLER_ADDRESS());
+}
+
 void *brealloc(void *ptr, size_t size)
 {
+	void *old_ptr = ptr;
+
 	if (!ptr)
-		os_atomic_inc_long(&num_allocs);
+		return arena_malloc(&arenas[0], size, CALLER_ADDRESS());
 
-	ptr = alloc.realloc(ptr, size);
-	if (!ptr && !size)
-		ptr = alloc.realloc(ptr, 1);
+	ptr = mem_realloc(ptr, size);
 	if (!ptr) {
 #ifdef ALIGNED_MALLOC
 		blog(LOG_ERROR, "Failed while trying to reallocate %lu bytes, errno %u", (unsigned long)size, errno);
@@ -142,14 +1028,20 @@ void *brealloc(void *ptr, size_t size)
 		       (unsigned long)size);
 	}
 
+	if (os_atomic_load_bool(&tracking))
+		track_realloc(old_ptr, ptr, size, CALLER_ADDRESS());
+
 	return ptr;
 }
 
 void bfree(void *ptr)
 {
 	if (ptr) {
+		if (os_atomic_load_bool(&tracking))
+			track_free(ptr);
+
 		os_atomic_dec_long(&num_allocs);
-		alloc.free(ptr);
+		mem_free(ptr);
 	}
 }
 
@@ -158,6 +1050,20 @@ long bnum_allocs(void)
 	return num_allocs;
 }
 
+void bmem_log_arenas(int log_level)
+{
+	struct bmem_arena_stats stats;
+	size_t idx = 0;
+
+	blog(log_level, "Memory arenas (live / peak bytes, live allocations):");
+	while (bmem_enum_arenas(idx++, &stats))
+		blog(log_level, "\t%-16s %" PRIu64 " / %" PRIu64 ", %ld",
+		     stats.name, stats.live_bytes, stats.peak_bytes,
+		     stats.live_allocs);
+	blog(log_level, "\tsmall block pools: %" PRIu64 " bytes reserved",
+	     bmem_pool_reserved_bytes());
+}
+
 int base_get_alignment(void)
 {
 	return ALIGNMENT;
@@ -165,7 +1071,7 @@ int base_get_alignment(void)
 
 void *bmemdup(const void *ptr, size_t size)
 {
-	void *out = bmalloc(size);
+	void *out = arena_malloc(&arenas[0], size, CALLER_ADDRESS());
 	if (size)
 		memcpy(out, ptr, size);
 
@@ -31,6 +31,7 @@ struct base_allocator {
 	void (*free)(void *);
 };
 
+/* must be set before anything is allocated */
 EXPORT void base_set_allocator(struct base_allocator *defs);
 
 EXPORT void *bmalloc(size_t size);
@@ -42,6 +43,52 @@ EXPORT bool is_allocator_failed(void);
 
 EXPORT long bnum_allocs(void);
 
+/*
+ * Arenas tag allocations with the subsystem that owns them so that live and
+ * peak usage can be reported per subsystem.  Arenas are created on first use
+ * by name and live for the rest of the process.  Blocks keep their arena when
+ * reallocated, and plain bmalloc allocations are counted as "general".
+ *
+ * The arenas libobs itself uses exist from the start and are fetched with
+ * bmem_arena_get_builtin, which takes no lock.
+ */
+struct bmem_arena;
+
+enum bmem_arena_id {
+	BMEM_ARENA_GENERAL,
+	BMEM_ARENA_SIGNALS,
+	BMEM_ARENA_VIDEO_FRAMES,
+	BMEM_ARENA_OBS_DATA,
+	BMEM_ARENA_AUDIO,
+	BMEM_NUM_BUILTIN_ARENAS,
+};
+
+struct bmem_arena_stats {
+	const char *name;
+	uint64_t live_bytes;
+	uint64_t peak_bytes;
+	long live_allocs;
+};
+
+EXPORT struct bmem_arena *bmem_arena_get(const char *name);
+EXPORT struct bmem_arena *bmem_arena_get_builtin(enum bmem_arena_id id);
+EXPORT void *bmalloc_arena(struct bmem_arena *arena, size_t size);
+
+EXPORT bool bmem_enum_arenas(size_t idx, struct bmem_arena_stats *stats);
+EXPORT uint64_t bmem_pool_reserved_bytes(void);
+EXPORT void bmem_log_arenas(int log_level);
+
+/*
+ * Allocation tracking records the call site, size and time of every block
+ * allocated while it is enabled, for finding leaks.  It slows down every
+ * allocation, so it is off by default.  bmem_log_tracked logs the live
+ * tracked blocks grouped by call site (largest first, up to max_sites) and by
+ * module.
+ */
+EXPORT void bmem_set_tracking(bool enable);
+EXPORT bool bmem_tracking_enabled(void);
+EXPORT void bmem_log_tracked(int log_level, size_t max_sites);
+
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
 static inline void *bzalloc(size_t size)
@@ -52,6 +99,14 @@ static inline void *bzalloc(size_t size)
 	return mem;
 }
 
+static inline void *bzalloc_arena(struct bmem_arena *arena, size_t size)
+{
+	void *mem = bmalloc_arena(arena, size);
+	if (mem)
+		memset(mem, 0, size);
+	return mem;
+}
+
 static inline char *bstrdup_n(const char *str, size_t n)
 {
 	char *dup;
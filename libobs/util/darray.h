@@ -34,9 +34,16 @@ extern "C" {
  *       Specifying size per call with inline maximizes compiler optimizations
  *
  *       See DARRAY macro at the bottom of the file for slightly safer usage.
+ *
+ *   An array can start out in storage it doesn't own (see darray_init_inline
+ * and DARRAY_INLINE), which saves allocating for arrays that are usually
+ * small.  It stays there until it outgrows it and then moves to the heap like
+ * any other array.  The capacity of such an array has DARRAY_BORROWED set,
+ * and it must not be moved to another array.
  */
 
 #define DARRAY_INVALID ((size_t)-1)
+#define DARRAY_BORROWED ((size_t)1 << (sizeof(size_t) * 8 - 1))
 
 struct darray {
 	void *array;
@@ -51,8 +58,27 @@ static inline void darray_init(struct darray *dst)
 	dst->capacity = 0;
 }
 
+static inline void darray_init_inline(struct darray *dst, void *storage,
+				      size_t capacity)
+{
+	dst->array = storage;
+	dst->num = 0;
+	dst->capacity = capacity | DARRAY_BORROWED;
+}
+
+static inline bool darray_is_borrowed(const struct darray *da)
+{
+	return (da->capacity & DARRAY_BORROWED) != 0;
+}
+
 static inline void darray_free(struct darray *dst)
 {
+	/* borrowed storage is kept, emptied, for the array to reuse */
+	if (darray_is_borrowed(dst)) {
+		dst->num = 0;
+		return;
+	}
+
 	bfree(dst->array);
 	dst->array = NULL;
 	dst->num = 0;
@@ -84,7 +110,7 @@ static inline void darray_reserve(const size_t element_size, struct darray *dst,
 				  const size_t capacity)
 {
 	void *ptr;
-	if (capacity == 0 || capacity <= dst->capacity)
+	if (capacity == 0 || capacity <= (dst->capacity & ~DARRAY_BORROWED))
 		return;
 
 	ptr = bmalloc(element_size * capacity);
@@ -92,7 +118,8 @@ static inline void darray_reserve(const size_t element_size, struct darray *dst,
 		if (dst->num)
 			memcpy(ptr, dst->array, element_size * dst->num);
 
-		bfree(dst->array);
+		if (!darray_is_borrowed(dst))
+			bfree(dst->array);
 	}
 	dst->array = ptr;
 	dst->capacity = capacity;
@@ -102,20 +129,22 @@ static inline void darray_ensure_capacity(const size_t element_size,
 					  struct darray *dst,
 					  const size_t new_size)
 {
+	size_t capacity = dst->capacity & ~DARRAY_BORROWED;
 	size_t new_cap;
 	void *ptr;
-	if (new_size <= dst->capacity)
+	if (new_size <= capacity)
 		return;
 
-	new_cap = (!dst->capacity) ? new_size : dst->capacity * 2;
+	new_cap = (!capacity) ? new_size : capacity * 2;
 	if (new_size > new_cap)
 		new_cap = new_size;
 	ptr = bmalloc(element_size * new_cap);
 	if (dst->array) {
-		if (dst->capacity)
-			memcpy(ptr, dst->array, element_size * dst->capacity);
+		if (capacity)
+			memcpy(ptr, dst->array, element_size * capacity);
 
-		bfree(dst->array);
+		if (!darray_is_borrowed(dst))
+			bfree(dst->array);
 	}
 	dst->array = ptr;
 	dst->capacity = new_cap;
@@ -166,6 +195,8 @@ static inline void darray_copy_array(const size_t element_size,
 
 static inline void darray_move(struct darray *dst, struct darray *src)
 {
+	assert(!darray_is_borrowed(src));
+
 	darray_free(dst);
 	memcpy(dst, src, sizeof(struct darray));
 	src->array = NULL;
@@ -474,8 +505,23 @@ static inline void darray_swap(const size_t element_size, struct darray *dst,
 		};                       \
 	}
 
+/*
+ * A DARRAY with storage for n items of its own, which it uses until it needs
+ * more.  Initialize it with da_init_inline; since the array points into the
+ * variable itself, it must not be copied or moved while in use.
+ */
+#define DARRAY_INLINE(type, n)        \
+	struct {                      \
+		DARRAY(type);         \
+		type inline_array[n]; \
+	}
+
 #define da_init(v) darray_init(&v.da)
 
+#define da_init_inline(v)                         \
+	darray_init_inline(&v.da, v.inline_array, \
+			   sizeof(v.inline_array) / sizeof(*v.inline_array))
+
 #define da_free(v) darray_free(&v.da)
 
 #define da_alloc_size(v) (sizeof(*v.array) * v.num)
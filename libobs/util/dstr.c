@@ -378,9 +378,14 @@ void dstr_ncopy(struct dstr *dst, const char *array, const size_t len)
 	if (!len)
 		return;
 
-	dst->array = bmemdup(array, len + 1);
+	if (dstr_is_borrowed(dst)) {
+		dstr_ensure_capacity(dst, len + 1);
+		memcpy(dst->array, array, len);
+	} else {
+		dst->array = bmemdup(array, len + 1);
+		dst->capacity = len + 1;
+	}
 	dst->len = len;
-	dst->capacity = len + 1;
 
 	dst->array[len] = 0;
 }
@@ -396,9 +401,14 @@ void dstr_ncopy_dstr(struct dstr *dst, const struct dstr *str, const size_t len)
 		return;
 
 	newlen = size_min(len, str->len);
-	dst->array = bmemdup(str->array, newlen + 1);
+	if (dstr_is_borrowed(dst)) {
+		dstr_ensure_capacity(dst, newlen + 1);
+		memcpy(dst->array, str->array, newlen);
+	} else {
+		dst->array = bmemdup(str->array, newlen + 1);
+		dst->capacity = newlen + 1;
+	}
 	dst->len = newlen;
-	dst->capacity = newlen + 1;
 
 	dst->array[newlen] = 0;
 }
@@ -715,6 +725,7 @@ void dstr_from_mbs(struct dstr *dst, const char *mbstr)
 {
 	dstr_free(dst);
 	dst->len = os_mbs_to_utf8_ptr(mbstr, 0, &dst->array);
+	dst->capacity = dst->array ? dst->len + 1 : 0;
 }
 
 char *dstr_to_mbs(const struct dstr *str)
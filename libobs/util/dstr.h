@@ -25,6 +25,12 @@
  * Dynamic string
  *
  *   Helper struct/functions for dynamically sizing string buffers.
+ *
+ *   A string can start out in a buffer it doesn't own (see dstr_init_inline),
+ * which saves allocating for strings that are usually short.  It stays there
+ * until it outgrows it and then moves to the heap like any other string.  The
+ * capacity of such a string has DSTR_BORROWED set, and its array must not be
+ * freed, moved to another string or kept after the buffer goes away.
  */
 
 #ifdef __cplusplus
@@ -39,6 +45,8 @@ struct dstr {
 	size_t capacity;
 };
 
+#define DSTR_BORROWED ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
 #ifndef _MSC_VER
 #define PRINTFATTR(f, a) __attribute__((__format__(__printf__, f, a)))
 #else
@@ -62,6 +70,7 @@ EXPORT char **strlist_split(const char *str, char split_ch, bool include_empty);
 EXPORT void strlist_free(char **strlist);
 
 static inline void dstr_init(struct dstr *dst);
+static inline void dstr_init_inline(struct dstr *dst, char *buf, size_t size);
 static inline void dstr_init_move(struct dstr *dst, struct dstr *src);
 static inline void dstr_init_move_array(struct dstr *dst, char *str);
 static inline void dstr_init_copy(struct dstr *dst, const char *src);
@@ -160,6 +169,20 @@ static inline void dstr_init(struct dstr *dst)
 	dst->capacity = 0;
 }
 
+/** Starts a string out in a buffer owned by the caller */
+static inline void dstr_init_inline(struct dstr *dst, char *buf, size_t size)
+{
+	dst->array = buf;
+	dst->array[0] = 0;
+	dst->len = 0;
+	dst->capacity = size | DSTR_BORROWED;
+}
+
+static inline bool dstr_is_borrowed(const struct dstr *str)
+{
+	return (str->capacity & DSTR_BORROWED) != 0;
+}
+
 static inline void dstr_init_move_array(struct dstr *dst, char *str)
 {
 	dst->array = str;
@@ -187,6 +210,13 @@ static inline void dstr_init_copy_dstr(struct dstr *dst, const struct dstr *src)
 
 static inline void dstr_free(struct dstr *dst)
 {
+	/* a borrowed buffer is kept, emptied, for the string to reuse */
+	if (dstr_is_borrowed(dst)) {
+		dst->array[0] = 0;
+		dst->len = 0;
+		return;
+	}
+
 	bfree(dst->array);
 	dst->array = NULL;
 	dst->len = 0;
@@ -216,14 +246,22 @@ static inline void dstr_move(struct dstr *dst, struct dstr *src)
 
 static inline void dstr_ensure_capacity(struct dstr *dst, const size_t new_size)
 {
+	size_t capacity = dst->capacity & ~DSTR_BORROWED;
 	size_t new_cap;
-	if (new_size <= dst->capacity)
+	if (new_size <= capacity)
 		return;
 
-	new_cap = (!dst->capacity) ? new_size : dst->capacity * 2;
+	new_cap = (!capacity) ? new_size : capacity * 2;
 	if (new_size > new_cap)
 		new_cap = new_size;
-	dst->array = (char *)brealloc(dst->array, new_cap);
+
+	if (dstr_is_borrowed(dst)) {
+		char *array = (char *)bmalloc(new_cap);
+		memcpy(array, dst->array, capacity);
+		dst->array = array;
+	} else {
+		dst->array = (char *)brealloc(dst->array, new_cap);
+	}
 	dst->capacity = new_cap;
 }
 
@@ -242,6 +280,10 @@ static inline void dstr_reserve(struct dstr *dst, const size_t capacity)
 {
 	if (capacity == 0 || capacity <= dst->len)
 		return;
+	if (dstr_is_borrowed(dst)) {
+		dstr_ensure_capacity(dst, capacity);
+		return;
+	}
 
 	dst->array = (char *)brealloc(dst->array, capacity);
 	dst->capacity = capacity;
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "histogram.h"
+
+void histogram_reset(struct histogram *hist)
+{
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+		os_atomic_set_long(&hist->counts[i], 0);
+}
+
+uint64_t histogram_bucket_max(size_t bucket)
+{
+	size_t range = bucket / HISTOGRAM_SUB_BUCKETS;
+	uint64_t sub = bucket % HISTOGRAM_SUB_BUCKETS;
+	unsigned int shift;
+
+	if (!range)
+		return sub;
+
+	shift = (unsigned int)range - 1;
+	return ((HISTOGRAM_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+uint64_t histogram_percentiles(const struct histogram *hist,
+			       const double *percentiles, uint64_t *values,
+			       size_t num)
+{
+	long counts[HISTOGRAM_BUCKETS];
+	uint64_t total = 0;
+	uint64_t seen = 0;
+	size_t bucket = 0;
+
+	/* copy the counts first, so values recorded while reading can't push
+	 * the percentiles past the total */
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		counts[i] = os_atomic_load_long(&hist->counts[i]);
+		total += (uint64_t)counts[i];
+	}
+
+	for (size_t i = 0; i < num; i++) {
+		double rank = percentiles[i] / 100.0 * (double)total;
+		uint64_t target = rank < 1.0 ? 1 : (uint64_t)(rank + 0.5);
+
+		if (!total) {
+			values[i] = 0;
+			continue;
+		}
+		if (target > total)
+			target = total;
+
+		while (seen + (uint64_t)counts[bucket] < target)
+			seen += (uint64_t)counts[bucket++];
+
+		values[i] = histogram_bucket_max(bucket);
+	}
+
+	return total;
+}
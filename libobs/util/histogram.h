@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+#include "threading.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Latency histogram
+ *
+ *   Counts values (usually nanoseconds) in log-linear buckets, the way HDR
+ * histograms do: each power of two is split into HISTOGRAM_SUB_BUCKETS equal
+ * buckets, so any value is known to within about 3% no matter how large it
+ * is.  Values below HISTOGRAM_SUB_BUCKETS are counted exactly, and values
+ * past the last bucket (about 68 seconds in nanoseconds) are counted in it.
+ *
+ *   Recording is a single atomic increment, so any thread can record while
+ * another reads percentiles.
+ */
+
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_BITS 36
+#define HISTOGRAM_BUCKETS \
+	((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+struct histogram {
+	volatile long counts[HISTOGRAM_BUCKETS];
+};
+
+static inline size_t histogram_bucket(uint64_t value)
+{
+	unsigned int bits = 0;
+
+	if (value >= (1ULL << HISTOGRAM_MAX_BITS))
+		return HISTOGRAM_BUCKETS - 1;
+	if (value < HISTOGRAM_SUB_BUCKETS)
+		return (size_t)value;
+
+	/* position of the highest set bit */
+	for (unsigned int shift = 32; shift; shift >>= 1) {
+		if (value >> (bits + shift))
+			bits += shift;
+	}
+
+	return (size_t)(bits - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS +
+	       (size_t)((value >> (bits - HISTOGRAM_SUB_BITS)) &
+			(HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+static inline void histogram_record(struct histogram *hist, uint64_t value)
+{
+	os_atomic_inc_long(&hist->counts[histogram_bucket(value)]);
+}
+
+EXPORT void histogram_reset(struct histogram *hist);
+
+/** Returns the largest value counted in a bucket */
+EXPORT uint64_t histogram_bucket_max(size_t bucket);
+
+/**
+ * Finds several percentiles in one pass.  percentiles must be in ascending
+ * order, from 0.0 to 100.0.  Each value is the largest value of the bucket
+ * the percentile falls in, so it never understates a latency.
+ *
+ * @return  The number of values counted, or 0 if there are none, in which
+ *          case every value is 0
+ */
+EXPORT uint64_t histogram_percentiles(const struct histogram *hist,
+				      const double *percentiles,
+				      uint64_t *values, size_t num);
+
+#ifdef __cplusplus
+}
+#endif
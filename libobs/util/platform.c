@@ -27,6 +27,14 @@
 #include "dstr.h"
 #include "obs.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+	defined(__i386__)
+#define CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 FILE *os_wfopen(const wchar_t *path, const char *mode)
 {
 	FILE *file = NULL;
@@ -807,3 +815,61 @@ char *os_generate_formatted_filename(const char *extension, bool space,
 
 	return sf.array;
 }
+
+static bool cpu_has_avx2(void)
+{
+#if defined(CPU_X86) && defined(_MSC_VER)
+	int regs[4];
+
+	__cpuid(regs, 0);
+	if (regs[0] < 7)
+		return false;
+
+	/* AVX and OSXSAVE, then make sure the OS saves the YMM registers */
+	__cpuid(regs, 1);
+	if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & (1 << 5)) != 0;
+
+#elif defined(CPU_X86)
+	__builtin_cpu_init();
+	return !!__builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+bool os_cpu_has_feature(enum os_cpu_feature feature)
+{
+	static bool initialized = false;
+	static bool has_avx2 = false;
+
+	if (!initialized) {
+		has_avx2 = cpu_has_avx2();
+		initialized = true;
+	}
+
+	switch (feature) {
+	case OS_CPU_FEATURE_SSE2:
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		return true;
+#else
+		return false;
+#endif
+	case OS_CPU_FEATURE_AVX2:
+		return has_avx2;
+	case OS_CPU_FEATURE_NEON:
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	return false;
+}
@@ -185,6 +185,15 @@ EXPORT void os_breakpoint(void);
 EXPORT int os_get_physical_cores(void);
 EXPORT int os_get_logical_cores(void);
 
+enum os_cpu_feature {
+	OS_CPU_FEATURE_SSE2,
+	OS_CPU_FEATURE_AVX2,
+	OS_CPU_FEATURE_NEON,
+};
+
+/** Returns whether the running CPU (and OS) supports the given feature */
+EXPORT bool os_cpu_has_feature(enum os_cpu_feature feature);
+
 EXPORT uint64_t os_get_sys_free_size(void);
 
 struct os_proc_memory_usage {
@@ -6,6 +6,7 @@
 #include "platform.h"
 #include "threading.h"
 
+#include <errno.h>
 #include <math.h>
 
 #include <zlib.h>
@@ -287,6 +288,465 @@ void profile_reenable_thread(void)
 	pthread_mutex_unlock(&root_mutex);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Tracing
+ *
+ *   While a trace is running, profile_start and profile_end also record begin
+ * and end events into a ring buffer owned by the calling thread.  Only that
+ * thread writes to its ring, so recording takes no lock.  A background thread
+ * drains the rings every TRACE_DRAIN_INTERVAL_MS, pairs the begin and end
+ * events into complete records and keeps those from the trace window, which
+ * can be saved as a Chrome trace at any time.
+ *
+ *   trace_writers counts threads that are between checking trace_enabled and
+ * finishing with their ring, so stopping can wait for them before freeing the
+ * rings.  A thread's ring is retired when the thread exits and freed after it
+ * has been drained for the last time. */
+
+#define TRACE_RING_SIZE 4096 /* events per thread, a power of two */
+#define TRACE_RING_RESERVE 64 /* kept free so ends can follow their begins */
+#define TRACE_MAX_DEPTH 32
+#define TRACE_MAX_RECORDS (1 << 20)
+#define TRACE_DRAIN_INTERVAL_MS 100
+
+struct trace_event {
+	const char *name;
+	uint64_t time;
+	bool end;
+};
+
+struct trace_record {
+	const char *name;
+	uint64_t start;
+	uint64_t duration;
+	size_t thread;
+};
+
+struct trace_ring {
+	struct trace_event events[TRACE_RING_SIZE];
+	volatile long head;
+	volatile long tail;
+	volatile long dropped;
+
+	/* only used by the owning thread */
+	size_t depth;
+	size_t drop_depth;
+
+	/* only used with trace_mutex held */
+	bool retired;
+
+	/* only used by the aggregator */
+	size_t thread;
+	size_t open_depth;
+	struct trace_event open[TRACE_MAX_DEPTH];
+};
+
+static volatile bool trace_enabled = false;
+static volatile long trace_writers = 0;
+static volatile long trace_generation = 0;
+
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool trace_running = false;
+static uint64_t trace_window = 0;
+static pthread_t trace_thread;
+static os_event_t *trace_stop_event = NULL;
+static DARRAY(struct trace_ring *) trace_rings;
+static DARRAY(const char *) trace_thread_names;
+static DARRAY(struct trace_record) trace_records;
+static size_t trace_records_start = 0;
+static uint64_t trace_dropped = 0;
+
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_ring_key;
+static bool trace_key_valid = false;
+
+static THREAD_LOCAL struct trace_ring *thread_ring = NULL;
+static THREAD_LOCAL long thread_ring_generation = 0;
+
+/* called when a thread with a ring exits.  the ring may already have been
+ * freed by profiler_trace_stop, in which case the generation won't match */
+static void trace_ring_retire(void *data)
+{
+	pthread_mutex_lock(&trace_mutex);
+	if (thread_ring == data &&
+	    thread_ring_generation == os_atomic_load_long(&trace_generation))
+		thread_ring->retired = true;
+	pthread_mutex_unlock(&trace_mutex);
+
+	thread_ring = NULL;
+}
+
+static void trace_key_init(void)
+{
+	trace_key_valid =
+		pthread_key_create(&trace_ring_key, trace_ring_retire) == 0;
+}
+
+static struct trace_ring *get_thread_ring(void)
+{
+	long generation = os_atomic_load_long(&trace_generation);
+	const char *no_name = NULL;
+	struct trace_ring *ring;
+
+	if (thread_ring && thread_ring_generation == generation)
+		return thread_ring;
+
+	pthread_once(&trace_key_once, trace_key_init);
+	ring = bzalloc(sizeof(struct trace_ring));
+
+	pthread_mutex_lock(&trace_mutex);
+	da_push_back(trace_thread_names, &no_name);
+	ring->thread = trace_thread_names.num;
+	da_push_back(trace_rings, &ring);
+	pthread_mutex_unlock(&trace_mutex);
+
+	if (trace_key_valid)
+		pthread_setspecific(trace_ring_key, ring);
+
+	thread_ring = ring;
+	thread_ring_generation = generation;
+	return ring;
+}
+
+static void trace_push(struct trace_ring *ring, const char *name,
+		       uint64_t time, bool end)
+{
+	unsigned long head = (unsigned long)ring->head;
+	unsigned long used =
+		head - (unsigned long)os_atomic_load_long(&ring->tail);
+	struct trace_event *event;
+
+	/* once a begin is dropped, everything inside it and its end are
+	 * dropped too, so the aggregator never pairs the wrong events */
+	if (!end) {
+		ring->depth++;
+		if (!ring->drop_depth &&
+		    used >= TRACE_RING_SIZE - TRACE_RING_RESERVE)
+			ring->drop_depth = ring->depth;
+	} else {
+		if (!ring->depth)
+			return;
+		if (ring->drop_depth == ring->depth--) {
+			ring->drop_depth = 0;
+			os_atomic_inc_long(&ring->dropped);
+			return;
+		}
+	}
+
+	if (ring->drop_depth || used >= TRACE_RING_SIZE) {
+		os_atomic_inc_long(&ring->dropped);
+		return;
+	}
+
+	event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+	event->name = name;
+	event->time = time ? time : os_gettime_ns();
+	event->end = end;
+	os_atomic_set_long(&ring->head, (long)(head + 1));
+}
+
+static inline void trace_event(const char *name, uint64_t time, bool end)
+{
+	if (!os_atomic_load_bool(&trace_enabled))
+		return;
+
+	os_atomic_inc_long(&trace_writers);
+	if (os_atomic_load_bool(&trace_enabled))
+		trace_push(get_thread_ring(), name, time, end);
+	os_atomic_dec_long(&trace_writers);
+}
+
+static void trace_add_event(struct trace_ring *ring,
+			    const struct trace_event *event)
+{
+	struct trace_record *record;
+	struct trace_event *start;
+	size_t depth = ring->open_depth;
+
+	if (!event->end) {
+		/* threads are named after the first thing they profile */
+		const char **name =
+			&trace_thread_names.array[ring->thread - 1];
+		if (!depth && !*name)
+			*name = event->name;
+
+		if (depth < TRACE_MAX_DEPTH)
+			ring->open[ring->open_depth++] = *event;
+		else
+			trace_dropped++;
+		return;
+	}
+
+	/* an end that had to be dropped leaves its begin open, so match ends
+	 * by name; anything opened inside the match is abandoned */
+	while (depth && ring->open[depth - 1].name != event->name)
+		depth--;
+	if (!depth) {
+		trace_dropped++;
+		return;
+	}
+
+	ring->open_depth = --depth;
+	start = &ring->open[depth];
+	record = da_push_back_new(trace_records);
+	record->name = start->name;
+	record->start = start->time;
+	record->duration = event->time - start->time;
+	record->thread = ring->thread;
+}
+
+static void trace_trim(uint64_t now)
+{
+	uint64_t cutoff = now > trace_window ? now - trace_window : 0;
+	size_t start = trace_records_start;
+	size_t num = trace_records.num;
+
+	if (num - start > TRACE_MAX_RECORDS) {
+		trace_dropped += num - start - TRACE_MAX_RECORDS;
+		start = num - TRACE_MAX_RECORDS;
+	}
+
+	/* records are roughly in the order they ended, which is close enough
+	 * to stop at the first one still in the window */
+	while (start < num) {
+		struct trace_record *record = &trace_records.array[start];
+		if (record->start + record->duration >= cutoff)
+			break;
+		start++;
+	}
+
+	if (start > num / 2) {
+		da_erase_range(trace_records, 0, start);
+		start = 0;
+	}
+
+	trace_records_start = start;
+}
+
+static void trace_drain(void)
+{
+	for (size_t i = 0; i < trace_rings.num;) {
+		struct trace_ring *ring = trace_rings.array[i];
+		unsigned long tail = (unsigned long)ring->tail;
+		unsigned long head =
+			(unsigned long)os_atomic_load_long(&ring->head);
+
+		for (; tail != head; tail++)
+			trace_add_event(ring,
+					&ring->events[tail &
+						      (TRACE_RING_SIZE - 1)]);
+
+		os_atomic_set_long(&ring->tail, (long)tail);
+		trace_dropped += os_atomic_set_long(&ring->dropped, 0);
+
+		/* its thread is gone, so nothing more can be written to it */
+		if (ring->retired) {
+			bfree(ring);
+			da_erase(trace_rings, i);
+			continue;
+		}
+
+		i++;
+	}
+
+	trace_trim(os_gettime_ns());
+}
+
+static void *trace_thread_loop(void *unused)
+{
+	os_set_thread_name("profiler: trace thread");
+
+	while (os_event_timedwait(trace_stop_event, TRACE_DRAIN_INTERVAL_MS) ==
+	       ETIMEDOUT) {
+		pthread_mutex_lock(&trace_mutex);
+		trace_drain();
+		pthread_mutex_unlock(&trace_mutex);
+	}
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+static void trace_free_records(void)
+{
+	da_free(trace_records);
+	da_free(trace_thread_names);
+	trace_records_start = 0;
+	trace_dropped = 0;
+}
+
+void profiler_trace_start(uint64_t window_ns)
+{
+	pthread_mutex_lock(&trace_mutex);
+	trace_window = window_ns;
+
+	if (trace_running) {
+		pthread_mutex_unlock(&trace_mutex);
+		return;
+	}
+
+	trace_free_records();
+
+	if (os_event_init(&trace_stop_event, OS_EVENT_TYPE_MANUAL) != 0) {
+		blog(LOG_ERROR, "profiler_trace_start: failed to create event");
+		pthread_mutex_unlock(&trace_mutex);
+		return;
+	}
+	if (pthread_create(&trace_thread, NULL, trace_thread_loop, NULL) !=
+	    0) {
+		blog(LOG_ERROR, "profiler_trace_start: failed to create "
+				"thread");
+		os_event_destroy(trace_stop_event);
+		trace_stop_event = NULL;
+		pthread_mutex_unlock(&trace_mutex);
+		return;
+	}
+
+	trace_running = true;
+	os_atomic_set_bool(&trace_enabled, true);
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+void profiler_trace_stop(void)
+{
+	pthread_mutex_lock(&trace_mutex);
+	if (!trace_running) {
+		pthread_mutex_unlock(&trace_mutex);
+		return;
+	}
+
+	os_atomic_set_bool(&trace_enabled, false);
+	trace_running = false;
+	pthread_mutex_unlock(&trace_mutex);
+
+	os_event_signal(trace_stop_event);
+	pthread_join(trace_thread, NULL);
+	os_event_destroy(trace_stop_event);
+	trace_stop_event = NULL;
+
+	while (os_atomic_load_long(&trace_writers) > 0)
+		os_sleep_ms(1);
+
+	/* the records stay, so the trace can still be saved */
+	pthread_mutex_lock(&trace_mutex);
+	trace_drain();
+	for (size_t i = 0; i < trace_rings.num; i++)
+		bfree(trace_rings.array[i]);
+	da_free(trace_rings);
+	os_atomic_inc_long(&trace_generation);
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+bool profiler_trace_active(void)
+{
+	return os_atomic_load_bool(&trace_enabled);
+}
+
+static void trace_cat_json_string(struct dstr *buffer, const char *str)
+{
+	dstr_cat_ch(buffer, '"');
+
+	for (; str && *str; str++) {
+		unsigned char ch = (unsigned char)*str;
+
+		if (ch == '"' || ch == '\\') {
+			dstr_cat_ch(buffer, '\\');
+			dstr_cat_ch(buffer, (char)ch);
+		} else if (ch < 0x20) {
+			dstr_catf(buffer, "\\u%04x", ch);
+		} else {
+			dstr_cat_ch(buffer, (char)ch);
+		}
+	}
+
+	dstr_cat_ch(buffer, '"');
+}
+
+static void trace_flush(FILE *f, struct dstr *buffer, bool force)
+{
+	if (buffer->len && (force || buffer->len >= 65536)) {
+		fwrite(buffer->array, 1, buffer->len, f);
+		buffer->len = 0;
+	}
+}
+
+bool profiler_trace_save(const char *filename)
+{
+	DARRAY(struct trace_record) records = {0};
+	DARRAY(const char *) names = {0};
+	struct dstr buffer = {0};
+	uint64_t base = UINT64_MAX;
+	uint64_t dropped;
+	bool first = true;
+	FILE *f;
+
+	f = os_fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	/* only copy under the lock; formatting and writing can take long
+	 * enough that the rings would overflow if draining had to wait */
+	pthread_mutex_lock(&trace_mutex);
+	if (trace_running)
+		trace_drain();
+
+	da_copy_array(records, trace_records.array + trace_records_start,
+		      trace_records.num - trace_records_start);
+	da_copy(names, trace_thread_names);
+	dropped = trace_dropped;
+	pthread_mutex_unlock(&trace_mutex);
+
+	for (size_t i = 0; i < records.num; i++)
+		if (records.array[i].start < base)
+			base = records.array[i].start;
+
+	dstr_copy(&buffer, "{\"traceEvents\":[");
+
+	for (size_t i = 0; i < names.num; i++) {
+		if (!names.array[i])
+			continue;
+
+		dstr_catf(&buffer,
+			  "%s\n{\"name\":\"thread_name\",\"ph\":\"M\","
+			  "\"pid\":1,\"tid\":%zu,\"args\":{\"name\":",
+			  first ? "" : ",", i + 1);
+		trace_cat_json_string(&buffer, names.array[i]);
+		dstr_cat(&buffer, "}}");
+		first = false;
+	}
+
+	for (size_t i = 0; i < records.num; i++) {
+		struct trace_record *record = &records.array[i];
+
+		dstr_cat(&buffer, first ? "\n{\"name\":" : ",\n{\"name\":");
+		trace_cat_json_string(&buffer, record->name);
+		dstr_catf(&buffer,
+			  ",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,"
+			  "\"ts\":%.3f,\"dur\":%.3f}",
+			  record->thread,
+			  (double)(record->start - base) / 1000.0,
+			  (double)record->duration / 1000.0);
+		first = false;
+
+		trace_flush(f, &buffer, false);
+	}
+
+	dstr_catf(&buffer,
+		  "\n],\"displayTimeUnit\":\"ms\","
+		  "\"otherData\":{\"dropped_events\":%" PRIu64 "}}\n",
+		  dropped);
+
+	trace_flush(f, &buffer, true);
+	dstr_free(&buffer);
+	da_free(records);
+	da_free(names);
+
+	fclose(f);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static bool lock_root(void)
 {
 	pthread_mutex_lock(&root_mutex);
@@ -367,8 +827,10 @@ static void merge_context(profile_call *context)
 
 void profile_start(const char *name)
 {
-	if (!thread_enabled)
+	if (!thread_enabled) {
+		trace_event(name, 0, false);
 		return;
+	}
 
 	profile_call new_call = {
 		.name = name,
@@ -390,11 +852,14 @@ void profile_start(const char *name)
 
 	thread_context = call;
 	call->start_time = os_gettime_ns();
+	trace_event(name, call->start_time, false);
 }
 
 void profile_end(const char *name)
 {
 	uint64_t end = os_gettime_ns();
+	trace_event(name, end, true);
+
 	if (!thread_enabled)
 		return;
 
@@ -803,6 +1268,11 @@ void profiler_free(void)
 {
 	DARRAY(profile_root_entry) old_root_entries = {0};
 
+	profiler_trace_stop();
+	pthread_mutex_lock(&trace_mutex);
+	trace_free_records();
+	pthread_mutex_unlock(&trace_mutex);
+
 	pthread_mutex_lock(&root_mutex);
 	enabled = false;
 	da_move(old_root_entries, root_entries);
@@ -33,6 +33,18 @@ EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Tracing */
+
+/** Records every profiled scope, keeping those from the last window_ns
+ * nanoseconds.  Calling it again while tracing only changes the window. */
+EXPORT void profiler_trace_start(uint64_t window_ns);
+EXPORT void profiler_trace_stop(void);
+EXPORT bool profiler_trace_active(void);
+
+/** Saves the trace in the Chrome trace event format (chrome://tracing) */
+EXPORT bool profiler_trace_save(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
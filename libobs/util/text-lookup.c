@@ -36,14 +36,28 @@ static inline void text_leaf_destroy(struct text_leaf *leaf)
 
 /* ------------------------------------------------------------------------- */
 
+/* most node strings are short pieces of a key, so they're kept in the node
+ * itself unless they don't fit */
+#define TEXT_NODE_INLINE_SIZE 32
+
 struct text_node {
 	struct dstr str;
 	struct text_node *first_subnode;
 	struct text_leaf *leaf;
 
 	struct text_node *next;
+
+	char inline_str[TEXT_NODE_INLINE_SIZE];
 };
 
+static inline struct text_node *text_node_create(void)
+{
+	struct text_node *node = bzalloc(sizeof(struct text_node));
+	dstr_init_inline(&node->str, node->inline_str,
+			 sizeof(node->inline_str));
+	return node;
+}
+
 static void text_node_destroy(struct text_node *node)
 {
 	struct text_node *subnode;
@@ -105,7 +119,7 @@ struct text_lookup {
 static void lookup_createsubnode(const char *lookup_val, struct text_leaf *leaf,
 				 struct text_node *node)
 {
-	struct text_node *new = bzalloc(sizeof(struct text_node));
+	struct text_node *new = text_node_create();
 	new->leaf = leaf;
 	new->next = node->first_subnode;
 	dstr_copy(&new->str, lookup_val);
@@ -116,7 +130,7 @@ static void lookup_createsubnode(const char *lookup_val, struct text_leaf *leaf,
 static void lookup_splitnode(const char *lookup_val, size_t len,
 			     struct text_leaf *leaf, struct text_node *node)
 {
-	struct text_node *split = bzalloc(sizeof(struct text_node));
+	struct text_node *split = text_node_create();
 
 	dstr_copy(&split->str, node->str.array + len);
 	split->leaf = node->leaf;
@@ -389,7 +403,7 @@ bool text_lookup_add(lookup_t *lookup, const char *path)
 		return false;
 
 	if (!lookup->top)
-		lookup->top = bzalloc(sizeof(struct text_node));
+		lookup->top = text_node_create();
 
 	dstr_replace(&file_str, "\r", " ");
 	lookup_addfiledata(lookup, file_str.array);
@@ -97,6 +97,45 @@ static inline bool os_atomic_compare_exchange_long(volatile long *val,
 	return previous == old_val;
 }
 
+static inline bool os_atomic_compare_exchange_int64(volatile int64_t *val,
+						    int64_t *old_ptr,
+						    int64_t new_val)
+{
+	const int64_t old_val = *old_ptr;
+	const int64_t previous =
+		_InterlockedCompareExchange64(val, new_val, old_val);
+	*old_ptr = previous;
+	return previous == old_val;
+}
+
+static inline int64_t os_atomic_load_int64(const volatile int64_t *ptr)
+{
+#if defined(_M_ARM64)
+	return (int64_t)__ldar64((volatile unsigned __int64 *)ptr);
+#elif defined(_M_X64)
+	const int64_t val =
+		__iso_volatile_load64((const volatile __int64 *)ptr);
+	_ReadWriteBarrier();
+	return val;
+#else
+	/* no plain atomic 64-bit loads on 32-bit targets */
+	return _InterlockedCompareExchange64((volatile int64_t *)ptr, 0, 0);
+#endif
+}
+
+/* returns the new value, like the other platforms */
+static inline int64_t os_atomic_add_int64(volatile int64_t *ptr, int64_t val)
+{
+#if defined(_M_IX86)
+	int64_t old_val = os_atomic_load_int64(ptr);
+	while (!os_atomic_compare_exchange_int64(ptr, &old_val, old_val + val))
+		;
+	return old_val + val;
+#else
+	return _InterlockedExchangeAdd64(ptr, val) + val;
+#endif
+}
+
 static inline void os_atomic_store_bool(volatile bool *ptr, bool val)
 {
 #if defined(_M_ARM64)
@@ -149,3 +188,15 @@ static inline bool os_atomic_load_bool(const volatile bool *ptr)
 
 	return b;
 }
+
+static inline void *os_atomic_load_ptr(void *const volatile *ptr)
+{
+	/* exchanging NULL for NULL is a load with a full barrier */
+	return _InterlockedCompareExchangePointer((void *volatile *)ptr, NULL,
+						  NULL);
+}
+
+static inline void *os_atomic_set_ptr(void *volatile *ptr, void *val)
+{
+	return _InterlockedExchangePointer(ptr, val);
+}
@@ -169,53 +169,17 @@ void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size,
 static int32_t last_time = 0;
 #endif
 
-static void flv_video(struct serializer *s, int32_t dts_offset,
-		      struct encoder_packet *packet, bool is_header)
+bool flv_packet_tag(struct encoder_packet *packet, int32_t dts_offset,
+		    struct flv_tag *tag, bool is_header)
 {
-	int64_t offset = packet->pts - packet->dts;
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
 
 	if (!packet->data || !packet->size)
-		return;
-
-	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
-
-#ifdef DEBUG_TIMESTAMPS
-	blog(LOG_DEBUG, "Video: %lu", time_ms);
-
-	if (last_time > time_ms)
-		blog(LOG_DEBUG, "Non-monotonic");
-
-	last_time = time_ms;
-#endif
-
-	s_wb24(s, (uint32_t)packet->size + 5);
-	s_wb24(s, time_ms);
-	s_w8(s, (time_ms >> 24) & 0x7F);
-	s_wb24(s, 0);
-
-	/* these are the 5 extra bytes mentioned above */
-	s_w8(s, packet->keyframe ? 0x17 : 0x27);
-	s_w8(s, is_header ? 0 : 1);
-	s_wb24(s, get_ms_time(packet, offset));
-	s_write(s, packet->data, packet->size);
-
-	/* write tag size (starting byte doesn't count) */
-	s_wb32(s, (uint32_t)serializer_get_pos(s) - 1);
-}
-
-static void flv_audio(struct serializer *s, int32_t dts_offset,
-		      struct encoder_packet *packet, bool is_header)
-{
-	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
-
-	if (!packet->data || !packet->size)
-		return;
-
-	s_w8(s, RTMP_PACKET_TYPE_AUDIO);
+		return false;
 
 #ifdef DEBUG_TIMESTAMPS
-	blog(LOG_DEBUG, "Audio: %lu", time_ms);
+	blog(LOG_DEBUG, "%s: %lu",
+	     packet->type == OBS_ENCODER_VIDEO ? "Video" : "Audio", time_ms);
 
 	if (last_time > time_ms)
 		blog(LOG_DEBUG, "Non-monotonic");
@@ -223,18 +187,27 @@ static void flv_audio(struct serializer *s, int32_t dts_offset,
 	last_time = time_ms;
 #endif
 
-	s_wb24(s, (uint32_t)packet->size + 2);
-	s_wb24(s, time_ms);
-	s_w8(s, (time_ms >> 24) & 0x7F);
-	s_wb24(s, 0);
+	/* 24 bits of timestamp, then 7 more in the extended byte */
+	tag->timestamp = (uint32_t)time_ms & 0x7FFFFFFF;
 
-	/* these are the two extra bytes mentioned above */
-	s_w8(s, 0xaf);
-	s_w8(s, is_header ? 0 : 1);
-	s_write(s, packet->data, packet->size);
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		int32_t offset = get_ms_time(packet, packet->pts - packet->dts);
+
+		tag->type = RTMP_PACKET_TYPE_VIDEO;
+		tag->prefix[0] = packet->keyframe ? 0x17 : 0x27;
+		tag->prefix[1] = is_header ? 0 : 1;
+		tag->prefix[2] = (uint8_t)(offset >> 16);
+		tag->prefix[3] = (uint8_t)(offset >> 8);
+		tag->prefix[4] = (uint8_t)offset;
+		tag->prefix_size = VIDEO_HEADER_SIZE;
+	} else {
+		tag->type = RTMP_PACKET_TYPE_AUDIO;
+		tag->prefix[0] = 0xaf;
+		tag->prefix[1] = is_header ? 0 : 1;
+		tag->prefix_size = 2;
+	}
 
-	/* write tag size (starting byte doesn't count) */
-	s_wb32(s, (uint32_t)serializer_get_pos(s) - 1);
+	return true;
 }
 
 void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
@@ -242,13 +215,24 @@ void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 {
 	struct array_output_data data;
 	struct serializer s;
+	struct flv_tag tag;
 
 	array_output_serializer_init(&s, &data);
 
-	if (packet->type == OBS_ENCODER_VIDEO)
-		flv_video(&s, dts_offset, packet, is_header);
-	else
-		flv_audio(&s, dts_offset, packet, is_header);
+	if (flv_packet_tag(packet, dts_offset, &tag, is_header)) {
+		s_w8(&s, tag.type);
+		s_wb24(&s, (uint32_t)(tag.prefix_size + packet->size));
+		s_wb24(&s, tag.timestamp);
+		s_w8(&s, (uint8_t)(tag.timestamp >> 24));
+		s_wb24(&s, 0);
+
+		/* the video/audio header bytes come before the packet data */
+		s_write(&s, tag.prefix, tag.prefix_size);
+		s_write(&s, packet->data, packet->size);
+
+		/* write tag size (starting byte doesn't count) */
+		s_wb32(&s, (uint32_t)serializer_get_pos(&s) - 1);
+	}
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
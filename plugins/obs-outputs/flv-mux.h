@@ -26,12 +26,22 @@ static int32_t get_ms_time(struct encoder_packet *packet, int64_t val)
 	return (int32_t)(val * MILLISECOND_DEN / packet->timebase_den);
 }
 
+/* everything about a packet's FLV tag except its data */
+struct flv_tag {
+	uint8_t type;
+	uint32_t timestamp;
+	uint8_t prefix[5];
+	size_t prefix_size;
+};
+
 extern void write_file_info(FILE *file, int64_t duration_ms, int64_t size);
 
 extern void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size,
 			  bool write_header);
 extern void flv_additional_meta_data(obs_output_t *context, uint8_t **output,
 				     size_t *size);
+extern bool flv_packet_tag(struct encoder_packet *packet, int32_t dts_offset,
+			   struct flv_tag *tag, bool is_header);
 extern void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 			   uint8_t **output, size_t *size, bool is_header);
 extern void flv_additional_packet_mux(struct encoder_packet *packet,
@@ -1619,6 +1619,97 @@ WriteN(RTMP *r, const char *buffer, int n)
     return n == 0;
 }
 
+#define RTMP_MAX_SLICES 64
+
+/* Sends the slices in order as if they were one buffer.  A plain socket
+ * takes them all in a single call; a custom send function or RC4 gets them
+ * one WriteN at a time. */
+static int
+WriteSlices(RTMP *r, RTMPSlice *slices, int count)
+{
+    int direct = !(r->m_bCustomSend && r->m_customSendFunc);
+    int i;
+
+#ifdef CRYPTO
+    if (r->Link.rc4keyOut)
+        direct = FALSE;
+#endif
+#if defined(RTMP_NETSTACK_DUMP)
+    direct = FALSE;
+#endif
+
+    if (direct)
+    {
+        while (count > 0)
+        {
+            int nBytes;
+#ifdef _WIN32
+            WSABUF bufs[RTMP_MAX_SLICES];
+            DWORD sent = 0;
+
+            for (i = 0; i < count; i++)
+            {
+                bufs[i].buf = (CHAR *)slices[i].data;
+                bufs[i].len = (ULONG)slices[i].size;
+            }
+            nBytes = WSASend(r->m_sb.sb_socket, bufs, count, &sent, 0,
+                             NULL, NULL) == 0 ? (int)sent : -1;
+#else
+            struct iovec iov[RTMP_MAX_SLICES];
+            struct msghdr msg = {0};
+
+            for (i = 0; i < count; i++)
+            {
+                iov[i].iov_base = (void *)slices[i].data;
+                iov[i].iov_len = slices[i].size;
+            }
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+            nBytes = (int)sendmsg(r->m_sb.sb_socket, &msg, MSG_NOSIGNAL);
+#endif
+
+            if (nBytes < 0)
+            {
+                int sockerr = GetSockError();
+                RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d", __FUNCTION__,
+                         sockerr);
+
+                if (sockerr == EINTR && !RTMP_ctrlC)
+                    continue;
+
+                r->last_error_code = sockerr;
+
+                RTMP_Close(r);
+                return FALSE;
+            }
+
+            if (nBytes == 0)
+                return FALSE;
+
+            /* drop what went out, which may end partway into a slice */
+            while (count > 0 && nBytes >= slices->size)
+            {
+                nBytes -= slices->size;
+                slices++;
+                count--;
+            }
+            if (count > 0)
+            {
+                slices->data += nBytes;
+                slices->size -= nBytes;
+            }
+        }
+        return TRUE;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (!WriteN(r, slices[i].data, slices[i].size))
+            return FALSE;
+    }
+    return TRUE;
+}
+
 #define SAVC(x)	static const AVal av_##x = AVC(#x)
 
 SAVC(app);
@@ -4069,18 +4160,15 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+/* Grows the outgoing channel list if needed and picks the smallest header
+ * type the previous packet on the channel allows.  *last is set to the
+ * previous packet's timestamp. */
+static int
+PreparePacketHeader(RTMP *r, RTMPPacket *packet, uint32_t *last)
 {
     const RTMPPacket *prevPacket;
-    uint32_t last = 0;
-    int nSize;
-    int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
-    uint32_t t;
-    char *buffer, *tbuf = NULL, *toff = NULL;
-    int nChunkSize;
-    int tlen;
+
+    *last = 0;
 
     if (packet->m_nChannel >= r->m_channelsAllocatedOut)
     {
@@ -4110,7 +4198,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         if (prevPacket->m_nTimeStamp == packet->m_nTimeStamp
                 && packet->m_headerType == RTMP_PACKET_SIZE_SMALL)
             packet->m_headerType = RTMP_PACKET_SIZE_MINIMUM;
-        last = prevPacket->m_nTimeStamp;
+        *last = prevPacket->m_nTimeStamp;
     }
 
     if (packet->m_headerType > 3)	/* sanity */
@@ -4120,39 +4208,27 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         return FALSE;
     }
 
-    nSize = packetSize[packet->m_headerType];
-    hSize = nSize;
-    cSize = 0;
-    t = packet->m_nTimeStamp - last;
+    return TRUE;
+}
 
-    if (packet->m_body)
-    {
-        header = packet->m_body - nSize;
-        hend = packet->m_body;
-    }
-    else
-    {
-        header = hbuf + 6;
-        hend = hbuf + sizeof(hbuf);
-    }
+/* Writes the first chunk header of a packet to header, which must hold
+ * RTMP_MAX_HEADER_SIZE bytes, and returns its size.  The header of every
+ * following chunk is contHeader[0..contSize). */
+static int
+EncodePacketHeader(const RTMPPacket *packet, uint32_t t, char *header,
+                   char *contHeader, int *contSize)
+{
+    char *hend = header + RTMP_MAX_HEADER_SIZE;
+    char *hptr = header;
+    int nSize = packetSize[packet->m_headerType];
+    int cSize = 0;
+    char c;
 
     if (packet->m_nChannel > 319)
         cSize = 2;
     else if (packet->m_nChannel > 63)
         cSize = 1;
-    if (cSize)
-    {
-        header -= cSize;
-        hSize += cSize;
-    }
 
-    if (nSize > 1 && t >= 0xffffff)
-    {
-        header -= 4;
-        hSize += 4;
-    }
-
-    hptr = header;
     c = packet->m_headerType << 6;
     switch (cSize)
     {
@@ -4191,6 +4267,49 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     if (nSize > 1 && t >= 0xffffff)
         hptr = AMF_EncodeInt32(hptr, hend, t);
 
+    contHeader[0] = 0xc0 | c;
+    memcpy(contHeader + 1, header + 1, cSize);
+    *contSize = 1 + cSize;
+
+    return (int)(hptr - header);
+}
+
+static void
+RememberPacket(RTMP *r, const RTMPPacket *packet)
+{
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
+    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+}
+
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    uint32_t last;
+    int nSize;
+    int hSize, contSize;
+    char *header, hbuf[RTMP_MAX_HEADER_SIZE], contHeader[3];
+    uint32_t t;
+    char *buffer, *tbuf = NULL, *toff = NULL;
+    int nChunkSize;
+    int tlen;
+
+    if (!PreparePacketHeader(r, packet, &last))
+        return FALSE;
+
+    t = packet->m_nTimeStamp - last;
+    hSize = EncodePacketHeader(packet, t, hbuf, contHeader, &contSize);
+
+    if (packet->m_body)
+    {
+        header = packet->m_body - hSize;
+        memcpy(header, hbuf, hSize);
+    }
+    else
+    {
+        header = hbuf;
+    }
+
     nSize = packet->m_nBodySize;
     buffer = packet->m_body;
     nChunkSize = r->m_outChunkSize;
@@ -4203,7 +4322,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         int chunks = (nSize+nChunkSize-1) / nChunkSize;
         if (chunks > 1)
         {
-            tlen = chunks * (cSize + 1) + nSize + hSize;
+            tlen = chunks * contSize + nSize + hSize;
             tbuf = malloc(tlen);
             if (!tbuf)
                 return FALSE;
@@ -4236,21 +4355,9 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
 
         if (nSize > 0)
         {
-            header = buffer - 1;
-            hSize = 1;
-            if (cSize)
-            {
-                header -= cSize;
-                hSize += cSize;
-            }
-            *header = (0xc0 | c);
-            if (cSize)
-            {
-                int tmp = packet->m_nChannel - 64;
-                header[1] = tmp & 0xff;
-                if (cSize == 2)
-                    header[2] = tmp >> 8;
-            }
+            hSize = contSize;
+            header = buffer - hSize;
+            memcpy(header, contHeader, hSize);
         }
     }
     if (tbuf)
@@ -4280,9 +4387,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         }
     }
 
-    if (!r->m_vecChannelsOut[packet->m_nChannel])
-        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
-    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+    RememberPacket(r, packet);
     return TRUE;
 }
 
@@ -5375,3 +5480,109 @@ RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
     }
     return size+s2;
 }
+
+/* Sends one FLV tag as a packet, like RTMP_Write, but without copying the
+ * body: the chunk headers are built on the side and sent in between the
+ * caller's slices.  Returns the body size, or -1 if sending failed. */
+int
+RTMP_WriteV(RTMP *r, uint8_t packetType, uint32_t timestamp,
+            const RTMPSlice *body, int count, int streamIdx)
+{
+    RTMPPacket packet = {0};
+    RTMPSlice out[RTMP_MAX_SLICES];
+    char hbuf[RTMP_MAX_HEADER_SIZE], contHeader[3];
+    int hSize, contSize, left, n = 0, i;
+    uint32_t last;
+
+    packet.m_nChannel = 0x04;	/* source channel */
+    packet.m_nInfoField2 = r->Link.streams[streamIdx].id;
+    packet.m_packetType = packetType;
+    packet.m_nTimeStamp = timestamp;
+    for (i = 0; i < count; i++)
+        packet.m_nBodySize += body[i].size;
+
+    if (((packetType == RTMP_PACKET_TYPE_AUDIO
+            || packetType == RTMP_PACKET_TYPE_VIDEO) &&
+            !timestamp) || packetType == RTMP_PACKET_TYPE_INFO)
+    {
+        packet.m_headerType = RTMP_PACKET_SIZE_LARGE;
+    }
+    else
+    {
+        packet.m_headerType = RTMP_PACKET_SIZE_MEDIUM;
+    }
+
+    RTMP_Log(RTMP_LOGDEBUG2, "%s: fd=%d, size=%u", __FUNCTION__,
+             (int)r->m_sb.sb_socket, packet.m_nBodySize);
+
+    /* HTTP and TLS want each chunk in one piece, so copy it once */
+    if ((r->Link.protocol & RTMP_FEATURE_HTTP) || r->m_sb.sb_ssl)
+    {
+        char *enc;
+        int ret;
+
+        if (!RTMPPacket_Alloc(&packet, packet.m_nBodySize))
+        {
+            RTMP_Log(RTMP_LOGDEBUG, "%s, failed to allocate packet", __FUNCTION__);
+            return -1;
+        }
+
+        enc = packet.m_body;
+        for (i = 0; i < count; i++)
+        {
+            memcpy(enc, body[i].data, body[i].size);
+            enc += body[i].size;
+        }
+
+        ret = RTMP_SendPacket(r, &packet, FALSE);
+        RTMPPacket_Free(&packet);
+        return ret ? (int)packet.m_nBodySize : -1;
+    }
+
+    if (!PreparePacketHeader(r, &packet, &last))
+        return -1;
+
+    hSize = EncodePacketHeader(&packet, packet.m_nTimeStamp - last, hbuf,
+                               contHeader, &contSize);
+    out[n].data = hbuf;
+    out[n++].size = hSize;
+    left = r->m_outChunkSize;
+
+    for (i = 0; i < count; i++)
+    {
+        const char *data = body[i].data;
+        int size = body[i].size;
+
+        while (size > 0)
+        {
+            int len;
+
+            if (n + 2 > RTMP_MAX_SLICES)
+            {
+                if (!WriteSlices(r, out, n))
+                    return -1;
+                n = 0;
+            }
+
+            if (!left)
+            {
+                out[n].data = contHeader;
+                out[n++].size = contSize;
+                left = r->m_outChunkSize;
+            }
+
+            len = size < left ? size : left;
+            out[n].data = data;
+            out[n++].size = len;
+            data += len;
+            size -= len;
+            left -= len;
+        }
+    }
+
+    if (!WriteSlices(r, out, n))
+        return -1;
+
+    RememberPacket(r, &packet);
+    return (int)packet.m_nBodySize;
+}
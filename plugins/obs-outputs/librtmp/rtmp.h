@@ -540,6 +540,16 @@ extern "C"
     int RTMP_Read(RTMP *r, char *buf, int size);
     int RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx);
 
+    /* a piece of a packet body, sent from where it is rather than copied */
+    typedef struct RTMPSlice
+    {
+        const char *data;
+        int size;
+    } RTMPSlice;
+
+    int RTMP_WriteV(RTMP *r, uint8_t packetType, uint32_t timestamp,
+                    const RTMPSlice *body, int count, int streamIdx);
+
 #ifdef USE_HASHSWF
     /* hashswf.c */
     int RTMP_HashSWF(const char *url, unsigned int *size, unsigned char *hash,
@@ -0,0 +1,375 @@
+#ifdef __linux__
+#include "rtmp-stream.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/*
+ *   The socket is non-blocking and edge-triggered in epoll, and queued data is
+ * sent straight out of the write_buf ring (both halves at once when it wraps),
+ * so nothing is moved around after a partial send.  The thread sleeps in
+ * epoll_wait whenever the ring is empty or the socket is full; socket_queue_data
+ * wakes it through socket_wake_fd when it adds data to an empty ring.
+ *
+ *   Every second, the bytes sent and the time spent waiting for the socket to
+ * take more data are logged at debug level, with totals at exit.
+ */
+
+#define LATENCY_FACTOR 20
+#define STATS_INTERVAL_NS 1000000000ULL
+
+struct socket_stats {
+	uint64_t window_start;
+	uint64_t window_bytes;
+	uint64_t window_blocked_ns;
+	uint64_t blocked_since;
+
+	uint64_t total_bytes;
+	uint64_t total_blocked_ns;
+	uint64_t max_blocked_ns;
+};
+
+static void fatal_sock_shutdown(struct rtmp_stream *stream)
+{
+	close(stream->rtmp.m_sb.sb_socket);
+	stream->rtmp.m_sb.sb_socket = -1;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	stream->write_buf_len = 0;
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	os_event_signal(stream->buffer_space_available_event);
+}
+
+static inline void stats_block(struct socket_stats *stats, uint64_t now)
+{
+	if (!stats->blocked_since)
+		stats->blocked_since = now;
+}
+
+static inline void stats_unblock(struct socket_stats *stats, uint64_t now)
+{
+	if (stats->blocked_since) {
+		stats->window_blocked_ns += now - stats->blocked_since;
+		stats->blocked_since = 0;
+	}
+}
+
+static void stats_tick(struct rtmp_stream *stream, struct socket_stats *stats,
+		       uint64_t now)
+{
+	uint64_t elapsed = now - stats->window_start;
+
+	if (elapsed < STATS_INTERVAL_NS)
+		return;
+
+	if (stats->blocked_since) {
+		stats->window_blocked_ns += now - stats->blocked_since;
+		stats->blocked_since = now;
+	}
+
+	blog(LOG_DEBUG,
+	     "socket_thread_linux: %" PRIu64 " kb/s sent, "
+	     "blocked %" PRIu64 " ms/s (buffer: %zu / %zu)",
+	     stats->window_bytes * 8 * 1000000 / elapsed,
+	     stats->window_blocked_ns * 1000 / elapsed,
+	     stream->write_buf_len, stream->write_buf_size);
+
+	if (stats->window_blocked_ns > stats->max_blocked_ns)
+		stats->max_blocked_ns = stats->window_blocked_ns;
+	stats->total_bytes += stats->window_bytes;
+	stats->total_blocked_ns += stats->window_blocked_ns;
+
+	stats->window_start = now;
+	stats->window_bytes = 0;
+	stats->window_blocked_ns = 0;
+}
+
+/* how long epoll_wait may sleep before the current window has to be logged */
+static int stats_timeout_ms(const struct socket_stats *stats, uint64_t now)
+{
+	uint64_t elapsed = now - stats->window_start;
+
+	if (elapsed >= STATS_INTERVAL_NS)
+		return 0;
+	return (int)((STATS_INTERVAL_NS - elapsed + 999999) / 1000000);
+}
+
+static bool socket_event(struct rtmp_stream *stream, uint32_t events,
+			 bool *can_write, struct socket_stats *stats,
+			 uint64_t now)
+{
+	int sock = stream->rtmp.m_sb.sb_socket;
+
+	if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+		int err_code = 0;
+		socklen_t size = sizeof(err_code);
+
+		getsockopt(sock, SOL_SOCKET, SO_ERROR, &err_code, &size);
+
+		if (os_event_try(stream->stop_event) != EAGAIN)
+			blog(LOG_ERROR,
+			     "socket_thread_linux: Aborting due to "
+			     "connection close during shutdown, "
+			     "%zu bytes lost, error %d",
+			     stream->write_buf_len, err_code);
+		else
+			blog(LOG_ERROR,
+			     "socket_thread_linux: Aborting due to "
+			     "connection close, error %d",
+			     err_code);
+
+		stream->rtmp.last_error_code = err_code;
+		fatal_sock_shutdown(stream);
+		return false;
+	}
+
+	if (events & EPOLLIN) {
+		char discard[16384];
+
+		for (;;) {
+			ssize_t ret = recv(sock, discard, sizeof(discard), 0);
+			if (ret > 0)
+				continue;
+			if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				break;
+			if (ret == -1 && errno == EINTR)
+				continue;
+
+			blog(LOG_ERROR,
+			     "socket_thread_linux: Socket error, "
+			     "recv() returned %zd, errno %d",
+			     ret, ret == 0 ? 0 : errno);
+			stream->rtmp.last_error_code = ret == 0 ? 0 : errno;
+			fatal_sock_shutdown(stream);
+			return false;
+		}
+	}
+
+	if (events & EPOLLOUT) {
+		*can_write = true;
+		stats_unblock(stats, now);
+	}
+
+	return true;
+}
+
+enum data_ret { RET_BREAK, RET_FATAL, RET_CONTINUE };
+
+static ssize_t send_iov(struct rtmp_stream *stream, struct iovec *iov,
+			int iov_count)
+{
+	struct msghdr msg = {0};
+
+	/* TLS has to go through librtmp, one contiguous piece at a time */
+	if (stream->rtmp.m_sb.sb_ssl)
+		return RTMPSockBuf_Send(&stream->rtmp.m_sb, iov[0].iov_base,
+					(int)iov[0].iov_len);
+
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iov_count;
+	return sendmsg(stream->rtmp.m_sb.sb_socket, &msg, MSG_NOSIGNAL);
+}
+
+static enum data_ret write_data(struct rtmp_stream *stream, bool *can_write,
+				struct socket_stats *stats,
+				size_t latency_packet_size)
+{
+	struct iovec iov[2];
+	size_t len, first;
+	ssize_t ret;
+
+	/* only this thread takes data out of the ring, so what's queued
+	 * stays put while it's sent without the lock */
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	len = stream->write_buf_len;
+	if (len > latency_packet_size)
+		len = latency_packet_size;
+	first = write_buf_contiguous(stream);
+	if (first > len)
+		first = len;
+
+	iov[0].iov_base = stream->write_buf + stream->write_buf_pos;
+	iov[0].iov_len = first;
+	iov[1].iov_base = stream->write_buf;
+	iov[1].iov_len = len - first;
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	if (!len)
+		return RET_BREAK;
+
+	ret = send_iov(stream, iov, iov[1].iov_len ? 2 : 1);
+
+	if (ret > 0) {
+		pthread_mutex_lock(&stream->write_buf_mutex);
+		write_buf_consume(stream, (size_t)ret);
+		len = stream->write_buf_len;
+		pthread_mutex_unlock(&stream->write_buf_mutex);
+
+		stats->window_bytes += (uint64_t)ret;
+		os_event_signal(stream->buffer_space_available_event);
+
+		return len ? RET_CONTINUE : RET_BREAK;
+	}
+
+	if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		*can_write = false;
+		stats_block(stats, os_gettime_ns());
+		return RET_BREAK;
+	}
+	if (ret < 0 && errno == EINTR)
+		return RET_CONTINUE;
+
+	/* connection closed, or connection was aborted / socket closed /
+	 * etc, that's a fatal error. */
+	blog(LOG_ERROR,
+	     "socket_thread_linux: Socket error, send() returned %zd, "
+	     "errno %d",
+	     ret, ret == 0 ? 0 : errno);
+
+	stream->rtmp.last_error_code = ret == 0 ? 0 : errno;
+	fatal_sock_shutdown(stream);
+	return RET_FATAL;
+}
+
+static inline bool add_to_epoll(int epoll_fd, int fd, uint32_t events)
+{
+	struct epoll_event ev = {0};
+
+	ev.events = events;
+	ev.data.fd = fd;
+	return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+static inline bool exit_signaled(struct rtmp_stream *stream)
+{
+	bool empty;
+
+	if (os_event_try(stream->send_thread_signaled_exit) == EAGAIN)
+		return false;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	empty = stream->write_buf_len == 0;
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	if (empty)
+		os_event_reset(stream->send_thread_signaled_exit);
+	return empty;
+}
+
+static void socket_thread_linux_internal(struct rtmp_stream *stream,
+					 int epoll_fd)
+{
+	int sock = stream->rtmp.m_sb.sb_socket;
+	struct socket_stats stats = {0};
+	struct epoll_event events[2];
+	bool can_write = true;
+
+	int delay_time;
+	size_t latency_packet_size;
+
+	if (!add_to_epoll(epoll_fd, sock,
+			  EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET) ||
+	    !add_to_epoll(epoll_fd, stream->socket_wake_fd, EPOLLIN)) {
+		blog(LOG_ERROR,
+		     "socket_thread_linux: Aborting due to "
+		     "epoll_ctl failure, %d",
+		     errno);
+		fatal_sock_shutdown(stream);
+		return;
+	}
+
+	if (stream->low_latency_mode) {
+		delay_time = 1000 / LATENCY_FACTOR;
+		latency_packet_size =
+			stream->write_buf_size / (LATENCY_FACTOR - 2);
+	} else {
+		latency_packet_size = stream->write_buf_size;
+		delay_time = 0;
+	}
+
+	stats.window_start = os_gettime_ns();
+
+	while (!exit_signaled(stream)) {
+		uint64_t now;
+		int count;
+
+		if (can_write) {
+			enum data_ret ret = write_data(stream, &can_write,
+						       &stats,
+						       latency_packet_size);
+			if (ret == RET_FATAL)
+				return;
+			if (ret == RET_CONTINUE) {
+				if (delay_time)
+					os_sleep_ms(delay_time);
+				continue;
+			}
+		}
+
+		/* nothing left to send, or the socket can't take any more.  wake
+		 * up at the end of the stats window even if nothing happens. */
+		count = epoll_wait(epoll_fd, events, 2,
+				   stats_timeout_ms(&stats, os_gettime_ns()));
+		if (count == -1) {
+			if (errno == EINTR)
+				continue;
+
+			blog(LOG_ERROR,
+			     "socket_thread_linux: Aborting due to "
+			     "epoll_wait failure, %d",
+			     errno);
+			fatal_sock_shutdown(stream);
+			return;
+		}
+
+		now = os_gettime_ns();
+
+		for (int i = 0; i < count; i++) {
+			if (events[i].data.fd == stream->socket_wake_fd) {
+				eventfd_t val;
+				eventfd_read(stream->socket_wake_fd, &val);
+
+			} else if (!socket_event(stream, events[i].events,
+						 &can_write, &stats, now)) {
+				return;
+			}
+		}
+
+		stats_tick(stream, &stats, now);
+	}
+
+	stats_unblock(&stats, os_gettime_ns());
+	stats.total_bytes += stats.window_bytes;
+	stats.total_blocked_ns += stats.window_blocked_ns;
+
+	blog(LOG_INFO,
+	     "socket_thread_linux: Normal exit, %" PRIu64 " bytes sent, "
+	     "blocked %" PRIu64 " ms in total and at most %" PRIu64
+	     " ms in one second",
+	     stats.total_bytes, stats.total_blocked_ns / 1000000,
+	     stats.max_blocked_ns / 1000000);
+}
+
+void *socket_thread_linux(void *data)
+{
+	struct rtmp_stream *stream = data;
+	int epoll_fd;
+
+	os_set_thread_name("rtmp-stream: socket_thread");
+
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd == -1) {
+		blog(LOG_ERROR,
+		     "socket_thread_linux: Aborting due to "
+		     "epoll_create1 failure, %d",
+		     errno);
+		fatal_sock_shutdown(stream);
+		return NULL;
+	}
+
+	socket_thread_linux_internal(stream, epoll_fd);
+	close(epoll_fd);
+	return NULL;
+}
+#endif
@@ -166,6 +166,9 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
 	stream->output = output;
 	pthread_mutex_init_value(&stream->packets_mutex);
+#ifdef __linux__
+	stream->socket_wake_fd = -1;
+#endif
 
 	RTMP_LogSetCallback(log_rtmp);
 	RTMP_Init(&stream->rtmp);
@@ -391,6 +394,8 @@ static int socket_queue_data(RTMPSockBuf *sb, const char *data, int len,
 	UNUSED_PARAMETER(sb);
 
 	struct rtmp_stream *stream = arg;
+	size_t end, first;
+	bool was_empty;
 
 retry_send:
 
@@ -410,21 +415,88 @@ retry_send:
 		goto retry_send;
 	}
 
-	memcpy(stream->write_buf + stream->write_buf_len, data, len);
+	end = stream->write_buf_pos + stream->write_buf_len;
+	if (end >= stream->write_buf_size)
+		end -= stream->write_buf_size;
+
+	first = stream->write_buf_size - end;
+	if (first > (size_t)len)
+		first = len;
+
+	memcpy(stream->write_buf + end, data, first);
+	memcpy(stream->write_buf, data + first, len - first);
+
+	was_empty = stream->write_buf_len == 0;
 	stream->write_buf_len += len;
 
 	pthread_mutex_unlock(&stream->write_buf_mutex);
 
 	os_event_signal(stream->buffer_has_data_event);
+#ifdef __linux__
+	/* the socket thread only sleeps on the socket while it has data */
+	if (was_empty)
+		eventfd_write(stream->socket_wake_fd, 1);
+#else
+	UNUSED_PARAMETER(was_empty);
+#endif
 
 	return len;
 }
 
+/* sends the packet data straight from the encoder, with the FLV tag's
+ * header bytes and the chunk headers in between */
+static int write_packet(struct rtmp_stream *stream,
+			struct encoder_packet *packet, bool is_header,
+			size_t *size)
+{
+	struct flv_tag tag;
+	RTMPSlice body[2];
+
+	*size = 0;
+
+	if (!flv_packet_tag(packet, is_header ? 0 : stream->start_dts_offset,
+			    &tag, is_header))
+		return 0;
+
+	body[0].data = (const char *)tag.prefix;
+	body[0].size = (int)tag.prefix_size;
+	body[1].data = (const char *)packet->data;
+	body[1].size = (int)packet->size;
+
+	/* counted as the FLV tag it would have been muxed into */
+	*size = 11 + tag.prefix_size + packet->size + 4;
+
+#ifdef TEST_FRAMEDROPS
+	droptest_cap_data_rate(stream, *size);
+#endif
+
+	return RTMP_WriteV(&stream->rtmp, tag.type, tag.timestamp, body, 2, 0);
+}
+
+static int write_additional_packet(struct rtmp_stream *stream,
+				   struct encoder_packet *packet,
+				   bool is_header, size_t idx, size_t *size)
+{
+	uint8_t *data;
+	int ret;
+
+	flv_additional_packet_mux(packet,
+				  is_header ? 0 : stream->start_dts_offset,
+				  &data, size, is_header, idx);
+
+#ifdef TEST_FRAMEDROPS
+	droptest_cap_data_rate(stream, *size);
+#endif
+
+	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)*size, 0);
+	bfree(data);
+	return ret;
+}
+
 static int send_packet(struct rtmp_stream *stream,
 		       struct encoder_packet *packet, bool is_header,
 		       size_t idx)
 {
-	uint8_t *data;
 	size_t size;
 	int recv_size = 0;
 	int ret = 0;
@@ -445,21 +517,11 @@ static int send_packet(struct rtmp_stream *stream,
 		}
 	}
 
-	if (idx > 0) {
-		flv_additional_packet_mux(
-			packet, is_header ? 0 : stream->start_dts_offset, &data,
-			&size, is_header, idx);
-	} else {
-		flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset,
-			       &data, &size, is_header);
-	}
-
-#ifdef TEST_FRAMEDROPS
-	droptest_cap_data_rate(stream, size);
-#endif
-
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	if (idx > 0)
+		ret = write_additional_packet(stream, packet, is_header, idx,
+					      &size);
+	else
+		ret = write_packet(stream, packet, is_header, &size);
 
 	if (is_header)
 		bfree(packet->data);
@@ -654,9 +716,16 @@ static void *send_thread(void *data)
 	if (stream->new_socket_loop) {
 		os_event_signal(stream->send_thread_signaled_exit);
 		os_event_signal(stream->buffer_has_data_event);
+#ifdef __linux__
+		eventfd_write(stream->socket_wake_fd, 1);
+#endif
 		pthread_join(stream->socket_thread, NULL);
 		stream->socket_thread_active = false;
 		stream->rtmp.m_bCustomSend = false;
+#ifdef __linux__
+		close(stream->socket_wake_fd);
+		stream->socket_wake_fd = -1;
+#endif
 	}
 
 	set_output_error(stream);
@@ -879,10 +948,25 @@ static int init_send(struct rtmp_stream *stream)
 
 		stream->write_buf_size = ideal_buffer_size;
 		stream->write_buf = bmalloc(ideal_buffer_size);
+		stream->write_buf_pos = 0;
+		stream->write_buf_len = 0;
 
 #ifdef _WIN32
 		ret = pthread_create(&stream->socket_thread, NULL,
 				     socket_thread_windows, stream);
+#elif defined(__linux__)
+		stream->socket_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (stream->socket_wake_fd == -1) {
+			warn("Failed to create socket wake event: %d", errno);
+			return OBS_OUTPUT_ERROR;
+		}
+
+		ret = pthread_create(&stream->socket_thread, NULL,
+				     socket_thread_linux, stream);
+		if (ret != 0) {
+			close(stream->socket_wake_fd);
+			stream->socket_wake_fd = -1;
+		}
 #else
 		warn("New socket loop not supported on this platform");
 		return OBS_OUTPUT_ERROR;
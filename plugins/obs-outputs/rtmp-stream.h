@@ -16,6 +16,11 @@
 #include <sys/ioctl.h>
 #endif
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 #define do_log(level, format, ...)                 \
 	blog(level, "[rtmp stream: '%s'] " format, \
 	     obs_output_get_name(stream->output), ##__VA_ARGS__)
@@ -123,7 +128,9 @@ struct rtmp_stream {
 	bool disable_send_window_optimization;
 	bool socket_thread_active;
 	pthread_t socket_thread;
+	/* ring of write_buf_len queued bytes starting at write_buf_pos */
 	uint8_t *write_buf;
+	size_t write_buf_pos;
 	size_t write_buf_len;
 	size_t write_buf_size;
 	pthread_mutex_t write_buf_mutex;
@@ -131,8 +138,29 @@ struct rtmp_stream {
 	os_event_t *buffer_has_data_event;
 	os_event_t *socket_available_event;
 	os_event_t *send_thread_signaled_exit;
+#ifdef __linux__
+	int socket_wake_fd;
+#endif
 };
 
+/* assumes write_buf_mutex */
+static inline size_t write_buf_contiguous(const struct rtmp_stream *stream)
+{
+	size_t to_end = stream->write_buf_size - stream->write_buf_pos;
+	return stream->write_buf_len < to_end ? stream->write_buf_len : to_end;
+}
+
+/* assumes write_buf_mutex */
+static inline void write_buf_consume(struct rtmp_stream *stream, size_t size)
+{
+	stream->write_buf_pos += size;
+	if (stream->write_buf_pos >= stream->write_buf_size)
+		stream->write_buf_pos -= stream->write_buf_size;
+	stream->write_buf_len -= size;
+}
+
 #ifdef _WIN32
 void *socket_thread_windows(void *data);
+#elif defined(__linux__)
+void *socket_thread_linux(void *data);
 #endif
@@ -162,24 +162,18 @@ static enum data_ret write_data(struct rtmp_stream *stream, bool *can_write,
 	}
 
 	int ret;
-	if (stream->low_latency_mode) {
-		size_t send_len =
-			min(latency_packet_size, stream->write_buf_len);
+	size_t send_len = write_buf_contiguous(stream);
 
-		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb,
-				       (const char *)stream->write_buf,
-				       (int)send_len);
-	} else {
-		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb,
-				       (const char *)stream->write_buf,
-				       (int)stream->write_buf_len);
-	}
+	if (stream->low_latency_mode)
+		send_len = min(latency_packet_size, send_len);
+
+	ret = RTMPSockBuf_Send(&stream->rtmp.m_sb,
+			       (const char *)stream->write_buf +
+				       stream->write_buf_pos,
+			       (int)send_len);
 
 	if (ret > 0) {
-		if (stream->write_buf_len - ret)
-			memmove(stream->write_buf, stream->write_buf + ret,
-				stream->write_buf_len - ret);
-		stream->write_buf_len -= ret;
+		write_buf_consume(stream, ret);
 
 		*last_send_time = os_gettime_ns() / 1000000;
 
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <media-io/audio-mix.h>
+
+/* 20 sources * 6 mixes * 2 channels, one 1024 frame audio tick each */
+#define FRAMES 1024
+#define BUFFERS 240
+#define ITERATIONS 2000
+
+static const struct {
+	enum audio_mix_impl impl;
+	const char *name;
+} impls[] = {
+	{AUDIO_MIX_IMPL_SCALAR, "scalar"},
+	{AUDIO_MIX_IMPL_SSE2, "SSE2"},
+	{AUDIO_MIX_IMPL_NEON, "NEON"},
+	{AUDIO_MIX_IMPL_AVX2, "AVX2"},
+};
+
+static void fill_random(float *data, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		data[i] = ((float)rand() / (float)RAND_MAX) * 0.25f - 0.125f;
+}
+
+static uint64_t run(const struct audio_mix_kernels *k, float *mix,
+		    const float *src)
+{
+	uint64_t start = os_gettime_ns();
+
+	for (int it = 0; it < ITERATIONS; it++) {
+		memset(mix, 0, FRAMES * sizeof(float));
+		for (size_t b = 0; b < BUFFERS; b++)
+			k->mix(mix, src + b * FRAMES, FRAMES);
+		k->clamp(mix, FRAMES);
+	}
+
+	return os_gettime_ns() - start;
+}
+
+int main(void)
+{
+	float *src = bmalloc(FRAMES * BUFFERS * sizeof(float));
+	float *ref = bmalloc(FRAMES * sizeof(float));
+	float *mix = bmalloc(FRAMES * sizeof(float));
+	uint64_t scalar_ns = 0;
+	int ret = 0;
+
+	srand(1);
+	fill_random(src, FRAMES * BUFFERS);
+
+	/* warm up caches before taking the reference timing */
+	run(audio_mix_get_kernels(AUDIO_MIX_IMPL_SCALAR), ref, src);
+	scalar_ns = run(audio_mix_get_kernels(AUDIO_MIX_IMPL_SCALAR), ref, src);
+
+	printf("active kernels: %s\n", audio_mix_get_active_kernels()->name);
+
+	for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+		const struct audio_mix_kernels *k =
+			audio_mix_get_kernels(impls[i].impl);
+		if (!k) {
+			printf("%-8s unsupported\n", impls[i].name);
+			continue;
+		}
+
+		uint64_t ns = run(k, mix, src);
+		bool exact = memcmp(mix, ref, FRAMES * sizeof(float)) == 0;
+
+		printf("%-8s %8.1f ns/tick  %5.2fx  %s\n", k->name,
+		       (double)ns / ITERATIONS, (double)scalar_ns / (double)ns,
+		       exact ? "exact" : "MISMATCH");
+		if (!exact)
+			ret = 1;
+	}
+
+	bfree(mix);
+	bfree(ref);
+	bfree(src);
+	return ret;
+}
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <media-io/format-conversion.h>
+
+/* throughput is reported in megabytes of packed (4 bytes per pixel) frame
+ * data processed per second */
+#define ITERATIONS 50
+
+static const struct {
+	uint32_t width;
+	uint32_t height;
+	const char *name;
+} sizes[] = {
+	{1280, 720, "720p"},
+	{1920, 1080, "1080p"},
+	{3840, 2160, "4K"},
+};
+
+static const struct {
+	enum format_conversion_impl impl;
+	const char *name;
+} impls[] = {
+	{FORMAT_CONVERSION_IMPL_GENERIC, "generic"},
+	{FORMAT_CONVERSION_IMPL_SSE2, "SSE2"},
+	{FORMAT_CONVERSION_IMPL_NEON, "NEON"},
+	{FORMAT_CONVERSION_IMPL_AVX2, "AVX2"},
+};
+
+enum func {
+	FUNC_UYVX_TO_I420,
+	FUNC_UYVX_TO_NV12,
+	FUNC_UYVX_TO_I444,
+	FUNC_DECOMPRESS_420,
+	FUNC_DECOMPRESS_NV12,
+	FUNC_DECOMPRESS_422,
+	NUM_FUNCS,
+};
+
+static const char *func_names[NUM_FUNCS] = {
+	"compress_uyvx_to_i420", "compress_uyvx_to_nv12",
+	"convert_uyvx_to_i444",  "decompress_420",
+	"decompress_nv12",       "decompress_422",
+};
+
+struct frame {
+	uint32_t width;
+	uint32_t height;
+	uint8_t *packed;
+	uint8_t *planes[3];
+};
+
+static void run(const struct format_conversion_kernels *k, enum func func,
+		struct frame *f)
+{
+	uint32_t w = f->width;
+	uint32_t h = f->height;
+	uint32_t packed_linesize = w * 4;
+	uint32_t linesize_444[3] = {w, w, w};
+	uint32_t linesize_420[3] = {w, w / 2, w / 2};
+	uint32_t linesize_nv12[3] = {w, w, 0};
+	const uint8_t *const planes[3] = {f->planes[0], f->planes[1],
+					  f->planes[2]};
+
+	switch (func) {
+	case FUNC_UYVX_TO_I420:
+		k->compress_uyvx_to_i420(f->packed, packed_linesize, 0, h,
+					 f->planes, linesize_420);
+		break;
+	case FUNC_UYVX_TO_NV12:
+		k->compress_uyvx_to_nv12(f->packed, packed_linesize, 0, h,
+					 f->planes, linesize_nv12);
+		break;
+	case FUNC_UYVX_TO_I444:
+		k->convert_uyvx_to_i444(f->packed, packed_linesize, 0, h,
+					f->planes, linesize_444);
+		break;
+	case FUNC_DECOMPRESS_420:
+		k->decompress_420(planes, linesize_420, 0, h, f->packed,
+				  packed_linesize);
+		break;
+	case FUNC_DECOMPRESS_NV12:
+		k->decompress_nv12(planes, linesize_nv12, 0, h, f->packed,
+				   packed_linesize);
+		break;
+	case FUNC_DECOMPRESS_422:
+		/* one packed 422 line is w * 2 bytes, which is what
+		 * decompress_422 expects to be given as its output width */
+		k->decompress_422(f->planes[0], w * 2, 0, h, f->packed, w * 2,
+				  true);
+		break;
+	case NUM_FUNCS:
+		break;
+	}
+}
+
+int main(void)
+{
+	printf("active kernels: %s\n",
+	       format_conversion_get_active_kernels()->name);
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		struct frame f = {sizes[s].width, sizes[s].height};
+		size_t packed_size = (size_t)f.width * f.height * 4;
+		double mb = (double)packed_size * ITERATIONS / 1000000.0;
+
+		f.packed = bzalloc(packed_size);
+		for (size_t p = 0; p < 3; p++)
+			f.planes[p] = bzalloc(packed_size);
+
+		for (size_t i = 0; i < packed_size; i++)
+			f.packed[i] = (uint8_t)rand();
+
+		printf("\n%s\n", sizes[s].name);
+
+		for (int func = 0; func < NUM_FUNCS; func++) {
+			printf("  %-22s", func_names[func]);
+
+			for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]);
+			     i++) {
+				const struct format_conversion_kernels *k =
+					format_conversion_get_kernels(
+						impls[i].impl);
+				if (!k)
+					continue;
+
+				run(k, func, &f);
+
+				uint64_t start = os_gettime_ns();
+				for (int it = 0; it < ITERATIONS; it++)
+					run(k, func, &f);
+				uint64_t ns = os_gettime_ns() - start;
+
+				printf("  %s %8.1f MB/s", k->name,
+				       mb / ((double)ns / 1000000000.0));
+			}
+
+			printf("\n");
+		}
+
+		for (size_t p = 0; p < 3; p++)
+			bfree(f.planes[p]);
+		bfree(f.packed);
+	}
+
+	return 0;
+}
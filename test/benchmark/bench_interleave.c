@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/darray.h>
+#include <util/platform.h>
+#include <obs-interleave.h>
+
+/* pushes video at 30fps and AAC audio on each track through the interleave
+ * queue, keeping half a second of packets queued the way a slow encoder
+ * would, and compares against keeping them in one sorted array */
+#define SECONDS 600
+#define VIDEO_USEC 33333
+#define AUDIO_USEC 21333
+#define DELAY_USEC 500000
+
+struct sorted_array {
+	DARRAY(struct encoder_packet) packets;
+};
+
+static void sorted_push(struct sorted_array *arr, struct encoder_packet *out)
+{
+	size_t idx;
+
+	for (idx = 0; idx < arr->packets.num; idx++) {
+		struct encoder_packet *cur = arr->packets.array + idx;
+
+		if (out->dts_usec == cur->dts_usec &&
+		    out->type == OBS_ENCODER_VIDEO)
+			break;
+		else if (out->dts_usec < cur->dts_usec)
+			break;
+	}
+
+	da_insert(arr->packets, idx, out);
+}
+
+static bool sorted_pop(struct sorted_array *arr, int64_t before)
+{
+	if (!arr->packets.num || arr->packets.array[0].dts_usec >= before)
+		return false;
+
+	da_erase(arr->packets, 0);
+	return true;
+}
+
+static bool queue_pop(struct interleave_queue *queue, int64_t before)
+{
+	struct encoder_packet *next = interleave_queue_peek(queue);
+	struct encoder_packet packet;
+
+	if (!next || next->dts_usec >= before)
+		return false;
+
+	interleave_queue_pop(queue, &packet);
+	return true;
+}
+
+/* the next packet to arrive, in the order encoders would deliver them */
+static void next_packet(struct encoder_packet *packet, int64_t *next_ts,
+			size_t tracks)
+{
+	size_t track = 0;
+
+	for (size_t i = 1; i <= tracks; i++) {
+		if (next_ts[i] < next_ts[track])
+			track = i;
+	}
+
+	memset(packet, 0, sizeof(*packet));
+	packet->dts_usec = next_ts[track];
+
+	if (track) {
+		packet->type = OBS_ENCODER_AUDIO;
+		packet->track_idx = track - 1;
+		next_ts[track] += AUDIO_USEC;
+	} else {
+		packet->type = OBS_ENCODER_VIDEO;
+		next_ts[track] += VIDEO_USEC;
+	}
+}
+
+static double run(size_t tracks, bool use_queue, size_t *count)
+{
+	struct interleave_queue queue = {0};
+	struct sorted_array arr = {0};
+	int64_t next_ts[INTERLEAVE_TRACKS] = {0};
+	struct encoder_packet packet;
+	uint64_t start;
+
+	*count = 0;
+	start = os_gettime_ns();
+
+	for (;;) {
+		int64_t before;
+
+		next_packet(&packet, next_ts, tracks);
+		if (packet.dts_usec >= SECONDS * 1000000LL)
+			break;
+
+		before = packet.dts_usec - DELAY_USEC;
+
+		if (use_queue) {
+			interleave_queue_push(&queue, &packet);
+			while (queue_pop(&queue, before))
+				;
+		} else {
+			sorted_push(&arr, &packet);
+			while (sorted_pop(&arr, before))
+				;
+		}
+
+		(*count)++;
+	}
+
+	interleave_queue_free(&queue);
+	da_free(arr.packets);
+
+	return (double)(os_gettime_ns() - start) / (double)*count;
+}
+
+int main(void)
+{
+	printf("%-14s %12s %12s %12s\n", "audio tracks", "packets",
+	       "sorted ns", "queue ns");
+
+	for (size_t tracks = 1; tracks <= MAX_AUDIO_MIXES; tracks++) {
+		size_t count;
+		double sorted_ns = run(tracks, false, &count);
+		double queue_ns = run(tracks, true, &count);
+
+		printf("%-14zu %12zu %12.1f %12.1f\n", tracks, count,
+		       sorted_ns, queue_ns);
+	}
+
+	return 0;
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <obs-data.h>
+
+/* times building, saving, loading and reading back a scene collection shaped
+ * like the ones the frontend writes: an array of sources, each with a
+ * settings object and a few filters.  Saving and loading are timed both as
+ * json and in the binary encoding */
+#define ITERATIONS 5
+
+static const struct {
+	int sources;
+	int keys;
+} sizes[] = {
+	{1000, 30},
+	{5000, 30},
+	{1000, 300},
+};
+
+static void key_name(char *buf, size_t size, int key)
+{
+	/* not in sorted order, as settings are rarely written that way */
+	snprintf(buf, size, "setting_%d", (key * 7919) % 100000);
+}
+
+static obs_data_t *make_settings(int keys)
+{
+	obs_data_t *settings = obs_data_create();
+	char name[64];
+
+	for (int i = 0; i < keys; i++) {
+		key_name(name, sizeof(name), i);
+
+		if (i % 3 == 0)
+			obs_data_set_int(settings, name, i);
+		else if (i % 3 == 1)
+			obs_data_set_double(settings, name, i * 0.5);
+		else
+			obs_data_set_string(settings, name, "value");
+	}
+
+	return settings;
+}
+
+static obs_data_t *make_collection(int num_sources, int keys)
+{
+	obs_data_t *collection = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+	char name[64];
+
+	for (int i = 0; i < num_sources; i++) {
+		obs_data_t *source = obs_data_create();
+		obs_data_t *settings = make_settings(keys);
+		obs_data_array_t *filters = obs_data_array_create();
+
+		for (int f = 0; f < 3; f++) {
+			obs_data_t *filter = obs_data_create();
+			obs_data_t *filter_settings = make_settings(keys / 3);
+
+			obs_data_set_string(filter, "id", "color_filter");
+			obs_data_set_obj(filter, "settings", filter_settings);
+			obs_data_array_push_back(filters, filter);
+
+			obs_data_release(filter_settings);
+			obs_data_release(filter);
+		}
+
+		snprintf(name, sizeof(name), "Source %d", i);
+		obs_data_set_string(source, "name", name);
+		obs_data_set_string(source, "id", "image_source");
+		obs_data_set_obj(source, "settings", settings);
+		obs_data_set_array(source, "filters", filters);
+		obs_data_array_push_back(sources, source);
+
+		obs_data_array_release(filters);
+		obs_data_release(settings);
+		obs_data_release(source);
+	}
+
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_array_release(sources);
+	return collection;
+}
+
+static long long read_collection(obs_data_t *collection, int keys)
+{
+	obs_data_array_t *sources = obs_data_get_array(collection, "sources");
+	size_t count = obs_data_array_count(sources);
+	long long sum = 0;
+	char name[64];
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *source = obs_data_array_item(sources, i);
+		obs_data_t *settings = obs_data_get_obj(source, "settings");
+
+		for (int k = 0; k < keys; k += 3) {
+			key_name(name, sizeof(name), k);
+			sum += obs_data_get_int(settings, name);
+		}
+
+		obs_data_release(settings);
+		obs_data_release(source);
+	}
+
+	obs_data_array_release(sources);
+	return sum;
+}
+
+static double ms_since(uint64_t start)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0;
+}
+
+int main(void)
+{
+	printf("%8s %6s %8s %8s %9s %9s %9s %9s %9s\n", "sources", "keys",
+	       "json MB", "bin MB", "build ms", "save ms", "load ms",
+	       "read ms", "bin save");
+	printf("%8s %6s %8s %8s %9s %9s %9s %9s %9s\n", "", "", "", "", "",
+	       "", "", "", "/load ms");
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		double build = 0.0, save = 0.0, load = 0.0, read = 0.0;
+		double bin_save = 0.0, bin_load = 0.0;
+		size_t json_size = 0, bin_size = 0;
+		long long sum = 0;
+
+		for (int it = 0; it < ITERATIONS; it++) {
+			uint64_t start = os_gettime_ns();
+			obs_data_t *collection = make_collection(
+				sizes[s].sources, sizes[s].keys);
+			build += ms_since(start);
+
+			start = os_gettime_ns();
+			char *json = bstrdup(obs_data_get_json(collection));
+			save += ms_since(start);
+			json_size = strlen(json);
+
+			start = os_gettime_ns();
+			void *bin = obs_data_get_binary(collection, &bin_size);
+			bin_save += ms_since(start);
+
+			obs_data_release(collection);
+
+			start = os_gettime_ns();
+			collection = obs_data_create_from_json(json);
+			load += ms_since(start);
+
+			start = os_gettime_ns();
+			sum += read_collection(collection, sizes[s].keys);
+			read += ms_since(start);
+
+			obs_data_release(collection);
+
+			start = os_gettime_ns();
+			collection = obs_data_create_from_binary(bin, bin_size);
+			bin_load += ms_since(start);
+
+			obs_data_release(collection);
+			bfree(json);
+			bfree(bin);
+		}
+
+		printf("%8d %6d %8.1f %8.1f %9.1f %9.1f %9.1f %9.1f %4.0f/%.0f\n",
+		       sizes[s].sources, sizes[s].keys,
+		       (double)json_size / 1000000.0,
+		       (double)bin_size / 1000000.0, build / ITERATIONS,
+		       save / ITERATIONS, load / ITERATIONS,
+		       read / ITERATIONS, bin_save / ITERATIONS,
+		       bin_load / ITERATIONS);
+
+		if (!sum)
+			printf("(no values read)\n");
+	}
+
+	return 0;
+}
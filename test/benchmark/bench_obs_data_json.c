@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <obs-data.h>
+
+#include <jansson.h>
+
+/* compares obs_data's own json reader/writer against going through a jansson
+ * tree the way obs_data used to, on a scene collection of about 10 MB */
+#define ITERATIONS 5
+#define NUM_SOURCES 3400
+#define NUM_KEYS 60
+
+static obs_data_t *make_settings(int keys, int seed)
+{
+	obs_data_t *settings = obs_data_create();
+	char name[64];
+	char value[64];
+
+	for (int i = 0; i < keys; i++) {
+		snprintf(name, sizeof(name), "setting_%d", (i * 7919) % 100000);
+
+		if (i % 4 == 0) {
+			obs_data_set_int(settings, name, (long long)i * seed);
+		} else if (i % 4 == 1) {
+			obs_data_set_double(settings, name, i / 3.0 + seed);
+		} else if (i % 4 == 2) {
+			obs_data_set_bool(settings, name, (i + seed) % 2);
+		} else {
+			snprintf(value, sizeof(value),
+				 "C:\\Users\\obs\\Videos\\\"clip\" %d.mkv", i);
+			obs_data_set_string(settings, name, value);
+		}
+	}
+
+	return settings;
+}
+
+static obs_data_t *make_collection(void)
+{
+	obs_data_t *collection = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+	char name[64];
+
+	for (int i = 0; i < NUM_SOURCES; i++) {
+		obs_data_t *source = obs_data_create();
+		obs_data_t *settings = make_settings(NUM_KEYS, i);
+		obs_data_array_t *filters = obs_data_array_create();
+
+		for (int f = 0; f < 2; f++) {
+			obs_data_t *filter = obs_data_create();
+			obs_data_t *filter_settings = make_settings(NUM_KEYS / 4, f);
+
+			obs_data_set_string(filter, "id", "color_filter");
+			obs_data_set_obj(filter, "settings", filter_settings);
+			obs_data_array_push_back(filters, filter);
+
+			obs_data_release(filter_settings);
+			obs_data_release(filter);
+		}
+
+		snprintf(name, sizeof(name), "Source %d", i);
+		obs_data_set_string(source, "name", name);
+		obs_data_set_string(source, "id", "image_source");
+		obs_data_set_obj(source, "settings", settings);
+		obs_data_set_array(source, "filters", filters);
+		obs_data_array_push_back(sources, source);
+
+		obs_data_array_release(filters);
+		obs_data_release(settings);
+		obs_data_release(source);
+	}
+
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_array_release(sources);
+	return collection;
+}
+
+/* ------------------------------------------------------------------------- */
+/* the previous path: a full jansson tree, converted item by item */
+
+static void add_json_object_data(obs_data_t *data, json_t *jobj);
+
+static void add_json_item(obs_data_t *data, const char *key, json_t *json)
+{
+	if (json_is_object(json)) {
+		obs_data_t *sub_obj = obs_data_create();
+		add_json_object_data(sub_obj, json);
+		obs_data_set_obj(data, key, sub_obj);
+		obs_data_release(sub_obj);
+
+	} else if (json_is_array(json)) {
+		obs_data_array_t *array = obs_data_array_create();
+		size_t idx;
+		json_t *jitem;
+
+		json_array_foreach (json, idx, jitem) {
+			obs_data_t *item;
+
+			if (!json_is_object(jitem))
+				continue;
+
+			item = obs_data_create();
+			add_json_object_data(item, jitem);
+			obs_data_array_push_back(array, item);
+			obs_data_release(item);
+		}
+
+		obs_data_set_array(data, key, array);
+		obs_data_array_release(array);
+
+	} else if (json_is_string(json)) {
+		obs_data_set_string(data, key, json_string_value(json));
+	} else if (json_is_integer(json)) {
+		obs_data_set_int(data, key, json_integer_value(json));
+	} else if (json_is_real(json)) {
+		obs_data_set_double(data, key, json_real_value(json));
+	} else if (json_is_boolean(json)) {
+		obs_data_set_bool(data, key, json_is_true(json));
+	}
+}
+
+static void add_json_object_data(obs_data_t *data, json_t *jobj)
+{
+	const char *key;
+	json_t *jitem;
+
+	json_object_foreach (jobj, key, jitem) {
+		add_json_item(data, key, jitem);
+	}
+}
+
+static obs_data_t *jansson_load(const char *text)
+{
+	json_error_t error;
+	json_t *root = json_loads(text, JSON_REJECT_DUPLICATES, &error);
+	obs_data_t *data;
+
+	if (!root)
+		return NULL;
+
+	data = obs_data_create();
+	add_json_object_data(data, root);
+	json_decref(root);
+	return data;
+}
+
+static json_t *to_json(obs_data_t *data)
+{
+	json_t *json = json_object();
+	obs_data_item_t *item;
+
+	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
+		const char *name = obs_data_item_get_name(item);
+		json_t *value = NULL;
+
+		if (!obs_data_item_has_user_value(item))
+			continue;
+
+		switch (obs_data_item_gettype(item)) {
+		case OBS_DATA_STRING:
+			value = json_string(obs_data_item_get_string(item));
+			break;
+		case OBS_DATA_NUMBER:
+			if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+				value = json_integer(
+					obs_data_item_get_int(item));
+			else
+				value = json_real(
+					obs_data_item_get_double(item));
+			break;
+		case OBS_DATA_BOOLEAN:
+			value = json_boolean(obs_data_item_get_bool(item));
+			break;
+		case OBS_DATA_OBJECT: {
+			obs_data_t *obj = obs_data_item_get_obj(item);
+			value = to_json(obj);
+			obs_data_release(obj);
+			break;
+		}
+		case OBS_DATA_ARRAY: {
+			obs_data_array_t *array = obs_data_item_get_array(item);
+			size_t count = obs_data_array_count(array);
+
+			value = json_array();
+			for (size_t idx = 0; idx < count; idx++) {
+				obs_data_t *sub = obs_data_array_item(array, idx);
+				json_array_append_new(value, to_json(sub));
+				obs_data_release(sub);
+			}
+
+			obs_data_array_release(array);
+			break;
+		}
+		default:
+			break;
+		}
+
+		json_object_set_new(json, name, value);
+	}
+
+	return json;
+}
+
+static char *jansson_save(obs_data_t *data)
+{
+	json_t *root = to_json(data);
+	char *text = json_dumps(root, JSON_PRESERVE_ORDER | JSON_COMPACT);
+	json_decref(root);
+	return text;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static double ms_since(uint64_t start)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0;
+}
+
+int main(void)
+{
+	obs_data_t *collection = make_collection();
+	char *expected = jansson_save(collection);
+	double save[2] = {0.0}, load[2] = {0.0};
+	bool match = true;
+
+	printf("collection: %.1f MB\n", (double)strlen(expected) / 1000000.0);
+
+	for (int it = 0; it < ITERATIONS; it++) {
+		uint64_t start = os_gettime_ns();
+		char *text = jansson_save(collection);
+		save[0] += ms_since(start);
+		free(text);
+
+		start = os_gettime_ns();
+		const char *json = obs_data_get_json(collection);
+		save[1] += ms_since(start);
+		match = match && strcmp(json, expected) == 0;
+
+		start = os_gettime_ns();
+		obs_data_t *loaded = jansson_load(expected);
+		load[0] += ms_since(start);
+		obs_data_release(loaded);
+
+		start = os_gettime_ns();
+		loaded = obs_data_create_from_json(expected);
+		load[1] += ms_since(start);
+		match = match && loaded &&
+			strcmp(obs_data_get_json(loaded), expected) == 0;
+		obs_data_release(loaded);
+	}
+
+	printf("%10s %12s %12s %8s\n", "", "jansson ms", "direct ms", "speedup");
+	printf("%10s %12.1f %12.1f %7.2fx\n", "save", save[0] / ITERATIONS,
+	       save[1] / ITERATIONS, save[0] / save[1]);
+	printf("%10s %12.1f %12.1f %7.2fx\n", "load", load[0] / ITERATIONS,
+	       load[1] / ITERATIONS, load[0] / load[1]);
+
+	if (!match)
+		printf("output differs from jansson\n");
+
+	free(expected);
+	obs_data_release(collection);
+	return match ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+
+#include <util/platform.h>
+#include <util/profiler.h>
+
+/* profiles a tick the way the graphics thread does, with a root and a few
+ * nested scopes, with the profiler alone and with tracing as well.  ticks run
+ * in batches that fit in a thread's trace ring, with a pause between them for
+ * the trace thread to drain it, so the timing doesn't include dropped events.
+ * the fastest batch is reported, to leave out the rest of the system */
+#define BATCHES 50
+#define BATCH_TICKS 256
+#define DRAIN_WAIT_MS 120
+
+static const char *root_name = "tick";
+static const char *child_names[] = {"tick_sources", "output_frame",
+				    "render_displays"};
+
+static double run(void)
+{
+	uint64_t fastest = UINT64_MAX;
+
+	for (int batch = 0; batch < BATCHES; batch++) {
+		uint64_t start = os_gettime_ns();
+
+		for (int i = 0; i < BATCH_TICKS; i++) {
+			profile_start(root_name);
+			for (size_t j = 0; j < 3; j++) {
+				profile_start(child_names[j]);
+				profile_end(child_names[j]);
+			}
+			profile_end(root_name);
+			profile_reenable_thread();
+		}
+
+		uint64_t time = os_gettime_ns() - start;
+		if (time < fastest)
+			fastest = time;
+		os_sleep_ms(DRAIN_WAIT_MS);
+	}
+
+	return (double)fastest / (BATCH_TICKS * 4);
+}
+
+int main(void)
+{
+	double ns[2];
+
+	profiler_start();
+	profile_register_root(root_name, 0);
+
+	ns[0] = run();
+	profiler_trace_start(30000000000ULL);
+	ns[1] = run();
+	profiler_trace_stop();
+
+	printf("%16s %12s\n", "", "ns/scope");
+	printf("%16s %12.1f\n", "profiler", ns[0]);
+	printf("%16s %12.1f\n", "with tracing", ns[1]);
+
+	profiler_stop();
+	profiler_free();
+	return 0;
+}
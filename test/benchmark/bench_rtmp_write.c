@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <obs.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "librtmp/rtmp.h"
+#include "flv-mux.h"
+
+/* sends the same packets to a local socket the old way (muxed into an FLV
+ * tag, then copied into an RTMP packet) and straight from the encoder data,
+ * while a thread on the other end reads and throws everything away */
+#define VIDEO_SIZE (100 * 1024)
+#define AUDIO_SIZE 512
+#define PACKETS 4000
+
+struct sink {
+	int fd;
+	uint64_t bytes;
+};
+
+static void *sink_thread(void *data)
+{
+	struct sink *sink = data;
+	char buf[65536];
+	ssize_t ret;
+
+	while ((ret = recv(sink->fd, buf, sizeof(buf), 0)) > 0)
+		sink->bytes += (uint64_t)ret;
+	return NULL;
+}
+
+static bool connect_sink(int *client, struct sink *sink, pthread_t *thread)
+{
+	struct sockaddr_in addr = {0};
+	socklen_t len = sizeof(addr);
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (listener == -1 ||
+	    bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    listen(listener, 1) != 0 ||
+	    getsockname(listener, (struct sockaddr *)&addr, &len) != 0)
+		return false;
+
+	*client = socket(AF_INET, SOCK_STREAM, 0);
+	if (connect(*client, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+		return false;
+
+	sink->fd = accept(listener, NULL, NULL);
+	sink->bytes = 0;
+	close(listener);
+
+	return sink->fd != -1 &&
+	       pthread_create(thread, NULL, sink_thread, sink) == 0;
+}
+
+static void make_packet(struct encoder_packet *packet, uint8_t *data, int i)
+{
+	memset(packet, 0, sizeof(*packet));
+	packet->timebase_den = 1000;
+	packet->dts = 1000 + i * 16;
+	packet->pts = packet->dts;
+	packet->data = data;
+
+	if (i & 1) {
+		packet->type = OBS_ENCODER_AUDIO;
+		packet->size = AUDIO_SIZE;
+	} else {
+		packet->type = OBS_ENCODER_VIDEO;
+		packet->size = VIDEO_SIZE;
+		packet->keyframe = i % 120 == 0;
+	}
+}
+
+static int write_muxed(RTMP *rtmp, struct encoder_packet *packet)
+{
+	uint8_t *data;
+	size_t size;
+	int ret;
+
+	flv_packet_mux(packet, 0, &data, &size, false);
+	ret = RTMP_Write(rtmp, (char *)data, (int)size, 0);
+	bfree(data);
+	return ret;
+}
+
+static int write_slices(RTMP *rtmp, struct encoder_packet *packet)
+{
+	struct flv_tag tag;
+	RTMPSlice body[2];
+
+	if (!flv_packet_tag(packet, 0, &tag, false))
+		return 0;
+
+	body[0].data = (const char *)tag.prefix;
+	body[0].size = (int)tag.prefix_size;
+	body[1].data = (const char *)packet->data;
+	body[1].size = (int)packet->size;
+	return RTMP_WriteV(rtmp, tag.type, tag.timestamp, body, 2, 0);
+}
+
+static bool run(const char *name, uint8_t *data,
+		int (*write)(RTMP *, struct encoder_packet *))
+{
+	struct encoder_packet packet;
+	struct sink sink;
+	pthread_t thread;
+	uint64_t start, elapsed;
+	int client;
+	RTMP rtmp;
+
+	if (!connect_sink(&client, &sink, &thread)) {
+		printf("could not connect to the sink\n");
+		return false;
+	}
+
+	RTMP_Init(&rtmp);
+	rtmp.m_sb.sb_socket = client;
+	rtmp.m_outChunkSize = 4096;
+	rtmp.Link.streams[0].id = 1;
+
+	start = os_gettime_ns();
+
+	for (int i = 0; i < PACKETS; i++) {
+		make_packet(&packet, data, i);
+		if (write(&rtmp, &packet) < 0) {
+			printf("%s: send failed\n", name);
+			break;
+		}
+	}
+
+	elapsed = os_gettime_ns() - start;
+
+	RTMP_Close(&rtmp);
+	pthread_join(thread, NULL);
+	close(sink.fd);
+
+	printf("%-10s %12.1f %12.1f %12.1f\n", name,
+	       (double)elapsed / PACKETS,
+	       (double)sink.bytes * 1000.0 / (double)elapsed,
+	       (double)sink.bytes / 1000000.0);
+	return true;
+}
+
+int main(void)
+{
+	uint8_t *data = bmalloc(VIDEO_SIZE);
+
+	for (int i = 0; i < VIDEO_SIZE; i++)
+		data[i] = (uint8_t)rand();
+
+	printf("%-10s %12s %12s %12s\n", "path", "ns/packet", "MB/s", "MB sent");
+	if (!run("muxed", data, write_muxed) ||
+	    !run("slices", data, write_slices)) {
+		bfree(data);
+		return 1;
+	}
+
+	bfree(data);
+	return 0;
+}
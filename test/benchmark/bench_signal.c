@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <util/threading.h>
+#include <util/platform.h>
+#include <callback/signal.h>
+
+/* emits one signal from several threads at once, the way sources signal from
+ * the graphics, audio and ui threads, with and without another thread
+ * connecting and disconnecting callbacks at the same time */
+#define EMIT_THREADS 8
+#define CALLBACKS 4
+#define DURATION_MS 1000
+
+struct bench {
+	signal_handler_t *handler;
+	volatile bool stop;
+	volatile long emits;
+};
+
+static void bench_cb(void *data, calldata_t *params)
+{
+	calldata_ptr(params, "source");
+	UNUSED_PARAMETER(data);
+}
+
+static void *emit_thread(void *param)
+{
+	struct bench *bench = param;
+	calldata_t params = {0};
+	long emits = 0;
+
+	calldata_set_ptr(&params, "source", bench);
+
+	while (!os_atomic_load_bool(&bench->stop)) {
+		signal_handler_signal(bench->handler, "update", &params);
+		emits++;
+	}
+
+	calldata_free(&params);
+	os_atomic_add_long(&bench->emits, emits);
+	return NULL;
+}
+
+static double run(signal_handler_t *handler, bool churn, long *churns)
+{
+	struct bench bench = {handler, false, 0};
+	pthread_t threads[EMIT_THREADS];
+	uint64_t start = os_gettime_ns();
+	uint64_t end = start + DURATION_MS * 1000000ULL;
+	int extra;
+
+	*churns = 0;
+
+	for (size_t i = 0; i < EMIT_THREADS; i++)
+		pthread_create(&threads[i], NULL, emit_thread, &bench);
+
+	while (os_gettime_ns() < end) {
+		if (!churn) {
+			os_sleep_ms(10);
+			continue;
+		}
+
+		signal_handler_connect(handler, "update", bench_cb, &extra);
+		signal_handler_disconnect(handler, "update", bench_cb, &extra);
+		(*churns)++;
+		os_sleep_ms(1);
+	}
+
+	os_atomic_set_bool(&bench.stop, true);
+	for (size_t i = 0; i < EMIT_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	return (double)bench.emits * 1000000000.0 /
+	       (double)(os_gettime_ns() - start);
+}
+
+int main(void)
+{
+	signal_handler_t *handler = signal_handler_create();
+	int data[CALLBACKS];
+	double rate[2];
+	long churns[2];
+
+	signal_handler_add(handler, "void update(ptr source)");
+	for (size_t i = 0; i < CALLBACKS; i++)
+		signal_handler_connect(handler, "update", bench_cb, &data[i]);
+
+	rate[0] = run(handler, false, &churns[0]);
+	rate[1] = run(handler, true, &churns[1]);
+
+	printf("%d emitting threads, %d callbacks\n", EMIT_THREADS, CALLBACKS);
+	printf("%24s %14s\n", "", "emits/sec");
+	printf("%24s %14.0f\n", "emit only", rate[0]);
+	printf("%24s %14.0f (%ld connect/disconnect)\n", "emit while connecting",
+	       rate[1], churns[1]);
+
+	signal_handler_destroy(handler);
+	return 0;
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+
+#include <util/platform.h>
+#include <callback/signal.h>
+
+/* emits the last of a source's signals with the parameters a volume change
+ * sends, looking the signal and parameters up by name and by atom */
+#define EMITS 2000000
+
+static const char *signals[] = {
+	"void destroy(ptr source)",
+	"void remove(ptr source)",
+	"void save(ptr source)",
+	"void load(ptr source)",
+	"void activate(ptr source)",
+	"void deactivate(ptr source)",
+	"void show(ptr source)",
+	"void hide(ptr source)",
+	"void mute(ptr source, bool muted)",
+	"void push_to_mute_changed(ptr source, bool enabled)",
+	"void push_to_mute_delay(ptr source, int delay)",
+	"void push_to_talk_changed(ptr source, bool enabled)",
+	"void push_to_talk_delay(ptr source, int delay)",
+	"void enable(ptr source, bool enabled)",
+	"void rename(ptr source, string new_name, string prev_name)",
+	"void update_properties(ptr source)",
+	"void update_flags(ptr source, int flags)",
+	"void audio_sync(ptr source, int out int offset)",
+	"void audio_mixers(ptr source, in out int mixers)",
+	"void audio_activate(ptr source)",
+	"void audio_deactivate(ptr source)",
+	"void filter_add(ptr source, ptr filter)",
+	"void filter_remove(ptr source, ptr filter)",
+	"void reorder_filters(ptr source)",
+	"void transition_start(ptr source)",
+	"void transition_video_stop(ptr source)",
+	"void transition_stop(ptr source)",
+	"void media_play(ptr source)",
+	"void media_pause(ptr source)",
+	"void media_restart(ptr source)",
+	"void media_stopped(ptr source)",
+	"void media_next(ptr source)",
+	"void media_previous(ptr source)",
+	"void media_started(ptr source)",
+	"void media_ended(ptr source)",
+	"void volume(ptr source, in out float volume)",
+	NULL,
+};
+
+static callback_atom_t source_atom;
+static callback_atom_t volume_atom;
+static double total = 0.0;
+
+static void volume_by_name(void *data, calldata_t *params)
+{
+	if (calldata_ptr(params, "source") == data)
+		total += calldata_float(params, "volume");
+}
+
+static void volume_by_id(void *data, calldata_t *params)
+{
+	void *source = NULL;
+	double volume = 0.0;
+
+	calldata_get_ptr_id(params, source_atom, &source);
+	calldata_get_float_id(params, volume_atom, &volume);
+	if (source == data)
+		total += volume;
+}
+
+static double emit_by_name(signal_handler_t *handler, void *source)
+{
+	uint8_t stack[128];
+	calldata_t params;
+	uint64_t start = os_gettime_ns();
+
+	for (int i = 0; i < EMITS; i++) {
+		calldata_init_fixed(&params, stack, sizeof(stack));
+		calldata_set_ptr(&params, "source", source);
+		calldata_set_float(&params, "volume", 0.5);
+		signal_handler_signal(handler, "volume", &params);
+	}
+
+	return (double)(os_gettime_ns() - start) / EMITS;
+}
+
+static double emit_by_id(signal_handler_t *handler, void *source)
+{
+	callback_atom_t volume_signal = callback_atom_get("volume");
+	uint8_t stack[128];
+	calldata_t params;
+	uint64_t start = os_gettime_ns();
+
+	for (int i = 0; i < EMITS; i++) {
+		calldata_init_fixed(&params, stack, sizeof(stack));
+		calldata_set_ptr_id(&params, source_atom, source);
+		calldata_set_float_id(&params, volume_atom, 0.5);
+		signal_handler_signal_id(handler, volume_signal, &params);
+	}
+
+	return (double)(os_gettime_ns() - start) / EMITS;
+}
+
+int main(void)
+{
+	signal_handler_t *handler = signal_handler_create();
+	double ns[2];
+	int source;
+
+	source_atom = callback_atom_get("source");
+	volume_atom = callback_atom_get("volume");
+	signal_handler_add_array(handler, signals);
+
+	signal_handler_connect(handler, "volume", volume_by_name, &source);
+	ns[0] = emit_by_name(handler, &source);
+	signal_handler_disconnect(handler, "volume", volume_by_name, &source);
+
+	signal_handler_connect(handler, "volume", volume_by_id, &source);
+	ns[1] = emit_by_id(handler, &source);
+	signal_handler_disconnect(handler, "volume", volume_by_id, &source);
+
+	printf("%zu signals\n", sizeof(signals) / sizeof(signals[0]) - 1);
+	printf("%12s %12s\n", "", "ns/emit");
+	printf("%12s %12.1f\n", "by name", ns[0]);
+	printf("%12s %12.1f\n", "by atom", ns[1]);
+
+	signal_handler_destroy(handler);
+	return total == EMITS ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/text-lookup.h>
+#include <obs-data.h>
+
+/* counts the blocks a locale lookup keeps allocated, and times the places
+ * that build lots of short strings: scene item hotkey names and parsing
+ * source settings */
+#define LOCALE_KEYS 2000
+#define NAMES 1000000
+#define PARSES 20000
+
+static const char *settings_json =
+	"{\"file\": \"C:\\\\Users\\\\obs\\\\Videos\\\\clip.mkv\", "
+	"\"looping\": true, \"restart_on_activate\": false, "
+	"\"speed_percent\": 100, \"color_range\": 0, "
+	"\"close_when_inactive\": true, \"hw_decode\": false, "
+	"\"input_format\": \"\", \"buffering_mb\": 2, "
+	"\"clear_on_media_end\": true, \"reconnect_delay_sec\": 10}";
+
+static bool write_locale(const char *path)
+{
+	FILE *f = os_fopen(path, "wb");
+	if (!f)
+		return false;
+
+	for (int i = 0; i < LOCALE_KEYS; i++)
+		fprintf(f, "Basic.Settings.Section%d.Item%d=\"Item %d\"\n",
+			i / 20, i, i);
+
+	fclose(f);
+	return true;
+}
+
+static long locale_allocs(const char *path, double *ms)
+{
+	long allocs = bnum_allocs();
+	uint64_t start = os_gettime_ns();
+	lookup_t *lookup = text_lookup_create(path);
+	long held;
+
+	*ms = (double)(os_gettime_ns() - start) / 1000000.0;
+	held = bnum_allocs() - allocs;
+	text_lookup_destroy(lookup);
+	return held;
+}
+
+static double make_names(bool inline_buf, long *allocs)
+{
+	char buf[128];
+	struct dstr name;
+	size_t total = 0;
+	uint64_t start;
+
+	*allocs = 0;
+	start = os_gettime_ns();
+
+	for (int i = 0; i < NAMES; i++) {
+		long before = bnum_allocs();
+
+		if (inline_buf)
+			dstr_init_inline(&name, buf, sizeof(buf));
+		else
+			dstr_init(&name);
+
+		dstr_copy(&name, "libobs.show_scene_item.%1");
+		dstr_replace(&name, "%1", "Video Capture Device");
+		total += name.len;
+
+		*allocs += bnum_allocs() - before;
+		dstr_free(&name);
+	}
+
+	return total ? (double)(os_gettime_ns() - start) / NAMES : 0.0;
+}
+
+static double parse_settings(void)
+{
+	uint64_t start = os_gettime_ns();
+
+	for (int i = 0; i < PARSES; i++)
+		obs_data_release(obs_data_create_from_json(settings_json));
+
+	return (double)(os_gettime_ns() - start) / PARSES;
+}
+
+int main(void)
+{
+	const char *path = "bench_small_strings.ini";
+	long heap_allocs, inline_allocs, locale;
+	double heap_ns, inline_ns, locale_ms;
+
+	if (!write_locale(path)) {
+		printf("could not write %s\n", path);
+		return 1;
+	}
+
+	locale = locale_allocs(path, &locale_ms);
+	os_unlink(path);
+
+	heap_ns = make_names(false, &heap_allocs);
+	inline_ns = make_names(true, &inline_allocs);
+
+	printf("locale of %d keys: %ld blocks held, loaded in %.2f ms\n",
+	       LOCALE_KEYS, locale, locale_ms);
+	printf("%-16s %12s %12s\n", "hotkey names", "ns/name", "allocs/name");
+	printf("%-16s %12.1f %12.2f\n", "heap", heap_ns,
+	       (double)heap_allocs / NAMES);
+	printf("%-16s %12.1f %12.2f\n", "inline", inline_ns,
+	       (double)inline_allocs / NAMES);
+	printf("settings json: %.1f ns/parse\n", parse_settings());
+
+	return 0;
+}
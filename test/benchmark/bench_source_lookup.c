@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/platform.h>
+#include <obs.h>
+
+/* looks sources up by name with 5000 of them created, the way scripts and the
+ * frontend api do, and compares against walking the source list */
+#define NUM_SOURCES 5000
+#define LOOKUPS 200000
+
+static const char *bench_get_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "bench source";
+}
+
+static void *bench_create(obs_data_t *settings, obs_source_t *source)
+{
+	UNUSED_PARAMETER(settings);
+	return source;
+}
+
+static void bench_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static struct obs_source_info bench_source = {
+	.id = "bench_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.get_name = bench_get_name,
+	.create = bench_create,
+	.destroy = bench_destroy,
+};
+
+struct scan_data {
+	const char *name;
+	obs_source_t *found;
+};
+
+static bool scan_source(void *param, obs_source_t *source)
+{
+	struct scan_data *scan = param;
+
+	if (strcmp(obs_source_get_name(source), scan->name) == 0) {
+		scan->found = obs_source_get_ref(source);
+		return false;
+	}
+	return true;
+}
+
+static obs_source_t *scan_by_name(const char *name)
+{
+	struct scan_data scan = {name, NULL};
+	obs_enum_sources(scan_source, &scan);
+	return scan.found;
+}
+
+static double run(obs_source_t *(*lookup)(const char *), int lookups,
+		  bool misses, int *found)
+{
+	char name[64];
+	uint64_t start;
+
+	*found = 0;
+	srand(1);
+	start = os_gettime_ns();
+
+	for (int i = 0; i < lookups; i++) {
+		snprintf(name, sizeof(name), misses ? "missing %d" : "source %d",
+			 rand() % NUM_SOURCES);
+
+		obs_source_t *source = lookup(name);
+		if (source) {
+			(*found)++;
+			obs_source_release(source);
+		}
+	}
+
+	return (double)(os_gettime_ns() - start) / lookups;
+}
+
+int main(void)
+{
+	obs_source_t **sources;
+	char name[64];
+	int found[4];
+	double ns[4];
+	int ret = 0;
+
+	if (!obs_startup("en-US", NULL, NULL)) {
+		printf("obs_startup failed\n");
+		return 1;
+	}
+
+	obs_register_source(&bench_source);
+
+	sources = malloc(NUM_SOURCES * sizeof(obs_source_t *));
+	for (int i = 0; i < NUM_SOURCES; i++) {
+		snprintf(name, sizeof(name), "source %d", i);
+		sources[i] = obs_source_create("bench_source", name, NULL, NULL);
+	}
+
+	/* the list walk is far slower, so it does fewer lookups */
+	ns[0] = run(obs_get_source_by_name, LOOKUPS, false, &found[0]);
+	ns[1] = run(scan_by_name, LOOKUPS / 100, false, &found[1]);
+	ns[2] = run(obs_get_source_by_name, LOOKUPS, true, &found[2]);
+	ns[3] = run(scan_by_name, LOOKUPS / 100, true, &found[3]);
+
+	printf("%d sources\n", NUM_SOURCES);
+	printf("%8s %12s %12s %8s\n", "", "index ns", "list ns", "speedup");
+	printf("%8s %12.1f %12.1f %7.0fx\n", "hit", ns[0], ns[1], ns[1] / ns[0]);
+	printf("%8s %12.1f %12.1f %7.0fx\n", "miss", ns[2], ns[3],
+	       ns[3] / ns[2]);
+
+	if (found[0] != LOOKUPS || found[1] != LOOKUPS / 100 || found[2] ||
+	    found[3]) {
+		printf("lookups returned the wrong sources\n");
+		ret = 1;
+	}
+
+	/* renamed sources are found by their new name only */
+	obs_source_set_name(sources[0], "renamed");
+	obs_source_t *old = obs_get_source_by_name("source 0");
+	obs_source_t *renamed = obs_get_source_by_name("renamed");
+	if (old || renamed != sources[0]) {
+		printf("rename was not indexed\n");
+		ret = 1;
+	}
+	obs_source_release(old);
+	obs_source_release(renamed);
+
+	for (int i = 0; i < NUM_SOURCES; i++)
+		obs_source_release(sources[i]);
+	free(sources);
+
+	obs_shutdown();
+	return ret;
+}
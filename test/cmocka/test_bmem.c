@@ -0,0 +1,226 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/threading.h>
+#include <util/base.h>
+
+static bool find_arena(const char *name, struct bmem_arena_stats *stats)
+{
+	size_t idx = 0;
+
+	while (bmem_enum_arenas(idx++, stats)) {
+		if (strcmp(stats->name, name) == 0)
+			return true;
+	}
+	return false;
+}
+
+static void arena_stats_test(void **state)
+{
+	struct bmem_arena *arena = bmem_arena_get("test-stats");
+	struct bmem_arena_stats stats;
+	void *small, *large;
+
+	UNUSED_PARAMETER(state);
+
+	assert_ptr_equal(bmem_arena_get("test-stats"), arena);
+
+	small = bmalloc_arena(arena, 100);
+	large = bmalloc_arena(arena, 100000);
+
+	assert_true(find_arena("test-stats", &stats));
+	assert_int_equal(stats.live_bytes, 100100);
+	assert_int_equal(stats.peak_bytes, 100100);
+	assert_int_equal(stats.live_allocs, 2);
+
+	bfree(large);
+
+	assert_true(find_arena("test-stats", &stats));
+	assert_int_equal(stats.live_bytes, 100);
+	assert_int_equal(stats.peak_bytes, 100100);
+	assert_int_equal(stats.live_allocs, 1);
+
+	bfree(small);
+
+	assert_true(find_arena("test-stats", &stats));
+	assert_int_equal(stats.live_bytes, 0);
+	assert_int_equal(stats.live_allocs, 0);
+}
+
+static void realloc_keeps_arena_test(void **state)
+{
+	struct bmem_arena *arena = bmem_arena_get("test-realloc");
+	struct bmem_arena_stats stats;
+	uint8_t *ptr;
+
+	UNUSED_PARAMETER(state);
+
+	/* grows within a size class, out of the pools, then shrinks back
+	 * into a heap block */
+	ptr = bmalloc_arena(arena, 16);
+	for (size_t i = 0; i < 16; i++)
+		ptr[i] = (uint8_t)i;
+
+	ptr = brealloc(ptr, 24);
+	ptr = brealloc(ptr, 5000);
+	for (size_t i = 0; i < 16; i++)
+		assert_int_equal(ptr[i], i);
+
+	assert_true(find_arena("test-realloc", &stats));
+	assert_int_equal(stats.live_bytes, 5000);
+	assert_int_equal(stats.live_allocs, 1);
+
+	ptr = brealloc(ptr, 8);
+	for (size_t i = 0; i < 8; i++)
+		assert_int_equal(ptr[i], i);
+
+	bfree(ptr);
+
+	assert_true(find_arena("test-realloc", &stats));
+	assert_int_equal(stats.live_bytes, 0);
+
+	/* both blocks were live while moving out of the pool */
+	assert_int_equal(stats.peak_bytes, 5000 + 24);
+}
+
+static void builtin_arena_test(void **state)
+{
+	struct bmem_arena *arena = bmem_arena_get_builtin(BMEM_ARENA_SIGNALS);
+	struct bmem_arena_stats stats;
+	void *ptr;
+
+	UNUSED_PARAMETER(state);
+
+	/* built-in arenas exist before anything is allocated from them, and
+	 * are the same arenas that are found by name */
+	assert_true(find_arena("audio", &stats));
+	assert_ptr_equal(bmem_arena_get("signals"), arena);
+	assert_ptr_equal(bmem_arena_get_builtin(BMEM_ARENA_GENERAL),
+			 bmem_arena_get(NULL));
+
+	ptr = bmalloc_arena(arena, 64);
+	assert_true(find_arena("signals", &stats));
+	assert_int_equal(stats.live_allocs, 1);
+	bfree(ptr);
+}
+
+static void alignment_test(void **state)
+{
+	size_t sizes[] = {0, 1, 31, 32, 33, 200, 991, 992, 993, 4096};
+	void *ptrs[sizeof(sizes) / sizeof(sizes[0])];
+
+	UNUSED_PARAMETER(state);
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		ptrs[i] = bmalloc(sizes[i]);
+		memset(ptrs[i], 0xAA, sizes[i]);
+		assert_int_equal((uintptr_t)ptrs[i] % base_get_alignment(),
+				 0);
+	}
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		bfree(ptrs[i]);
+}
+
+#define THREAD_BLOCKS 1000
+
+/* blocks allocated on one thread and freed on another end up in the freeing
+ * thread's cache */
+static void *alloc_thread(void *data)
+{
+	void **blocks = data;
+
+	for (size_t i = 0; i < THREAD_BLOCKS; i++) {
+		blocks[i] = bmalloc(i % 900);
+		memset(blocks[i], (int)i, i % 900);
+	}
+	return NULL;
+}
+
+static void cross_thread_free_test(void **state)
+{
+	void *blocks[THREAD_BLOCKS];
+	long start_allocs = bnum_allocs();
+	pthread_t thread;
+
+	UNUSED_PARAMETER(state);
+
+	for (int round = 0; round < 4; round++) {
+		assert_int_equal(
+			pthread_create(&thread, NULL, alloc_thread, blocks), 0);
+		pthread_join(thread, NULL);
+
+		for (size_t i = 0; i < THREAD_BLOCKS; i++)
+			bfree(blocks[i]);
+	}
+
+	assert_int_equal(bnum_allocs(), start_allocs);
+}
+
+static struct captured_log {
+	char text[4096];
+	size_t len;
+} tracking_log;
+
+static void capture_log(int level, const char *format, va_list args,
+			void *param)
+{
+	struct captured_log *log = param;
+	int len;
+
+	UNUSED_PARAMETER(level);
+
+	len = vsnprintf(log->text + log->len, sizeof(log->text) - log->len,
+			format, args);
+	if (len > 0 && log->len + len < sizeof(log->text))
+		log->len += len;
+}
+
+static void tracking_test(void **state)
+{
+	void *leaked, *resized, *freed;
+
+	UNUSED_PARAMETER(state);
+
+	bmem_set_tracking(true);
+	assert_true(bmem_tracking_enabled());
+
+	leaked = bmalloc(100);
+	freed = bmalloc(1000);
+	resized = bmalloc(10);
+	resized = brealloc(resized, 5000);
+	bfree(freed);
+
+	base_set_log_handler(capture_log, &tracking_log);
+	bmem_log_tracked(LOG_INFO, 10);
+	base_set_log_handler(NULL, NULL);
+
+	assert_non_null(strstr(tracking_log.text,
+			       "Tracked allocations: 2 blocks, 5100 bytes"));
+	assert_non_null(strstr(tracking_log.text, "test_bmem"));
+
+	bmem_set_tracking(false);
+	assert_false(bmem_tracking_enabled());
+
+	bfree(leaked);
+	bfree(resized);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(arena_stats_test),
+		cmocka_unit_test(realloc_keeps_arena_test),
+		cmocka_unit_test(builtin_arena_test),
+		cmocka_unit_test(alignment_test),
+		cmocka_unit_test(cross_thread_free_test),
+		cmocka_unit_test(tracking_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
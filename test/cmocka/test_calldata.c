@@ -0,0 +1,205 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <util/threading.h>
+#include <util/base.h>
+#include <util/bmem.h>
+#include <callback/calldata.h>
+
+static void atom_test(void **state)
+{
+	callback_atom_t first, second;
+
+	UNUSED_PARAMETER(state);
+
+	assert_int_equal(callback_atom_find("test_atom_first"), 0);
+
+	first = callback_atom_get("test_atom_first");
+	second = callback_atom_get("test_atom_second");
+	assert_int_not_equal(first, 0);
+	assert_int_not_equal(second, 0);
+	assert_int_not_equal(first, second);
+
+	/* the same name always gives the same atom */
+	assert_int_equal(callback_atom_get("test_atom_first"), first);
+	assert_int_equal(callback_atom_find("test_atom_first"), first);
+	assert_string_equal(callback_atom_name(first), "test_atom_first");
+	assert_string_equal(callback_atom_name(second), "test_atom_second");
+
+	assert_int_equal(callback_atom_get(""), 0);
+	assert_int_equal(callback_atom_get(NULL), 0);
+	assert_null(callback_atom_name(0));
+	assert_null(callback_atom_name(0xFFFFFFFF));
+}
+
+static void many_atoms_test(void **state)
+{
+	callback_atom_t atoms[2000];
+	char name[64];
+
+	UNUSED_PARAMETER(state);
+
+	/* enough to fill several blocks and share hash chains */
+	for (int i = 0; i < 2000; i++) {
+		snprintf(name, sizeof(name), "test_many_%d", i);
+		atoms[i] = callback_atom_get(name);
+	}
+
+	for (int i = 0; i < 2000; i++) {
+		snprintf(name, sizeof(name), "test_many_%d", i);
+		assert_int_equal(callback_atom_find(name), atoms[i]);
+		assert_string_equal(callback_atom_name(atoms[i]), name);
+	}
+}
+
+#define ATOM_THREADS 4
+
+static void *atom_thread(void *param)
+{
+	callback_atom_t *atoms = param;
+	char name[64];
+
+	for (int i = 0; i < 500; i++) {
+		snprintf(name, sizeof(name), "test_thread_%d", i);
+		atoms[i] = callback_atom_get(name);
+	}
+	return NULL;
+}
+
+static void atom_threads_test(void **state)
+{
+	static callback_atom_t atoms[ATOM_THREADS][500];
+	pthread_t threads[ATOM_THREADS];
+
+	UNUSED_PARAMETER(state);
+
+	/* threads adding the same names at once all get the same atoms */
+	for (size_t i = 0; i < ATOM_THREADS; i++)
+		assert_int_equal(pthread_create(&threads[i], NULL, atom_thread,
+						atoms[i]),
+				 0);
+	for (size_t i = 0; i < ATOM_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	for (size_t i = 1; i < ATOM_THREADS; i++)
+		assert_memory_equal(atoms[i], atoms[0], sizeof(atoms[0]));
+}
+
+static void calldata_test(void **state)
+{
+	callback_atom_t source = callback_atom_get("source");
+	calldata_t cd = {0};
+	long long val = 0;
+	const char *str = NULL;
+
+	UNUSED_PARAMETER(state);
+
+	calldata_set_int(&cd, "volume", 10);
+	calldata_set_ptr_id(&cd, source, &cd);
+	calldata_set_string(&cd, "name", "short");
+
+	/* names and atoms find the same parameters */
+	assert_true(calldata_get_int_id(&cd, callback_atom_find("volume"),
+					&val));
+	assert_int_equal(val, 10);
+	assert_ptr_equal(calldata_ptr(&cd, "source"), &cd);
+	assert_true(calldata_get_string_id(&cd, callback_atom_find("name"),
+					   &str));
+	assert_string_equal(str, "short");
+
+	/* growing and shrinking a parameter keeps the others intact */
+	calldata_set_string(&cd, "name", "a much longer name than before");
+	assert_string_equal(calldata_string(&cd, "name"),
+			    "a much longer name than before");
+	assert_int_equal(calldata_int(&cd, "volume"), 10);
+	calldata_set_string(&cd, "name", NULL);
+	assert_null(calldata_string(&cd, "name"));
+	assert_int_equal(calldata_int(&cd, "volume"), 10);
+	assert_ptr_equal(calldata_ptr(&cd, "source"), &cd);
+
+	/* wrong sizes and unknown names are not found */
+	assert_false(calldata_get_bool(&cd, "volume", &(bool){false}));
+	assert_false(calldata_get_int(&cd, "never_set_anywhere", &val));
+	assert_false(calldata_get_int_id(&cd, 0, &val));
+
+	calldata_free(&cd);
+}
+
+static void calldata_fixed_test(void **state)
+{
+	uint8_t stack[128];
+	calldata_t cd;
+
+	UNUSED_PARAMETER(state);
+
+	calldata_init_fixed(&cd, stack, sizeof(stack));
+	calldata_set_ptr(&cd, "source", stack);
+	calldata_set_bool(&cd, "muted", true);
+	calldata_set_float(&cd, "volume", 0.5);
+
+	assert_ptr_equal(calldata_ptr(&cd, "source"), stack);
+	assert_true(calldata_bool(&cd, "muted"));
+	assert_true(calldata_float(&cd, "volume") == 0.5);
+
+	/* going past the end of a fixed stack is refused */
+	calldata_set_string(&cd, "name",
+			    "a string too long for the rest of the stack");
+	assert_null(calldata_string(&cd, "name"));
+	assert_true(calldata_float(&cd, "volume") == 0.5);
+}
+
+static void calldata_inline_test(void **state)
+{
+	const char *long_name = "a name long enough that it no longer fits in "
+				"the buffer the calldata started with";
+	long allocs = bnum_allocs();
+	uint8_t stack[64];
+	calldata_t cd;
+
+	UNUSED_PARAMETER(state);
+
+	/* stays in the buffer while the parameters fit */
+	calldata_init_inline(&cd, stack, sizeof(stack));
+	calldata_set_ptr(&cd, "source", stack);
+	calldata_set_bool(&cd, "muted", true);
+	assert_ptr_equal(cd.stack, stack);
+	assert_int_equal(bnum_allocs(), allocs);
+
+	/* and moves to the heap with everything intact once they don't */
+	calldata_set_string(&cd, "name", long_name);
+	assert_ptr_not_equal(cd.stack, stack);
+	assert_int_equal(bnum_allocs(), allocs + 1);
+	assert_ptr_equal(calldata_ptr(&cd, "source"), stack);
+	assert_true(calldata_bool(&cd, "muted"));
+	assert_string_equal(calldata_string(&cd, "name"), long_name);
+
+	calldata_set_string(&cd, "other", long_name);
+	assert_string_equal(calldata_string(&cd, "other"), long_name);
+	assert_string_equal(calldata_string(&cd, "name"), long_name);
+
+	calldata_free(&cd);
+	assert_int_equal(bnum_allocs(), allocs);
+
+	/* freeing without having spilled doesn't touch the buffer */
+	calldata_init_inline(&cd, stack, sizeof(stack));
+	calldata_set_int(&cd, "value", 1);
+	calldata_free(&cd);
+	assert_int_equal(bnum_allocs(), allocs);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(atom_test),
+		cmocka_unit_test(many_atoms_test),
+		cmocka_unit_test(atom_threads_test),
+		cmocka_unit_test(calldata_test),
+		cmocka_unit_test(calldata_fixed_test),
+		cmocka_unit_test(calldata_inline_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -3,6 +3,7 @@
 #include <setjmp.h>
 #include <cmocka.h>
 
+#include <util/bmem.h>
 #include <util/darray.h>
 
 static void array_basic_test(void **state)
@@ -19,10 +20,50 @@ static void array_basic_test(void **state)
 	da_free(testarray);
 }
 
+static void array_inline_test(void **state)
+{
+	DARRAY_INLINE(int, 4) testarray;
+	long allocs = bnum_allocs();
+
+	UNUSED_PARAMETER(state);
+
+	/* stays in its own storage while the items fit */
+	da_init_inline(testarray);
+	for (int i = 0; i < 4; i++)
+		da_push_back(testarray, &i);
+
+	assert_ptr_equal(testarray.array, testarray.inline_array);
+	assert_int_equal(bnum_allocs(), allocs);
+
+	/* and moves to the heap with everything intact once they don't */
+	for (int i = 4; i < 10; i++)
+		da_push_back(testarray, &i);
+
+	assert_ptr_not_equal(testarray.array, testarray.inline_array);
+	assert_int_equal(bnum_allocs(), allocs + 1);
+	assert_int_equal(testarray.num, 10);
+	for (int i = 0; i < 10; i++)
+		assert_int_equal(testarray.array[i], i);
+
+	da_free(testarray);
+	assert_int_equal(bnum_allocs(), allocs);
+
+	/* freeing without having spilled keeps the storage for reuse */
+	da_init_inline(testarray);
+	da_push_back(testarray, &(int){1});
+	da_free(testarray);
+	assert_ptr_equal(testarray.array, testarray.inline_array);
+	assert_int_equal(testarray.num, 0);
+	da_push_back(testarray, &(int){2});
+	assert_int_equal(testarray.array[0], 2);
+	assert_int_equal(bnum_allocs(), allocs);
+}
+
 int main()
 {
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test(array_basic_test),
+		cmocka_unit_test(array_inline_test),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
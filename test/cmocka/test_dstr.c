@@ -0,0 +1,69 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/dstr.h>
+
+static void dstr_inline_test(void **state)
+{
+	const char *long_str = "a string long enough that it no longer fits in "
+			       "the buffer it started in";
+	long allocs = bnum_allocs();
+	struct dstr str;
+	char buf[32];
+
+	UNUSED_PARAMETER(state);
+
+	/* stays in the buffer while the string fits */
+	dstr_init_inline(&str, buf, sizeof(buf));
+	assert_string_equal(str.array, "");
+
+	dstr_copy(&str, "libobs.show.%1");
+	dstr_replace(&str, "%1", "Scene");
+	dstr_cat(&str, "!");
+	assert_ptr_equal(str.array, buf);
+	assert_string_equal(str.array, "libobs.show.Scene!");
+	assert_int_equal(str.len, strlen("libobs.show.Scene!"));
+
+	dstr_ncopy(&str, "abcdef", 3);
+	assert_ptr_equal(str.array, buf);
+	assert_string_equal(str.array, "abc");
+	assert_int_equal(bnum_allocs(), allocs);
+
+	/* and moves to the heap with its contents once it doesn't */
+	dstr_cat(&str, long_str);
+	assert_ptr_not_equal(str.array, buf);
+	assert_int_equal(bnum_allocs(), allocs + 1);
+	assert_false(dstr_is_borrowed(&str));
+	assert_memory_equal(str.array, "abc", 3);
+	assert_string_equal(str.array + 3, long_str);
+
+	dstr_free(&str);
+	assert_null(str.array);
+	assert_int_equal(bnum_allocs(), allocs);
+
+	/* freeing without having spilled keeps the buffer for reuse */
+	dstr_init_inline(&str, buf, sizeof(buf));
+	dstr_printf(&str, "%d items", 12);
+	assert_string_equal(str.array, "12 items");
+	dstr_free(&str);
+	assert_ptr_equal(str.array, buf);
+	assert_int_equal(str.len, 0);
+	assert_string_equal(str.array, "");
+
+	dstr_copy(&str, long_str);
+	assert_string_equal(str.array, long_str);
+	dstr_free(&str);
+	assert_int_equal(bnum_allocs(), allocs);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(dstr_inline_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,248 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <media-io/format-conversion.h>
+
+/* every implementation must match the generic one byte for byte, including
+ * the padding it writes past the end of a line, so the outputs are filled
+ * with a sentinel before converting */
+#define SENTINEL 0xCD
+
+static const enum format_conversion_impl impls[] = {
+	FORMAT_CONVERSION_IMPL_SSE2,
+	FORMAT_CONVERSION_IMPL_NEON,
+	FORMAT_CONVERSION_IMPL_AVX2,
+};
+
+#define NUM_IMPLS (sizeof(impls) / sizeof(impls[0]))
+
+/* widths chosen to hit both the vector loops and their scalar tails */
+static const uint32_t widths[] = {4, 8, 12, 36, 100, 1284};
+static const uint32_t height = 6;
+
+#define NUM_WIDTHS (sizeof(widths) / sizeof(widths[0]))
+
+static uint8_t *random_buffer(size_t size)
+{
+	uint8_t *buf = bmalloc(size);
+	for (size_t i = 0; i < size; i++)
+		buf[i] = (uint8_t)rand();
+	return buf;
+}
+
+enum packer {
+	PACK_I420,
+	PACK_NV12,
+	PACK_I444,
+};
+
+static void run_packer(const struct format_conversion_kernels *k,
+		       enum packer packer, const uint8_t *input,
+		       uint32_t in_linesize, uint8_t *output[],
+		       const uint32_t out_linesize[])
+{
+	switch (packer) {
+	case PACK_I420:
+		k->compress_uyvx_to_i420(input, in_linesize, 0, height, output,
+					 out_linesize);
+		break;
+	case PACK_NV12:
+		k->compress_uyvx_to_nv12(input, in_linesize, 0, height, output,
+					 out_linesize);
+		break;
+	case PACK_I444:
+		k->convert_uyvx_to_i444(input, in_linesize, 0, height, output,
+					out_linesize);
+		break;
+	}
+}
+
+static void check_packer(enum packer packer)
+{
+	const struct format_conversion_kernels *ref =
+		format_conversion_get_kernels(FORMAT_CONVERSION_IMPL_GENERIC);
+
+	for (size_t w = 0; w < NUM_WIDTHS; w++) {
+		uint32_t width = widths[w];
+		uint32_t in_linesize = width * 4;
+		uint32_t out_linesize[3] = {width, width, width};
+		uint32_t planes = packer == PACK_NV12 ? 2 : 3;
+		size_t plane_size = width * height;
+		uint8_t *input = random_buffer(in_linesize * height);
+		uint8_t *expected[3] = {0};
+		uint8_t *output[3] = {0};
+
+		if (packer == PACK_I420)
+			out_linesize[1] = out_linesize[2] = width / 2;
+
+		for (uint32_t p = 0; p < planes; p++) {
+			expected[p] = bmalloc(plane_size);
+			output[p] = bmalloc(plane_size);
+			memset(expected[p], SENTINEL, plane_size);
+		}
+
+		run_packer(ref, packer, input, in_linesize, expected,
+			   out_linesize);
+
+		for (size_t i = 0; i < NUM_IMPLS; i++) {
+			const struct format_conversion_kernels *k =
+				format_conversion_get_kernels(impls[i]);
+			if (!k)
+				continue;
+
+			for (uint32_t p = 0; p < planes; p++)
+				memset(output[p], SENTINEL, plane_size);
+
+			run_packer(k, packer, input, in_linesize, output,
+				   out_linesize);
+
+			for (uint32_t p = 0; p < planes; p++)
+				assert_memory_equal(output[p], expected[p],
+						    plane_size);
+		}
+
+		for (uint32_t p = 0; p < planes; p++) {
+			bfree(expected[p]);
+			bfree(output[p]);
+		}
+		bfree(input);
+	}
+}
+
+static void compress_uyvx_to_i420_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_packer(PACK_I420);
+}
+
+static void compress_uyvx_to_nv12_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_packer(PACK_NV12);
+}
+
+static void convert_uyvx_to_i444_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_packer(PACK_I444);
+}
+
+enum unpacker {
+	UNPACK_420,
+	UNPACK_NV12,
+	UNPACK_YUY2,
+	UNPACK_UYVY,
+};
+
+static void run_unpacker(const struct format_conversion_kernels *k,
+			 enum unpacker unpacker, const uint8_t *const input[],
+			 const uint32_t in_linesize[], uint8_t *output,
+			 uint32_t out_linesize)
+{
+	switch (unpacker) {
+	case UNPACK_420:
+		k->decompress_420(input, in_linesize, 0, height, output,
+				  out_linesize);
+		break;
+	case UNPACK_NV12:
+		k->decompress_nv12(input, in_linesize, 0, height, output,
+				   out_linesize);
+		break;
+	case UNPACK_YUY2:
+	case UNPACK_UYVY:
+		k->decompress_422(input[0], in_linesize[0], 0, height, output,
+				  out_linesize, unpacker == UNPACK_YUY2);
+		break;
+	}
+}
+
+static void check_unpacker(enum unpacker unpacker)
+{
+	const struct format_conversion_kernels *ref =
+		format_conversion_get_kernels(FORMAT_CONVERSION_IMPL_GENERIC);
+
+	for (size_t w = 0; w < NUM_WIDTHS; w++) {
+		/* odd pixel pairs exercise the scalar tails */
+		uint32_t width = widths[w] + 2;
+		uint32_t in_linesize[3] = {width, width / 2, width / 2};
+		uint32_t out_linesize = width * 4;
+		size_t out_size = out_linesize * height * 2;
+		const uint8_t *input[3];
+		uint8_t *planes[3];
+		uint8_t *expected = bmalloc(out_size);
+		uint8_t *output = bmalloc(out_size);
+
+		if (unpacker == UNPACK_NV12)
+			in_linesize[1] = width;
+		else if (unpacker >= UNPACK_YUY2)
+			in_linesize[0] = width * 2;
+
+		/* decompress_422 converts min(in, out) / 2 dwords per line,
+		 * which runs past the end of a packed line, so both sides are
+		 * over-allocated */
+		for (uint32_t p = 0; p < 3; p++) {
+			planes[p] = random_buffer(in_linesize[p] * height * 2);
+			input[p] = planes[p];
+		}
+
+		memset(expected, SENTINEL, out_size);
+		run_unpacker(ref, unpacker, input, in_linesize, expected,
+			     out_linesize);
+
+		for (size_t i = 0; i < NUM_IMPLS; i++) {
+			const struct format_conversion_kernels *k =
+				format_conversion_get_kernels(impls[i]);
+			if (!k)
+				continue;
+
+			memset(output, SENTINEL, out_size);
+			run_unpacker(k, unpacker, input, in_linesize, output,
+				     out_linesize);
+			assert_memory_equal(output, expected, out_size);
+		}
+
+		for (uint32_t p = 0; p < 3; p++)
+			bfree(planes[p]);
+		bfree(expected);
+		bfree(output);
+	}
+}
+
+static void decompress_420_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_unpacker(UNPACK_420);
+}
+
+static void decompress_nv12_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_unpacker(UNPACK_NV12);
+}
+
+static void decompress_422_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_unpacker(UNPACK_YUY2);
+	check_unpacker(UNPACK_UYVY);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(compress_uyvx_to_i420_test),
+		cmocka_unit_test(compress_uyvx_to_nv12_test),
+		cmocka_unit_test(convert_uyvx_to_i444_test),
+		cmocka_unit_test(decompress_420_test),
+		cmocka_unit_test(decompress_nv12_test),
+		cmocka_unit_test(decompress_422_test),
+	};
+
+	srand(1);
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,88 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/histogram.h>
+#include <util/bmem.h>
+
+static void bucket_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* small values are exact */
+	for (uint64_t i = 0; i < HISTOGRAM_SUB_BUCKETS * 2; i++)
+		assert_int_equal(histogram_bucket_max(histogram_bucket(i)), i);
+
+	/* larger ones are within a bucket's width, and never understated */
+	for (uint64_t value = 64; value < (1ULL << HISTOGRAM_MAX_BITS);
+	     value = value * 3 / 2 + 7) {
+		size_t bucket = histogram_bucket(value);
+		uint64_t max = histogram_bucket_max(bucket);
+
+		assert_true(bucket < HISTOGRAM_BUCKETS);
+		assert_true(max >= value);
+		assert_true(max - value <= value / HISTOGRAM_SUB_BUCKETS);
+		assert_true(histogram_bucket_max(bucket - 1) < value);
+	}
+
+	/* buckets are in order of value */
+	for (size_t i = 1; i < HISTOGRAM_BUCKETS; i++)
+		assert_true(histogram_bucket_max(i) >
+			    histogram_bucket_max(i - 1));
+
+	assert_int_equal(histogram_bucket(UINT64_MAX), HISTOGRAM_BUCKETS - 1);
+}
+
+static void percentile_test(void **state)
+{
+	static const double percentiles[] = {0.0, 50.0, 95.0, 99.0, 99.9,
+					     100.0};
+	struct histogram *hist = bzalloc(sizeof(struct histogram));
+	uint64_t values[6];
+
+	UNUSED_PARAMETER(state);
+
+	assert_int_equal(histogram_percentiles(hist, percentiles, values, 6),
+			 0);
+	assert_int_equal(values[1], 0);
+
+	/* 1..10000 microseconds, one each */
+	for (uint64_t i = 1; i <= 10000; i++)
+		histogram_record(hist, i * 1000);
+
+	assert_int_equal(histogram_percentiles(hist, percentiles, values, 6),
+			 10000);
+
+	const uint64_t expected[] = {1000,    5000000, 9500000,
+				     9900000, 9990000, 10000000};
+	for (size_t i = 0; i < 6; i++) {
+		assert_true(values[i] >= expected[i]);
+		assert_true(values[i] - expected[i] <=
+			    expected[i] / HISTOGRAM_SUB_BUCKETS);
+	}
+
+	/* a single outlier shows up in the tail, not the median */
+	histogram_reset(hist);
+	for (int i = 0; i < 999; i++)
+		histogram_record(hist, 16000000);
+	histogram_record(hist, 250000000);
+
+	assert_int_equal(histogram_percentiles(hist, percentiles, values, 6),
+			 1000);
+	assert_true(values[1] < 17000000);
+	assert_true(values[3] < 17000000);
+	assert_true(values[5] >= 250000000);
+
+	bfree(hist);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(bucket_test),
+		cmocka_unit_test(percentile_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,177 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <obs-interleave.h>
+
+static void push(struct interleave_queue *queue, enum obs_encoder_type type,
+		 size_t track_idx, int64_t dts_usec)
+{
+	struct encoder_packet packet = {0};
+	long *refs = bzalloc(sizeof(long) + 4);
+
+	/* reference counted the way encoder packet data is */
+	*refs = 1;
+	packet.data = (uint8_t *)(refs + 1);
+	packet.size = 4;
+	packet.type = type;
+	packet.track_idx = track_idx;
+	packet.dts_usec = dts_usec;
+
+	interleave_queue_push(queue, &packet);
+}
+
+static void pop_expect(struct interleave_queue *queue,
+		       enum obs_encoder_type type, size_t track_idx,
+		       int64_t dts_usec)
+{
+	struct encoder_packet packet;
+
+	assert_true(interleave_queue_pop(queue, &packet));
+	assert_int_equal(packet.type, type);
+	assert_int_equal(packet.dts_usec, dts_usec);
+	if (type == OBS_ENCODER_AUDIO)
+		assert_int_equal(packet.track_idx, track_idx);
+	obs_encoder_packet_release(&packet);
+}
+
+static void order_test(void **state)
+{
+	struct interleave_queue queue = {0};
+	long allocs = bnum_allocs();
+	int64_t last = -1;
+	size_t count = 0;
+
+	UNUSED_PARAMETER(state);
+
+	/* video at ~30fps and three audio tracks at ~43 packets a second,
+	 * arriving a track at a time the way encoders deliver them */
+	for (int i = 0; i < 300; i++) {
+		push(&queue, OBS_ENCODER_VIDEO, 0, i * 33333);
+		for (size_t track = 0; track < 3; track++) {
+			push(&queue, OBS_ENCODER_AUDIO, track,
+			     i * 23220 + (int64_t)track * 7);
+		}
+	}
+
+	assert_int_equal(queue.num, 1200);
+
+	for (;;) {
+		struct encoder_packet packet;
+
+		if (!interleave_queue_pop(&queue, &packet))
+			break;
+
+		assert_true(packet.dts_usec >= last);
+		last = packet.dts_usec;
+		count++;
+		obs_encoder_packet_release(&packet);
+	}
+
+	assert_int_equal(count, 1200);
+	assert_int_equal(queue.num, 0);
+	assert_null(interleave_queue_peek(&queue));
+
+	interleave_queue_free(&queue);
+	assert_int_equal(bnum_allocs(), allocs);
+}
+
+static void tie_test(void **state)
+{
+	struct interleave_queue queue = {0};
+
+	UNUSED_PARAMETER(state);
+
+	/* at the same timestamp, video goes first, then audio by track */
+	push(&queue, OBS_ENCODER_AUDIO, 2, 1000);
+	push(&queue, OBS_ENCODER_AUDIO, 0, 1000);
+	push(&queue, OBS_ENCODER_VIDEO, 0, 1000);
+	push(&queue, OBS_ENCODER_AUDIO, 1, 500);
+
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 1, 500);
+	pop_expect(&queue, OBS_ENCODER_VIDEO, 0, 1000);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 0, 1000);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 2, 1000);
+
+	interleave_queue_free(&queue);
+}
+
+static void out_of_order_test(void **state)
+{
+	struct interleave_queue queue = {0};
+
+	UNUSED_PARAMETER(state);
+
+	/* a late packet still comes out in order, even ahead of the track's
+	 * current first packet */
+	push(&queue, OBS_ENCODER_VIDEO, 0, 300);
+	push(&queue, OBS_ENCODER_AUDIO, 0, 200);
+	push(&queue, OBS_ENCODER_VIDEO, 0, 500);
+	push(&queue, OBS_ENCODER_VIDEO, 0, 400);
+	push(&queue, OBS_ENCODER_VIDEO, 0, 100);
+
+	pop_expect(&queue, OBS_ENCODER_VIDEO, 0, 100);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 0, 200);
+	pop_expect(&queue, OBS_ENCODER_VIDEO, 0, 300);
+	pop_expect(&queue, OBS_ENCODER_VIDEO, 0, 400);
+	pop_expect(&queue, OBS_ENCODER_VIDEO, 0, 500);
+
+	interleave_queue_free(&queue);
+}
+
+static void discard_test(void **state)
+{
+	struct interleave_queue queue = {0};
+	long allocs = bnum_allocs();
+
+	UNUSED_PARAMETER(state);
+
+	for (int i = 0; i < 10; i++) {
+		push(&queue, OBS_ENCODER_VIDEO, 0, i * 100);
+		push(&queue, OBS_ENCODER_AUDIO, 0, i * 100 + 50);
+	}
+
+	/* up to but not including a queued packet */
+	interleave_queue_discard(&queue, interleave_queue_first(&queue, 1),
+				 false);
+	assert_int_equal(queue.num, 19);
+
+	/* through the fourth video packet */
+	interleave_queue_discard(&queue,
+				 interleave_track_packet(&queue, 0, 2), true);
+	assert_int_equal(queue.num, 13);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 0, 350);
+
+	/* shifting a track's timestamps and resorting */
+	for (size_t i = 0; i < interleave_track_size(&queue, 1); i++)
+		interleave_track_packet(&queue, 1, i)->dts_usec -= 400;
+	interleave_queue_resort(&queue);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 0, 50);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 0, 150);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 0, 250);
+	pop_expect(&queue, OBS_ENCODER_AUDIO, 0, 350);
+	pop_expect(&queue, OBS_ENCODER_VIDEO, 0, 400);
+
+	interleave_queue_free(&queue);
+	assert_int_equal(queue.num, 0);
+	assert_int_equal(bnum_allocs(), allocs);
+
+	/* and it can be used again after being freed */
+	push(&queue, OBS_ENCODER_VIDEO, 0, 0);
+	pop_expect(&queue, OBS_ENCODER_VIDEO, 0, 0);
+	interleave_queue_free(&queue);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(order_test),
+		cmocka_unit_test(tie_test),
+		cmocka_unit_test(out_of_order_test),
+		cmocka_unit_test(discard_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,415 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <obs-data.h>
+
+/* enough keys to make obs_data switch to its sorted index */
+#define NUM_KEYS 200
+
+static void key_name(char *buf, size_t size, int key)
+{
+	snprintf(buf, size, "key%03d", (key * 37) % NUM_KEYS);
+}
+
+static void check_order(obs_data_t *data, size_t expected)
+{
+	obs_data_item_t *item = obs_data_first(data);
+	char last[64] = "";
+	size_t count = 0;
+
+	for (; item; obs_data_item_next(&item)) {
+		const char *name = obs_data_item_get_name(item);
+		assert_true(strcmp(last, name) < 0);
+		snprintf(last, sizeof(last), "%s", name);
+		count++;
+	}
+
+	assert_int_equal(count, expected);
+}
+
+static void lookup_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	char name[64];
+
+	UNUSED_PARAMETER(state);
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		obs_data_set_int(data, name, i);
+		check_order(data, i + 1);
+	}
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		assert_int_equal(obs_data_get_int(data, name), i);
+		assert_true(obs_data_has_user_value(data, name));
+	}
+
+	assert_false(obs_data_has_user_value(data, "key"));
+	assert_false(obs_data_has_user_value(data, "zzz"));
+
+	obs_data_release(data);
+}
+
+static void erase_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	size_t count = NUM_KEYS;
+	char name[64];
+
+	UNUSED_PARAMETER(state);
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		obs_data_set_int(data, name, i);
+	}
+
+	for (int i = 0; i < NUM_KEYS; i += 3) {
+		key_name(name, sizeof(name), i);
+		obs_data_erase(data, name);
+		check_order(data, --count);
+	}
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		assert_int_equal(obs_data_has_user_value(data, name),
+				 i % 3 != 0);
+	}
+
+	/* erased keys go back in their sorted place */
+	for (int i = 0; i < NUM_KEYS; i += 3) {
+		key_name(name, sizeof(name), i);
+		obs_data_set_int(data, name, -i);
+		check_order(data, ++count);
+		assert_int_equal(obs_data_get_int(data, name), -i);
+	}
+
+	obs_data_release(data);
+}
+
+static void resize_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	char value[2048];
+	char name[64];
+
+	UNUSED_PARAMETER(state);
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		obs_data_set_default_string(data, name, "default");
+		obs_data_set_string(data, name, "x");
+	}
+
+	/* growing the values reallocates the items in place in the list */
+	memset(value, 'v', sizeof(value) - 1);
+	value[sizeof(value) - 1] = 0;
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		obs_data_set_string(data, name, value + i);
+	}
+
+	check_order(data, NUM_KEYS);
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		assert_string_equal(obs_data_get_string(data, name), value + i);
+		assert_string_equal(obs_data_get_default_string(data, name),
+				    "default");
+	}
+
+	obs_data_release(data);
+}
+
+/* how the "path" string below is escaped */
+#define PATH_JSON "\"C:\\\\dir\\\\\\\"a\\\"\\n\\u0001/\xc3\xa9\""
+
+static void json_write_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	obs_data_t *obj = obs_data_create();
+	obs_data_array_t *array = obs_data_array_create();
+
+	UNUSED_PARAMETER(state);
+
+	obs_data_set_string(obj, "path", "C:\\dir\\\"a\"\n\x01/\xc3\xa9");
+	obs_data_array_push_back(array, obj);
+	obs_data_array_push_back(array, obj);
+
+	obs_data_set_int(data, "int", -42);
+	obs_data_set_double(data, "double", 0.5);
+	obs_data_set_double(data, "whole", 3.0);
+	obs_data_set_double(data, "large", 1e20);
+	obs_data_set_double(data, "nan", NAN);
+	obs_data_set_bool(data, "bool", true);
+	obs_data_set_obj(data, "obj", obj);
+	obs_data_set_obj(data, "empty", NULL);
+	obs_data_set_array(data, "array", array);
+	obs_data_set_string(data, "invalid", "\xff");
+	obs_data_set_default_int(data, "default", 1);
+
+	/* non-finite numbers and invalid UTF-8 are left out, and only the full
+	 * json includes defaults */
+	assert_string_equal(obs_data_get_json(data),
+			    "{\"array\":[{\"path\":" PATH_JSON "},"
+			    "{\"path\":" PATH_JSON "}],"
+			    "\"bool\":true,\"double\":0.5,\"empty\":{},"
+			    "\"int\":-42,\"large\":1e20,"
+			    "\"obj\":{\"path\":" PATH_JSON "},\"whole\":3.0}");
+
+	obs_data_erase(data, "array");
+	obs_data_erase(data, "obj");
+	obs_data_erase(data, "empty");
+
+	assert_string_equal(obs_data_get_full_json(data),
+			    "{\n"
+			    "    \"bool\": true,\n"
+			    "    \"default\": 1,\n"
+			    "    \"double\": 0.5,\n"
+			    "    \"int\": -42,\n"
+			    "    \"large\": 1e20,\n"
+			    "    \"whole\": 3.0\n"
+			    "}");
+
+	obs_data_array_release(array);
+	obs_data_release(obj);
+	obs_data_release(data);
+}
+
+static void json_read_test(void **state)
+{
+	const char *json = " {\"s\": \"a\\u00e9\\ud83d\\ude00\\t\","
+			   "\"i\": -9223372036854775808,"
+			   "\"d\": 1.5e-3, \"b\": false, \"n\": null,"
+			   "\"o\": {\"x\": [1, {\"y\": 2}, [{\"z\": 3}]]}} ";
+	obs_data_t *data = obs_data_create_from_json(json);
+	obs_data_array_t *array;
+	obs_data_t *obj, *item;
+
+	UNUSED_PARAMETER(state);
+
+	assert_non_null(data);
+	assert_string_equal(obs_data_get_string(data, "s"),
+			    "a\xc3\xa9\xf0\x9f\x98\x80\t");
+	assert_true(obs_data_get_int(data, "i") == LLONG_MIN);
+	assert_true(obs_data_get_double(data, "d") == 1.5e-3);
+	assert_true(obs_data_has_user_value(data, "b"));
+	assert_false(obs_data_has_user_value(data, "n"));
+
+	/* only objects are kept from arrays */
+	obj = obs_data_get_obj(data, "o");
+	array = obs_data_get_array(obj, "x");
+	assert_int_equal(obs_data_array_count(array), 1);
+	item = obs_data_array_item(array, 0);
+	assert_int_equal(obs_data_get_int(item, "y"), 2);
+
+	obs_data_release(item);
+	obs_data_array_release(array);
+	obs_data_release(obj);
+	obs_data_release(data);
+}
+
+static void json_reject_test(void **state)
+{
+	static const char *invalid[] = {
+		"",
+		"1",
+		"{\"a\":1,}",
+		"{\"a\":1} x",
+		"{\"a\":1,\"a\":2}",
+		"{\"a\":null,\"a\":1}",
+		"{\"a\":[{\"b\":1,\"b\":1}]}",
+		"{\"a\":01}",
+		"{\"a\":1.}",
+		"{\"a\":9223372036854775808}",
+		"{\"a\":1e400}",
+		"{\"a\":\"\\u0000\"}",
+		"{\"a\":\"\\ud83d\"}",
+		"{\"a\":\"\xff\"}",
+		"{\"a\":\"\n\"}",
+		"{\"a\":tru}",
+	};
+
+	UNUSED_PARAMETER(state);
+
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		assert_null(obs_data_create_from_json(invalid[i]));
+
+	/* a top-level array is accepted, but leaves the object empty */
+	obs_data_t *data = obs_data_create_from_json("[{\"a\":1}]");
+	assert_non_null(data);
+	assert_null(obs_data_first(data));
+	obs_data_release(data);
+}
+
+static void json_round_trip_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	obs_data_t *loaded;
+	char name[64];
+	char *json;
+
+	UNUSED_PARAMETER(state);
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		if (i % 3 == 0)
+			obs_data_set_int(data, name, (long long)i << 40);
+		else if (i % 3 == 1)
+			obs_data_set_double(data, name, i / 7.0);
+		else
+			obs_data_set_string(data, name, name);
+	}
+
+	json = bstrdup(obs_data_get_json(data));
+	loaded = obs_data_create_from_json(json);
+	assert_non_null(loaded);
+	assert_string_equal(obs_data_get_json(loaded), json);
+
+	for (int i = 0; i < NUM_KEYS; i += 3) {
+		key_name(name, sizeof(name), i);
+		assert_true(obs_data_get_int(loaded, name) ==
+			    (long long)i << 40);
+	}
+
+	bfree(json);
+	obs_data_release(loaded);
+	obs_data_release(data);
+}
+
+static obs_data_t *make_nested(void)
+{
+	obs_data_t *data = obs_data_create();
+	obs_data_t *obj = obs_data_create();
+	obs_data_array_t *array = obs_data_array_create();
+	char name[64];
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		key_name(name, sizeof(name), i);
+		if (i % 4 == 0)
+			obs_data_set_int(obj, name, -((long long)i << 50));
+		else if (i % 4 == 1)
+			obs_data_set_double(obj, name, i / 7.0);
+		else if (i % 4 == 2)
+			obs_data_set_bool(obj, name, i % 3 == 0);
+		else
+			obs_data_set_string(obj, name, "\xc3\xa9\t\"");
+	}
+
+	obs_data_array_push_back(array, obj);
+	obs_data_array_push_back(array, obj);
+
+	obs_data_set_obj(data, "obj", obj);
+	obs_data_set_array(data, "array", array);
+	obs_data_set_array(data, "empty", NULL);
+	obs_data_set_string(data, "", "empty name");
+	obs_data_set_int(data, "min", LLONG_MIN);
+	obs_data_set_int(data, "max", LLONG_MAX);
+	obs_data_set_default_int(data, "default", 1);
+
+	obs_data_array_release(array);
+	obs_data_release(obj);
+	return data;
+}
+
+static void binary_round_trip_test(void **state)
+{
+	obs_data_t *data = make_nested();
+	char *json = bstrdup(obs_data_get_json(data));
+	obs_data_t *loaded;
+	size_t size;
+	void *bin;
+
+	UNUSED_PARAMETER(state);
+
+	bin = obs_data_get_binary(data, &size);
+	assert_non_null(bin);
+	assert_memory_equal(bin, "OBSD", 4);
+
+	loaded = obs_data_create_from_binary(bin, size);
+	assert_non_null(loaded);
+	assert_string_equal(obs_data_get_json(loaded), json);
+
+	/* defaults aren't stored, the same as with json */
+	assert_false(obs_data_has_default_value(loaded, "default"));
+
+	obs_data_release(loaded);
+	bfree(bin);
+	bfree(json);
+	obs_data_release(data);
+}
+
+static void binary_reject_test(void **state)
+{
+	obs_data_t *data = make_nested();
+	obs_data_t *loaded;
+	uint8_t *bin;
+	size_t size;
+
+	UNUSED_PARAMETER(state);
+
+	bin = obs_data_get_binary(data, &size);
+
+	/* every truncation fails cleanly */
+	for (size_t len = 0; len < size; len++)
+		assert_null(obs_data_create_from_binary(bin, len));
+
+	/* corruption anywhere either fails or still loads something, but
+	 * never reads out of bounds */
+	for (size_t pos = 0; pos < size; pos += 7) {
+		uint8_t old = bin[pos];
+
+		bin[pos] ^= 0xA5;
+		loaded = obs_data_create_from_binary(bin, size);
+		obs_data_release(loaded);
+		bin[pos] = old;
+	}
+
+	/* newer versions are refused */
+	bin[4] = 2;
+	assert_null(obs_data_create_from_binary(bin, size));
+
+	bfree(bin);
+	obs_data_release(data);
+
+	/* an item, then the same item twice */
+	static const uint8_t single[] = {'O', 'B', 'S', 'D', 1, 0, 0, 0,
+					 1,   5,   1,   'a', 0};
+	static const uint8_t duplicate[] = {'O', 'B', 'S', 'D', 1, 0, 0, 0,
+					    2,   5,   1,   'a', 0, 5, 1, 'a',
+					    0};
+
+	loaded = obs_data_create_from_binary(single, sizeof(single));
+	assert_non_null(loaded);
+	assert_true(obs_data_get_bool(loaded, "a"));
+	obs_data_release(loaded);
+
+	assert_null(obs_data_create_from_binary(duplicate, sizeof(duplicate)));
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(lookup_test),
+		cmocka_unit_test(erase_test),
+		cmocka_unit_test(resize_test),
+		cmocka_unit_test(json_write_test),
+		cmocka_unit_test(json_read_test),
+		cmocka_unit_test(json_reject_test),
+		cmocka_unit_test(json_round_trip_test),
+		cmocka_unit_test(binary_round_trip_test),
+		cmocka_unit_test(binary_reject_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,190 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/profiler.h>
+#include <util/bmem.h>
+
+#define TRACE_THREADS 4
+
+static const char *thread_names[TRACE_THREADS] = {
+	"trace_thread_0",
+	"trace_thread_1",
+	"trace_thread_2",
+	"trace_thread_3",
+};
+static const char *inner_name = "trace_inner";
+
+static char *save_trace(void)
+{
+	const char *path = "test_profiler_trace.json";
+	char *json;
+
+	assert_true(profiler_trace_save(path));
+	json = os_quick_read_utf8_file(path);
+	os_unlink(path);
+
+	assert_non_null(json);
+	return json;
+}
+
+static size_t count(const char *str, const char *find)
+{
+	size_t num = 0;
+
+	while ((str = strstr(str, find)) != NULL) {
+		str += strlen(find);
+		num++;
+	}
+
+	return num;
+}
+
+static void *trace_thread(void *param)
+{
+	const char *name = param;
+
+	for (int i = 0; i < 100; i++) {
+		profile_start(name);
+		profile_start(inner_name);
+		profile_end(inner_name);
+		profile_end(name);
+	}
+
+	return NULL;
+}
+
+static void trace_threads_test(void **state)
+{
+	pthread_t threads[TRACE_THREADS];
+	char *json;
+
+	UNUSED_PARAMETER(state);
+
+	profiler_trace_start(60000000000ULL);
+	assert_true(profiler_trace_active());
+
+	for (size_t i = 0; i < TRACE_THREADS; i++)
+		assert_int_equal(pthread_create(&threads[i], NULL, trace_thread,
+						(void *)thread_names[i]),
+				 0);
+	for (size_t i = 0; i < TRACE_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	/* saving while running picks up what hasn't been drained yet */
+	json = save_trace();
+	assert_true(strncmp(json, "{\"traceEvents\":[", 16) == 0);
+	assert_int_equal(count(json, "\"ph\":\"X\""), TRACE_THREADS * 200);
+	assert_int_equal(count(json, "\"name\":\"trace_inner\""),
+			 TRACE_THREADS * 100);
+	assert_int_equal(count(json, "\"thread_name\""), TRACE_THREADS);
+	for (size_t i = 0; i < TRACE_THREADS; i++)
+		assert_int_equal(count(json, thread_names[i]), 101);
+	bfree(json);
+
+	/* stopping keeps the trace, but nothing more is recorded */
+	profiler_trace_stop();
+	assert_false(profiler_trace_active());
+	trace_thread((void *)thread_names[0]);
+
+	json = save_trace();
+	assert_int_equal(count(json, "\"ph\":\"X\""), TRACE_THREADS * 200);
+	bfree(json);
+
+	profiler_free();
+}
+
+static void trace_thread_exit_test(void **state)
+{
+	pthread_t thread;
+	long allocs;
+	char *json;
+
+	UNUSED_PARAMETER(state);
+
+	profiler_trace_start(60000000000ULL);
+	trace_thread((void *)thread_names[0]);
+	bfree(save_trace());
+	allocs = bnum_allocs();
+
+	/* the ring of a thread that has exited is freed once it's drained,
+	 * and what it recorded is kept */
+	assert_int_equal(pthread_create(&thread, NULL, trace_thread,
+					(void *)thread_names[1]),
+			 0);
+	pthread_join(thread, NULL);
+
+	for (int i = 0; i < 100 && bnum_allocs() > allocs; i++)
+		os_sleep_ms(10);
+	assert_int_equal(bnum_allocs(), allocs);
+
+	json = save_trace();
+	assert_int_equal(count(json, "\"ph\":\"X\""), 400);
+	assert_int_equal(count(json, thread_names[1]), 101);
+	bfree(json);
+
+	profiler_free();
+}
+
+static void trace_window_test(void **state)
+{
+	char *json;
+
+	UNUSED_PARAMETER(state);
+
+	/* scopes that ended before the window are trimmed */
+	profiler_trace_start(50000000ULL);
+	trace_thread((void *)thread_names[0]);
+	os_sleep_ms(300);
+	profile_start(thread_names[1]);
+	profile_end(thread_names[1]);
+
+	json = save_trace();
+	assert_int_equal(count(json, "\"ph\":\"X\""), 1);
+	assert_int_equal(count(json, thread_names[1]), 1);
+	bfree(json);
+
+	profiler_free();
+	assert_false(profiler_trace_active());
+}
+
+static void trace_unmatched_test(void **state)
+{
+	static const char *escaped = "trace \"quoted\"\\";
+	char *json;
+
+	UNUSED_PARAMETER(state);
+
+	/* ends of scopes started before tracing are ignored, and an end
+	 * closes anything left open inside its scope */
+	profile_start(thread_names[0]);
+	profiler_trace_start(60000000000ULL);
+	profile_start(escaped);
+	profile_start(inner_name);
+	profile_end(escaped);
+	profile_end(thread_names[0]);
+
+	json = save_trace();
+	assert_int_equal(count(json, "\"ph\":\"X\""), 1);
+	assert_non_null(strstr(json, "\"trace \\\"quoted\\\"\\\\\""));
+	bfree(json);
+
+	profiler_free();
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(trace_threads_test),
+		cmocka_unit_test(trace_thread_exit_test),
+		cmocka_unit_test(trace_window_test),
+		cmocka_unit_test(trace_unmatched_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
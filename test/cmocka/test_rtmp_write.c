@@ -0,0 +1,285 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <obs.h>
+#include <util/bmem.h>
+#include <util/darray.h>
+#include <util/threading.h>
+
+#include "librtmp/rtmp.h"
+#include "flv-mux.h"
+
+/* RTMP_WriteV must put exactly the same bytes on the wire as muxing the
+ * packet into an FLV tag and handing that to RTMP_Write */
+
+/* sizes around the chunk boundaries, and one big enough to need more than
+ * one sendmsg at the smallest chunk size */
+static const size_t packet_sizes[] = {1, 123, 126, 127, 128, 129, 5000, 70000};
+static const int chunk_sizes[] = {128, 4096, 100000};
+
+#define NUM_PACKET_SIZES (sizeof(packet_sizes) / sizeof(packet_sizes[0]))
+#define NUM_CHUNK_SIZES (sizeof(chunk_sizes) / sizeof(chunk_sizes[0]))
+#define MAX_PACKET_SIZE 70000
+
+struct reader {
+	int fd;
+	DARRAY(uint8_t) bytes;
+};
+
+static void *reader_thread(void *data)
+{
+	struct reader *reader = data;
+	uint8_t buf[4096];
+	ssize_t ret;
+
+	/* read slowly so that the writer sees partial sends */
+	while ((ret = recv(reader->fd, buf, sizeof(buf), 0)) > 0)
+		da_push_back_array(reader->bytes, buf, (size_t)ret);
+	return NULL;
+}
+
+static void start_reader(RTMP *rtmp, struct reader *reader,
+			 pthread_t *thread, int chunk_size)
+{
+	int fds[2];
+	int sndbuf = 4096;
+
+	assert_int_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+	setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+	reader->fd = fds[1];
+	da_init(reader->bytes);
+	assert_int_equal(pthread_create(thread, NULL, reader_thread, reader),
+			 0);
+
+	RTMP_Init(rtmp);
+	rtmp->m_sb.sb_socket = fds[0];
+	rtmp->m_outChunkSize = chunk_size;
+	rtmp->Link.streams[0].id = 1;
+}
+
+static void stop_reader(RTMP *rtmp, struct reader *reader, pthread_t thread)
+{
+	close(rtmp->m_sb.sb_socket);
+	rtmp->m_sb.sb_socket = -1;
+	RTMP_Close(rtmp);
+
+	pthread_join(thread, NULL);
+	close(reader->fd);
+}
+
+static int write_muxed(RTMP *rtmp, struct encoder_packet *packet)
+{
+	uint8_t *data;
+	size_t size;
+	int ret;
+
+	flv_packet_mux(packet, 0, &data, &size, false);
+	ret = RTMP_Write(rtmp, (char *)data, (int)size, 0);
+	bfree(data);
+	return ret;
+}
+
+static int write_slices(RTMP *rtmp, struct encoder_packet *packet)
+{
+	struct flv_tag tag;
+	RTMPSlice body[2];
+
+	if (!flv_packet_tag(packet, 0, &tag, false))
+		return -1;
+
+	body[0].data = (const char *)tag.prefix;
+	body[0].size = (int)tag.prefix_size;
+	body[1].data = (const char *)packet->data;
+	body[1].size = (int)packet->size;
+	return RTMP_WriteV(rtmp, tag.type, tag.timestamp, body, 2, 0);
+}
+
+/* audio and video share a channel, so alternating them changes the header
+ * type picked for each packet.  at the half way point the timestamp jumps
+ * far enough for the delta to need the extended field. */
+static void make_packet(struct encoder_packet *packet, uint8_t *data,
+			int64_t start_ms, size_t i)
+{
+	memset(packet, 0, sizeof(*packet));
+	packet->timebase_den = 1000;
+	packet->dts = start_ms + (int64_t)(i / 2) * 16;
+	if (i >= NUM_PACKET_SIZES)
+		packet->dts += 0x1000000;
+	packet->pts = packet->dts + (i & 2 ? 33 : 0);
+	packet->data = data;
+	packet->size = packet_sizes[i % NUM_PACKET_SIZES];
+
+	if (i & 1) {
+		packet->type = OBS_ENCODER_AUDIO;
+	} else {
+		packet->type = OBS_ENCODER_VIDEO;
+		packet->keyframe = i == 0;
+	}
+}
+
+static void send_all(int chunk_size, int64_t start_ms, uint8_t *data,
+		     int (*write)(RTMP *, struct encoder_packet *),
+		     struct reader *reader)
+{
+	struct encoder_packet packet;
+	pthread_t thread;
+	RTMP rtmp;
+
+	start_reader(&rtmp, reader, &thread, chunk_size);
+
+	for (size_t i = 0; i < NUM_PACKET_SIZES * 2; i++) {
+		make_packet(&packet, data, start_ms, i);
+		assert_true(write(&rtmp, &packet) >= 0);
+	}
+
+	stop_reader(&rtmp, reader, thread);
+}
+
+static void compare_writes(int64_t start_ms)
+{
+	uint8_t *data = bmalloc(MAX_PACKET_SIZE);
+
+	for (size_t i = 0; i < MAX_PACKET_SIZE; i++)
+		data[i] = (uint8_t)rand();
+
+	for (size_t i = 0; i < NUM_CHUNK_SIZES; i++) {
+		struct reader muxed;
+		struct reader slices;
+
+		send_all(chunk_sizes[i], start_ms, data, write_muxed, &muxed);
+		send_all(chunk_sizes[i], start_ms, data, write_slices, &slices);
+
+		assert_true(muxed.bytes.num > 0);
+		assert_int_equal(muxed.bytes.num, slices.bytes.num);
+		assert_memory_equal(muxed.bytes.array, slices.bytes.array,
+				    muxed.bytes.num);
+
+		da_free(muxed.bytes);
+		da_free(slices.bytes);
+	}
+
+	bfree(data);
+}
+
+static void write_matches_mux_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	compare_writes(1000);
+}
+
+static void write_extended_timestamp_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* the first packet on the channel has no previous timestamp to be
+	 * relative to, so this starts out in the extended field */
+	compare_writes(0x1234567);
+}
+
+/* RTMP_Write and RTMP_WriteV always use channel 4, so the two and three
+ * byte basic headers they share with RTMP_SendPacket are checked against
+ * hand encoded ones instead */
+static void check_channel(int channel, const uint8_t *basic, size_t basic_size)
+{
+	const uint32_t timestamp = 0x1234567;
+	const int body_size = 300;
+	const int chunk_size = 128;
+	struct reader reader;
+	pthread_t thread;
+	RTMPPacket packet;
+	RTMP rtmp;
+	DARRAY(uint8_t) expected;
+	uint8_t msg_header[15];
+
+	start_reader(&rtmp, &reader, &thread, chunk_size);
+
+	RTMPPacket_Reset(&packet);
+	assert_true(RTMPPacket_Alloc(&packet, body_size));
+	packet.m_nChannel = channel;
+	packet.m_headerType = RTMP_PACKET_SIZE_LARGE;
+	packet.m_packetType = RTMP_PACKET_TYPE_VIDEO;
+	packet.m_nTimeStamp = timestamp;
+	packet.m_nInfoField2 = 1;
+	packet.m_nBodySize = body_size;
+	for (int i = 0; i < body_size; i++)
+		packet.m_body[i] = (char)i;
+
+	assert_true(RTMP_SendPacket(&rtmp, &packet, FALSE));
+	RTMPPacket_Free(&packet);
+
+	stop_reader(&rtmp, &reader, thread);
+
+	/* timestamp (extended), body size, type, stream id, full timestamp */
+	msg_header[0] = 0xff;
+	msg_header[1] = 0xff;
+	msg_header[2] = 0xff;
+	msg_header[3] = (uint8_t)(body_size >> 16);
+	msg_header[4] = (uint8_t)(body_size >> 8);
+	msg_header[5] = (uint8_t)body_size;
+	msg_header[6] = RTMP_PACKET_TYPE_VIDEO;
+	msg_header[7] = 1;
+	msg_header[8] = 0;
+	msg_header[9] = 0;
+	msg_header[10] = 0;
+	msg_header[11] = (uint8_t)(timestamp >> 24);
+	msg_header[12] = (uint8_t)(timestamp >> 16);
+	msg_header[13] = (uint8_t)(timestamp >> 8);
+	msg_header[14] = (uint8_t)timestamp;
+
+	da_init(expected);
+	da_push_back_array(expected, basic, basic_size);
+	da_push_back_array(expected, msg_header, sizeof(msg_header));
+
+	for (int i = 0; i < body_size; i++) {
+		uint8_t byte = (uint8_t)i;
+
+		if (i && i % chunk_size == 0) {
+			uint8_t cont = 0xc0 | basic[0];
+			da_push_back(expected, &cont);
+			da_push_back_array(expected, basic + 1,
+					   basic_size - 1);
+		}
+		da_push_back(expected, &byte);
+	}
+
+	assert_int_equal(reader.bytes.num, expected.num);
+	assert_memory_equal(reader.bytes.array, expected.array, expected.num);
+
+	da_free(expected);
+	da_free(reader.bytes);
+}
+
+static void channel_header_test(void **state)
+{
+	static const uint8_t channel_64[] = {0x00, 0x00};
+	static const uint8_t channel_319[] = {0x00, 0xff};
+	static const uint8_t channel_320[] = {0x01, 0x00, 0x01};
+	static const uint8_t channel_1000[] = {0x01, 0xa8, 0x03};
+
+	UNUSED_PARAMETER(state);
+
+	check_channel(64, channel_64, sizeof(channel_64));
+	check_channel(319, channel_319, sizeof(channel_319));
+	check_channel(320, channel_320, sizeof(channel_320));
+	check_channel(1000, channel_1000, sizeof(channel_1000));
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(write_matches_mux_test),
+		cmocka_unit_test(write_extended_timestamp_test),
+		cmocka_unit_test(channel_header_test),
+	};
+
+	srand(1);
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
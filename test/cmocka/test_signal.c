@@ -0,0 +1,450 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/threading.h>
+#include <util/base.h>
+#include <util/platform.h>
+#include <callback/signal.h>
+#include <callback/proc.h>
+
+struct counter {
+	signal_handler_t *handler;
+	volatile long calls;
+	volatile bool disconnected;
+	struct counter *other;
+};
+
+static void count_cb(void *data, calldata_t *params)
+{
+	struct counter *counter = data;
+	UNUSED_PARAMETER(params);
+
+	/* must never run once disconnecting has returned */
+	assert_false(os_atomic_load_bool(&counter->disconnected));
+	os_atomic_inc_long(&counter->calls);
+}
+
+static void remove_self_cb(void *data, calldata_t *params)
+{
+	count_cb(data, params);
+	signal_handler_remove_current();
+}
+
+static void disconnect_other_cb(void *data, calldata_t *params)
+{
+	struct counter *counter = data;
+
+	count_cb(data, params);
+	signal_handler_disconnect(counter->handler, "test", count_cb,
+				  counter->other);
+}
+
+static void connect_other_cb(void *data, calldata_t *params)
+{
+	struct counter *counter = data;
+
+	count_cb(data, params);
+	signal_handler_connect(counter->handler, "test", count_cb,
+			       counter->other);
+}
+
+static void global_cb(void *data, const char *signal, calldata_t *params)
+{
+	assert_string_equal(signal, "test");
+	count_cb(data, params);
+}
+
+static signal_handler_t *create_handler(void)
+{
+	signal_handler_t *handler = signal_handler_create();
+	assert_true(signal_handler_add(handler, "void test()"));
+	assert_false(signal_handler_add(handler, "void test()"));
+	return handler;
+}
+
+static void connect_test(void **state)
+{
+	signal_handler_t *handler = create_handler();
+	struct counter counter = {0};
+
+	UNUSED_PARAMETER(state);
+
+	/* connecting the same callback twice only calls it once */
+	signal_handler_connect(handler, "test", count_cb, &counter);
+	signal_handler_connect(handler, "test", count_cb, &counter);
+	signal_handler_connect_global(handler, global_cb, &counter);
+
+	signal_handler_signal(handler, "test", NULL);
+	assert_int_equal(counter.calls, 2);
+
+	signal_handler_disconnect(handler, "test", count_cb, &counter);
+	signal_handler_disconnect_global(handler, global_cb, &counter);
+
+	signal_handler_signal(handler, "test", NULL);
+	signal_handler_signal(handler, "missing", NULL);
+	assert_int_equal(counter.calls, 2);
+
+	signal_handler_destroy(handler);
+}
+
+static void signal_id_test(void **state)
+{
+	signal_handler_t *handler = create_handler();
+	struct counter counter = {0};
+	callback_atom_t test = callback_atom_find("test");
+
+	UNUSED_PARAMETER(state);
+
+	assert_int_not_equal(test, 0);
+	signal_handler_connect(handler, "test", count_cb, &counter);
+	signal_handler_connect_global(handler, global_cb, &counter);
+
+	/* global callbacks still get the name */
+	signal_handler_signal_id(handler, test, NULL);
+	assert_int_equal(counter.calls, 2);
+
+	signal_handler_signal_id(handler, 0, NULL);
+	signal_handler_signal_id(handler, callback_atom_get("not_a_signal"),
+				 NULL);
+	assert_int_equal(counter.calls, 2);
+
+	signal_handler_disconnect_global(handler, global_cb, &counter);
+	signal_handler_destroy(handler);
+}
+
+static void proc_cb(void *data, calldata_t *params)
+{
+	calldata_set_int(params, "result",
+			 calldata_int(params, "value") * (long long)data);
+}
+
+static void proc_id_test(void **state)
+{
+	proc_handler_t *handler = proc_handler_create();
+	calldata_t cd = {0};
+
+	UNUSED_PARAMETER(state);
+
+	proc_handler_add(handler, "void twice(in int value, out int result)",
+			 proc_cb, (void *)2);
+	proc_handler_add(handler, "void thrice(in int value, out int result)",
+			 proc_cb, (void *)3);
+
+	calldata_set_int(&cd, "value", 5);
+	assert_true(proc_handler_call(handler, "thrice", &cd));
+	assert_int_equal(calldata_int(&cd, "result"), 15);
+	assert_true(proc_handler_call_id(handler, callback_atom_find("twice"),
+					 &cd));
+	assert_int_equal(calldata_int(&cd, "result"), 10);
+
+	assert_false(proc_handler_call(handler, "never_declared", &cd));
+	assert_false(proc_handler_call_id(handler, 0, &cd));
+
+	calldata_free(&cd);
+	proc_handler_destroy(handler);
+}
+
+static void remove_current_test(void **state)
+{
+	signal_handler_t *handler = create_handler();
+	struct counter counter = {0};
+
+	UNUSED_PARAMETER(state);
+
+	signal_handler_connect(handler, "test", remove_self_cb, &counter);
+
+	signal_handler_signal(handler, "test", NULL);
+	signal_handler_signal(handler, "test", NULL);
+	assert_int_equal(counter.calls, 1);
+
+	/* can be connected again afterwards */
+	signal_handler_connect(handler, "test", remove_self_cb, &counter);
+	signal_handler_signal(handler, "test", NULL);
+	assert_int_equal(counter.calls, 2);
+
+	signal_handler_destroy(handler);
+}
+
+static void modify_while_signalling_test(void **state)
+{
+	signal_handler_t *handler = create_handler();
+	struct counter other = {0};
+	struct counter first = {handler, 0, false, &other};
+	struct counter added = {0};
+	struct counter adder = {handler, 0, false, &added};
+
+	UNUSED_PARAMETER(state);
+
+	/* a callback disconnected by an earlier one in the same signal is
+	 * skipped */
+	signal_handler_connect(handler, "test", disconnect_other_cb, &first);
+	signal_handler_connect(handler, "test", count_cb, &other);
+
+	signal_handler_signal(handler, "test", NULL);
+	assert_int_equal(first.calls, 1);
+	assert_int_equal(other.calls, 0);
+
+	/* a callback connected during a signal is called from the next one */
+	signal_handler_connect(handler, "test", connect_other_cb, &adder);
+
+	signal_handler_signal(handler, "test", NULL);
+	assert_int_equal(added.calls, 0);
+
+	signal_handler_signal(handler, "test", NULL);
+	assert_int_equal(added.calls, 1);
+
+	signal_handler_destroy(handler);
+}
+
+static void keep_ref_test(void **state)
+{
+	signal_handler_t *handler = create_handler();
+	struct counter counter = {0};
+
+	UNUSED_PARAMETER(state);
+
+	/* the handler stays alive until the last referencing callback is
+	 * disconnected */
+	signal_handler_connect_ref(handler, "test", count_cb, &counter);
+	signal_handler_destroy(handler);
+
+	signal_handler_signal(handler, "test", NULL);
+	assert_int_equal(counter.calls, 1);
+
+	signal_handler_disconnect(handler, "test", count_cb, &counter);
+}
+
+#define EMIT_THREADS 4
+
+struct emit_data {
+	signal_handler_t *handler;
+	volatile bool stop;
+};
+
+static void *emit_thread(void *param)
+{
+	struct emit_data *emit = param;
+
+	while (!os_atomic_load_bool(&emit->stop))
+		signal_handler_signal(emit->handler, "test", NULL);
+	return NULL;
+}
+
+static void concurrent_test(void **state)
+{
+	struct emit_data emit = {create_handler(), false};
+	struct counter always = {0};
+	pthread_t threads[EMIT_THREADS];
+
+	UNUSED_PARAMETER(state);
+
+	signal_handler_connect(emit.handler, "test", count_cb, &always);
+
+	for (size_t i = 0; i < EMIT_THREADS; i++)
+		assert_int_equal(
+			pthread_create(&threads[i], NULL, emit_thread, &emit),
+			0);
+
+	while (!os_atomic_load_long(&always.calls))
+		os_sleep_ms(1);
+
+	/* callbacks come and go while other threads signal, and none may
+	 * be called after its disconnect returns */
+	for (int i = 0; i < 2000; i++) {
+		struct counter counter = {0};
+
+		signal_handler_connect(emit.handler, "test", count_cb,
+				       &counter);
+		signal_handler_connect_global(emit.handler, global_cb,
+					      &counter);
+
+		signal_handler_disconnect(emit.handler, "test", count_cb,
+					  &counter);
+		signal_handler_disconnect_global(emit.handler, global_cb,
+						 &counter);
+		os_atomic_set_bool(&counter.disconnected, true);
+	}
+
+	os_atomic_set_bool(&emit.stop, true);
+	for (size_t i = 0; i < EMIT_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	signal_handler_destroy(emit.handler);
+}
+
+struct busy_data {
+	signal_handler_t *handler;
+	volatile bool armed;
+	volatile bool entered;
+	volatile bool left;
+};
+
+/* sits inside the callback for a while on the thread that signalled it */
+static void busy_cb(void *data, calldata_t *params)
+{
+	struct busy_data *busy = data;
+	UNUSED_PARAMETER(params);
+
+	os_atomic_set_bool(&busy->entered, true);
+	os_sleep_ms(100);
+	os_atomic_set_bool(&busy->left, true);
+}
+
+static void disconnect_busy_cb(void *data, calldata_t *params)
+{
+	struct busy_data *busy = data;
+	UNUSED_PARAMETER(params);
+
+	if (!os_atomic_set_bool(&busy->armed, false))
+		return;
+
+	/* another thread is still inside busy_cb.  this thread is inside a
+	 * signal, so waiting for it is left until the signal returns */
+	signal_handler_disconnect(busy->handler, "test", busy_cb, busy);
+}
+
+static void *emit_once_thread(void *param)
+{
+	struct busy_data *busy = param;
+
+	signal_handler_signal(busy->handler, "test", NULL);
+	return NULL;
+}
+
+static void disconnect_busy_test(void **state)
+{
+	struct busy_data busy = {create_handler(), false, false, false};
+	pthread_t thread;
+
+	UNUSED_PARAMETER(state);
+
+	signal_handler_connect(busy.handler, "test", disconnect_busy_cb, &busy);
+	signal_handler_connect(busy.handler, "test", busy_cb, &busy);
+
+	assert_int_equal(
+		pthread_create(&thread, NULL, emit_once_thread, &busy), 0);
+	while (!os_atomic_load_bool(&busy.entered))
+		os_sleep_ms(1);
+
+	os_atomic_set_bool(&busy.armed, true);
+	signal_handler_signal(busy.handler, "test", NULL);
+	assert_false(os_atomic_load_bool(&busy.armed));
+	assert_true(os_atomic_load_bool(&busy.left));
+
+	pthread_join(thread, NULL);
+	signal_handler_destroy(busy.handler);
+}
+
+struct cross_data {
+	signal_handler_t *handler;
+	volatile bool entered[2];
+	volatile bool done[2];
+};
+
+struct cross_thread {
+	struct cross_data *cross;
+	int role;
+	pthread_t thread;
+};
+
+static THREAD_LOCAL int cross_role = -1;
+
+static void wait_entered(struct cross_data *cross, size_t idx)
+{
+	while (!os_atomic_load_bool(&cross->entered[idx]))
+		os_sleep_ms(1);
+}
+
+static void cross_a_cb(void *data, calldata_t *params);
+static void cross_b_cb(void *data, calldata_t *params);
+
+/* each callback only does something on the thread with its role, where it
+ * waits for the other thread to be inside the other callback and
+ * disconnects it */
+static void cross_a_cb(void *data, calldata_t *params)
+{
+	struct cross_data *cross = data;
+	UNUSED_PARAMETER(params);
+
+	if (cross_role != 0)
+		return;
+
+	os_atomic_set_bool(&cross->entered[0], true);
+	wait_entered(cross, 1);
+	signal_handler_disconnect(cross->handler, "test", cross_b_cb, cross);
+	os_atomic_set_bool(&cross->done[0], true);
+}
+
+static void cross_b_cb(void *data, calldata_t *params)
+{
+	struct cross_data *cross = data;
+	UNUSED_PARAMETER(params);
+
+	if (cross_role != 1)
+		return;
+
+	os_atomic_set_bool(&cross->entered[1], true);
+	wait_entered(cross, 0);
+	signal_handler_disconnect(cross->handler, "test", cross_a_cb, cross);
+	os_atomic_set_bool(&cross->done[1], true);
+}
+
+static void *emit_cross_thread(void *param)
+{
+	struct cross_thread *thread = param;
+
+	cross_role = thread->role;
+	signal_handler_signal(thread->cross->handler, "test", NULL);
+	return NULL;
+}
+
+static void cross_disconnect_test(void **state)
+{
+	struct cross_data cross = {create_handler()};
+	struct cross_thread threads[2] = {{&cross, 0}, {&cross, 1}};
+	struct counter counter = {0};
+
+	UNUSED_PARAMETER(state);
+
+	signal_handler_connect(cross.handler, "test", cross_a_cb, &cross);
+	signal_handler_connect(cross.handler, "test", cross_b_cb, &cross);
+	signal_handler_connect(cross.handler, "test", count_cb, &counter);
+
+	/* two threads each disconnect the callback the other one is inside
+	 * of, which must not leave them waiting on each other */
+	for (size_t i = 0; i < 2; i++)
+		assert_int_equal(pthread_create(&threads[i].thread, NULL,
+						emit_cross_thread, &threads[i]),
+				 0);
+	for (size_t i = 0; i < 2; i++)
+		pthread_join(threads[i].thread, NULL);
+
+	assert_true(cross.done[0]);
+	assert_true(cross.done[1]);
+	assert_int_equal(counter.calls, 2);
+
+	/* both are gone, the other callback is still connected */
+	signal_handler_signal(cross.handler, "test", NULL);
+	assert_int_equal(counter.calls, 3);
+
+	signal_handler_destroy(cross.handler);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(connect_test),
+		cmocka_unit_test(signal_id_test),
+		cmocka_unit_test(proc_id_test),
+		cmocka_unit_test(remove_current_test),
+		cmocka_unit_test(modify_while_signalling_test),
+		cmocka_unit_test(keep_ref_test),
+		cmocka_unit_test(concurrent_test),
+		cmocka_unit_test(disconnect_busy_test),
+		cmocka_unit_test(cross_disconnect_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}